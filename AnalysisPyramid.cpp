@@ -0,0 +1,123 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AnalysisPyramid.h"
+#include "imageproc/Constants.h"
+#include "imageproc/Grayscale.h"
+#include "imageproc/Scale.h"
+#include <QMutexLocker>
+#include <algorithm>
+#include <cmath>
+
+using namespace imageproc;
+
+AnalysisPyramid::AnalysisPyramid(const GrayImage& gray_image,
+                                 const Dpm& dpm,
+                                 const BinaryThreshold bw_threshold,
+                                 const bool black_on_white)
+        : m_grayImage(gray_image),
+          m_dpm(dpm),
+          m_bwThreshold(bw_threshold),
+          m_blackOnWhite(black_on_white),
+          m_darkestGrayLevel(-1) {
+}
+
+GrayImage AnalysisPyramid::normalizedGray() const {
+    const QMutexLocker locker(&m_mutex);
+
+    return normalizedGrayLocked();
+}
+
+BinaryThreshold AnalysisPyramid::normalizedThreshold() const {
+    return m_blackOnWhite ? m_bwThreshold : BinaryThreshold(256 - int(m_bwThreshold));
+}
+
+uint8_t AnalysisPyramid::darkestGrayLevel() const {
+    const QMutexLocker locker(&m_mutex);
+
+    if (m_darkestGrayLevel < 0) {
+        m_darkestGrayLevel = imageproc::darkestGrayLevel(normalizedGrayLocked());
+    }
+
+    return static_cast<uint8_t>(m_darkestGrayLevel);
+}
+
+GrayImage AnalysisPyramid::grayAtDpi(const int dpi) const {
+    const QMutexLocker locker(&m_mutex);
+
+    return levelLocked(dpi).gray;
+}
+
+BinaryImage AnalysisPyramid::binaryAtDpi(const int dpi) const {
+    const QMutexLocker locker(&m_mutex);
+
+    Level& level = levelLocked(dpi);
+    if (level.binary.isNull()) {
+        level.binary = BinaryImage(level.gray, normalizedThreshold());
+    }
+
+    return level.binary;
+}
+
+QTransform AnalysisPyramid::origToDpi(const int dpi) const {
+    const double xfactor = (dpi * constants::DPI2DPM) / m_dpm.horizontal();
+    const double yfactor = (dpi * constants::DPI2DPM) / m_dpm.vertical();
+    if ((std::fabs(xfactor - 1.0) < 0.1) && (std::fabs(yfactor - 1.0) < 0.1)) {
+        return QTransform();
+    }
+
+    QTransform xform;
+    xform.scale(xfactor, yfactor);
+
+    return xform;
+}
+
+GrayImage AnalysisPyramid::normalizedGrayLocked() const {
+    if (m_blackOnWhite) {
+        return m_grayImage;
+    }
+    if (m_normalizedGray.isNull()) {
+        m_normalizedGray = m_grayImage.inverted();
+    }
+
+    return m_normalizedGray;
+}
+
+AnalysisPyramid::Level& AnalysisPyramid::levelLocked(const int dpi) const {
+    const auto it = m_levels.find(dpi);
+    if (it != m_levels.end()) {
+        return it->second;
+    }
+
+    Level level;
+    const QTransform orig_to_level(origToDpi(dpi));
+    if (orig_to_level.isIdentity()) {
+        level.gray = normalizedGrayLocked();
+    } else {
+        level.gray = scaleToGray(normalizedGrayLocked(), levelSize(orig_to_level));
+    }
+
+    return m_levels[dpi] = level;
+}
+
+QSize AnalysisPyramid::levelSize(const QTransform& orig_to_level) const {
+    return QSize(
+            std::max(1, (int) std::ceil(orig_to_level.m11() * m_grayImage.width())),
+            std::max(1, (int) std::ceil(orig_to_level.m22() * m_grayImage.height()))
+    );
+}
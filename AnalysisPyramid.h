@@ -0,0 +1,112 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCANTAILOR_ANALYSISPYRAMID_H
+#define SCANTAILOR_ANALYSISPYRAMID_H
+
+#include "NonCopyable.h"
+#include "Dpm.h"
+#include "imageproc/BinaryImage.h"
+#include "imageproc/BinaryThreshold.h"
+#include "imageproc/GrayImage.h"
+#include <QMutex>
+#include <QTransform>
+#include <cstdint>
+#include <map>
+
+/**
+ * \brief Reduced and polarity-normalized versions of an input image.
+ *
+ * Analysis stages work on dark content on a light background, usually at
+ * a fixed resolution such as 100, 150, 200 or 300 DPI.  Rather than having
+ * every stage derive such images from the full resolution one, the stages
+ * request them from here.  Every image is built on first request and then
+ * kept for as long as the pyramid lives, which is normally the time a page
+ * goes through the filter chain, as copies of FilterData share it.
+ *
+ * All levels are in the coordinates of the original image, that is
+ * without any ImageTransformation applied.
+ *
+ * This class is thread-safe.
+ */
+class AnalysisPyramid {
+DECLARE_NON_COPYABLE(AnalysisPyramid)
+
+public:
+    AnalysisPyramid(const imageproc::GrayImage& gray_image,
+                    const Dpm& dpm,
+                    imageproc::BinaryThreshold bw_threshold,
+                    bool black_on_white);
+
+    /**
+     * \brief The full resolution image, inverted if the original is white on black.
+     */
+    imageproc::GrayImage normalizedGray() const;
+
+    /**
+     * \brief The binarization threshold that goes with normalizedGray().
+     */
+    imageproc::BinaryThreshold normalizedThreshold() const;
+
+    /**
+     * \brief The darkest gray level of normalizedGray().
+     */
+    uint8_t darkestGrayLevel() const;
+
+    /**
+     * \brief normalizedGray() scaled to the given resolution.
+     *
+     * If the original resolution is within 10% of the requested one,
+     * the full resolution image is returned.
+     */
+    imageproc::GrayImage grayAtDpi(int dpi) const;
+
+    /**
+     * \brief grayAtDpi() binarized with normalizedThreshold().
+     */
+    imageproc::BinaryImage binaryAtDpi(int dpi) const;
+
+    /**
+     * \brief Maps full resolution coordinates to those of grayAtDpi() and binaryAtDpi().
+     */
+    QTransform origToDpi(int dpi) const;
+
+private:
+    struct Level {
+        imageproc::GrayImage gray;
+        imageproc::BinaryImage binary;
+    };
+
+    imageproc::GrayImage normalizedGrayLocked() const;
+
+    Level& levelLocked(int dpi) const;
+
+    QSize levelSize(const QTransform& orig_to_level) const;
+
+    mutable QMutex m_mutex;
+    imageproc::GrayImage m_grayImage;
+    Dpm m_dpm;
+    imageproc::BinaryThreshold m_bwThreshold;
+    bool m_blackOnWhite;
+    mutable imageproc::GrayImage m_normalizedGray;
+    mutable int m_darkestGrayLevel;
+    mutable std::map<int, Level> m_levels;
+};
+
+
+#endif //SCANTAILOR_ANALYSISPYRAMID_H
@@ -0,0 +1,160 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CliClient.h"
+#include "CommandLine.h"
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegExp>
+#include <iostream>
+
+CliClient::CliClient(const QString& socket_name)
+        : m_socketName(socket_name) {
+}
+
+int CliClient::submit(const CommandLine& cli, const QStringList& arguments) {
+    const QRegExp rx_client_option("^--(connect|cancel)(=.*)?$");
+    const QRegExp rx_output_project("^(--output-project|-o)=(.+)$");
+
+    QJsonArray args;
+    // Skip the program name.
+    for (int i = 1; i < arguments.size(); ++i) {
+        const QString& arg = arguments[i];
+        if ((arg == "-") || !arg.startsWith('-') || rx_client_option.exactMatch(arg)) {
+            continue;
+        }
+
+        if (rx_output_project.exactMatch(arg)) {
+            args.append(rx_output_project.cap(1) + "=" + QFileInfo(rx_output_project.cap(2)).absoluteFilePath());
+        } else {
+            args.append(arg);
+        }
+    }
+
+    if (!cli.projectFile().isEmpty()) {
+        args.append(QFileInfo(cli.projectFile()).absoluteFilePath());
+    }
+    for (const ImageFileInfo& image : cli.images()) {
+        args.append(image.fileInfo().absoluteFilePath());
+    }
+    args.append(QFileInfo(cli.outputDirectory()).absoluteFilePath());
+
+    QJsonObject request;
+    request["command"] = QStringLiteral("submit");
+    request["args"] = args;
+    if (!connectToDaemon() || !send(request)) {
+        return 1;
+    }
+
+    QJsonObject message;
+    while (receive(message)) {
+        const QString event(message.value("event").toString());
+        if (event == "queued") {
+            std::cout << "Job " << message.value("job").toInt() << " queued" << std::endl;
+        } else if (event == "progress") {
+            if (cli.isVerbose()) {
+                std::cout << "Filter: " << message.value("filter").toInt()
+                          << "\tPage: " << message.value("page").toInt()
+                          << "/" << message.value("pages").toInt() << std::endl;
+            }
+        } else if (event == "finished") {
+            const QString state(message.value("state").toString());
+            if (state == "done") {
+                return 0;
+            }
+
+            std::cerr << "Job " << state.toStdString();
+            if (message.contains("error")) {
+                std::cerr << ": " << message.value("error").toString().toStdString();
+            }
+            std::cerr << std::endl;
+
+            return 1;
+        } else if (event == "error") {
+            std::cerr << message.value("error").toString().toStdString() << std::endl;
+
+            return 1;
+        }
+    }
+
+    std::cerr << "Lost connection to the daemon" << std::endl;
+
+    return 1;
+}  // CliClient::submit
+
+int CliClient::cancel(const int job_id) {
+    QJsonObject request;
+    request["command"] = QStringLiteral("cancel");
+    request["job"] = job_id;
+    if (!connectToDaemon() || !send(request)) {
+        return 1;
+    }
+
+    QJsonObject message;
+    if (!receive(message)) {
+        std::cerr << "Lost connection to the daemon" << std::endl;
+
+        return 1;
+    }
+    if (message.value("event").toString() == "error") {
+        std::cerr << message.value("error").toString().toStdString() << std::endl;
+
+        return 1;
+    }
+
+    std::cout << "Job " << job_id << " " << message.value("state").toString().toStdString() << std::endl;
+
+    return 0;
+}
+
+bool CliClient::connectToDaemon() {
+    m_socket.connectToServer(m_socketName);
+    if (!m_socket.waitForConnected()) {
+        std::cerr << "Unable to connect to " << m_socketName.toStdString() << ": "
+                  << m_socket.errorString().toStdString() << std::endl;
+
+        return false;
+    }
+
+    return true;
+}
+
+bool CliClient::send(const QJsonObject& message) {
+    const QByteArray data(QJsonDocument(message).toJson(QJsonDocument::Compact) + '\n');
+    if ((m_socket.write(data) != data.size()) || !m_socket.waitForBytesWritten()) {
+        std::cerr << "Unable to send a request to the daemon: " << m_socket.errorString().toStdString() << std::endl;
+
+        return false;
+    }
+
+    return true;
+}
+
+bool CliClient::receive(QJsonObject& message) {
+    while (!m_socket.canReadLine()) {
+        if (!m_socket.waitForReadyRead(-1)) {
+            return false;
+        }
+    }
+
+    message = QJsonDocument::fromJson(m_socket.readLine()).object();
+
+    return true;
+}
@@ -0,0 +1,65 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCANTAILOR_CLICLIENT_H
+#define SCANTAILOR_CLICLIENT_H
+
+#include "NonCopyable.h"
+#include <QLocalSocket>
+#include <QString>
+#include <QStringList>
+
+class CommandLine;
+class QJsonObject;
+
+/**
+ * \brief Submits jobs to a CliDaemon and reports on them.
+ *
+ * The methods return what scantailor-cli's main() should return.
+ */
+class CliClient {
+DECLARE_NON_COPYABLE(CliClient)
+
+public:
+    explicit CliClient(const QString& socket_name);
+
+    /**
+     * \brief Submits the job described by \p cli and waits for it to finish.
+     *
+     * \p arguments are the arguments \p cli was parsed from.  Options are
+     * passed on as they are, while input and output paths are taken from
+     * \p cli and made absolute, so the daemon doesn't depend on our working
+     * directory or stdin.
+     */
+    int submit(const CommandLine& cli, const QStringList& arguments);
+
+    int cancel(int job_id);
+
+private:
+    bool connectToDaemon();
+
+    bool send(const QJsonObject& message);
+
+    bool receive(QJsonObject& message);
+
+    QString m_socketName;
+    QLocalSocket m_socket;
+};
+
+
+#endif //SCANTAILOR_CLICLIENT_H
@@ -0,0 +1,512 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CliDaemon.h"
+#include "BackgroundTask.h"
+#include "CommandLine.h"
+#include "ConsoleBatch.h"
+#include "ThumbnailPixmapCache.h"
+#include "Utils.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPointer>
+#include <QRunnable>
+#include <algorithm>
+
+class CliDaemon::Job : public ConsoleBatch::ProgressListener {
+public:
+    Job(CliDaemon* daemon, int id, const CommandLine& cli, QLocalSocket* client)
+            : m_pDaemon(daemon),
+              m_id(id),
+              m_cli(cli),
+              m_pClient(client),
+              m_state(QUEUED),
+              m_filterIdx(-1),
+              m_pageIdx(-1),
+              m_numPages(0),
+              m_cancelled(false) {
+    }
+
+    int id() const {
+        return m_id;
+    }
+
+    const CommandLine& cli() const {
+        return m_cli;
+    }
+
+    /**
+     * \brief The connection that submitted the job, or null if it was closed.
+     */
+    QLocalSocket* client() const {
+        return m_pClient;
+    }
+
+    void detachClient() {
+        m_pClient = nullptr;
+    }
+
+    JobState state() const {
+        return m_state;
+    }
+
+    bool isFinished() const {
+        return (m_state == DONE) || (m_state == FAILED) || (m_state == CANCELLED);
+    }
+
+    void setState(const JobState state) {
+        m_state = state;
+    }
+
+    int filterIdx() const {
+        return m_filterIdx;
+    }
+
+    int pageIdx() const {
+        return m_pageIdx;
+    }
+
+    int numPages() const {
+        return m_numPages;
+    }
+
+    void setProgress(const int filter_idx, const int page_idx, const int num_pages) {
+        m_filterIdx = filter_idx;
+        m_pageIdx = page_idx;
+        m_numPages = num_pages;
+    }
+
+    /**
+     * \brief Stops the job as soon as possible.  May be called from any thread.
+     */
+    void cancel() {
+        const QMutexLocker locker(&m_mutex);
+
+        m_cancelled = true;
+        if (m_ptrCurrentTask) {
+            m_ptrCurrentTask->cancel();
+        }
+    }
+
+    bool isCancelled() const {
+        const QMutexLocker locker(&m_mutex);
+
+        return m_cancelled;
+    }
+
+    void pageStarted(const int filter_idx,
+                     const int page_idx,
+                     const int num_pages,
+                     const BackgroundTaskPtr& task) override {
+        {
+            const QMutexLocker locker(&m_mutex);
+
+            m_ptrCurrentTask = task;
+            if (m_cancelled) {
+                task->cancel();
+            }
+        }
+
+        QMetaObject::invokeMethod(
+                m_pDaemon, "jobProgressed", Qt::QueuedConnection,
+                Q_ARG(int, m_id), Q_ARG(int, filter_idx), Q_ARG(int, page_idx), Q_ARG(int, num_pages)
+        );
+    }
+
+private:
+    CliDaemon* m_pDaemon;
+    const int m_id;
+    const CommandLine m_cli;
+
+    // Accessed from the daemon's thread only.
+    QPointer<QLocalSocket> m_pClient;
+    JobState m_state;
+    int m_filterIdx;
+    int m_pageIdx;
+    int m_numPages;
+
+    mutable QMutex m_mutex;
+    BackgroundTaskPtr m_ptrCurrentTask;
+    bool m_cancelled;
+};
+
+
+class CliDaemon::JobRunnable : public QRunnable {
+public:
+    JobRunnable(CliDaemon* daemon,
+                std::shared_ptr<Job> job,
+                intrusive_ptr<ThumbnailPixmapCache> thumbnail_cache)
+            : m_pDaemon(daemon),
+              m_ptrJob(std::move(job)),
+              m_ptrThumbnailCache(std::move(thumbnail_cache)) {
+    }
+
+    void run() override {
+        JobState state = CANCELLED;
+        QString error;
+
+        if (!m_ptrJob->isCancelled()) {
+            QMetaObject::invokeMethod(m_pDaemon, "jobStarted", Qt::QueuedConnection, Q_ARG(int, m_ptrJob->id()));
+
+            const CommandLine& cli = m_ptrJob->cli();
+            try {
+                std::unique_ptr<ConsoleBatch> batch;
+                if (!cli.projectFile().isEmpty()) {
+                    batch.reset(new ConsoleBatch(cli.projectFile(), cli));
+                } else {
+                    batch.reset(new ConsoleBatch(cli.images(), cli.outputDirectory(), cli.getLayoutDirection(), cli));
+                }
+                batch->setThumbnailCache(m_ptrThumbnailCache);
+                batch->process(m_ptrJob.get());
+
+                if (cli.hasOutputProject()) {
+                    batch->saveProject(cli.outputProjectFile());
+                }
+                state = DONE;
+            } catch (const BackgroundTask::CancelledException&) {
+                state = CANCELLED;
+            } catch (const std::exception& e) {
+                state = FAILED;
+                error = QString::fromLocal8Bit(e.what());
+            }
+        }
+
+        QMetaObject::invokeMethod(
+                m_pDaemon, "jobFinished", Qt::QueuedConnection,
+                Q_ARG(int, m_ptrJob->id()), Q_ARG(int, state), Q_ARG(QString, error)
+        );
+    }
+
+private:
+    CliDaemon* m_pDaemon;
+    std::shared_ptr<Job> m_ptrJob;
+    intrusive_ptr<ThumbnailPixmapCache> m_ptrThumbnailCache;
+};
+
+
+CliDaemon::CliDaemon(const QString& socket_name, const int max_jobs, QObject* parent)
+        : QObject(parent),
+          m_socketName(socket_name),
+          m_pServer(new QLocalServer(this)),
+          m_nextJobId(1) {
+    m_threadPool.setMaxThreadCount(std::max(max_jobs, 1));
+
+    connect(m_pServer, SIGNAL(newConnection()), SLOT(acceptConnections()));
+}
+
+CliDaemon::~CliDaemon() {
+    for (const auto& kv : m_jobs) {
+        kv.second->cancel();
+    }
+    m_threadPool.waitForDone();
+}
+
+bool CliDaemon::listen() {
+    {
+        QLocalSocket probe;
+        probe.connectToServer(m_socketName);
+        if (probe.waitForConnected(1000)) {
+            m_errorString = tr("Another daemon is listening on %1").arg(m_socketName);
+
+            return false;
+        }
+    }
+
+    QLocalServer::removeServer(m_socketName);
+    m_pServer->setSocketOptions(QLocalServer::UserAccessOption);
+    if (!m_pServer->listen(m_socketName)) {
+        m_errorString = m_pServer->errorString();
+
+        return false;
+    }
+
+    return true;
+}
+
+QString CliDaemon::errorString() const {
+    return m_errorString;
+}
+
+void CliDaemon::acceptConnections() {
+    while (QLocalSocket* socket = m_pServer->nextPendingConnection()) {
+        connect(socket, SIGNAL(readyRead()), SLOT(readRequests()));
+        connect(socket, SIGNAL(disconnected()), SLOT(dropConnection()));
+    }
+}
+
+void CliDaemon::readRequests() {
+    auto* socket = qobject_cast<QLocalSocket*>(sender());
+    if (!socket) {
+        return;
+    }
+
+    while (socket->canReadLine()) {
+        const QByteArray line(socket->readLine().trimmed());
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        const QJsonDocument request(QJsonDocument::fromJson(line));
+        if (!request.isObject()) {
+            send(socket, errorMessage(tr("Malformed request")));
+            continue;
+        }
+        handleRequest(socket, request.object());
+    }
+}
+
+void CliDaemon::dropConnection() {
+    auto* socket = qobject_cast<QLocalSocket*>(sender());
+    if (!socket) {
+        return;
+    }
+
+    for (const auto& kv : m_jobs) {
+        Job& job = *kv.second;
+        if (job.client() == socket) {
+            job.detachClient();
+            if (!job.isFinished()) {
+                job.cancel();
+            }
+        }
+    }
+
+    socket->deleteLater();
+}
+
+void CliDaemon::jobStarted(const int job_id) {
+    const auto it(m_jobs.find(job_id));
+    if (it != m_jobs.end()) {
+        it->second->setState(RUNNING);
+    }
+}
+
+void CliDaemon::jobProgressed(const int job_id, const int filter_idx, const int page_idx, const int num_pages) {
+    const auto it(m_jobs.find(job_id));
+    if (it == m_jobs.end()) {
+        return;
+    }
+
+    Job& job = *it->second;
+    job.setProgress(filter_idx, page_idx, num_pages);
+
+    QJsonObject message;
+    message["job"] = job.id();
+    message["event"] = QStringLiteral("progress");
+    message["filter"] = filter_idx + 1;
+    message["page"] = page_idx + 1;
+    message["pages"] = num_pages;
+    send(job.client(), message);
+}
+
+void CliDaemon::jobFinished(const int job_id, const int state, const QString& error) {
+    const auto it(m_jobs.find(job_id));
+    if (it == m_jobs.end()) {
+        return;
+    }
+
+    Job& job = *it->second;
+    job.setState(static_cast<JobState>(state));
+
+    QJsonObject message;
+    message["job"] = job.id();
+    message["event"] = QStringLiteral("finished");
+    message["state"] = stateName(job.state());
+    if (!error.isEmpty()) {
+        message["error"] = error;
+    }
+    send(job.client(), message);
+
+    pruneFinishedJobs();
+}
+
+void CliDaemon::handleRequest(QLocalSocket* socket, const QJsonObject& request) {
+    const QString command(request.value("command").toString());
+
+    if (command == "submit") {
+        submitJob(socket, request);
+    } else if ((command == "status") || (command == "cancel")) {
+        const auto it(m_jobs.find(request.value("job").toInt()));
+        if (it == m_jobs.end()) {
+            send(socket, errorMessage(tr("No such job")));
+
+            return;
+        }
+
+        Job& job = *it->second;
+        if ((command == "cancel") && !job.isFinished()) {
+            job.cancel();
+        }
+        send(socket, statusMessage(job));
+    } else {
+        send(socket, errorMessage(tr("Unknown command: %1").arg(command)));
+    }
+}
+
+void CliDaemon::submitJob(QLocalSocket* socket, const QJsonObject& request) {
+    QStringList args;
+    args << QCoreApplication::applicationFilePath();
+    for (const QJsonValue& arg : request.value("args").toArray()) {
+        args << arg.toString();
+    }
+
+    const QString error(checkJobArguments(args));
+    if (!error.isEmpty()) {
+        send(socket, errorMessage(error));
+
+        return;
+    }
+
+    const CommandLine cli(args, false);
+    if (cli.isError()) {
+        send(socket, errorMessage(cli.errors().join("\n")));
+
+        return;
+    }
+    if (cli.images().empty() && cli.projectFile().isEmpty()) {
+        send(socket, errorMessage(tr("No images or project file given")));
+
+        return;
+    }
+
+    const int job_id = m_nextJobId++;
+    const auto job(std::make_shared<Job>(this, job_id, cli, socket));
+    m_jobs[job_id] = job;
+    m_threadPool.start(new JobRunnable(this, job, thumbnailCacheFor(cli.outputDirectory())));
+
+    QJsonObject message;
+    message["job"] = job_id;
+    message["event"] = QStringLiteral("queued");
+    send(socket, message);
+}
+
+QString CliDaemon::checkJobArguments(const QStringList& args) {
+    // CommandLine reads stdin on "-", which would block the daemon.
+    // A missing output directory is checked here for a clearer message.
+    if ((args.size() < 2) || !QFileInfo(args.back()).isDir()) {
+        return tr("The last argument must be an existing output directory");
+    }
+
+    for (int i = 1; i < args.size(); ++i) {
+        const QString& arg = args[i];
+        if (arg == "-") {
+            return tr("Reading file names from stdin is not supported");
+        }
+        if (!arg.startsWith('-') && QFileInfo(arg).isRelative()) {
+            return tr("Paths must be absolute: %1").arg(arg);
+        }
+    }
+
+    return QString();
+}
+
+intrusive_ptr<ThumbnailPixmapCache> CliDaemon::thumbnailCacheFor(const QString& output_dir) {
+    const QString key(QDir(output_dir).absolutePath());
+
+    for (auto it = m_thumbnailCaches.begin(); it != m_thumbnailCaches.end(); ++it) {
+        if (it->first == key) {
+            m_thumbnailCaches.splice(m_thumbnailCaches.begin(), m_thumbnailCaches, it);
+
+            return it->second;
+        }
+    }
+
+    m_thumbnailCaches.emplace_front(key, Utils::createThumbnailCache(output_dir));
+    if (static_cast<int>(m_thumbnailCaches.size()) > MAX_THUMBNAIL_CACHES) {
+        // Jobs still using it hold their own references.
+        m_thumbnailCaches.pop_back();
+    }
+
+    return m_thumbnailCaches.front().second;
+}
+
+void CliDaemon::pruneFinishedJobs() {
+    int num_finished = 0;
+    for (const auto& kv : m_jobs) {
+        if (kv.second->isFinished()) {
+            ++num_finished;
+        }
+    }
+
+    // Job ids increase, so the oldest jobs come first.
+    auto it(m_jobs.begin());
+    while ((num_finished > MAX_FINISHED_JOBS) && (it != m_jobs.end())) {
+        if (it->second->isFinished()) {
+            m_jobs.erase(it++);
+            --num_finished;
+        } else {
+            ++it;
+        }
+    }
+}
+
+QJsonObject CliDaemon::statusMessage(const Job& job) {
+    QJsonObject message;
+    message["job"] = job.id();
+    message["event"] = QStringLiteral("status");
+    message["state"] = stateName(job.state());
+    if (job.numPages() > 0) {
+        message["filter"] = job.filterIdx() + 1;
+        message["page"] = job.pageIdx() + 1;
+        message["pages"] = job.numPages();
+    }
+
+    return message;
+}
+
+QJsonObject CliDaemon::errorMessage(const QString& error) {
+    QJsonObject message;
+    message["event"] = QStringLiteral("error");
+    message["error"] = error;
+
+    return message;
+}
+
+void CliDaemon::send(QLocalSocket* socket, const QJsonObject& message) {
+    if (!socket) {
+        return;
+    }
+
+    socket->write(QJsonDocument(message).toJson(QJsonDocument::Compact));
+    socket->write("\n");
+}
+
+QString CliDaemon::stateName(const JobState state) {
+    switch (state) {
+        case QUEUED:
+            return QStringLiteral("queued");
+        case RUNNING:
+            return QStringLiteral("running");
+        case DONE:
+            return QStringLiteral("done");
+        case FAILED:
+            return QStringLiteral("failed");
+        case CANCELLED:
+            return QStringLiteral("cancelled");
+    }
+
+    return QString();
+}
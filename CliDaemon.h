@@ -0,0 +1,147 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCANTAILOR_CLIDAEMON_H
+#define SCANTAILOR_CLIDAEMON_H
+
+#include "intrusive_ptr.h"
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <list>
+#include <map>
+#include <memory>
+#include <utility>
+
+class QLocalServer;
+class QLocalSocket;
+class QJsonObject;
+class ThumbnailPixmapCache;
+
+/**
+ * \brief Runs scantailor-cli jobs submitted over a local socket.
+ *
+ * This saves clients the startup cost of scantailor-cli and lets jobs share
+ * cached image metadata and thumbnails.  Clients send one JSON object per
+ * line and get JSON objects back, one per line:
+ * \code
+ * {"command": "submit", "args": [<scantailor-cli arguments>]}
+ *     -> {"job": 1, "event": "queued"}
+ *     -> {"job": 1, "event": "progress", "filter": 4, "page": 1, "pages": 20}
+ *     -> {"job": 1, "event": "finished", "state": "done"}
+ * {"command": "status", "job": 1}
+ *     -> {"job": 1, "event": "status", "state": "running", "filter": 4, "page": 2, "pages": 20}
+ * {"command": "cancel", "job": 1}
+ *     -> {"job": 1, "event": "status", "state": "running", ...}
+ * \endcode
+ * The job arguments are those of scantailor-cli, except that paths have to
+ * be absolute and file names can't be read from stdin.  Filter and page
+ * numbers are 1-based.  Malformed requests are answered with
+ * {"event": "error", "error": <message>}.
+ *
+ * Progress and completion events go to the connection that submitted the job.
+ * Closing that connection cancels its unfinished jobs.  Jobs run concurrently
+ * on a thread pool owned by the daemon.  Each job processes its pages one by
+ * one, the way scantailor-cli does.
+ */
+class CliDaemon : public QObject {
+Q_OBJECT
+public:
+    /**
+     * \param socket_name The name or path of the socket to listen on.
+     * \param max_jobs The number of jobs to run at once.  Each job already
+     *        spreads its work over all cores, so one is usually enough.
+     */
+    CliDaemon(const QString& socket_name, int max_jobs, QObject* parent = nullptr);
+
+    /**
+     * \brief Cancels all jobs and waits for them to stop.
+     */
+    ~CliDaemon() override;
+
+    /**
+     * \brief Starts listening for clients.
+     *
+     * A socket left over from a daemon that is no longer running is replaced.
+     * If another daemon is listening on the socket, false is returned.
+     */
+    bool listen();
+
+    QString errorString() const;
+
+private slots:
+
+    void acceptConnections();
+
+    void readRequests();
+
+    void dropConnection();
+
+    void jobStarted(int job_id);
+
+    void jobProgressed(int job_id, int filter_idx, int page_idx, int num_pages);
+
+    void jobFinished(int job_id, int state, const QString& error);
+
+private:
+    class Job;
+    class JobRunnable;
+
+    enum JobState {
+        QUEUED,
+        RUNNING,
+        DONE,
+        FAILED,
+        CANCELLED
+    };
+
+    typedef std::list<std::pair<QString, intrusive_ptr<ThumbnailPixmapCache>>> ThumbnailCaches;
+
+    static const int MAX_THUMBNAIL_CACHES = 8;
+
+    static const int MAX_FINISHED_JOBS = 100;
+
+    void handleRequest(QLocalSocket* socket, const QJsonObject& request);
+
+    void submitJob(QLocalSocket* socket, const QJsonObject& request);
+
+    static QString checkJobArguments(const QStringList& args);
+
+    intrusive_ptr<ThumbnailPixmapCache> thumbnailCacheFor(const QString& output_dir);
+
+    void pruneFinishedJobs();
+
+    static QJsonObject statusMessage(const Job& job);
+
+    static QJsonObject errorMessage(const QString& error);
+
+    static void send(QLocalSocket* socket, const QJsonObject& message);
+
+    static QString stateName(JobState state);
+
+    QString m_socketName;
+    QString m_errorString;
+    QLocalServer* m_pServer;
+    QThreadPool m_threadPool;
+    std::map<int, std::shared_ptr<Job>> m_jobs;
+    ThumbnailCaches m_thumbnailCaches;
+    int m_nextJobId;
+};
+
+
+#endif //SCANTAILOR_CLIDAEMON_H
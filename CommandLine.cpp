@@ -56,14 +56,12 @@ bool CommandLine::parseCli(const QStringList& argv) {
     opts << "orientation";
     opts << "rotate";
     opts << "deskew";
-    opts << "skew-deviation";
     opts << "disable-content-detection";
     opts << "enable-page-detection";
     opts << "enable-fine-tuning";
     opts << "force-disable-page-detection";
     opts << "content-detection";
     opts << "content-box";
-    opts << "content-deviation";
     opts << "enable-auto-margins";
     opts << "margins";
     opts << "margins-left";
@@ -94,6 +92,7 @@ bool CommandLine::parseCli(const QStringList& argv) {
     opts << "threshold";
     opts << "despeckle";
     opts << "dewarping";
+    opts << "pyramid-tracing";
     opts << "depth-perception";
     opts << "start-filter";
     opts << "end-filter";
@@ -104,17 +103,17 @@ bool CommandLine::parseCli(const QStringList& argv) {
     opts << "window-title";
     opts << "page-detection-box";
     opts << "page-detection-tolerance";
-    opts << "page-borders";
-    opts << "page-borders-left";
-    opts << "page-borders-top";
-    opts << "page-borders-right";
-    opts << "page-borders-bottom";
     opts << "disable-check-output";
     opts << "default-output-dpi";
     opts << "default-color-mode";
     opts << "tiff-force-rgb";
     opts << "tiff-force-grayscale";
     opts << "tiff-force-keep-color-space";
+    opts << "trace";
+    opts << "daemon";
+    opts << "daemon-jobs";
+    opts << "connect";
+    opts << "cancel";
 
     QMap<QString, QString> shortMap;
     shortMap["h"] = "help";
@@ -132,32 +131,28 @@ bool CommandLine::parseCli(const QStringList& argv) {
         if (rx.exactMatch(argv[i])) {
             QString key = rx.cap(1);
             if (!opts.contains(key)) {
-                m_error = true;
-                std::cout << "Unknown option '" << key.toStdString() << "'" << std::endl;
+                addError(QString("Unknown option '%1'").arg(key));
                 continue;
             }
             m_options[key] = rx.cap(2);
         } else if (rx_switch.exactMatch(argv[i])) {
             QString key = rx_switch.cap(1);
             if (!opts.contains(key)) {
-                m_error = true;
-                std::cout << "Unknown switch '" << key.toStdString() << "'" << std::endl;
+                addError(QString("Unknown switch '%1'").arg(key));
                 continue;
             }
             m_options[key] = "true";
         } else if (rx_short.exactMatch(argv[i])) {
             QString key = shortMap[rx_short.cap(1)];
             if (key == "") {
-                std::cout << "Unknown option: '" << rx_short.cap(1).toStdString() << "'" << std::endl;
-                m_error = true;
+                addError(QString("Unknown option '%1'").arg(rx_short.cap(1)));
                 continue;
             }
             m_options[key] = rx_short.cap(2);
         } else if (rx_short_switch.exactMatch(argv[i])) {
             QString key = shortMap[rx_short_switch.cap(1)];
             if (key == "") {
-                std::cout << "Unknown switch: '" << rx_short_switch.cap(1).toStdString() << "'" << std::endl;
-                m_error = true;
+                addError(QString("Unknown switch '%1'").arg(rx_short_switch.cap(1)));
                 continue;
             }
             m_options[key] = "true";
@@ -172,8 +167,7 @@ bool CommandLine::parseCli(const QStringList& argv) {
                 if (file.isDir()) {
                     CommandLine::m_outputDirectory = file.filePath();
                 } else {
-                    std::cout << "Error: Last argument must be an existing directory" << std::endl;
-                    exit(1);
+                    addError("Last argument must be an existing directory");
                 }
             } else if (file.filePath() == "-") {
                 // file names from stdin
@@ -210,6 +204,11 @@ bool CommandLine::parseCli(const QStringList& argv) {
     return m_error;
 } // CommandLine::parseCli
 
+void CommandLine::addError(const QString& message) {
+    m_error = true;
+    m_errors.push_back(message);
+}
+
 void CommandLine::addImage(const QString& path) {
     QFileInfo file(path);
     m_files.push_back(file);
@@ -227,20 +226,18 @@ void CommandLine::setup() {
     m_defaultOutputDpi = fetchDpi("default-output-dpi");
     m_margins = fetchMargins();
     m_defaultMargins = fetchMargins("default-margins");
-    m_pageBorders = fetchPageBorders();
     m_alignment = fetchAlignment();
     m_contentDetection = fetchContentDetection();
     m_contentRect = fetchContentRect();
-    m_contentDeviation = fetchContentDeviation();
     m_orientation = fetchOrientation();
     m_threshold = fetchThreshold();
     m_deskewAngle = fetchDeskewAngle();
     m_deskewMode = fetchDeskewMode();
-    m_skewDeviation = fetchSkewDeviation();
     m_startFilterIdx = fetchStartFilterIdx();
     m_endFilterIdx = fetchEndFilterIdx();
     m_matchLayoutTolerance = fetchMatchLayoutTolerance();
     m_dewarpingOptions = output::DewarpingOptions(fetchDewarpingMode());
+    m_dewarpingOptions.setPyramidTracing(hasPyramidTracing());
     m_language = fetchLanguage();
     m_windowTitle = fetchWindowTitle();
     m_pageDetectionBox = fetchPageDetectionBox();
@@ -275,6 +272,10 @@ void CommandLine::printHelp() {
     std::cout << "\t2) scantailor <project_file>" << std::endl;
     std::cout << "\t3) scantailor-cli [options] <images|directory|-> <output_directory>" << std::endl;
     std::cout << "\t4) scantailor-cli [options] <project_file> [output_directory]" << std::endl;
+    std::cout << "\t5) scantailor-cli --daemon=<socket> [--daemon-jobs=<n>]" << std::endl;
+    std::cout << "\t6) scantailor-cli --connect=<socket> [options] <images|directory|-|project_file> <output_directory>"
+              << std::endl;
+    std::cout << "\t7) scantailor-cli --connect=<socket> --cancel=<job>" << std::endl;
     std::cout << std::endl;
     std::cout << "1)" << std::endl;
     std::cout << "\tstart ScanTailor's GUI interface" << std::endl;
@@ -287,6 +288,13 @@ void CommandLine::printHelp() {
     std::cout << "\tbatch processing project from command line; no GUI" << std::endl;
     std::cout << "\tif output_directory is specified as last argument, it overwrites the one in project file"
               << std::endl;
+    std::cout << "5)" << std::endl;
+    std::cout << "\tserve batch processing jobs on a local socket; jobs run n at a time, default: 1"
+              << std::endl;
+    std::cout << "6)" << std::endl;
+    std::cout << "\tprocess images or a project like 3) and 4), but in a running daemon" << std::endl;
+    std::cout << "7)" << std::endl;
+    std::cout << "\tcancel a job running in a daemon" << std::endl;
     std::cout << std::endl;
     std::cout << "Options:" << std::endl;
     std::cout << "\t--help, -h" << std::endl;
@@ -301,9 +309,6 @@ void CommandLine::printHelp() {
     std::cout << "\t--orientation=<left|right|upsidedown|none>\n\t\t\t\t\t\t-- default: none" << std::endl;
     std::cout << "\t--rotate=<0.0...360.0>\t\t\t-- it also sets deskew to manual mode" << std::endl;
     std::cout << "\t--deskew=<auto|manual>\t\t\t-- default: auto" << std::endl;
-    std::cout
-            << "\t--skew-deviation=<0.0...)\t\t-- default: 5.0; pages with bigger skew deviation will be painted in red"
-            << std::endl;
     std::cout << "\t--disable-content-detection\t\t-- default: enabled" << std::endl;
     std::cout << "\t--enable-page-detection\t\t\t-- default: disabled" << std::endl;
     std::cout
@@ -317,10 +322,6 @@ void CommandLine::printHelp() {
     std::cout << "\t--disable-content-text-mask\n\t\t\t\t\t\t-- disable using text mask to estimate a content box"
               << std::endl;
     std::cout << "\t--content-detection=<cautious|normal|aggressive>\n\t\t\t\t\t\t-- default: normal" << std::endl;
-    std::cout
-            <<
-            "\t--content-deviation=<0.0...)\t\t-- default: 1.0; pages with bigger content deviation will be painted in red"
-            << std::endl;
     std::cout << "\t--content-box=<<left_offset>x<top_offset>:<width>x<height>>" << std::endl;
     std::cout << "\t\t\t\t\t\t-- if set the content detection is se to manual mode" << std::endl;
     std::cout << "\t\t\t\t\t\t   example: --content-box=100x100:1500x2500" << std::endl;
@@ -366,6 +367,8 @@ void CommandLine::printHelp() {
     std::cout << "\t--threshold=<n>\t\t\t\t-- n<0 thinner, n>0 thicker; default: 0" << std::endl;
     std::cout << "\t--despeckle=<off|cautious|normal|aggressive>\n\t\t\t\t\t\t-- default: normal" << std::endl;
     std::cout << "\t--dewarping=<off|auto>\t\t\t-- default: off" << std::endl;
+    std::cout << "\t--pyramid-tracing\t\t\t-- faster text line tracing for auto dewarping; default: false"
+              << std::endl;
     std::cout << "\t--depth-perception=<1.0...3.0>\t\t-- default: 2.0" << std::endl;
     std::cout << "\t--start-filter=<1...6>\t\t\t-- default: 4" << std::endl;
     std::cout << "\t--end-filter=<1...6>\t\t\t-- default: 6" << std::endl;
@@ -376,8 +379,10 @@ void CommandLine::printHelp() {
     std::cout << "\t--window-title=WindowTitle\t\t-- default: project name" << std::endl;
     std::cout << "\t--page-detection-box=<widthxheight>\t\t-- in mm" << std::endl;
     std::cout << "\t\t--page-detection-tolerance=<0.0..1.0>\t-- default: 0.1" << std::endl;
-    std::cout << "\t--disable-check-output\t\t\t-- don't check if page is valid when switching to step 6";
-    std::cout << std::endl;
+    std::cout << "\t--disable-check-output\t\t\t-- don't check if page is valid when switching to step 6"
+              << std::endl;
+    std::cout << "\t--trace=<file.json>\t\t\t-- record a performance trace in the Chrome trace format"
+              << std::endl;
 } // CommandLine::printHelp
 
 page_split::LayoutType CommandLine::fetchLayoutType() {
@@ -605,16 +610,9 @@ QRectF CommandLine::fetchContentRect() {
         return QRectF(rx.cap(1).toFloat(), rx.cap(2).toFloat(), rx.cap(3).toFloat(), rx.cap(4).toFloat());
     }
 
-    std::cout << "invalid --content-box=" << m_options["content-box"].toLatin1().constData() << std::endl;
-    exit(1);
-}
-
-double CommandLine::fetchContentDeviation() {
-    if (!hasContentDeviation()) {
-        return 1.0;
-    }
+    addError("Invalid --content-box=" + m_options["content-box"]);
 
-    return m_options["content-deviation"].toDouble();
+    return QRectF();
 }
 
 CommandLine::Orientation CommandLine::fetchOrientation() {
@@ -622,7 +620,7 @@ CommandLine::Orientation CommandLine::fetchOrientation() {
         return TOP;
     }
 
-    Orientation orient;
+    Orientation orient = TOP;
     QString cli_orient = m_options["orientation"];
 
     if (cli_orient == "left") {
@@ -631,9 +629,8 @@ CommandLine::Orientation CommandLine::fetchOrientation() {
         orient = RIGHT;
     } else if (cli_orient == "upsidedown") {
         orient = UPSIDEDOWN;
-    } else {
-        std::cout << "Wrong orientation " << m_options["orientation"].toLatin1().constData() << std::endl;
-        exit(1);
+    } else if (cli_orient != "none") {
+        addError("Invalid --orientation=" + m_options["orientation"]);
     }
 
     return orient;
@@ -671,14 +668,6 @@ AutoManualMode CommandLine::fetchDeskewMode() {
     return (m_options["deskew"].toLower() == "manual") ? MODE_MANUAL : MODE_AUTO;
 }
 
-double CommandLine::fetchSkewDeviation() {
-    if (!hasSkewDeviation()) {
-        return 5.0;
-    }
-
-    return m_options["skew-deviation"].toDouble();
-}
-
 int CommandLine::fetchStartFilterIdx() {
     if (!hasStartFilterIdx()) {
         return 0;
@@ -769,7 +758,7 @@ QString CommandLine::fetchWindowTitle() const {
     return "";
 }
 
-QSizeF CommandLine::fetchPageDetectionBox() const {
+QSizeF CommandLine::fetchPageDetectionBox() {
     if (!hasPageDetectionBox()) {
         return QSizeF();
     }
@@ -779,8 +768,9 @@ QSizeF CommandLine::fetchPageDetectionBox() const {
         return QSizeF(rx.cap(1).toFloat(), rx.cap(2).toFloat());
     }
 
-    std::cout << "invalid --page-detection-box=" << m_options["page-detection-box"].toLatin1().constData() << std::endl;
-    exit(1);
+    addError("Invalid --page-detection-box=" + m_options["page-detection-box"]);
+
+    return QSizeF();
 }
 
 double CommandLine::fetchPageDetectionTolerance() const {
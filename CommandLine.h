@@ -85,6 +85,15 @@ public:
         return m_error;
     }
 
+    /**
+     * \brief Explains what made isError() true, one message per problem.
+     *
+     * Nothing is printed while parsing, so it's up to the caller to report these.
+     */
+    const QStringList& errors() const {
+        return m_errors;
+    }
+
     const std::vector<ImageFileInfo>& images() const {
         return m_images;
     }
@@ -123,10 +132,6 @@ public:
 
     bool hasMargins(QString base = "margins") const;
 
-    bool hasPageBorders() const {
-        return hasMargins("page-borders");
-    }
-
     bool hasAlignment() const;
 
     bool hasOutputDpi() const;
@@ -169,18 +174,10 @@ public:
         return contains("deskew") && !m_options["deskew"].isEmpty();
     }
 
-    bool hasSkewDeviation() const {
-        return contains("skew-deviation") && !m_options["skew-deviation"].isEmpty();
-    }
-
     bool hasContentRect() const {
         return contains("content-box") && !m_options["content-box"].isEmpty();
     }
 
-    bool hasContentDeviation() const {
-        return contains("content-deviation") && !m_options["content-deviation"].isEmpty();
-    }
-
     bool hasContentDetection() const {
         return !contains("disable-content-detection");
     }
@@ -221,6 +218,10 @@ public:
         return contains("dewarping");
     }
 
+    bool hasPyramidTracing() const {
+        return contains("pyramid-tracing");
+    }
+
     bool hasMatchLayoutTolerance() const {
         return contains("match-layout-tolerance") && !m_options["match-layout-tolerance"].isEmpty();
     }
@@ -257,6 +258,26 @@ public:
         return contains("disable-check-output");
     }
 
+    bool hasTrace() const {
+        return contains("trace") && !m_options["trace"].isEmpty();
+    }
+
+    bool hasDaemon() const {
+        return contains("daemon") && !m_options["daemon"].isEmpty();
+    }
+
+    bool hasDaemonJobs() const {
+        return contains("daemon-jobs") && !m_options["daemon-jobs"].isEmpty();
+    }
+
+    bool hasConnect() const {
+        return contains("connect") && !m_options["connect"].isEmpty();
+    }
+
+    bool hasCancelJob() const {
+        return contains("cancel") && !m_options["cancel"].isEmpty();
+    }
+
     page_split::LayoutType getLayout() const {
         return m_layoutType;
     }
@@ -297,10 +318,6 @@ public:
         return m_defaultMargins;
     }
 
-    Margins getPageBorders() const {
-        return m_pageBorders;
-    }
-
     page_layout::Alignment getAlignment() const {
         return m_alignment;
     }
@@ -313,10 +330,6 @@ public:
         return m_contentRect;
     }
 
-    double getContentDeviation() const {
-        return m_contentDeviation;
-    }
-
     Orientation getOrientation() const {
         return m_orientation;
     }
@@ -333,10 +346,6 @@ public:
         return m_deskewMode;
     }
 
-    double getSkewDeviation() const {
-        return m_skewDeviation;
-    }
-
     int getStartFilterIdx() const {
         return m_startFilterIdx;
     }
@@ -369,6 +378,26 @@ public:
         return m_windowTitle;
     }
 
+    QString getTraceFile() const {
+        return m_options["trace"];
+    }
+
+    QString getDaemonSocket() const {
+        return m_options["daemon"];
+    }
+
+    int getDaemonJobs() const {
+        return m_options["daemon-jobs"].toInt();
+    }
+
+    QString getConnectSocket() const {
+        return m_options["connect"];
+    }
+
+    int getCancelJob() const {
+        return m_options["cancel"].toInt();
+    }
+
     QSizeF getPageDetectionBox() const {
         return m_pageDetectionBox;
     }
@@ -395,6 +424,7 @@ private:
 
     static CommandLine m_globalInstance;
     bool m_error;
+    QStringList m_errors;
     bool m_gui;
     bool m_global;
     QString m_language;
@@ -432,16 +462,13 @@ private:
     Dpi m_defaultOutputDpi;
     Margins m_margins;
     Margins m_defaultMargins;
-    Margins m_pageBorders;
     page_layout::Alignment m_alignment;
     Despeckle::Level m_contentDetection;
     QRectF m_contentRect;
-    double m_contentDeviation{ 1.0 };
     Orientation m_orientation;
     int m_threshold{ 0 };
     double m_deskewAngle{ 0.0 };
     AutoManualMode m_deskewMode;
-    double m_skewDeviation{ 5.0 };
     int m_startFilterIdx{ 0 };
     int m_endFilterIdx{ 5 };
     output::DewarpingOptions m_dewarpingOptions;
@@ -451,6 +478,8 @@ private:
 
     bool parseCli(const QStringList& argv);
 
+    void addError(const QString& message);
+
     void addImage(const QString& path);
 
     void setup();
@@ -469,18 +498,12 @@ private:
 
     Margins fetchMargins(QString base = "margins", Margins def = Margins(10.0, 5.0, 10.0, 5.0));
 
-    Margins fetchPageBorders() {
-        return fetchMargins("page-borders", Margins(0, 0, 0, 0));
-    }
-
     page_layout::Alignment fetchAlignment();
 
     Despeckle::Level fetchContentDetection();
 
     QRectF fetchContentRect();
 
-    double fetchContentDeviation();
-
     Orientation fetchOrientation();
 
     QString fetchOutputProjectFile();
@@ -491,8 +514,6 @@ private:
 
     AutoManualMode fetchDeskewMode();
 
-    double fetchSkewDeviation();
-
     int fetchStartFilterIdx();
 
     int fetchEndFilterIdx();
@@ -509,7 +530,7 @@ private:
 
     QString fetchWindowTitle() const;
 
-    QSizeF fetchPageDetectionBox() const;
+    QSizeF fetchPageDetectionBox();
 
     double fetchPageDetectionTolerance() const;
 
@@ -21,6 +21,9 @@
 #include <vector>
 #include <iostream>
 #include <cassert>
+#include <stdexcept>
+#include <QFile>
+#include <QImage>
 
 #include "Utils.h"
 #include "ProjectPages.h"
@@ -33,6 +36,7 @@
 #include "LoadFileTask.h"
 #include "ProjectWriter.h"
 #include "ProjectReader.h"
+#include "TiffWriter.h"
 
 #include "filters/fix_orientation/Settings.h"
 #include "filters/fix_orientation/Task.h"
@@ -54,8 +58,10 @@
 
 ConsoleBatch::ConsoleBatch(const std::vector<ImageFileInfo>& images,
                            const QString& output_directory,
-                           const Qt::LayoutDirection layout)
-        : batch(true),
+                           const Qt::LayoutDirection layout,
+                           const CommandLine& cli)
+        : m_cli(cli),
+          batch(true),
           debug(true),
           m_ptrDisambiguator(new FileNameDisambiguator),
           m_ptrPages(new ProjectPages(images, ProjectPages::AUTO_PAGES, layout)) {
@@ -66,8 +72,9 @@ ConsoleBatch::ConsoleBatch(const std::vector<ImageFileInfo>& images,
     m_outFileNameGen = OutputFileNameGenerator(m_ptrDisambiguator, output_directory, m_ptrPages->layoutDirection());
 }
 
-ConsoleBatch::ConsoleBatch(const QString project_file)
-        : batch(true),
+ConsoleBatch::ConsoleBatch(const QString project_file, const CommandLine& cli)
+        : m_cli(cli),
+          batch(true),
           debug(true) {
     QFile file(project_file);
     if (!file.open(QIODevice::ReadOnly)) {
@@ -90,7 +97,7 @@ ConsoleBatch::ConsoleBatch(const QString project_file)
     m_ptrStages = intrusive_ptr<StageSequence>(new StageSequence(m_ptrPages, accessor));
     m_ptrReader->readFilterSettings(m_ptrStages->filters());
 
-    const CommandLine& cli = CommandLine::get();
+    const CommandLine& cli = m_cli;
     QString output_directory = m_ptrReader->outputDirectory();
     if (!cli.outputDirectory().isEmpty()) {
         output_directory = cli.outputDirectory();
@@ -159,8 +166,10 @@ BackgroundTaskPtr ConsoleBatch::createCompositeTask(const PageInfo& page, const
 } // ConsoleBatch::createCompositeTask
 
 // process the image vector **images** and save output to **output_dir**
-void ConsoleBatch::process() {
-    const CommandLine& cli = CommandLine::get();
+void ConsoleBatch::process(ProgressListener* const listener) {
+    const CommandLine& cli = m_cli;
+
+    TiffWriter::reloadSettings();
 
     int startFilterIdx = m_ptrStages->fixOrientationFilterIdx();
     if (cli.hasStartFilterIdx()) {
@@ -185,15 +194,18 @@ void ConsoleBatch::process() {
             std::cout << "Filter: " << (j + 1) << "\n";
         }
 
-        PageSequence page_sequence = m_ptrPages->toPageSequence(PAGE_VIEW);
-        setupFilter(j, page_sequence.selectAll());
-        for (unsigned i = 0; i < page_sequence.numPages(); i++) {
-            PageInfo page = page_sequence.pageAt(i);
+        const std::vector<PageTask> tasks(createFilterTasks(j));
+        const auto num_pages = static_cast<int>(tasks.size());
+        for (int i = 0; i < num_pages; i++) {
+            const PageTask& page_task = tasks[i];
             if (cli.isVerbose()) {
-                std::cout << "\tProcessing: " << page.imageId().filePath().toLatin1().constData() << "\n";
+                std::cout << "\tProcessing: " << page_task.page.imageId().filePath().toLatin1().constData() << "\n";
+            }
+            if (listener) {
+                listener->pageStarted(j, i, num_pages, page_task.task);
             }
-            BackgroundTaskPtr bgTask = createCompositeTask(page, j);
-            (*bgTask)();
+            (*page_task.task)();
+            page_task.task->throwIfCancelled();
         }
     }
 
@@ -201,11 +213,21 @@ void ConsoleBatch::process() {
         PageSequence page_sequence = m_ptrPages->toPageSequence(PAGE_VIEW);
         setupFilter(j, page_sequence.selectAll());
     }
+} // ConsoleBatch::process
+
+std::vector<ConsoleBatch::PageTask> ConsoleBatch::createFilterTasks(const int filter_idx) {
+    PageSequence page_sequence = m_ptrPages->toPageSequence(PAGE_VIEW);
+    setupFilter(filter_idx, page_sequence.selectAll());
 
-    for (int j = 0; j <= endFilterIdx; j++) {
-        m_ptrStages->filterAt(j)->updateStatistics();
+    std::vector<PageTask> tasks;
+    tasks.reserve(page_sequence.numPages());
+    for (unsigned i = 0; i < page_sequence.numPages(); i++) {
+        const PageInfo page(page_sequence.pageAt(i));
+        tasks.push_back(PageTask{page, createCompositeTask(page, filter_idx)});
     }
-} // ConsoleBatch::process
+
+    return tasks;
+}
 
 void ConsoleBatch::saveProject(const QString project_file) {
     PageInfo fpage = m_ptrPages->toPageSequence(PAGE_VIEW).pageAt(0);
@@ -214,6 +236,10 @@ void ConsoleBatch::saveProject(const QString project_file) {
     writer.write(project_file, m_ptrStages->filters());
 }
 
+void ConsoleBatch::setThumbnailCache(const intrusive_ptr<ThumbnailPixmapCache>& thumbnail_cache) {
+    m_ptrThumbnailCache = thumbnail_cache;
+}
+
 void ConsoleBatch::setupFilter(int idx, std::set<PageId> allPages) {
     if (idx == m_ptrStages->fixOrientationFilterIdx()) {
         setupFixOrientation(allPages);
@@ -232,7 +258,7 @@ void ConsoleBatch::setupFilter(int idx, std::set<PageId> allPages) {
 
 void ConsoleBatch::setupFixOrientation(std::set<PageId> allPages) {
     intrusive_ptr<fix_orientation::Filter> fix_orientation = m_ptrStages->fixOrientationFilter();
-    const CommandLine& cli = CommandLine::get();
+    const CommandLine& cli = m_cli;
 
     for (std::set<PageId>::iterator i = allPages.begin(); i != allPages.end(); i++) {
         PageId page = *i;
@@ -261,7 +287,7 @@ void ConsoleBatch::setupFixOrientation(std::set<PageId> allPages) {
 
 void ConsoleBatch::setupPageSplit(std::set<PageId> allPages) {
     intrusive_ptr<page_split::Filter> page_split = m_ptrStages->pageSplitFilter();
-    const CommandLine& cli = CommandLine::get();
+    const CommandLine& cli = m_cli;
 
     // PAGE SPLIT
     if (cli.hasLayout()) {
@@ -271,7 +297,7 @@ void ConsoleBatch::setupPageSplit(std::set<PageId> allPages) {
 
 void ConsoleBatch::setupDeskew(std::set<PageId> allPages) {
     intrusive_ptr<deskew::Filter> deskew = m_ptrStages->deskewFilter();
-    const CommandLine& cli = CommandLine::get();
+    const CommandLine& cli = m_cli;
 
     for (std::set<PageId>::iterator i = allPages.begin(); i != allPages.end(); i++) {
         PageId page = *i;
@@ -287,15 +313,11 @@ void ConsoleBatch::setupDeskew(std::set<PageId> allPages) {
             deskew->getSettings()->setPageParams(page, params);
         }
     }
-
-    if (cli.hasSkewDeviation()) {
-        deskew->getSettings()->setMaxDeviation(cli.getSkewDeviation());
-    }
 }
 
 void ConsoleBatch::setupSelectContent(std::set<PageId> allPages) {
     intrusive_ptr<select_content::Filter> select_content = m_ptrStages->selectContentFilter();
-    const CommandLine& cli = CommandLine::get();
+    const CommandLine& cli = m_cli;
 
     for (std::set<PageId>::iterator i = allPages.begin(); i != allPages.end(); i++) {
         PageId page = *i;
@@ -315,17 +337,10 @@ void ConsoleBatch::setupSelectContent(std::set<PageId> allPages) {
         params.setContentDetect(cli.isContentDetectionEnabled());
         params.setPageDetect(cli.isPageDetectionEnabled());
         params.setFineTuneCorners(cli.isFineTuningEnabled());
-        if (cli.hasPageBorders()) {
-            params.setPageBorders(cli.getPageBorders());
-        }
 
         select_content->getSettings()->setPageParams(page, params);
     }
 
-    if (cli.hasContentDeviation()) {
-        select_content->getSettings()->setMaxDeviation(cli.getContentDeviation());
-    }
-
     if (cli.hasPageDetectionBox()) {
         select_content->getSettings()->setPageDetectionBox(cli.getPageDetectionBox());
     }
@@ -337,7 +352,7 @@ void ConsoleBatch::setupSelectContent(std::set<PageId> allPages) {
 
 void ConsoleBatch::setupPageLayout(std::set<PageId> allPages) {
     intrusive_ptr<page_layout::Filter> page_layout = m_ptrStages->pageLayoutFilter();
-    const CommandLine& cli = CommandLine::get();
+    const CommandLine& cli = m_cli;
     QMap<QString, float> img_cache;
 
     for (std::set<PageId>::iterator i = allPages.begin(); i != allPages.end(); i++) {
@@ -389,7 +404,7 @@ void ConsoleBatch::setupPageLayout(std::set<PageId> allPages) {
 
 void ConsoleBatch::setupOutput(std::set<PageId> allPages) {
     intrusive_ptr<output::Filter> output = m_ptrStages->outputFilter();
-    const CommandLine& cli = CommandLine::get();
+    const CommandLine& cli = m_cli;
 
     for (std::set<PageId>::iterator i = allPages.begin(); i != allPages.end(); i++) {
         PageId page = *i;
@@ -402,7 +417,9 @@ void ConsoleBatch::setupOutput(std::set<PageId> allPages) {
         }
 
         if (cli.hasPictureShape()) {
-            params.setPictureShape(cli.getPictureShape());
+            output::PictureShapeOptions pictureShapeOptions = params.pictureShapeOptions();
+            pictureShapeOptions.setPictureShape(cli.getPictureShape());
+            params.setPictureShapeOptions(pictureShapeOptions);
         }
 
         output::ColorParams colorParams = params.colorParams();
@@ -434,7 +451,11 @@ void ConsoleBatch::setupOutput(std::set<PageId> allPages) {
         }
 
         if (cli.hasDewarping()) {
-            params.setDewarpingMode(cli.getDewarpingMode());
+            params.setDewarpingOptions(cli.getDewarpingMode());
+        } else if (cli.hasPyramidTracing()) {
+            output::DewarpingOptions dewarpingOptions = params.dewarpingOptions();
+            dewarpingOptions.setPyramidTracing(true);
+            params.setDewarpingOptions(dewarpingOptions);
         }
         if (cli.hasDepthPerception()) {
             params.setDepthPerception(cli.getDepthPerception());
@@ -26,6 +26,7 @@
 
 #include "intrusive_ptr.h"
 #include "BackgroundTask.h"
+#include "CommandLine.h"
 #include "FilterResult.h"
 #include "OutputFileNameGenerator.h"
 #include "PageId.h"
@@ -43,17 +44,65 @@
 class ConsoleBatch {
     // Member-wise copying is OK.
 public:
-    ConsoleBatch(const std::vector<ImageFileInfo>& images,
-                 const QString& output_directory,
-                 const Qt::LayoutDirection layout);
+    /**
+     * \brief Gets notified about the progress of process().
+     */
+    class ProgressListener {
+    public:
+        virtual ~ProgressListener() = default;
+
+        /**
+         * \brief Called right before \p task runs page \p page_idx out of \p num_pages
+         *        through the filters up to \p filter_idx.
+         *
+         * Cancelling \p task, which may be done from any thread, stops process()
+         * with BackgroundTask::CancelledException.
+         */
+        virtual void pageStarted(int filter_idx, int page_idx, int num_pages, const BackgroundTaskPtr& task) = 0;
+    };
 
-    ConsoleBatch(const QString project_file);
 
-    void process();
+    ConsoleBatch(const std::vector<ImageFileInfo>& images,
+                 const QString& output_directory,
+                 const Qt::LayoutDirection layout,
+                 const CommandLine& cli = CommandLine::get());
+
+    ConsoleBatch(const QString project_file, const CommandLine& cli = CommandLine::get());
+
+    void process(ProgressListener* listener = nullptr);
+
+    /**
+     * \brief A page together with the task that runs it through the filters.
+     */
+    struct PageTask {
+        PageInfo page;
+        BackgroundTaskPtr task;
+    };
+
+    /**
+     * \brief Applies the command line settings to the filter at \p filter_idx
+     *        and creates tasks that run every page through the filters up to it.
+     *
+     * The tasks follow the order of pages in the page sequence.
+     * process() runs exactly these tasks, one by one for every filter in turn.
+     */
+    std::vector<PageTask> createFilterTasks(int filter_idx);
+
+    const intrusive_ptr<StageSequence>& stages() const {
+        return m_ptrStages;
+    }
 
     void saveProject(const QString project_file);
 
+    /**
+     * \brief Replaces the thumbnail cache created by the constructor.
+     *
+     * Allows batches writing to the same output directory to share a cache.
+     */
+    void setThumbnailCache(const intrusive_ptr<ThumbnailPixmapCache>& thumbnail_cache);
+
 private:
+    CommandLine m_cli;
     bool batch;
     bool debug;
     intrusive_ptr<FileNameDisambiguator> m_ptrDisambiguator;
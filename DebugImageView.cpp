@@ -47,28 +47,28 @@ private:
 
 class DebugImageView::ImageLoader : public AbstractCommand0<BackgroundExecutor::TaskResultPtr> {
 public:
-    ImageLoader(DebugImageView* owner, const QString& file_path)
+    ImageLoader(DebugImageView* owner, const intrusive_ptr<DebugImage>& image)
             : m_ptrOwner(owner),
-              m_filePath(file_path) {
+              m_ptrImage(image) {
     }
 
     BackgroundExecutor::TaskResultPtr operator()() override {
-        QImage image(m_filePath);
+        const QImage image(m_ptrImage->load());
 
         return BackgroundExecutor::TaskResultPtr(new ImageLoadResult(m_ptrOwner, image));
     }
 
 private:
     QPointer<DebugImageView> m_ptrOwner;
-    QString m_filePath;
+    intrusive_ptr<DebugImage> m_ptrImage;
 };
 
 
-DebugImageView::DebugImageView(AutoRemovingFile file,
+DebugImageView::DebugImageView(const intrusive_ptr<DebugImage>& image,
                                boost::function<QWidget*(const QImage&)>const & image_view_factory,
                                QWidget* parent)
         : QStackedWidget(parent),
-          m_file(file),
+          m_ptrImage(image),
           m_imageViewFactory(image_view_factory),
           m_pPlaceholderWidget(new ProcessingIndicationWidget(this)),
           m_isLive(false) {
@@ -78,7 +78,7 @@ DebugImageView::DebugImageView(AutoRemovingFile file,
 void DebugImageView::setLive(const bool live) {
     if (live && !m_isLive) {
         ImageViewBase::backgroundExecutor().enqueueTask(
-                BackgroundExecutor::TaskPtr(new ImageLoader(this, m_file.get()))
+                BackgroundExecutor::TaskPtr(new ImageLoader(this, m_ptrImage))
         );
     } else if (!live && m_isLive) {
         if (QWidget* wgt = currentWidget()) {
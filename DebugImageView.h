@@ -19,7 +19,8 @@
 #ifndef DEBUG_IMAGE_VIEW_H_
 #define DEBUG_IMAGE_VIEW_H_
 
-#include "AutoRemovingFile.h"
+#include "DebugImages.h"
+#include "intrusive_ptr.h"
 #include <QStackedWidget>
 #include <QWidget>
 #include <boost/intrusive/list.hpp>
@@ -31,7 +32,7 @@ class DebugImageView : public QStackedWidget, public boost::intrusive::list_base
         boost::intrusive::link_mode<boost::intrusive::auto_unlink>
 > {
 public:
-    explicit DebugImageView(AutoRemovingFile file, boost::function<QWidget*(const QImage&)>const & image_view_factory
+    explicit DebugImageView(const intrusive_ptr<DebugImage>& image, boost::function<QWidget*(const QImage&)>const & image_view_factory
     = boost::function<QWidget*(const QImage&)>(), QWidget* parent = nullptr);
 
     /**
@@ -46,7 +47,7 @@ private:
 
     void imageLoaded(const QImage& image);
 
-    AutoRemovingFile m_file;
+    intrusive_ptr<DebugImage> m_ptrImage;
     boost::function<QWidget*(const QImage&)> m_imageViewFactory;
     QWidget* m_pPlaceholderWidget;
     bool m_isLive;
@@ -17,15 +17,74 @@
  */
 
 #include "DebugImages.h"
-#include "imageproc/BinaryImage.h"
-#include <QImage>
+#include <QAtomicInt>
+#include <QImageReader>
 #include <QImageWriter>
 #include <QTemporaryFile>
 #include <QDir>
 
-void DebugImages::add(const QImage& image,
-                      const QString& label,
-                      boost::function<QWidget*(const QImage&)>const & image_view_factory) {
+namespace {
+    /**
+     * The amount of memory all the DebugImage objects together may hold,
+     * in kilobytes.
+     */
+    const int MEMORY_BUDGET_KBYTES = 512 * 1024;
+
+    QAtomicInt g_reservedKbytes(0);
+
+    int kbytesFor(const int bytes_per_line, const int height) {
+        return static_cast<int>((static_cast<qint64>(bytes_per_line) * height + 1023) / 1024);
+    }
+}
+
+DebugImage::DebugImage(const QImage& image)
+        : m_reservedKbytes(0) {
+    if (reserveMemory(kbytesFor(image.bytesPerLine(), image.height()))) {
+        m_image = image;
+    } else {
+        writeToFile(image);
+    }
+}
+
+DebugImage::DebugImage(const imageproc::BinaryImage& image)
+        : m_reservedKbytes(0) {
+    if (reserveMemory(kbytesFor(image.wordsPerLine() * 4, image.height()))) {
+        m_bwImage = image;
+    } else {
+        writeToFile(image.toQImage());
+    }
+}
+
+DebugImage::~DebugImage() {
+    g_reservedKbytes.fetchAndAddOrdered(-m_reservedKbytes);
+}
+
+QImage DebugImage::load() const {
+    if (!m_image.isNull()) {
+        return m_image;
+    }
+    if (!m_bwImage.isNull()) {
+        return m_bwImage.toQImage();
+    }
+    if (!m_file.get().isNull()) {
+        return QImageReader(m_file.get(), "png").read();
+    }
+
+    return QImage();
+}
+
+bool DebugImage::reserveMemory(const int kbytes) {
+    if (g_reservedKbytes.fetchAndAddOrdered(kbytes) + kbytes > MEMORY_BUDGET_KBYTES) {
+        g_reservedKbytes.fetchAndAddOrdered(-kbytes);
+
+        return false;
+    }
+    m_reservedKbytes = kbytes;
+
+    return true;
+}
+
+void DebugImage::writeToFile(const QImage& image) {
     QTemporaryFile file(QDir::tempPath() + "/scantailor-dbg-XXXXXX.png");
     if (!file.open()) {
         return;
@@ -40,22 +99,34 @@ void DebugImages::add(const QImage& image,
         return;
     }
 
-    m_sequence.push_back(intrusive_ptr<Item>(new Item(arem_file, label, image_view_factory)));
+    m_file = arem_file;
+}
+
+void DebugImages::add(const QImage& image,
+                      const QString& label,
+                      boost::function<QWidget*(const QImage&)>const & image_view_factory) {
+    const intrusive_ptr<DebugImage> debug_image(new DebugImage(image));
+    if (!debug_image->isNull()) {
+        m_sequence.push_back(intrusive_ptr<Item>(new Item(debug_image, label, image_view_factory)));
+    }
 }
 
 void DebugImages::add(const imageproc::BinaryImage& image,
                       const QString& label,
                       boost::function<QWidget*(const QImage&)>const & image_view_factory) {
-    add(image.toQImage(), label, image_view_factory);
+    const intrusive_ptr<DebugImage> debug_image(new DebugImage(image));
+    if (!debug_image->isNull()) {
+        m_sequence.push_back(intrusive_ptr<Item>(new Item(debug_image, label, image_view_factory)));
+    }
 }
 
-AutoRemovingFile DebugImages::retrieveNext(QString* label,
-                                           boost::function<QWidget*(const QImage&)>* image_view_factory) {
+intrusive_ptr<DebugImage> DebugImages::retrieveNext(QString* label,
+                                                    boost::function<QWidget*(const QImage&)>* image_view_factory) {
     if (m_sequence.empty()) {
-        return AutoRemovingFile();
+        return intrusive_ptr<DebugImage>();
     }
 
-    AutoRemovingFile file(m_sequence.front()->file);
+    const intrusive_ptr<DebugImage> image(m_sequence.front()->image);
     if (label) {
         *label = m_sequence.front()->label;
     }
@@ -65,6 +136,5 @@ AutoRemovingFile DebugImages::retrieveNext(QString* label,
 
     m_sequence.pop_front();
 
-    return file;
+    return image;
 }
-
@@ -21,17 +21,58 @@
 
 #include "ref_countable.h"
 #include "intrusive_ptr.h"
+#include "NonCopyable.h"
 #include "AutoRemovingFile.h"
+#include "imageproc/BinaryImage.h"
 #include <boost/function.hpp>
+#include <QImage>
 #include <QString>
 #include <deque>
 
-class QImage;
 class QWidget;
 
-namespace imageproc {
-    class BinaryImage;
-}
+/**
+ * \brief A debug image, kept in memory while a global memory budget allows.
+ *
+ * Images are held by reference (both QImage and BinaryImage are implicitly
+ * shared) and converted only when displayed.  Once the budget is exhausted,
+ * further images are written to temporary files instead.
+ */
+class DebugImage : public ref_countable {
+DECLARE_NON_COPYABLE(DebugImage)
+
+public:
+    explicit DebugImage(const QImage& image);
+
+    explicit DebugImage(const imageproc::BinaryImage& image);
+
+    ~DebugImage() override;
+
+    /**
+     * \brief Returns the image, loading or converting it if necessary.
+     *
+     * May be called from any thread.
+     */
+    QImage load() const;
+
+    /**
+     * \brief Returns true if the image couldn't be stored.
+     */
+    bool isNull() const {
+        return m_image.isNull() && m_bwImage.isNull() && m_file.get().isNull();
+    }
+
+private:
+    bool reserveMemory(int kbytes);
+
+    void writeToFile(const QImage& image);
+
+    QImage m_image;
+    imageproc::BinaryImage m_bwImage;
+    AutoRemovingFile m_file;
+    int m_reservedKbytes;
+};
+
 
 /**
  * \brief A sequence of image + label pairs.
@@ -57,19 +98,21 @@ public:
      *
      * The label and viewer widget factory (that may not be bound)
      * are returned by taking pointers to them as arguments.
-     * Returns a null AutoRemovingFile if image sequence is empty.
+     * Returns a null pointer if image sequence is empty.
      */
-    AutoRemovingFile
+    intrusive_ptr<DebugImage>
     retrieveNext(QString* label = nullptr, boost::function<QWidget*(const QImage&)>* image_view_factory = nullptr);
 
 private:
     struct Item : public ref_countable {
-        AutoRemovingFile file;
+        intrusive_ptr<DebugImage> image;
         QString label;
         boost::function<QWidget*(const QImage&)> imageViewFactory;
 
-        Item(AutoRemovingFile f, const QString& l, boost::function<QWidget*(const QImage&)>const & imf)
-                : file(f),
+        Item(const intrusive_ptr<DebugImage>& img,
+             const QString& l,
+             boost::function<QWidget*(const QImage&)>const & imf)
+                : image(img),
                   label(l),
                   imageViewFactory(imf) {
         }
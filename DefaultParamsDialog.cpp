@@ -345,6 +345,7 @@ void DefaultParamsDialog::updateOutputDisplay(const DefaultParams::OutputParams&
             dewarpingModeCB->findData(params.getDewarpingOptions().dewarpingMode())
     );
     dewarpingPostDeskewCB->setChecked(params.getDewarpingOptions().needPostDeskew());
+    dewarpingPyramidTracingCB->setChecked(params.getDewarpingOptions().needPyramidTracing());
     depthPerceptionSlider->setValue(qRound(params.getDepthPerception().value() * 10));
 
     // update the display
@@ -756,6 +757,7 @@ std::unique_ptr<DefaultParams> DefaultParamsDialog::buildParams() const {
     DewarpingOptions dewarpingOptions;
     dewarpingOptions.setDewarpingMode(static_cast<DewarpingMode>(dewarpingModeCB->currentData().toInt()));
     dewarpingOptions.setPostDeskew(dewarpingPostDeskewCB->isChecked());
+    dewarpingOptions.setPyramidTracing(dewarpingPyramidTracingCB->isChecked());
 
     DespeckleLevel despeckleLevel;
     if (despeckleAggressiveBtn->isChecked()) {
@@ -23,7 +23,10 @@
 #include "FastQueue.h"
 #include "imageproc/BinaryImage.h"
 #include "imageproc/ConnectivityMap.h"
-#include <unordered_map>
+#include "Tracer.h"
+#include "ParallelFor.h"
+#include <algorithm>
+#include <vector>
 #include <QImage>
 #include <QDebug>
 
@@ -258,15 +261,35 @@ namespace {
             return (lesser_label == other.lesser_label)
                    && (greater_label == other.greater_label);
         }
+    };
+
+/**
+ * \brief A connection together with the squared distance between the components.
+ */
+    struct ConnectionDistance {
+        Connection conn;
+        uint32_t sqdist;
+
+        ConnectionDistance(uint32_t lbl1, uint32_t lbl2, uint32_t sqd)
+                : conn(lbl1, lbl2),
+                  sqdist(sqd) {
+        }
 
-        struct hash {
-            std::size_t operator()(const Connection& connection) const noexcept {
-                return std::hash<int>()(connection.lesser_label)
-                       ^ std::hash<int>()(connection.greater_label << 1);
+        /**
+         * The ordering is by connection then distance, so that the
+         * first entry for a connection carries the minimum distance.
+         */
+        bool operator<(const ConnectionDistance& rhs) const {
+            if (conn == rhs.conn) {
+                return sqdist < rhs.sqdist;
             }
-        };
+
+            return conn < rhs.conn;
+        }
     };
 
+    typedef std::vector<ConnectionDistance> Connections;
+
 /**
  * \brief A directional assiciation between two connected components.
  */
@@ -299,22 +322,27 @@ namespace {
     };
 
 /**
- * \brief If the association didn't exist, create it,
- *        otherwise the minimum distance.
+ * The number of pixels per parallelFor() chunk of row-wise passes.
  */
-    void updateDistance(std::unordered_map<Connection, uint32_t, Connection::hash>& conns,
-                        uint32_t label1,
-                        uint32_t label2,
-                        uint32_t sqdist) {
-        typedef std::unordered_map<Connection, uint32_t, Connection::hash> Connections;
-
-        const Connection conn(label1, label2);
-        auto it(conns.find(conn));
-        if (it == conns.end()) {
-            conns.insert(Connections::value_type(conn, sqdist));
-        } else if (sqdist < it->second) {
-            it->second = sqdist;
-        }
+    const int PIXELS_PER_CHUNK = 1 << 18;
+
+    int rowsPerChunk(const int width) {
+        return std::max(1, PIXELS_PER_CHUNK / std::max(width, 1));
+    }
+
+/**
+ * \brief Leaves a single entry per connection, the one with the minimum distance.
+ *
+ * The entries end up sorted by connection.
+ */
+    void reduceConnections(Connections& conns) {
+        std::sort(conns.begin(), conns.end());
+        conns.erase(
+                std::unique(conns.begin(), conns.end(), [](const ConnectionDistance& lhs, const ConnectionDistance& rhs) {
+                    return lhs.conn == rhs.conn;
+                }),
+                conns.end()
+        );
     }
 
 /**
@@ -642,45 +670,77 @@ namespace {
 
 /**
  * Calculate the minimum distance between components from neighboring
- * Voronoi segments.
+ * Voronoi segments and merge them into \p conns.
+ *
+ * Rows are processed in parallel.  Every chunk of rows collects its own
+ * connections, reducing them as it goes to keep memory bounded.
  */
     void voronoiDistances(const ConnectivityMap& cmap,
                           const std::vector<Distance>& distance_matrix,
-                          std::unordered_map<Connection, uint32_t, Connection::hash>& conns) {
+                          Connections& conns) {
         const int width = cmap.size().width();
         const int height = cmap.size().height();
+        const int stride = cmap.stride();
 
-        const int offsets[] = { -cmap.stride(), -1, 1, cmap.stride() };
+        const int offsets[] = { -stride, -1, 1, stride };
 
         const uint32_t* const cmap_data = cmap.data();
         const Distance* const distance_data = &distance_matrix[0] + width + 3;
-        for (int y = 0, offset = 0; y < height; ++y, offset += 2) {
-            for (int x = 0; x < width; ++x, ++offset) {
-                const uint32_t label = cmap_data[offset];
-                assert(label != 0);
-
-                const int x1 = x + distance_data[offset].vec.x;
-                const int y1 = y + distance_data[offset].vec.y;
-
-                for (int i : offsets) {
-                    const int nbh_offset = offset + i;
-                    const uint32_t nbh_label = cmap_data[nbh_offset];
-                    if ((nbh_label == 0) || (nbh_label == label)) {
-                        // label 0 can be encountered in
-                        // padding lines.
-                        continue;
-                    }
 
-                    const int x2 = x + distance_data[nbh_offset].vec.x;
-                    const int y2 = y + distance_data[nbh_offset].vec.y;
-                    const int dx = x1 - x2;
-                    const int dy = y1 - y2;
-                    const uint32_t sqdist = dx * dx + dy * dy;
+        const int rows_per_chunk = rowsPerChunk(width);
+        std::vector<Connections> chunk_conns((height + rows_per_chunk - 1) / rows_per_chunk);
+        parallelFor(0, height, rows_per_chunk, [&](const int first_row, const int last_row) {
+            Connections& local_conns = chunk_conns[first_row / rows_per_chunk];
+            size_t reduce_threshold = size_t(width) * 4;
+
+            for (int y = first_row; y < last_row; ++y) {
+                int offset = y * stride;
+                for (int x = 0; x < width; ++x, ++offset) {
+                    const uint32_t label = cmap_data[offset];
+                    assert(label != 0);
+
+                    const int x1 = x + distance_data[offset].vec.x;
+                    const int y1 = y + distance_data[offset].vec.y;
+
+                    for (int i : offsets) {
+                        const int nbh_offset = offset + i;
+                        const uint32_t nbh_label = cmap_data[nbh_offset];
+                        if ((nbh_label == 0) || (nbh_label == label)) {
+                            // label 0 can be encountered in
+                            // padding lines.
+                            continue;
+                        }
+
+                        const int x2 = x + distance_data[nbh_offset].vec.x;
+                        const int y2 = y + distance_data[nbh_offset].vec.y;
+                        const int dx = x1 - x2;
+                        const int dy = y1 - y2;
+                        const uint32_t sqdist = dx * dx + dy * dy;
+
+                        local_conns.emplace_back(label, nbh_label, sqdist);
+                    }
+                }
 
-                    updateDistance(conns, label, nbh_label, sqdist);
+                if (local_conns.size() >= reduce_threshold) {
+                    reduceConnections(local_conns);
+                    reduce_threshold = std::max(reduce_threshold, local_conns.size() * 2);
                 }
             }
+
+            reduceConnections(local_conns);
+        });
+
+        size_t total_conns = conns.size();
+        for (const Connections& local_conns : chunk_conns) {
+            total_conns += local_conns.size();
+        }
+        conns.reserve(total_conns);
+        for (Connections& local_conns : chunk_conns) {
+            conns.insert(conns.end(), local_conns.begin(), local_conns.end());
+            Connections().swap(local_conns);
         }
+
+        reduceConnections(conns);
     }  // voronoiDistances
 }  // namespace
 
@@ -700,6 +760,8 @@ void Despeckle::despeckleInPlace(BinaryImage& image,
                                  const Level level,
                                  const TaskStatus& status,
                                  DebugImages* const dbg) {
+    const TraceSpan span("imageproc", "Despeckle::despeckleInPlace");
+
     const Settings settings(Settings::get(level, dpi));
 
     ConnectivityMap cmap(image, CONN8);
@@ -760,13 +822,14 @@ void Despeckle::despeckleInPlace(BinaryImage& image,
 
     const uint32_t max_label = next_avail_component - 1;
     // Remapping individual pixels.
-    cmap_line = cmap_data;
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            cmap_line[x] = remapping_table[cmap_line[x]];
+    parallelFor(0, height, rowsPerChunk(width), [&](const int first_row, const int last_row) {
+        uint32_t* line = cmap_data + first_row * cmap_stride;
+        for (int y = first_row; y < last_row; ++y, line += cmap_stride) {
+            for (int x = 0; x < width; ++x) {
+                line[x] = remapping_table[line[x]];
+            }
         }
-        cmap_line += cmap_stride;
-    }
+    });
     if (dbg) {
         dbg->add(cmap.visualized(), "big_components_unified");
     }
@@ -785,8 +848,6 @@ void Despeckle::despeckleInPlace(BinaryImage& image,
 
     // Now build a bidirectional map of distances between neighboring
     // connected components.
-
-    typedef std::unordered_map<Connection, uint32_t, Connection::hash> Connections;  // conn -> sqdist
     Connections conns;
 
     voronoiDistances(cmap, distance_matrix, conns);
@@ -794,13 +855,11 @@ void Despeckle::despeckleInPlace(BinaryImage& image,
     status.throwIfCancelled();
 
     // Tag connected components with ANCHORED_TO_BIG or ANCHORED_TO_SMALL.
-    for (const Connections::value_type& pair : conns) {
-        const Connection conn(pair.first);
-        const uint32_t sqdist = pair.second;
-        Component& comp1 = components[conn.lesser_label];
-        Component& comp2 = components[conn.greater_label];
-        tagSourceComponent(comp1, comp2, sqdist, settings);
-        tagSourceComponent(comp2, comp1, sqdist, settings);
+    for (const ConnectionDistance& conn_dist : conns) {
+        Component& comp1 = components[conn_dist.conn.lesser_label];
+        Component& comp2 = components[conn_dist.conn.greater_label];
+        tagSourceComponent(comp1, comp2, conn_dist.sqdist, settings);
+        tagSourceComponent(comp2, comp1, conn_dist.sqdist, settings);
     }
 
     // Prevent it from growing when we compute the Voronoi diagram
@@ -821,27 +880,30 @@ void Despeckle::despeckleInPlace(BinaryImage& image,
 
         const Distance zero_distance(Distance::zero());
         const Distance special_distance(Distance::special());
-        for (int y = 0, offset = 0; y < height; ++y, offset += 2) {
-            for (int x = 0; x < width; ++x, ++offset) {
-                const uint32_t label = cmap_data[offset];
-                assert(label != 0);
-
-                const Component& comp = components[label];
-                if (!comp.anchoredToSmallButNotBig()) {
-                    if (distance_data[offset] == zero_distance) {
-                        // Prevent this region from growing
-                        // and from being taken over by another
-                        // by another region.
-                        distance_data[offset] = special_distance;
-                    } else {
-                        // Allow this region to be taken over by others.
-                        // Note: x + 1 here is equivalent to x
-                        // in voronoi() or voronoiSpecial().
-                        distance_data[offset].reset(x + 1);
+        parallelFor(0, height, rowsPerChunk(width), [&](const int first_row, const int last_row) {
+            for (int y = first_row; y < last_row; ++y) {
+                int offset = y * cmap_stride;
+                for (int x = 0; x < width; ++x, ++offset) {
+                    const uint32_t label = cmap_data[offset];
+                    assert(label != 0);
+
+                    const Component& comp = components[label];
+                    if (!comp.anchoredToSmallButNotBig()) {
+                        if (distance_data[offset] == zero_distance) {
+                            // Prevent this region from growing
+                            // and from being taken over by another
+                            // by another region.
+                            distance_data[offset] = special_distance;
+                        } else {
+                            // Allow this region to be taken over by others.
+                            // Note: x + 1 here is equivalent to x
+                            // in voronoi() or voronoiSpecial().
+                            distance_data[offset].reset(x + 1);
+                        }
                     }
                 }
             }
-        }
+        });
 
         status.throwIfCancelled();
 
@@ -872,23 +934,21 @@ void Despeckle::despeckleInPlace(BinaryImage& image,
     // Build a directional connection map and only include
     // good connections, that is those with a small enough
     // distance.
-    // While at it, clear the bidirectional connection map.
+    // After that, clear the bidirectional connection map.
     std::vector<TargetSourceConn> target_source;
-    while (!conns.empty()) {
-        const auto it(conns.begin());
-        const uint32_t label1 = it->first.lesser_label;
-        const uint32_t label2 = it->first.greater_label;
-        const uint32_t sqdist = it->second;
+    for (const ConnectionDistance& conn_dist : conns) {
+        const uint32_t label1 = conn_dist.conn.lesser_label;
+        const uint32_t label2 = conn_dist.conn.greater_label;
         const Component& comp1 = components[label1];
         const Component& comp2 = components[label2];
-        if (canBeAttachedTo(comp1, comp2, sqdist, settings)) {
+        if (canBeAttachedTo(comp1, comp2, conn_dist.sqdist, settings)) {
             target_source.emplace_back(label2, label1);
         }
-        if (canBeAttachedTo(comp2, comp1, sqdist, settings)) {
+        if (canBeAttachedTo(comp2, comp1, conn_dist.sqdist, settings)) {
             target_source.emplace_back(label1, label2);
         }
-        conns.erase(it);
     }
+    Connections().swap(conns);
 
     std::sort(target_source.begin(), target_source.end());
 
@@ -937,17 +997,20 @@ void Despeckle::despeckleInPlace(BinaryImage& image,
     status.throwIfCancelled();
     // Remove unmarked components from the binary image.
     const uint32_t msb = uint32_t(1) << 31;
-    uint32_t* image_line = image.data();
+    uint32_t* const image_data = image.data();
     const int image_stride = image.wordsPerLine();
-    cmap_line = cmap_data;
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            if (!components[cmap_line[x]].anchoredToBig()) {
-                image_line[x >> 5] &= ~(msb >> (x & 31));
+    parallelFor(0, height, rowsPerChunk(width), [&](const int first_row, const int last_row) {
+        uint32_t* image_line = image_data + first_row * image_stride;
+        const uint32_t* line = cmap_data + first_row * cmap_stride;
+        for (int y = first_row; y < last_row; ++y) {
+            for (int x = 0; x < width; ++x) {
+                if (!components[line[x]].anchoredToBig()) {
+                    image_line[x >> 5] &= ~(msb >> (x & 31));
+                }
             }
+            image_line += image_stride;
+            line += cmap_stride;
         }
-        image_line += image_stride;
-        cmap_line += cmap_stride;
-    }
+    });
 } // Despeckle::despeckleInPlace
 
@@ -33,6 +33,7 @@
 #include "imageproc/GrayRasterOp.h"
 #include "imageproc/RasterOpGeneric.h"
 #include "imageproc/SeedFill.h"
+#include "Tracer.h"
 #include <QDebug>
 #include <boost/lambda/lambda.hpp>
 #include <boost/lambda/bind.hpp>
@@ -164,6 +165,8 @@ imageproc::PolynomialSurface estimateBackground(const GrayImage& input,
                                                 const QPolygonF& area_to_consider,
                                                 const TaskStatus& status,
                                                 DebugImages* dbg) {
+    const TraceSpan span("imageproc", "estimateBackground");
+
     QSize reduced_size(input.size());
     reduced_size.scale(300, 300, Qt::KeepAspectRatio);
     GrayImage background(scaleToGray(GrayImage(input), reduced_size));
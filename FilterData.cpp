@@ -36,6 +36,8 @@ FilterData::FilterData(const QImage& image)
         blackPixelsCount += grayscaleHistogram[level];
     }
     m_blackOnWhite = (2 * blackPixelsCount < m_grayImage.width() * m_grayImage.height());
+
+    m_ptrAnalysisPyramid.reset(new AnalysisPyramid(m_grayImage, Dpm(image), m_bwThreshold, m_blackOnWhite));
 }
 
 FilterData::FilterData(const FilterData& other, const ImageTransformation& xform)
@@ -43,7 +45,8 @@ FilterData::FilterData(const FilterData& other, const ImageTransformation& xform
           m_grayImage(other.m_grayImage),
           m_xform(xform),
           m_bwThreshold(other.m_bwThreshold),
-          m_blackOnWhite(other.m_blackOnWhite) {
+          m_blackOnWhite(other.m_blackOnWhite),
+          m_ptrAnalysisPyramid(other.m_ptrAnalysisPyramid) {
 }
 
 imageproc::BinaryThreshold FilterData::bwThreshold() const {
@@ -66,3 +69,6 @@ bool FilterData::isBlackOnWhite() const {
     return m_blackOnWhite;
 }
 
+const AnalysisPyramid& FilterData::analysisPyramid() const {
+    return *m_ptrAnalysisPyramid;
+}
@@ -22,7 +22,9 @@
 #include "imageproc/BinaryThreshold.h"
 #include "imageproc/GrayImage.h"
 #include "ImageTransformation.h"
+#include "AnalysisPyramid.h"
 #include <QImage>
+#include <memory>
 
 class FilterData {
     // Member-wise copying is OK.
@@ -41,12 +43,21 @@ public:
 
     bool isBlackOnWhite() const;
 
+    /**
+     * \brief Reduced and polarity-normalized versions of origImage().
+     *
+     * The pyramid is shared by all the copies of this object, so that
+     * every level is built at most once per loaded page.
+     */
+    const AnalysisPyramid& analysisPyramid() const;
+
 private:
     QImage m_origImage;
     imageproc::GrayImage m_grayImage;
     ImageTransformation m_xform;
     imageproc::BinaryThreshold m_bwThreshold;
     bool m_blackOnWhite;
+    std::shared_ptr<AnalysisPyramid> m_ptrAnalysisPyramid;
 };
 
 
@@ -18,9 +18,113 @@
 
 #include "ImageLoader.h"
 #include "TiffReader.h"
+#include "JpegReader.h"
 #include "ImageId.h"
+#include "Tracer.h"
+#include "imageproc/GrayImage.h"
 #include <QImage>
 #include <QFile>
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+using namespace imageproc;
+
+namespace {
+    /**
+     * Averages \p factor x \p factor blocks of pixels.  Partial blocks
+     * at the right and bottom edges are averaged over what they cover.
+     * Each of the \p channels bytes of a pixel is averaged separately.
+     */
+    void boxDecimate(const uint8_t* src,
+                     const int src_stride,
+                     const QSize src_size,
+                     const int channels,
+                     const int factor,
+                     uint8_t* dst,
+                     const int dst_stride) {
+        const int src_width = src_size.width();
+        const int src_height = src_size.height();
+        const int dst_width = (src_width + factor - 1) / factor;
+        const int dst_height = (src_height + factor - 1) / factor;
+
+        std::vector<uint32_t> column_sums(static_cast<size_t>(src_width * channels));
+
+        for (int dst_y = 0; dst_y < dst_height; ++dst_y) {
+            const int y0 = dst_y * factor;
+            const int y1 = std::min(y0 + factor, src_height);
+
+            std::fill(column_sums.begin(), column_sums.end(), 0);
+            for (int y = y0; y < y1; ++y) {
+                const uint8_t* const src_line = src + y * src_stride;
+                for (int i = 0; i < src_width * channels; ++i) {
+                    column_sums[i] += src_line[i];
+                }
+            }
+
+            uint8_t* const dst_line = dst + dst_y * dst_stride;
+            for (int dst_x = 0; dst_x < dst_width; ++dst_x) {
+                const int x0 = dst_x * factor;
+                const int x1 = std::min(x0 + factor, src_width);
+                const uint32_t area = static_cast<uint32_t>((x1 - x0) * (y1 - y0));
+                for (int c = 0; c < channels; ++c) {
+                    uint32_t sum = 0;
+                    for (int x = x0; x < x1; ++x) {
+                        sum += column_sums[x * channels + c];
+                    }
+                    dst_line[dst_x * channels + c] = static_cast<uint8_t>((sum + area / 2) / area);
+                }
+            }
+        }
+    }
+
+    /**
+     * Reduces the image by the largest integer factor that keeps it
+     * no smaller than it would be when scaled down to fit \p max_size.
+     */
+    QImage decimate(const QImage& image, const QSize& max_size) {
+        if (image.isNull() || max_size.isEmpty()) {
+            return image;
+        }
+
+        const QSize min_size(image.size().scaled(max_size, Qt::KeepAspectRatio));
+        if (min_size.isEmpty()) {
+            return image;
+        }
+        const int factor = std::min(image.width() / min_size.width(), image.height() / min_size.height());
+        if (factor < 2) {
+            return image;
+        }
+
+        const QSize dst_size((image.width() + factor - 1) / factor, (image.height() + factor - 1) / factor);
+
+        QImage reduced;
+        const bool gray = (image.format() == QImage::Format_Mono) || (image.format() == QImage::Format_MonoLSB)
+                          || (image.format() == QImage::Format_Grayscale8)
+                          || ((image.format() == QImage::Format_Indexed8) && image.isGrayscale());
+        if (gray) {
+            const GrayImage src(image);
+            GrayImage dst(dst_size);
+            boxDecimate(src.data(), src.stride(), src.size(), 1, factor, dst.data(), dst.stride());
+            reduced = dst.toQImage();
+        } else {
+            const QImage src(
+                    image.convertToFormat(image.hasAlphaChannel() ? QImage::Format_ARGB32 : QImage::Format_RGB32)
+            );
+            reduced = QImage(dst_size, src.format());
+            if (reduced.isNull()) {
+                throw std::bad_alloc();
+            }
+            boxDecimate(src.bits(), src.bytesPerLine(), src.size(), 4, factor, reduced.bits(), reduced.bytesPerLine());
+        }
+
+        reduced.setDotsPerMeterX(qRound(double(image.dotsPerMeterX()) * dst_size.width() / image.width()));
+        reduced.setDotsPerMeterY(qRound(double(image.dotsPerMeterY()) * dst_size.height() / image.height()));
+
+        return reduced;
+    }
+}  // namespace
 
 QImage ImageLoader::load(const ImageId& image_id) {
     return load(image_id.filePath(), image_id.zeroBasedPage());
@@ -36,6 +140,8 @@ QImage ImageLoader::load(const QString& file_path, const int page_num) {
 }
 
 QImage ImageLoader::load(QIODevice& io_dev, const int page_num) {
+    const TraceSpan span("io", "ImageLoader::load");
+
     if (TiffReader::canRead(io_dev)) {
         return TiffReader::readImage(io_dev, page_num);
     }
@@ -51,3 +157,44 @@ QImage ImageLoader::load(QIODevice& io_dev, const int page_num) {
     return image;
 }
 
+
+QImage ImageLoader::load(const ImageId& image_id, const QSize& max_size) {
+    QFile file(image_id.filePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QImage();
+    }
+
+    return load(file, image_id.zeroBasedPage(), max_size);
+}
+
+QImage ImageLoader::load(QIODevice& io_dev, const int page_num, const QSize& max_size) {
+    const TraceSpan span("io", "ImageLoader::load(reduced)");
+
+    if (TiffReader::canRead(io_dev)) {
+        return decimate(TiffReader::readImage(io_dev, page_num, max_size), max_size);
+    }
+
+    if (page_num != 0) {
+        // Qt can only load the first page of multi-page images.
+        return QImage();
+    }
+
+    if (JpegReader::canRead(io_dev)) {
+        const qint64 start_pos = io_dev.pos();
+        const QImage image(JpegReader::readImage(io_dev, max_size));
+        if (!image.isNull()) {
+            // DCT scaling goes no further than 1/8.
+            return decimate(image, max_size);
+        }
+
+        // Let Qt try, as it supports more color spaces.
+        if (io_dev.isSequential() || !io_dev.seek(start_pos)) {
+            return QImage();
+        }
+    }
+
+    QImage image;
+    image.load(&io_dev, nullptr);
+
+    return decimate(image, max_size);
+}
@@ -23,6 +23,7 @@ class ImageId;
 class QImage;
 class QString;
 class QIODevice;
+class QSize;
 
 class ImageLoader {
 public:
@@ -31,6 +32,22 @@ public:
     static QImage load(const ImageId& image_id);
 
     static QImage load(QIODevice& io_dev, int page_num);
+
+    /**
+     * \brief Loads an image at a reduced resolution, if possible.
+     *
+     * For consumers that are going to scale the image down to fit
+     * \p max_size anyway, such as thumbnail generators.  The image is
+     * reduced as much as possible without going below the size it would
+     * have after such scaling.  JPEG images are decoded at a reduced scale,
+     * TIFF images are read from reduced resolution subimages if present.
+     * Whatever remains to be reduced is done by box filtering with an
+     * integer factor.  The resolution (dots per meter) of the returned
+     * image is adjusted accordingly.
+     */
+    static QImage load(const ImageId& image_id, const QSize& max_size);
+
+    static QImage load(QIODevice& io_dev, int page_num, const QSize& max_size);
 };
 
 
@@ -21,6 +21,33 @@
 #include <QString>
 #include <QIODevice>
 #include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QCache>
+#include <QMutex>
+#include <QMutexLocker>
+
+namespace {
+    /**
+     * The result of probing a file, valid as long as the file
+     * keeps its modification time and size.
+     */
+    struct CachedMetadata {
+        QDateTime lastModified;
+        qint64 size = 0;
+        ImageMetadataLoader::Status status = ImageMetadataLoader::GENERIC_ERROR;
+        std::vector<ImageMetadata> metadata;
+    };
+
+    /**
+     * The number of files to remember.  Least recently used entries
+     * are evicted beyond that.
+     */
+    const int MAX_CACHED_FILES = 10000;
+
+    QMutex cacheMutex;
+    QCache<QString, CachedMetadata> cache(MAX_CACHED_FILES);
+}  // namespace
 
 ImageMetadataLoader::LoaderList ImageMetadataLoader::m_sLoaders;
 
@@ -44,11 +71,58 @@ ImageMetadataLoader::Status ImageMetadataLoader::loadImpl(QIODevice& io_device,
 
 ImageMetadataLoader::Status ImageMetadataLoader::loadImpl(const QString& file_path,
                                                           VirtualFunction1<void, const ImageMetadata&>& out) {
+    const QFileInfo file_info(file_path);
+    const QString key(file_info.absoluteFilePath());
+    const QDateTime last_modified(file_info.lastModified());
+    const qint64 size = file_info.size();
+
+    CachedMetadata entry;
+    bool cache_hit = false;
+    {
+        const QMutexLocker locker(&cacheMutex);
+        if (const CachedMetadata* cached = cache.object(key)) {
+            if ((cached->lastModified == last_modified) && (cached->size == size)) {
+                entry = *cached;
+                cache_hit = true;
+            } else {
+                // The file has changed since.
+                cache.remove(key);
+            }
+        }
+    }
+    if (cache_hit) {
+        for (const ImageMetadata& metadata : entry.metadata) {
+            out(metadata);
+        }
+
+        return entry.status;
+    }
+
     QFile file(file_path);
     if (!file.open(QIODevice::ReadOnly)) {
         return GENERIC_ERROR;
     }
 
-    return loadImpl(file, out);
-}
+    entry.lastModified = last_modified;
+    entry.size = size;
+    const auto collect = [&entry](const ImageMetadata& metadata) {
+        entry.metadata.push_back(metadata);
+    };
+    ProxyFunction1<decltype(collect), void, const ImageMetadata&> collector(collect);
+    entry.status = loadImpl(file, collector);
+
+    for (const ImageMetadata& metadata : entry.metadata) {
+        out(metadata);
+    }
+
+    const Status status = entry.status;
+    if (status != GENERIC_ERROR) {
+        // Read errors may be transient, especially on network shares,
+        // so we only remember definite answers.
+        const QMutexLocker locker(&cacheMutex);
+        cache.insert(key, new CachedMetadata(std::move(entry)));
+    }
+
+    return status;
+}  // ImageMetadataLoader::loadImpl
 
@@ -48,6 +48,14 @@ public:
     template<typename OutFunc>
     static Status load(QIODevice& io_device, OutFunc out);
 
+    /**
+     * \brief Loads metadata from a file.
+     *
+     * Results are cached by the absolute file path, and reused for as long
+     * as the file keeps its modification time and size.  Only the most
+     * recently used files are remembered.  The function may be called from
+     * multiple threads at the same time.
+     */
     template<typename OutFunc>
     static Status load(const QString& file_path, OutFunc out);
 
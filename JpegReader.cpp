@@ -0,0 +1,417 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C) 2007-2009  Joseph Artsimovich <joseph_a@mail.ru>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "JpegReader.h"
+#include "ImageMetadata.h"
+#include "NonCopyable.h"
+#include "Dpm.h"
+#include <QIODevice>
+#include <QImage>
+#include <QDebug>
+#include <csetjmp>
+#include <cassert>
+#include <cstring>
+#include <new>
+#include <vector>
+
+extern "C" {
+#include <jpeglib.h>
+}
+
+namespace {
+/*============================= JpegErrorManager ===========================*/
+
+    class JpegErrorManager : public jpeg_error_mgr {
+    DECLARE_NON_COPYABLE(JpegErrorManager)
+
+    public:
+        JpegErrorManager();
+
+        jmp_buf& jmpBuf() {
+            return m_jmpBuf;
+        }
+
+    private:
+        static void errorExit(j_common_ptr cinfo);
+
+        static JpegErrorManager* object(j_common_ptr cinfo);
+
+        jmp_buf m_jmpBuf{ };
+    };
+
+
+    JpegErrorManager::JpegErrorManager() : jpeg_error_mgr() {
+        jpeg_std_error(this);
+        error_exit = &JpegErrorManager::errorExit;
+    }
+
+    void JpegErrorManager::errorExit(j_common_ptr cinfo) {
+        longjmp(object(cinfo)->jmpBuf(), 1);
+    }
+
+    JpegErrorManager* JpegErrorManager::object(j_common_ptr cinfo) {
+        return static_cast<JpegErrorManager*>(cinfo->err);
+    }
+
+/*=========================== libjpeg error handling ======================*/
+
+    // libjpeg reports fatal errors through JpegErrorManager::errorExit(),
+    // which longjmp()s to the setjmp() in one of the functions below.
+    // Nothing in their frames needs destruction, so nothing is skipped.
+    // They report failure by returning false or -1, and the decompressor
+    // is then destroyed by its owner as usual.
+
+    bool createDecompress(JpegErrorManager& err_mgr, j_decompress_ptr cinfo) {
+        if (setjmp(err_mgr.jmpBuf())) {
+            return false;
+        }
+        jpeg_create_decompress(cinfo);
+
+        return true;
+    }
+
+    int readHeader(JpegErrorManager& err_mgr, j_decompress_ptr cinfo, bool require_image) {
+        if (setjmp(err_mgr.jmpBuf())) {
+            return -1;
+        }
+
+        return jpeg_read_header(cinfo, require_image ? 1 : 0);
+    }
+
+    bool startDecompress(JpegErrorManager& err_mgr, j_decompress_ptr cinfo) {
+        if (setjmp(err_mgr.jmpBuf())) {
+            return false;
+        }
+
+        return jpeg_start_decompress(cinfo) != 0;
+    }
+
+    bool readScanline(JpegErrorManager& err_mgr, j_decompress_ptr cinfo, JSAMPROW row) {
+        if (setjmp(err_mgr.jmpBuf())) {
+            return false;
+        }
+        jpeg_read_scanlines(cinfo, &row, 1);
+
+        return true;
+    }
+
+/*======================== JpegDecompressionHandle =======================*/
+
+    class JpegDecompressHandle {
+    DECLARE_NON_COPYABLE(JpegDecompressHandle)
+
+    public:
+        JpegDecompressHandle(JpegErrorManager& err_mgr, jpeg_source_mgr* src_mgr);
+
+        ~JpegDecompressHandle();
+
+        /**
+         * \brief Returns false if libjpeg failed to create the decompressor.
+         */
+        bool isValid() const {
+            return m_isValid;
+        }
+
+        jpeg_decompress_struct* ptr() {
+            return &m_info;
+        }
+
+        jpeg_decompress_struct* operator->() {
+            return &m_info;
+        }
+
+    private:
+        jpeg_decompress_struct m_info{ };
+        bool m_isValid;
+    };
+
+
+    JpegDecompressHandle::JpegDecompressHandle(JpegErrorManager& err_mgr, jpeg_source_mgr* src_mgr)
+            : m_isValid(false) {
+        m_info.err = &err_mgr;
+        if (createDecompress(err_mgr, &m_info)) {
+            m_info.src = src_mgr;
+            m_isValid = true;
+        }
+    }
+
+    JpegDecompressHandle::~JpegDecompressHandle() {
+        // Safe even if creation failed half way, as the memory manager
+        // is allocated last.
+        jpeg_destroy_decompress(&m_info);
+    }
+
+/*============================ JpegSourceManager =========================*/
+
+    class JpegSourceManager : public jpeg_source_mgr {
+    DECLARE_NON_COPYABLE(JpegSourceManager)
+
+    public:
+        explicit JpegSourceManager(QIODevice& io_device);
+
+    private:
+        static void initSource(j_decompress_ptr cinfo);
+
+        static boolean fillInputBuffer(j_decompress_ptr cinfo);
+
+        boolean fillInputBufferImpl();
+
+        static void skipInputData(j_decompress_ptr cinfo, long num_bytes);
+
+        void skipInputDataImpl(long num_bytes);
+
+        static void termSource(j_decompress_ptr cinfo);
+
+        static JpegSourceManager* object(j_decompress_ptr cinfo);
+
+        QIODevice& m_rDevice;
+        JOCTET m_buf[4096]{ };
+    };
+
+
+    JpegSourceManager::JpegSourceManager(QIODevice& io_device)
+            : jpeg_source_mgr(), m_rDevice(io_device) {
+        init_source = &JpegSourceManager::initSource;
+        fill_input_buffer = &JpegSourceManager::fillInputBuffer;
+        skip_input_data = &JpegSourceManager::skipInputData;
+        resync_to_restart = &jpeg_resync_to_restart;
+        term_source = &JpegSourceManager::termSource;
+        bytes_in_buffer = 0;
+        next_input_byte = m_buf;
+    }
+
+    void JpegSourceManager::initSource(j_decompress_ptr cinfo) {
+        // No-op.
+    }
+
+    boolean JpegSourceManager::fillInputBuffer(j_decompress_ptr cinfo) {
+        return object(cinfo)->fillInputBufferImpl();
+    }
+
+    boolean JpegSourceManager::fillInputBufferImpl() {
+        const qint64 bytes_read = m_rDevice.read((char*) m_buf, sizeof(m_buf));
+        if (bytes_read > 0) {
+            bytes_in_buffer = bytes_read;
+        } else {
+            // Insert a fake EOI marker.
+            m_buf[0] = 0xFF;
+            m_buf[1] = JPEG_EOI;
+            bytes_in_buffer = 2;
+        }
+        next_input_byte = m_buf;
+
+        return 1;
+    }
+
+    void JpegSourceManager::skipInputData(j_decompress_ptr cinfo, long num_bytes) {
+        object(cinfo)->skipInputDataImpl(num_bytes);
+    }
+
+    void JpegSourceManager::skipInputDataImpl(long num_bytes) {
+        if (num_bytes <= 0) {
+            return;
+        }
+
+        while (num_bytes > (long) bytes_in_buffer) {
+            num_bytes -= (long) bytes_in_buffer;
+            fillInputBufferImpl();
+        }
+        next_input_byte += num_bytes;
+        bytes_in_buffer -= num_bytes;
+    }
+
+    void JpegSourceManager::termSource(j_decompress_ptr cinfo) {
+        // No-op.
+    }
+
+    JpegSourceManager* JpegSourceManager::object(j_decompress_ptr cinfo) {
+        return static_cast<JpegSourceManager*>(cinfo->src);
+    }
+
+    Dpi densityToDpi(const jpeg_decompress_struct& info) {
+        if (info.density_unit == 1) {
+            // Dots per inch.
+            return Dpi(info.X_density, info.Y_density);
+        } else if (info.density_unit == 2) {
+            // Dots per centimeter.
+            return Dpm(info.X_density * 100, info.Y_density * 100);
+        }
+
+        return Dpi();
+    }
+}  // namespace {
+
+/*================================ JpegReader ===============================*/
+
+bool JpegReader::canRead(QIODevice& device) {
+    if (!device.isReadable()) {
+        return false;
+    }
+
+    static const unsigned char jpeg_signature[] = { 0xff, 0xd8, 0xff };
+    static const int sig_size = sizeof(jpeg_signature);
+
+    unsigned char signature[sig_size];
+    if (device.peek((char*) signature, sig_size) != sig_size) {
+        return false;
+    }
+
+    return memcmp(jpeg_signature, signature, sig_size) == 0;
+}
+
+ImageMetadataLoader::Status JpegReader::readMetadata(QIODevice& io_device,
+                                                     VirtualFunction1<void, const ImageMetadata&>& out) {
+    if (!io_device.isReadable()) {
+        return ImageMetadataLoader::GENERIC_ERROR;
+    }
+    if (!canRead(io_device)) {
+        return ImageMetadataLoader::FORMAT_NOT_RECOGNIZED;
+    }
+
+    JpegErrorManager err_mgr;
+    JpegSourceManager src_mgr(io_device);
+    JpegDecompressHandle cinfo(err_mgr, &src_mgr);
+    if (!cinfo.isValid()) {
+        return ImageMetadataLoader::GENERIC_ERROR;
+    }
+
+    const int header_status = readHeader(err_mgr, cinfo.ptr(), false);
+    if (header_status == JPEG_HEADER_TABLES_ONLY) {
+        return ImageMetadataLoader::NO_IMAGES;
+    } else if (header_status != JPEG_HEADER_OK) {
+        // Either an error, or JPEG_SUSPENDED, which never happens to us.
+        return ImageMetadataLoader::GENERIC_ERROR;
+    }
+
+    if (!startDecompress(err_mgr, cinfo.ptr())) {
+        // Corrupt data, or a compression type libjpeg doesn't support.
+        return ImageMetadataLoader::GENERIC_ERROR;
+    }
+
+    const QSize size(cinfo->image_width, cinfo->image_height);
+    out(ImageMetadata(size, densityToDpi(*cinfo.ptr())));
+
+    return ImageMetadataLoader::LOADED;
+} // JpegReader::readMetadata
+
+
+QImage JpegReader::readImage(QIODevice& device, const QSize& max_size) {
+    if (!canRead(device)) {
+        return QImage();
+    }
+
+    JpegErrorManager err_mgr;
+    JpegSourceManager src_mgr(device);
+    JpegDecompressHandle cinfo(err_mgr, &src_mgr);
+    if (!cinfo.isValid() || (readHeader(err_mgr, cinfo.ptr(), true) != JPEG_HEADER_OK)) {
+        return QImage();
+    }
+
+    switch (cinfo->jpeg_color_space) {
+        case JCS_GRAYSCALE:
+            cinfo->out_color_space = JCS_GRAYSCALE;
+            break;
+        case JCS_RGB:
+        case JCS_YCbCr:
+            cinfo->out_color_space = JCS_RGB;
+            break;
+        default:
+            // CMYK and friends are left to Qt.
+            return QImage();
+    }
+
+    const QSize full_size(cinfo->image_width, cinfo->image_height);
+    cinfo->scale_num = 1;
+    cinfo->scale_denom = scaleDenominator(full_size, max_size);
+
+    if (!startDecompress(err_mgr, cinfo.ptr())) {
+        return QImage();
+    }
+
+    const int width = cinfo->output_width;
+    const int height = cinfo->output_height;
+
+    QImage image;
+    if (cinfo->out_color_space == JCS_GRAYSCALE) {
+        image = QImage(width, height, QImage::Format_Indexed8);
+        if (image.isNull()) {
+            throw std::bad_alloc();
+        }
+        image.setColorCount(256);
+        for (int i = 0; i < 256; ++i) {
+            image.setColor(i, qRgb(i, i, i));
+        }
+
+        while (cinfo->output_scanline < cinfo->output_height) {
+            if (!readScanline(err_mgr, cinfo.ptr(), image.scanLine(cinfo->output_scanline))) {
+                return QImage();
+            }
+        }
+    } else {
+        image = QImage(width, height, QImage::Format_RGB32);
+        if (image.isNull()) {
+            throw std::bad_alloc();
+        }
+
+        std::vector<JSAMPLE> buf(width * 3);
+        while (cinfo->output_scanline < cinfo->output_height) {
+            auto* dst_line = (QRgb*) image.scanLine(cinfo->output_scanline);
+            JSAMPROW row = buf.data();
+            if (!readScanline(err_mgr, cinfo.ptr(), row)) {
+                return QImage();
+            }
+            for (int x = 0; x < width; ++x) {
+                dst_line[x] = qRgb(row[x * 3], row[x * 3 + 1], row[x * 3 + 2]);
+            }
+        }
+    }
+
+    const Dpi dpi(densityToDpi(*cinfo.ptr()));
+    if (!dpi.isNull()) {
+        const Dpm dpm(dpi);
+        image.setDotsPerMeterX(qRound(double(dpm.horizontal()) * width / full_size.width()));
+        image.setDotsPerMeterY(qRound(double(dpm.vertical()) * height / full_size.height()));
+    }
+
+    // We don't call jpeg_finish_decompress(), as we are not interested
+    // in whatever follows the image data.
+
+    return image;
+} // JpegReader::readImage
+
+int JpegReader::scaleDenominator(const QSize& full_size, const QSize& max_size) {
+    if (!max_size.isValid() || full_size.isEmpty()) {
+        return 1;
+    }
+
+    const QSize min_size(full_size.scaled(max_size, Qt::KeepAspectRatio));
+
+    // libjpeg rounds scaled dimensions up.
+    int denom = 1;
+    while (denom < 8) {
+        const int next = denom * 2;
+        const int width = (full_size.width() + next - 1) / next;
+        const int height = (full_size.height() + next - 1) / next;
+        if ((width < min_size.width()) || (height < min_size.height())) {
+            break;
+        }
+        denom = next;
+    }
+
+    return denom;
+}
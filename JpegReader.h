@@ -0,0 +1,57 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C) 2007-2008  Joseph Artsimovich <joseph_a@mail.ru>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JPEGREADER_H_
+#define JPEGREADER_H_
+
+#include "ImageMetadataLoader.h"
+#include "VirtualFunction.h"
+#include <QSize>
+
+class QIODevice;
+class QImage;
+class ImageMetadata;
+
+class JpegReader {
+public:
+    static bool canRead(QIODevice& device);
+
+    static ImageMetadataLoader::Status readMetadata(QIODevice& device,
+                                                    VirtualFunction1<void, const ImageMetadata&>& out);
+
+    /**
+     * \brief Reads a JPEG image, possibly at a reduced resolution.
+     *
+     * libjpeg can decode an image at 1/2, 1/4 or 1/8 of its size for
+     * a fraction of the cost of a full decode.  The largest of these
+     * reductions is used that still produces an image that can be scaled
+     * down to fit \p max_size.  An invalid \p max_size means full resolution.
+     * The resolution of the returned image is adjusted accordingly.
+     *
+     * \return The resulting image in either Format_Indexed8 (grayscale) or
+     *         Format_RGB32, or a null image in case of failure.  Color spaces
+     *         other than grayscale, RGB and YCbCr are not supported.
+     */
+    static QImage readImage(QIODevice& device, const QSize& max_size = QSize());
+
+private:
+    static int scaleDenominator(const QSize& full_size, const QSize& max_size);
+};
+
+
+#endif  // ifndef JPEGREADER_H_
@@ -27,7 +27,9 @@
 #include "Dpm.h"
 #include "FilterData.h"
 #include "ImageLoader.h"
+#include "Tracer.h"
 #include <QFile>
+#include <QFileInfo>
 #include <QDir>
 #include <QTextDocument>
 
@@ -58,6 +60,7 @@ LoadFileTask::LoadFileTask(Type type,
         : BackgroundTask(type),
           m_ptrThumbnailCache(std::move(thumbnail_cache)),
           m_imageId(page.imageId()),
+          m_traceLabel(traceLabel(page)),
           m_imageMetadata(page.metadata()),
           m_ptrPages(std::move(pages)),
           m_ptrNextTask(std::move(next_task)) {
@@ -67,6 +70,8 @@ LoadFileTask::LoadFileTask(Type type,
 LoadFileTask::~LoadFileTask() = default;
 
 FilterResultPtr LoadFileTask::operator()() {
+    const TracePageScope trace_page(m_traceLabel);
+
     QImage image(ImageLoader::load(m_imageId));
 
     try {
@@ -109,6 +114,18 @@ void LoadFileTask::overrideDpi(QImage& image) const {
     image.setDotsPerMeterY(dpm.vertical());
 }
 
+QString LoadFileTask::traceLabel(const PageInfo& page) {
+    QString label(QFileInfo(page.imageId().filePath()).fileName());
+    if (page.imageId().isMultiPageFile()) {
+        label += QString("#%1").arg(page.imageId().page());
+    }
+    if (page.id().subPage() != PageId::SINGLE_PAGE) {
+        label += QString(" (%1)").arg(page.id().subPageAsString());
+    }
+
+    return label;
+}
+
 /*======================= LoadFileTask::ErrorResult ======================*/
 
 LoadFileTask::ErrorResult::ErrorResult(const QString& file_path)
@@ -56,8 +56,11 @@ private:
 
     void overrideDpi(QImage& image) const;
 
+    static QString traceLabel(const PageInfo& page);
+
     intrusive_ptr<ThumbnailPixmapCache> m_ptrThumbnailCache;
     ImageId m_imageId;
+    QString m_traceLabel;
     ImageMetadata m_imageMetadata;
     const intrusive_ptr<ProjectPages> m_ptrPages;
     const intrusive_ptr<fix_orientation::Task> m_ptrNextTask;
@@ -30,7 +30,6 @@
 #include "Utils.h"
 #include "FilterOptionsWidget.h"
 #include "ErrorWidget.h"
-#include "AutoRemovingFile.h"
 #include "DebugImages.h"
 #include "DebugImageView.h"
 #include "TabbedDebugImages.h"
@@ -76,10 +75,14 @@
 #include "Application.h"
 #include "UnitsProvider.h"
 #include "DefaultParamsDialog.h"
+#include "Tracer.h"
+#include "TiffWriter.h"
 #include <boost/lambda/lambda.hpp>
 #include <QStackedLayout>
 #include <QScrollBar>
 #include <QDir>
+#include <QFile>
+#include <QFileInfo>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QSortFilterProxyModel>
@@ -294,6 +297,9 @@ MainWindow::MainWindow()
 #else
     actionDebug->setVisible(false);
 #endif
+    actionTrace->setChecked(Tracer::isEnabled());
+    connect(actionTrace, SIGNAL(toggled(bool)), SLOT(traceToggled(bool)));
+    connect(actionExportTrace, SIGNAL(triggered(bool)), SLOT(exportTraceRequested()));
 
     connect(
             actionSettings, SIGNAL(triggered(bool)),
@@ -820,10 +826,10 @@ void MainWindow::setImageWidget(QWidget* widget,
         }
     } else {
         m_ptrTabbedDebugImages->addTab(widget, "Main");
-        AutoRemovingFile file;
+        intrusive_ptr<DebugImage> image;
         QString label;
-        while (!(file = debug_images->retrieveNext(&label)).get().isNull()) {
-            QWidget* widget = new DebugImageView(file);
+        while ((image = debug_images->retrieveNext(&label))) {
+            QWidget* widget = new DebugImageView(image);
             m_imageWidgetCleanup.add(widget);
             m_ptrTabbedDebugImages->addTab(widget, label);
         }
@@ -1214,6 +1220,8 @@ void MainWindow::startBatchProcessing() {
 
     m_ptrInteractiveQueue->cancelAndClear();
 
+    TiffWriter::reloadSettings();
+
     m_ptrBatchQueue.reset(new ProcessingTaskQueue);
     PageInfo page(m_ptrThumbSequence->selectionLeader());
     for (; !page.isNull(); page = m_ptrThumbSequence->nextPage(page.id())) {
@@ -1355,6 +1363,39 @@ void MainWindow::debugToggled(const bool enabled) {
     m_debug = enabled;
 }
 
+void MainWindow::traceToggled(const bool enabled) {
+    if (enabled) {
+        Tracer::clear();
+    }
+    Tracer::setEnabled(enabled);
+}
+
+void MainWindow::exportTraceRequested() {
+    const QString trace_file(
+            QFileDialog::getSaveFileName(
+                    this, QString(), QDir::homePath(),
+                    tr("Chrome Trace Files") + " (*.json)"
+            )
+    );
+    if (trace_file.isEmpty()) {
+        return;
+    }
+
+    // The aggregated summary goes next to the trace, as a plain text file.
+    const QFileInfo trace_file_info(trace_file);
+    QFile summary_file(trace_file_info.dir().filePath(trace_file_info.completeBaseName() + ".txt"));
+    if (!Tracer::writeChromeTrace(trace_file)
+        || !summary_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        QMessageBox::warning(
+                this, tr("Error"),
+                tr("Unable to write the performance trace.")
+        );
+
+        return;
+    }
+    summary_file.write(Tracer::summary().toUtf8());
+}
+
 void MainWindow::fixDpiDialogRequested() {
     if (isBatchProcessingInProgress() || !isProjectLoaded()) {
         return;
@@ -1918,7 +1959,23 @@ void MainWindow::showInsertFileDialog(BeforeOrAfter before_or_after, const Image
 
     // The order of items returned by QFileDialog is platform-dependent,
     // so we enforce our own ordering.
-    std::sort(files.begin(), files.end(), SmartFilenameOrdering());
+    {
+        std::vector<std::pair<SmartFilenameOrdering::Key, QString>> keyed_files;
+        keyed_files.reserve(files.size());
+        for (const QString& file : files) {
+            keyed_files.emplace_back(SmartFilenameOrdering::key(QFileInfo(file)), file);
+        }
+        std::sort(
+                keyed_files.begin(), keyed_files.end(),
+                [](const std::pair<SmartFilenameOrdering::Key, QString>& lhs,
+                   const std::pair<SmartFilenameOrdering::Key, QString>& rhs) {
+                    return lhs.first < rhs.first;
+                }
+        );
+        for (int i = 0; i < files.size(); ++i) {
+            files[i] = keyed_files[i].second;
+        }
+    }
 
     // I suspect on some platforms it may be possible to select the same file twice,
     // so to be safe, remove duplicates.
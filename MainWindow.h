@@ -168,6 +168,10 @@ private slots:
 
     void debugToggled(bool enabled);
 
+    void traceToggled(bool enabled);
+
+    void exportTraceRequested();
+
     void fixDpiDialogRequested();
 
     void fixedDpiSubmitted();
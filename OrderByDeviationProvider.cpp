@@ -5,14 +5,11 @@ OrderByDeviationProvider::OrderByDeviationProvider(const DeviationProvider<PageI
         : m_deviationProvider(&settings) {
 }
 
-bool OrderByDeviationProvider::precedes(const PageId& lhs_page,
-                                        bool lhs_incomplete,
-                                        const PageId& rhs_page,
-                                        bool rhs_incomplete) const {
-    if (lhs_incomplete != rhs_incomplete) {
-        // Invalid (unknown) sizes go to the back.
-        return lhs_incomplete;
+PageOrderProvider::SortKey OrderByDeviationProvider::sortKey(const PageId& page, bool incomplete) const {
+    if (incomplete) {
+        return SortKey(0, 0.0);
     }
 
-    return (m_deviationProvider->getDeviationValue(lhs_page) > m_deviationProvider->getDeviationValue(rhs_page));
+    // Larger deviations go first.
+    return SortKey(1, -m_deviationProvider->getDeviationValue(page));
 }
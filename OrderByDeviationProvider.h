@@ -11,10 +11,7 @@ class OrderByDeviationProvider : public PageOrderProvider {
     public:
         explicit OrderByDeviationProvider(const DeviationProvider<PageId>& deviationProvider);
 
-        bool precedes(const PageId& lhs_page,
-                      bool lhs_incomplete,
-                      const PageId& rhs_page,
-                      bool rhs_incomplete) const override;
+        SortKey sortKey(const PageId& page, bool incomplete) const override;
 
     private:
         const DeviationProvider<PageId>* m_deviationProvider;
@@ -25,18 +25,71 @@ class PageId;
 
 /**
  * A base class for different page ordering strategies.
+ *
+ * Ordering is done in two steps: sortKey() snapshots what is needed
+ * to know about a page, and keyPrecedes() compares these snapshots.
+ * That way, potentially expensive lookups happen once per page rather
+ * than twice per comparison.
  */
 class PageOrderProvider : public ref_countable {
 public:
+    struct SortKey {
+        /**
+         * Compared first.
+         */
+        int group;
+
+        /**
+         * Compared if groups are equal.
+         */
+        double value;
+
+        SortKey()
+                : group(0),
+                  value(0.0) {
+        }
+
+        SortKey(int group, double value)
+                : group(group),
+                  value(value) {
+        }
+    };
+
+    /**
+     * Computes the sort key of a page.  \p incomplete indicates whether
+     * the page is represented by IncompleteThumbnail.
+     */
+    virtual SortKey sortKey(const PageId& page, bool incomplete) const = 0;
+
+    /**
+     * Returns true if \p lhs_page precedes \p rhs_page, given their sort keys.
+     * The default implementation compares groups, then values.
+     */
+    virtual bool keyPrecedes(const PageId& lhs_page,
+                             const SortKey& lhs_key,
+                             const PageId& rhs_page,
+                             const SortKey& rhs_key) const {
+        if (lhs_key.group != rhs_key.group) {
+            return lhs_key.group < rhs_key.group;
+        }
+
+        return lhs_key.value < rhs_key.value;
+    }
+
     /**
      * Returns true if \p lhs_page precedes \p rhs_page.
      * \p lhs_incomplete and \p rhs_incomplete indicate whether
      * a page is represented by IncompleteThumbnail.
      */
-    virtual bool precedes(const PageId& lhs_page,
-                          bool lhs_incomplete,
-                          const PageId& rhs_page,
-                          bool rhs_incomplete) const = 0;
+    bool precedes(const PageId& lhs_page,
+                  bool lhs_incomplete,
+                  const PageId& rhs_page,
+                  bool rhs_incomplete) const {
+        return keyPrecedes(
+                lhs_page, sortKey(lhs_page, lhs_incomplete),
+                rhs_page, sortKey(rhs_page, rhs_incomplete)
+        );
+    }
 };
 
 
@@ -20,11 +20,72 @@
 #include "NonCopyable.h"
 #include "ImageMetadataLoader.h"
 #include "SmartFilenameOrdering.h"
+#include "PayloadEvent.h"
+#include "OutOfMemoryHandler.h"
 #include <QSortFilterProxyModel>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QSettings>
-#include <deque>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QCoreApplication>
+#include <algorithm>
+
+namespace {
+    /**
+     * The maximum number of files probed at the same time.  Probing is
+     * I/O bound, so we go beyond the number of cores, but not so far as
+     * to flood a network share with requests.
+     */
+    const int MAX_PARALLEL_METADATA_LOADS = 8;
+
+    struct MetadataLoadResult {
+        int itemIdx;
+        ImageMetadataLoader::Status status;
+        std::vector<ImageMetadata> perPageMetadata;
+    };
+
+
+    /**
+     * Loads the metadata of a single file and posts the result
+     * to the dialog as a PayloadEvent<MetadataLoadResult>.
+     */
+    class MetadataLoadTask : public QRunnable {
+    public:
+        MetadataLoadTask(QObject* receiver, int item_idx, const QString& file_path)
+                : m_pReceiver(receiver),
+                  m_itemIdx(item_idx),
+                  m_filePath(file_path) {
+        }
+
+        void run() override {
+            MetadataLoadResult result{m_itemIdx, ImageMetadataLoader::GENERIC_ERROR, {}};
+            try {
+                result.status = ImageMetadataLoader::load(
+                        m_filePath, [&](const ImageMetadata& metadata) {
+                            result.perPageMetadata.push_back(metadata);
+                        }
+                );
+            } catch (const std::bad_alloc&) {
+                OutOfMemoryHandler::instance().handleOutOfMemorySituation();
+                result.status = ImageMetadataLoader::GENERIC_ERROR;
+                result.perPageMetadata.clear();
+            } catch (...) {
+                // The dialog waits for a result from every task,
+                // so failures have to be reported as well.
+                result.status = ImageMetadataLoader::GENERIC_ERROR;
+                result.perPageMetadata.clear();
+            }
+
+            QCoreApplication::postEvent(m_pReceiver, new PayloadEvent<MetadataLoadResult>(result));
+        }
+
+    private:
+        QObject* m_pReceiver;
+        int m_itemIdx;
+        QString m_filePath;
+    };
+}  // namespace
 
 class ProjectFilesDialog::Item {
 public:
@@ -36,6 +97,7 @@ public:
 
     Item(const QFileInfo& file_info, Qt::ItemFlags flags)
             : m_fileInfo(file_info),
+              m_sortKey(SmartFilenameOrdering::key(file_info)),
               m_flags(flags),
               m_status(STATUS_DEFAULT) {
     }
@@ -44,6 +106,10 @@ public:
         return m_fileInfo;
     }
 
+    const SmartFilenameOrdering::Key& sortKey() const {
+        return m_sortKey;
+    }
+
     Qt::ItemFlags flags() const {
         return m_flags;
     }
@@ -66,6 +132,7 @@ public:
 
 private:
     QFileInfo m_fileInfo;
+    SmartFilenameOrdering::Key m_sortKey;
     Qt::ItemFlags m_flags;
     std::vector<ImageMetadata> m_perPageMetadata;
     Status m_status;
@@ -78,8 +145,7 @@ DECLARE_NON_COPYABLE(FileList)
 public:
     enum LoadStatus {
         LOAD_OK,
-        LOAD_FAILED,
-        NO_MORE_FILES
+        LOAD_FAILED
     };
 
     FileList();
@@ -119,7 +185,13 @@ public:
 
     void prepareForLoadingFiles();
 
-    LoadStatus loadNextFile();
+    /**
+     * \brief Calls out(item_idx, file_path) for every file to load, in visual order.
+     */
+    template<typename OutFunc>
+    void filesToLoad(OutFunc out) const;
+
+    LoadStatus setLoadResult(const MetadataLoadResult& result);
 
 private:
     int rowCount(const QModelIndex& parent) const override;
@@ -129,7 +201,7 @@ private:
     Qt::ItemFlags flags(const QModelIndex& index) const override;
 
     std::vector<Item> m_items;
-    std::deque<int> m_itemsToLoad;
+    std::vector<int> m_itemsToLoad;
 };
 
 
@@ -198,15 +270,25 @@ void ProjectFilesDialog::FileList::assign(It begin, It end) {
     append(begin, end);
 }
 
+template<typename OutFunc>
+void ProjectFilesDialog::FileList::filesToLoad(OutFunc out) const {
+    for (const int item_idx : m_itemsToLoad) {
+        out(item_idx, m_items[item_idx].fileInfo().absoluteFilePath());
+    }
+}
+
 ProjectFilesDialog::ProjectFilesDialog(QWidget* parent)
         : QDialog(parent),
           m_ptrOffProjectFiles(new FileList),
           m_ptrOffProjectFilesSorted(new SortedFileList(*m_ptrOffProjectFiles)),
           m_ptrInProjectFiles(new FileList),
           m_ptrInProjectFilesSorted(new SortedFileList(*m_ptrInProjectFiles)),
-          m_loadTimerId(0),
+          m_pMetadataLoadPool(new QThreadPool(this)),
+          m_numPendingLoads(0),
           m_metadataLoadFailed(false),
           m_autoOutDir(true) {
+    m_pMetadataLoadPool->setMaxThreadCount(MAX_PARALLEL_METADATA_LOADS);
+
     m_supportedExtensions.insert("png");
     m_supportedExtensions.insert("jpg");
     m_supportedExtensions.insert("jpeg");
@@ -232,7 +314,11 @@ ProjectFilesDialog::ProjectFilesDialog(QWidget* parent)
     connect(buttonBox, SIGNAL(accepted()), this, SLOT(onOK()));
 }
 
-ProjectFilesDialog::~ProjectFilesDialog() = default;
+ProjectFilesDialog::~ProjectFilesDialog() {
+    // The tasks post events to us, so they must not outlive us.
+    m_pMetadataLoadPool->clear();
+    m_pMetadataLoadPool->waitForDone();
+}
 
 QString ProjectFilesDialog::inputDirectory() const {
     return inpDirLine->text();
@@ -246,15 +332,21 @@ QString ProjectFilesDialog::outputDirectory() const {
 std::vector<ImageFileInfo>
 ProjectFilesDialog::inProjectFiles() const {
 
-    std::vector<ImageFileInfo> files;
+    std::vector<const Item*> items;
     m_ptrInProjectFiles->items([&](const Item& item) {
-        files.emplace_back(item.fileInfo(), item.perPageMetadata());
+        items.push_back(&item);
     });
 
-    std::sort(files.begin(), files.end(), [](const ImageFileInfo& lhs, const ImageFileInfo& rhs) {
-        return SmartFilenameOrdering()(lhs.fileInfo(), rhs.fileInfo());
+    std::sort(items.begin(), items.end(), [](const Item* lhs, const Item* rhs) {
+        return lhs->sortKey() < rhs->sortKey();
     });
 
+    std::vector<ImageFileInfo> files;
+    files.reserve(items.size());
+    for (const Item* item : items) {
+        files.emplace_back(item->fileInfo(), item->perPageMetadata());
+    }
+
     return files;
 }
 
@@ -521,33 +613,40 @@ void ProjectFilesDialog::startLoadingMetadata() {
     buttonBox->button(QDialogButtonBox::Ok)->setEnabled(false);
     offProjectList->clearSelection();
     inProjectList->clearSelection();
-    m_loadTimerId = startTimer(0);
     m_metadataLoadFailed = false;
+
+    // Tasks are queued in visual order, so files are probed roughly
+    // from the top of the list down.
+    m_numPendingLoads = 0;
+    m_ptrInProjectFiles->filesToLoad([&](const int item_idx, const QString& file_path) {
+        m_pMetadataLoadPool->start(new MetadataLoadTask(this, item_idx, file_path));
+        ++m_numPendingLoads;
+    });
+
+    if (m_numPendingLoads == 0) {
+        finishLoadingMetadata();
+    }
 }
 
-void ProjectFilesDialog::timerEvent(QTimerEvent* event) {
-    if (event->timerId() != m_loadTimerId) {
-        QWidget::timerEvent(event);
+void ProjectFilesDialog::customEvent(QEvent* event) {
+    auto* evt = dynamic_cast<PayloadEvent<MetadataLoadResult>*>(event);
+    if (!evt) {
+        QDialog::customEvent(event);
 
         return;
     }
 
-    switch (m_ptrInProjectFiles->loadNextFile()) {
-        case FileList::NO_MORE_FILES:
-            finishLoadingMetadata();
-            break;
-        case FileList::LOAD_FAILED:
-            m_metadataLoadFailed = true;
-            // Fall through.
-        case FileList::LOAD_OK:
-            progressBar->setValue(progressBar->value() + 1);
-            break;
+    if (m_ptrInProjectFiles->setLoadResult(evt->payload()) == FileList::LOAD_FAILED) {
+        m_metadataLoadFailed = true;
+    }
+    progressBar->setValue(progressBar->value() + 1);
+
+    if (--m_numPendingLoads == 0) {
+        finishLoadingMetadata();
     }
 }
 
 void ProjectFilesDialog::finishLoadingMetadata() {
-    killTimer(m_loadTimerId);
-
     inpDirLine->setEnabled(true);
     inpDirBrowseBtn->setEnabled(true);
     outDirLine->setEnabled(true);
@@ -655,7 +754,7 @@ Qt::ItemFlags ProjectFilesDialog::FileList::flags(const QModelIndex& index) cons
 
 void ProjectFilesDialog::FileList::prepareForLoadingFiles() {
 
-    std::deque<int> item_indexes;
+    std::vector<int> item_indexes;
     const auto num_items = static_cast<const int>(m_items.size());
     for (int i = 0; i < num_items; ++i) {
         item_indexes.push_back(i);
@@ -671,39 +770,24 @@ void ProjectFilesDialog::FileList::prepareForLoadingFiles() {
     m_itemsToLoad.swap(item_indexes);
 }
 
-ProjectFilesDialog::FileList::LoadStatus ProjectFilesDialog::FileList::loadNextFile() {
-
-    if (m_itemsToLoad.empty()) {
-        return NO_MORE_FILES;
-    }
-
-    const int item_idx = m_itemsToLoad.front();
-    Item& item = m_items[item_idx];
-    std::vector<ImageMetadata> per_page_metadata;
-    const QString file_path(item.fileInfo().absoluteFilePath());
-    const ImageMetadataLoader::Status st = ImageMetadataLoader::load(
-            file_path, [&](const ImageMetadata& metadata) {
-                per_page_metadata.push_back(metadata);
-            }
-    );
+ProjectFilesDialog::FileList::LoadStatus ProjectFilesDialog::FileList::setLoadResult(const MetadataLoadResult& result) {
+    Item& item = m_items[result.itemIdx];
 
     LoadStatus status;
 
-    if (st == ImageMetadataLoader::LOADED) {
+    if (result.status == ImageMetadataLoader::LOADED) {
         status = LOAD_OK;
-        item.perPageMetadata().swap(per_page_metadata);
+        item.perPageMetadata() = result.perPageMetadata;
         item.setStatus(Item::STATUS_LOAD_OK);
     } else {
         status = LOAD_FAILED;
         item.setStatus(Item::STATUS_LOAD_FAILED);
     }
-    const QModelIndex idx(index(item_idx, 0));
+    const QModelIndex idx(index(result.itemIdx, 0));
     emit dataChanged(idx, idx);
 
-    m_itemsToLoad.pop_front();
-
     return status;
-} // ProjectFilesDialog::FileList::loadNextFile
+} // ProjectFilesDialog::FileList::setLoadResult
 
 /*================= ProjectFilesDialog::SortedFileList ===================*/
 
@@ -731,6 +815,6 @@ bool ProjectFilesDialog::ItemVisualOrdering::operator()(const Item& lhs, const I
         return lhs_failed;
     }
 
-    return SmartFilenameOrdering()(lhs.fileInfo(), rhs.fileInfo());
+    return lhs.sortKey() < rhs.sortKey();
 }
 
@@ -27,6 +27,8 @@
 #include <vector>
 #include <memory>
 
+class QThreadPool;
+
 class ProjectFilesDialog : public QDialog, private Ui::ProjectFilesDialog {
 Q_OBJECT
 public:
@@ -74,7 +76,7 @@ private:
 
     void startLoadingMetadata();
 
-    void timerEvent(QTimerEvent* event) override;
+    void customEvent(QEvent* event) override;
 
     void finishLoadingMetadata();
 
@@ -83,7 +85,8 @@ private:
     std::unique_ptr<SortedFileList> m_ptrOffProjectFilesSorted;
     std::unique_ptr<FileList> m_ptrInProjectFiles;
     std::unique_ptr<SortedFileList> m_ptrInProjectFilesSorted;
-    int m_loadTimerId;
+    QThreadPool* m_pMetadataLoadPool;
+    int m_numPendingLoads;
     bool m_metadataLoadFailed;
     bool m_autoOutDir;
 };
@@ -19,6 +19,7 @@
 #include "SettingsDialog.h"
 #include "OpenGLSupport.h"
 #include "Application.h"
+#include "TiffWriter.h"
 #include <QSettings>
 #include <QtWidgets/QMessageBox>
 #include <tiff.h>
@@ -112,6 +113,7 @@ void SettingsDialog::commitChanges() {
 
     settings.setValue("settings/bw_compression", ui.tiffCompressionBWBox->currentData().toInt());
     settings.setValue("settings/color_compression", ui.tiffCompressionColorBox->currentData().toInt());
+    TiffWriter::reloadSettings();
     settings.setValue("settings/language", ui.languageBox->currentData().toString());
 
     emit settingsChanged();
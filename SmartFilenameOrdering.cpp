@@ -18,62 +18,68 @@
 
 #include "SmartFilenameOrdering.h"
 #include <QFileInfo>
+#include <algorithm>
 
 bool SmartFilenameOrdering::operator()(const QFileInfo& lhs, const QFileInfo& rhs) const {
-    // First compare directories.
-    if (int comp = lhs.absolutePath().compare(rhs.absolutePath())) {
-        return comp < 0;
-    }
+    return key(lhs) < key(rhs);
+}
 
-    const QString lhs_fname(lhs.fileName());
-    const QString rhs_fname(rhs.fileName());
-    const QChar* lhs_ptr = lhs_fname.constData();
-    const QChar* rhs_ptr = rhs_fname.constData();
-    while (!lhs_ptr->isNull() && !rhs_ptr->isNull()) {
-        const bool lhs_is_digit = lhs_ptr->isDigit();
-        const bool rhs_is_digit = rhs_ptr->isDigit();
-        if (lhs_is_digit != rhs_is_digit) {
-            // Digits have priority over non-digits.
-            return lhs_is_digit;
-        }
+SmartFilenameOrdering::Key SmartFilenameOrdering::key(const QFileInfo& file_info) {
+    Key key;
+    key.m_dir = file_info.absolutePath();
+    key.m_fileName = file_info.fileName();
 
-        if (lhs_is_digit && rhs_is_digit) {
-            unsigned long lhs_number = 0;
+    const QChar* ptr = key.m_fileName.constData();
+    while (!ptr->isNull()) {
+        Key::Token token{ptr->isDigit(), 0};
+        if (token.isNumber) {
             do {
-                lhs_number = lhs_number * 10 + lhs_ptr->digitValue();
-                ++lhs_ptr;
+                token.value = token.value * 10 + ptr->digitValue();
+                ++ptr;
                 // Note: isDigit() implies !isNull()
-            } while (lhs_ptr->isDigit());
-
-            unsigned long rhs_number = 0;
+            } while (ptr->isDigit());
+        } else {
             do {
-                rhs_number = rhs_number * 10 + rhs_ptr->digitValue();
-                ++rhs_ptr;
-                // Note: isDigit() implies !isNull()
-            } while (rhs_ptr->isDigit());
-
-            if (lhs_number != rhs_number) {
-                return lhs_number < rhs_number;
-            } else {
-                continue;
-            }
+                ++token.value;
+                ++ptr;
+            } while (!ptr->isNull() && !ptr->isDigit());
         }
+        key.m_tokens.push_back(token);
+    }
 
-        if (lhs_ptr->isNull() != rhs_ptr->isNull()) {
-            return *lhs_ptr < *rhs_ptr;
+    return key;
+}
+
+bool SmartFilenameOrdering::Key::operator<(const Key& other) const {
+    // First compare directories.
+    if (int comp = m_dir.compare(other.m_dir)) {
+        return comp < 0;
+    }
+
+    const size_t num_tokens = std::min(m_tokens.size(), other.m_tokens.size());
+    for (size_t i = 0; i < num_tokens; ++i) {
+        const Token& lhs = m_tokens[i];
+        const Token& rhs = other.m_tokens[i];
+        if (lhs.isNumber != rhs.isNumber) {
+            // Digits have priority over non-digits.
+            return lhs.isNumber;
         }
 
-        ++lhs_ptr;
-        ++rhs_ptr;
+        // For numbers, smaller ones go first.  Of two non-digit runs,
+        // the shorter one goes first, as it's followed by either a digit
+        // or the end of the name, both of which have priority.
+        if (lhs.value != rhs.value) {
+            return lhs.value < rhs.value;
+        }
     }
 
-    if (!lhs_ptr->isNull() || !rhs_ptr->isNull()) {
-        return lhs_ptr->isNull();
+    if (m_tokens.size() != other.m_tokens.size()) {
+        // A name that ends earlier goes first.
+        return m_tokens.size() < other.m_tokens.size();
     }
 
     // OK, the smart comparison indicates the file names are equal.
     // However, if they aren't symbol-to-symbol equal, we can't treat
     // them as equal, so let's do a usual comparision now.
-    return lhs_fname < rhs_fname;
-} // ()
-
+    return m_fileName < other.m_fileName;
+}
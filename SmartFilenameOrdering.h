@@ -19,12 +19,54 @@
 #ifndef SMARTFILENAMEORDERING_H_
 #define SMARTFILENAMEORDERING_H_
 
+#include <QString>
+#include <vector>
+
 class QFileInfo;
 
 class SmartFilenameOrdering {
 public:
+    /**
+     * \brief A file path, preprocessed for fast comparison.
+     *
+     * Comparing two keys with operator<() gives the same result as
+     * comparing the original paths with SmartFilenameOrdering, but
+     * the path splitting and digit parsing is done only once per path.
+     * When sorting many files, build a key for each of them first.
+     */
+    class Key {
+    public:
+        Key() = default;
+
+        bool operator<(const Key& other) const;
+
+    private:
+        friend class SmartFilenameOrdering;
+
+        /**
+         * A run of either digits or non-digits.  For a number,
+         * \p value is the number itself, otherwise it's the length
+         * of the run.  Non-digit characters themselves only matter
+         * when everything else is equal, in which case whole file
+         * names are compared.
+         */
+        struct Token {
+            bool isNumber;
+            unsigned long value;
+        };
+
+        QString m_dir;
+        QString m_fileName;
+        std::vector<Token> m_tokens;
+    };
+
     SmartFilenameOrdering() = default;
 
+    /**
+     * \brief Builds a comparison key for a file.
+     */
+    static Key key(const QFileInfo& file_info);
+
     /**
      * \brief Compare filenames using a set of heuristic rules.
      *
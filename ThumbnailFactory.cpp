@@ -19,6 +19,7 @@
 #include "ThumbnailFactory.h"
 #include "CompositeCacheDrivenTask.h"
 #include "filter_dc/ThumbnailCollector.h"
+#include "IncompleteThumbnail.h"
 #include <QGraphicsItem>
 #include <utility>
 
@@ -42,6 +43,30 @@ private:
     std::unique_ptr<QGraphicsItem> m_ptrThumbnail;
 };
 
+class ThumbnailFactory::IncompletenessCollector : public ThumbnailCollector {
+public:
+    IncompletenessCollector(intrusive_ptr<ThumbnailPixmapCache> cache, const QSizeF& max_size);
+
+    void processThumbnail(std::unique_ptr<QGraphicsItem> thumbnail) override;
+
+    bool needThumbnail() const override;
+
+    void processIncompleteness(bool incomplete) override;
+
+    intrusive_ptr<ThumbnailPixmapCache> thumbnailCache() override;
+
+    QSizeF maxLogicalThumbSize() const override;
+
+    bool incomplete() const {
+        return m_incomplete;
+    }
+
+private:
+    intrusive_ptr<ThumbnailPixmapCache> m_ptrCache;
+    QSizeF m_maxSize;
+    bool m_incomplete;
+};
+
 
 ThumbnailFactory::ThumbnailFactory(intrusive_ptr<ThumbnailPixmapCache> pixmap_cache,
                                    const QSizeF& max_size,
@@ -61,6 +86,13 @@ ThumbnailFactory::get(const PageInfo& page_info) {
     return collector.retrieveThumbnail();
 }
 
+bool ThumbnailFactory::isIncomplete(const PageInfo& page_info) {
+    IncompletenessCollector collector(m_ptrPixmapCache, m_maxSize);
+    m_ptrTask->process(page_info, &collector);
+
+    return collector.incomplete();
+}
+
 /*======================= ThumbnailFactory::Collector ======================*/
 
 ThumbnailFactory::Collector::Collector(intrusive_ptr<ThumbnailPixmapCache> cache, const QSizeF& max_size)
@@ -81,3 +113,33 @@ QSizeF ThumbnailFactory::Collector::maxLogicalThumbSize() const {
     return m_maxSize;
 }
 
+/*================= ThumbnailFactory::IncompletenessCollector ================*/
+
+ThumbnailFactory::IncompletenessCollector::IncompletenessCollector(intrusive_ptr<ThumbnailPixmapCache> cache,
+                                                                   const QSizeF& max_size)
+        : m_ptrCache(std::move(cache)),
+          m_maxSize(max_size),
+          m_incomplete(false) {
+}
+
+void ThumbnailFactory::IncompletenessCollector::processThumbnail(std::unique_ptr<QGraphicsItem> thumbnail) {
+    // In case a filter builds the thumbnail anyway.
+    m_incomplete = dynamic_cast<IncompleteThumbnail*>(thumbnail.get()) != nullptr;
+}
+
+bool ThumbnailFactory::IncompletenessCollector::needThumbnail() const {
+    return false;
+}
+
+void ThumbnailFactory::IncompletenessCollector::processIncompleteness(const bool incomplete) {
+    m_incomplete = incomplete;
+}
+
+intrusive_ptr<ThumbnailPixmapCache>
+ThumbnailFactory::IncompletenessCollector::thumbnailCache() {
+    return m_ptrCache;
+}
+
+QSizeF ThumbnailFactory::IncompletenessCollector::maxLogicalThumbSize() const {
+    return m_maxSize;
+}
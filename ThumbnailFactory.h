@@ -42,9 +42,18 @@ public:
 
     std::unique_ptr<QGraphicsItem> get(const PageInfo& page_info);
 
+    /**
+     * \brief Returns whether get() would return an IncompleteThumbnail.
+     *
+     * This runs the same task as get(), but without building the thumbnail.
+     */
+    bool isIncomplete(const PageInfo& page_info);
+
 private:
     class Collector;
 
+    class IncompletenessCollector;
+
     intrusive_ptr<ThumbnailPixmapCache> m_ptrPixmapCache;
     QSizeF m_maxSize;
     intrusive_ptr<CompositeCacheDrivenTask> m_ptrTask;
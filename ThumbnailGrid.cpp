@@ -0,0 +1,62 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ThumbnailGrid.h"
+#include <QRectF>
+#include <QtGlobal>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+ThumbnailGrid::ThumbnailGrid(const QPointF& origin, const QSizeF& slot_size, const int num_columns)
+        : m_origin(origin),
+          m_slotSize(slot_size),
+          m_numColumns(num_columns) {
+    assert(m_numColumns > 0);
+    assert(m_slotSize.height() > 0);
+}
+
+int ThumbnailGrid::numRows(const int num_items) const {
+    return (num_items + m_numColumns - 1) / m_numColumns;
+}
+
+QPointF ThumbnailGrid::position(const int index) const {
+    return QPointF(
+            m_origin.x() + (index % m_numColumns) * m_slotSize.width(),
+            m_origin.y() + (index / m_numColumns) * m_slotSize.height()
+    );
+}
+
+std::pair<int, int> ThumbnailGrid::itemRange(const QRectF& rect,
+                                             const qreal top_margin,
+                                             const int margin_rows,
+                                             const int num_items) const {
+    const qreal rows_top = m_origin.y() - top_margin;
+    const qreal first_row = std::floor((rect.top() - rows_top) / m_slotSize.height());
+    const qreal last_row = std::floor((rect.bottom() - rows_top) / m_slotSize.height());
+
+    // Clamp rows before converting them to indexes, so that huge rects don't overflow.
+    const int num_rows = numRows(num_items);
+    const int begin_row = static_cast<int>(qBound<qreal>(0, first_row - margin_rows, num_rows));
+    const int end_row = static_cast<int>(qBound<qreal>(0, last_row + 1 + margin_rows, num_rows));
+
+    return std::make_pair(
+            std::min(begin_row * m_numColumns, num_items),
+            std::min(end_row * m_numColumns, num_items)
+    );
+}
@@ -0,0 +1,65 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCANTAILOR_THUMBNAILGRID_H
+#define SCANTAILOR_THUMBNAILGRID_H
+
+#include <QPointF>
+#include <QSizeF>
+#include <utility>
+
+class QRectF;
+
+/**
+ * \brief Thumbnails laid out row by row, each in a slot of the same size.
+ *
+ * The position of a thumbnail follows from its index alone, and so do
+ * the thumbnails near a given area, without looking at the thumbnails.
+ */
+class ThumbnailGrid {
+    // Member-wise copying is OK.
+public:
+    ThumbnailGrid(const QPointF& origin, const QSizeF& slot_size, int num_columns);
+
+    int numColumns() const {
+        return m_numColumns;
+    }
+
+    int numRows(int num_items) const;
+
+    QPointF position(int index) const;
+
+    /**
+     * \brief The indexes of thumbnails in rows intersecting \p rect.
+     *
+     * A row starts \p top_margin above the position of its thumbnails
+     * and is one slot high.  The range is extended by \p margin_rows rows
+     * above and below and clamped to the indexes of \p num_items thumbnails.
+     *
+     * \return [begin, end) indexes, possibly an empty range.
+     */
+    std::pair<int, int> itemRange(const QRectF& rect, qreal top_margin, int margin_rows, int num_items) const;
+
+private:
+    QPointF m_origin;
+    QSizeF m_slotSize;
+    int m_numColumns;
+};
+
+
+#endif  // ifndef SCANTAILOR_THUMBNAILGRID_H
@@ -636,7 +636,8 @@ QImage ThumbnailPixmapCache::Impl::loadSaveThumbnail(const ImageId& image_id,
         return image;
     }
 
-    image = ImageLoader::load(image_id);
+    // We are going to scale it down anyway.
+    image = ImageLoader::load(image_id, max_thumb_size);
     if (image.isNull()) {
         return QImage();
     }
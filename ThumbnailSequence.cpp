@@ -18,12 +18,14 @@
 
 #include "ThumbnailSequence.h"
 #include "ThumbnailFactory.h"
+#include "ThumbnailGrid.h"
 #include "IncompleteThumbnail.h"
 #include "PageSequence.h"
 #include "ColorSchemeManager.h"
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/sequenced_index.hpp>
+#include <boost/multi_index/random_access_index.hpp>
 #include <boost/multi_index/mem_fun.hpp>
 #include <boost/function.hpp>
 #include <boost/lambda/lambda.hpp>
@@ -35,6 +37,10 @@
 #include <QGraphicsSceneMouseEvent>
 #include <QApplication>
 #include <QFileInfo>
+#include <QFontMetricsF>
+#include <QScrollBar>
+#include <algorithm>
+#include <tuple>
 
 using namespace ::boost::multi_index;
 using namespace ::boost::lambda;
@@ -42,7 +48,7 @@ using namespace ::boost::lambda;
 
 class ThumbnailSequence::Item {
 public:
-    Item(const PageInfo& page_info, CompositeItem* comp_item);
+    explicit Item(const PageInfo& page_info);
 
     const PageId& pageId() const {
         return pageInfo.id();
@@ -61,8 +67,24 @@ public:
     void setSelectionLeader(bool selection_leader) const;
 
     PageInfo pageInfo;
+
+    /**
+     * The graphics item representing this page, or null if the page
+     * is not near the visible area of the view.
+     */
     mutable CompositeItem* composite;
+
+    /**
+     * Whether the page was represented by IncompleteThumbnail when its
+     * sort key was computed.  Only maintained if an order provider is set.
+     */
     mutable bool incompleteThumbnail;
+
+    /**
+     * Cached result of PageOrderProvider::sortKey().  Only meaningful
+     * if an order provider is set.
+     */
+    mutable PageOrderProvider::SortKey sortKey;
 private:
     mutable bool m_isSelected;
     mutable bool m_isSelectionLeader;
@@ -154,7 +176,7 @@ private:
                             tag<ItemsByIdTag>,
                             const_mem_fun<Item, const PageId&, &Item::pageId>
                     >,
-                    sequenced<tag<ItemsInOrderTag>>,
+                    random_access<tag<ItemsInOrderTag>>,
                     sequenced<tag<SelectedThenUnselectedTag>>
             >
     > Container;
@@ -190,7 +212,8 @@ private:
      * \param begin Beginning of the interval to consider.
      * \param end End of the interval to consider.
      * \param page_id The item to find insertion position for.
-     * \param page_incomplete Whether the page is represented by IncompleteThumbnail.
+     * \param page_key The sort key of \p page_id, as returned by
+     *        PageOrderProvider::sortKey().
      * \param hint The place to start the search.  Must be within [begin, end].
      * \param dist_from_hint If provided, the distance from \p hint
      *        to the calculated insertion position will be written there.
@@ -200,7 +223,7 @@ private:
     ItemsInOrder::iterator itemInsertPosition(ItemsInOrder::iterator begin,
                                               ItemsInOrder::iterator end,
                                               const PageId& page_id,
-                                              bool page_incomplete,
+                                              const PageOrderProvider::SortKey& page_key,
                                               ItemsInOrder::iterator hint,
                                               int* dist_from_hint = 0);
 
@@ -210,9 +233,52 @@ private:
 
     std::unique_ptr<CompositeItem> getCompositeItem(const Item* item, const PageInfo& info);
 
+    bool isIncompleteThumbnail(const PageInfo& page_info);
+
+    void updateSortKey(const Item& item);
+
+    QGraphicsView* view() const;
+
+    int numColumnsForView() const;
+
+    /**
+     * The distance between the positions of neighbouring thumbnails.
+     * Every thumbnail occupies a slot of this size, no matter its
+     * actual size, which makes it possible to calculate the position
+     * of any thumbnail from its index in m_itemsInOrder.
+     */
+    QSizeF slotSize() const;
+
+    ThumbnailGrid grid() const;
+
+    int indexOf(const Item& item) const;
+
+    QPointF itemPosition(int index) const;
+
+    QRectF itemSceneRect(const Item& item) const;
+
+    /**
+     * Creates graphics items for the thumbnails near the visible area
+     * of the view and destroys those far from it.  Also updates positions
+     * of the existing graphics items, in case their indexes have changed.
+     */
+    void updateMaterializedItems();
+
+    void materialize(const Item& item, int index);
+
+    void dematerialize(const Item& item);
+
+    void dematerializeAll();
+
     void commitSceneRect();
 
     static const int SPACING = 0;
+
+    /**
+     * The number of rows of thumbnails to keep materialized
+     * above and below the visible area.
+     */
+    static const int MATERIALIZED_MARGIN_ROWS = 3;
     ThumbnailSequence& m_rOwner;
     QSizeF m_maxLogicalThumbSize;
     Container m_items;
@@ -229,7 +295,19 @@ private:
     intrusive_ptr<ThumbnailFactory> m_ptrFactory;
     intrusive_ptr<PageOrderProvider const> m_ptrOrderProvider;
     GraphicsScene m_graphicsScene;
-    QRectF m_sceneRect;
+
+    /**
+     * Items that have their CompositeItem, in no particular order.
+     */
+    std::vector<const Item*> m_materializedItems;
+
+    /**
+     * The number of thumbnails in a row.  It depends on the width of the view
+     * and is updated by invalidateAllThumbnails(), like the order of thumbnails.
+     */
+    int m_numColumns;
+
+    mutable QSizeF m_slotSize;
 };
 
 
@@ -263,6 +341,18 @@ private:
 
 class ThumbnailSequence::CompositeItem : public QGraphicsItemGroup {
 public:
+    static const int MIN_WIDTH = 300;
+    static const int THUMB_LABEL_SPACING = 1;
+
+    /** The minimum distance from the thumbnail or the label to the sides of boundingRect(). */
+    static const int MIN_HORIZONTAL_MARGIN = 5;
+
+    /** The distance from pos() to the top of boundingRect(). */
+    static const int TOP_MARGIN = 5;
+
+    /** The distance from the bottom of the label to the bottom of boundingRect(). */
+    static const int BOTTOM_MARGIN = 3;
+
     CompositeItem(ThumbnailSequence::Impl& owner,
                   std::unique_ptr<QGraphicsItem> thumbnail,
                   std::unique_ptr<LabelGroup> label_group);
@@ -277,10 +367,16 @@ public:
 
     bool incompleteThumbnail() const;
 
-    void updateSceneRect(QRectF& scene_rect);
-
     void updateAppearence(bool selected, bool selection_leader);
 
+    /**
+     * The size of boundingRect() of the largest possible item, provided
+     * its label is no wider than maxLabelWidth().
+     */
+    static QSizeF maxSize(const QSizeF& max_thumb_size);
+
+    static qreal maxLabelWidth(const QSizeF& max_thumb_size);
+
     virtual QRectF boundingRect() const;
 
     virtual void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget);
@@ -396,11 +492,8 @@ ThumbnailSequence::selectedRanges() const {
 }
 
 void ThumbnailSequence::emitNewSelectionLeader(const PageInfo& page_info,
-                                               const CompositeItem* composite,
+                                               const QRectF& thumb_rect,
                                                const SelectionFlags flags) {
-    const QRectF thumb_rect(
-            composite->mapToScene(composite->boundingRect()).boundingRect()
-    );
     emit newSelectionLeader(page_info, thumb_rect, flags);
 }
 
@@ -413,7 +506,8 @@ ThumbnailSequence::Impl::Impl(ThumbnailSequence& owner, const QSizeF& max_logica
           m_itemsById(m_items.get<ItemsByIdTag>()),
           m_itemsInOrder(m_items.get<ItemsInOrderTag>()),
           m_selectedThenUnselected(m_items.get<SelectedThenUnselectedTag>()),
-          m_pSelectionLeader(0) {
+          m_pSelectionLeader(0),
+          m_numColumns(1) {
     m_graphicsScene.setContextMenuEventCallback(
             [&](QGraphicsSceneContextMenuEvent* evt) {
                 this->sceneContextMenuEvent(evt);
@@ -430,6 +524,13 @@ void ThumbnailSequence::Impl::setThumbnailFactory(intrusive_ptr<ThumbnailFactory
 
 void ThumbnailSequence::Impl::attachView(QGraphicsView* const view) {
     view->setScene(&m_graphicsScene);
+
+    // Thumbnails are materialized as they are scrolled into view.
+    const auto update = [this]() {
+        updateMaterializedItems();
+    };
+    QObject::connect(view->verticalScrollBar(), &QScrollBar::valueChanged, &m_rOwner, update);
+    QObject::connect(view->verticalScrollBar(), &QScrollBar::rangeChanged, &m_rOwner, update);
 }
 
 void ThumbnailSequence::Impl::reset(const PageSequence& pages,
@@ -456,10 +557,8 @@ void ThumbnailSequence::Impl::reset(const PageSequence& pages,
     const Item* some_selected_item = 0;
 
     for (const PageInfo& page_info : pages) {
-        std::unique_ptr<CompositeItem> composite(getCompositeItem(0, page_info));
-        m_itemsInOrder.push_back(Item(page_info, composite.release()));
+        m_itemsInOrder.push_back(Item(page_info));
         const Item* item = &m_itemsInOrder.back();
-        item->composite->setItem(item);
 
         if (selected.find(page_info.id()) != selected.end()) {
             item->setSelected(true);
@@ -482,7 +581,7 @@ void ThumbnailSequence::Impl::reset(const PageSequence& pages,
     if (m_pSelectionLeader) {
         m_pSelectionLeader->setSelectionLeader(true);
         m_rOwner.emitNewSelectionLeader(
-                selection_leader, m_pSelectionLeader->composite, DEFAULT_SELECTION_FLAGS
+                selection_leader, itemSceneRect(*m_pSelectionLeader), DEFAULT_SELECTION_FLAGS
         );
     }
 } // ThumbnailSequence::Impl::reset
@@ -521,33 +620,35 @@ void ThumbnailSequence::Impl::invalidateThumbnail(const PageInfo& page_info) {
 }
 
 void ThumbnailSequence::Impl::invalidateThumbnailImpl(const ItemsById::iterator id_it) {
-    std::unique_ptr<CompositeItem> composite(getCompositeItem(&* id_it, id_it->pageInfo));
+    const Item& item = *id_it;
 
-    CompositeItem* const new_composite = composite.get();
-    CompositeItem* const old_composite = id_it->composite;
-    const QSizeF old_size(old_composite->boundingRect().size());
-    const QSizeF new_size(new_composite->boundingRect().size());
-    const QPointF old_pos(new_composite->pos());
+    // Thumbnails far from the visible area will be created from scratch
+    // when they get close to it, so there is nothing to update.
+    if (item.composite) {
+        const int index = indexOf(item);
+        dematerialize(item);
+        materialize(item, index);
+    }
 
-    new_composite->updateAppearence(id_it->isSelected(), id_it->isSelectionLeader());
+    if (!m_ptrOrderProvider) {
+        return;
+    }
 
-    m_graphicsScene.addItem(composite.release());
-    id_it->composite = new_composite;
-    id_it->incompleteThumbnail = new_composite->incompleteThumbnail();
-    delete old_composite;
+    updateSortKey(item);
 
-    ItemsInOrder::iterator after_old(m_items.project<ItemsInOrderTag>(id_it));
-    // Notice after_old++ below.
+    const ItemsInOrder::iterator old_pos(m_itemsInOrder.iterator_to(item));
+    ItemsInOrder::iterator after_old(old_pos);
+    ++after_old;
 
     // Move our item to the beginning of m_itemsInOrder, to make it out of range
     // we are going to pass to itemInsertPosition().
-    m_itemsInOrder.relocate(m_itemsInOrder.begin(), after_old++);
+    m_itemsInOrder.relocate(m_itemsInOrder.begin(), old_pos);
 
     int dist = 0;
     const ItemsInOrder::iterator after_new(
             itemInsertPosition(
-                    ++m_itemsInOrder.begin(), m_itemsInOrder.end(),
-                    id_it->pageInfo.id(), id_it->incompleteThumbnail,
+                    m_itemsInOrder.begin() + 1, m_itemsInOrder.end(),
+                    item.pageInfo.id(), item.sortKey,
                     after_old, &dist
             )
     );
@@ -555,127 +656,46 @@ void ThumbnailSequence::Impl::invalidateThumbnailImpl(const ItemsById::iterator
     // Move our item to its intended position.
     m_itemsInOrder.relocate(after_new, m_itemsInOrder.begin());
 
-
-    // Now let's reposition the items on the scene.
-
-    ItemsInOrder::iterator ord_it, ord_end;
-
-    // The range of [ord_it, ord_end) is supposed to contain all items
-    // between the old and new positions of our item, with the new
-    // position in range.
-
-    if (dist <= 0) {  // New position is before or equals to the old one.
-        ord_it = after_new;
-        --ord_it;  // Include new item position in the range.
-        ord_end = after_old;
-    } else {  // New position is after the old one.
-        ord_it = after_old;
-        ord_end = after_new;
-    }
-
-    int view_width = m_graphicsScene.views().first()->width();
-
-    double xoffset = SPACING;
-    double yoffset = SPACING;
-
-    if (ord_it != m_itemsInOrder.begin()) {
-        ItemsInOrder::iterator prev(ord_it);
-        --prev;
-        xoffset = prev->composite->pos().x() + prev->composite->boundingRect().width() + SPACING;
-        if (xoffset <= view_width) {
-            yoffset = prev->composite->pos().y() + SPACING;
-        } else {
-            xoffset = SPACING;
-            yoffset = prev->composite->pos().y() + prev->composite->boundingRect().height() + SPACING;
-        }
+    if (dist == 0) {
+        return;
     }
 
-    // Reposition items between the old and the new position of our item,
-    // including the item itself.
-    for (; ord_it != ord_end; ++ord_it) {
-        ord_it->composite->setPos(xoffset, yoffset);
-        xoffset += ord_it->composite->boundingRect().width() + SPACING;
-        if (xoffset > view_width) {
-            xoffset = SPACING;
-            yoffset += ord_it->composite->boundingRect().height() + SPACING;
-        }
-    }
+    // Items between the old and the new position have shifted by one slot.
+    updateMaterializedItems();
 
-    // Reposition the items following both the new and the old position
-    // of the item, if the item size has changed.
-    if (old_size != new_size) {
-        for (; ord_it != m_itemsInOrder.end(); ++ord_it) {
-            ord_it->composite->setPos(xoffset, yoffset);
-            xoffset += ord_it->composite->boundingRect().width() + SPACING;
-            if (xoffset > view_width) {
-                xoffset = SPACING;
-                yoffset += ord_it->composite->boundingRect().height() + SPACING;
-            }
-        }
-    }
-    // Update scene rect.
-    m_sceneRect.setTop(m_sceneRect.bottom());
-    m_itemsInOrder.front().composite->updateSceneRect(m_sceneRect);
-    m_sceneRect.setBottom(m_sceneRect.top());
-    m_itemsInOrder.back().composite->updateSceneRect(m_sceneRect);
-    id_it->composite->updateSceneRect(m_sceneRect);
-    commitSceneRect();
     // Possibly emit the newSelectionLeader() signal.
-    if (m_pSelectionLeader == &*id_it) {
-        if ((old_size != new_size) || (old_pos != id_it->composite->pos())) {
-            m_rOwner.emitNewSelectionLeader(
-                    id_it->pageInfo, id_it->composite, REDUNDANT_SELECTION
-            );
-        }
+    if (m_pSelectionLeader == &item) {
+        m_rOwner.emitNewSelectionLeader(item.pageInfo, itemSceneRect(item), REDUNDANT_SELECTION);
     }
 } // ThumbnailSequence::Impl::invalidateThumbnailImpl
 
 void ThumbnailSequence::Impl::invalidateAllThumbnails() {
-    // Recreate thumbnails now, whether a thumbnail is incomplete
-    // is taken into account when sorting.
-    ItemsInOrder::iterator ord_it(m_itemsInOrder.begin());
-    const ItemsInOrder::iterator ord_end(m_itemsInOrder.end());
-    for (; ord_it != ord_end; ++ord_it) {
-        CompositeItem* const old_composite = ord_it->composite;
-        ord_it->composite = getCompositeItem(&*ord_it, ord_it->pageInfo).release();
-        ord_it->incompleteThumbnail = ord_it->composite->incompleteThumbnail();
-        delete old_composite;
-    }
+    // Thumbnails are recreated as they get close to the visible area.
+    dematerializeAll();
 
     // Sort pages in m_itemsInOrder using m_ptrOrderProvider.
+    // Sort keys are computed once per page, as that may involve
+    // settings lookups, which we don't want to repeat on every comparison.
     if (m_ptrOrderProvider) {
+        for (const Item& item : m_itemsInOrder) {
+            updateSortKey(item);
+        }
+
         m_itemsInOrder.sort(
                 [this](const Item& lhs, const Item& rhs) {
-                    return m_ptrOrderProvider->precedes(
-                            lhs.pageId(), lhs.incompleteThumbnail,
-                            rhs.pageId(), rhs.incompleteThumbnail
+                    return m_ptrOrderProvider->keyPrecedes(
+                            lhs.pageId(), lhs.sortKey,
+                            rhs.pageId(), rhs.sortKey
                     );
                 }
         );
     }
 
-    m_sceneRect = QRectF(0.0, 0.0, 0.0, 0.0);
-    double xoffset = SPACING;
-    double yoffset = SPACING;
-
-    int num_items = 0;
-    int view_width = m_graphicsScene.views().first()->width();
-    for (ord_it = m_itemsInOrder.begin(); ord_it != ord_end; ++ord_it, ++num_items) {
-        CompositeItem* composite = ord_it->composite;
-        composite->setPos(xoffset, yoffset);
-        composite->updateSceneRect(m_sceneRect);
-        composite->updateAppearence(ord_it->isSelected(), ord_it->isSelectionLeader());
-
-        xoffset += composite->boundingRect().width() + SPACING;
-        if (xoffset > view_width) {
-            xoffset = SPACING;
-            yoffset += composite->boundingRect().height() + SPACING;
-        }
-        m_graphicsScene.addItem(composite);
-    }
+    m_numColumns = numColumnsForView();
 
     commitSceneRect();
-} // ThumbnailSequence::Impl::invalidateAllThumbnails
+    updateMaterializedItems();
+}
 
 bool ThumbnailSequence::Impl::setSelection(const PageId& page_id) {
     const ItemsById::iterator id_it(m_itemsById.find(page_id));
@@ -716,7 +736,7 @@ bool ThumbnailSequence::Impl::setSelection(const PageId& page_id) {
         flags |= REDUNDANT_SELECTION;
     }
 
-    m_rOwner.emitNewSelectionLeader(id_it->pageInfo, id_it->composite, flags);
+    m_rOwner.emitNewSelectionLeader(id_it->pageInfo, itemSceneRect(*id_it), flags);
 
     return true;
 } // ThumbnailSequence::Impl::setSelection
@@ -815,76 +835,40 @@ void ThumbnailSequence::Impl::insert(const PageInfo& page_info, BeforeOrAfter be
         }
     }
 
-    // If m_ptrOrderProvider is not set, ord_it won't change.
-    ord_it = itemInsertPosition(
-            m_itemsInOrder.begin(), m_itemsInOrder.end(), page_info.id(),
-
-            /*page_incomplete=*/ true, ord_it
-    );
-
-    double offset = 0.0;
-    if (!m_items.empty()) {
-        if (ord_it != m_itemsInOrder.end()) {
-            offset = ord_it->composite->pos().y();
-        } else {
-            ItemsInOrder::iterator it(ord_it);
-            --it;
-            offset = it->composite->y()
-                     + it->composite->boundingRect().height() + SPACING;
-        }
+    const Item item(page_info);
+    if (m_ptrOrderProvider) {
+        updateSortKey(item);
     }
-    std::unique_ptr<CompositeItem> composite(
-            getCompositeItem(0, page_info)
-    );
-    composite->setPos(0.0, offset);
-    composite->updateSceneRect(m_sceneRect);
 
-    const QPointF pos_delta(0.0, composite->boundingRect().height() + SPACING);
-
-    const Item item(page_info, composite.get());
-    const std::pair<ItemsInOrder::iterator, bool> ins(
-            m_itemsInOrder.insert(ord_it, item)
+    // If m_ptrOrderProvider is not set, ord_it won't change.
+    ord_it = itemInsertPosition(
+            m_itemsInOrder.begin(), m_itemsInOrder.end(), page_info.id(), item.sortKey, ord_it
     );
-    composite->setItem(&*ins.first);
-    m_graphicsScene.addItem(composite.release());
 
-    const ItemsInOrder::iterator ord_end(m_itemsInOrder.end());
-    for (; ord_it != ord_end; ++ord_it) {
-        ord_it->composite->setPos(ord_it->composite->pos() + pos_delta);
-        ord_it->composite->updateSceneRect(m_sceneRect);
-    }
+    m_itemsInOrder.insert(ord_it, item);
 
     commitSceneRect();
+    updateMaterializedItems();
 } // ThumbnailSequence::Impl::insert
 
 void ThumbnailSequence::Impl::removePages(const std::set<PageId>& to_remove) {
-    m_sceneRect = QRectF(0, 0, 0, 0);
-
-    const std::set<PageId>::const_iterator to_remove_end(to_remove.end());
-    QPointF pos_delta(0, 0);
-
-    ItemsInOrder::iterator ord_it(m_itemsInOrder.begin());
-    const ItemsInOrder::iterator ord_end(m_itemsInOrder.end());
-    while (ord_it != ord_end) {
-        if (to_remove.find(ord_it->pageInfo.id()) == to_remove_end) {
-            // Keeping this page.
-            if (pos_delta != QPointF(0, 0)) {
-                ord_it->composite->setPos(ord_it->composite->pos() + pos_delta);
-            }
-            ord_it->composite->updateSceneRect(m_sceneRect);
-            ++ord_it;
-        } else {
-            // Removing this page.
-            if (m_pSelectionLeader == &*ord_it) {
+    const auto is_removed = [&to_remove](const Item& item) {
+        return to_remove.find(item.pageInfo.id()) != to_remove.end();
+    };
+
+    for (const Item& item : m_itemsInOrder) {
+        if (is_removed(item)) {
+            if (m_pSelectionLeader == &item) {
                 m_pSelectionLeader = 0;
             }
-            pos_delta.ry() -= ord_it->composite->boundingRect().height() + SPACING;
-            delete ord_it->composite;
-            m_itemsInOrder.erase(ord_it++);
+            dematerialize(item);
         }
     }
 
+    m_itemsInOrder.remove_if(is_removed);
+
     commitSceneRect();
+    updateMaterializedItems();
 }
 
 bool ThumbnailSequence::Impl::multipleItemsSelected() const {
@@ -918,9 +902,7 @@ QRectF ThumbnailSequence::Impl::selectionLeaderSceneRect() const {
         return QRectF();
     }
 
-    return m_pSelectionLeader->composite->mapToScene(
-            m_pSelectionLeader->composite->boundingRect()
-    ).boundingRect();
+    return itemSceneRect(*m_pSelectionLeader);
 }
 
 std::set<PageId>
@@ -966,10 +948,7 @@ void ThumbnailSequence::Impl::contextMenuRequested(const PageInfo& page_info, co
 
 void ThumbnailSequence::Impl::sceneContextMenuEvent(QGraphicsSceneContextMenuEvent* evt) {
     if (!m_itemsInOrder.empty()) {
-        CompositeItem* composite = m_itemsInOrder.back().composite;
-        const QRectF last_thumb_rect(
-                composite->mapToScene(composite->boundingRect()).boundingRect()
-        );
+        const QRectF last_thumb_rect(itemSceneRect(m_itemsInOrder.back()));
         if (evt->scenePos().y() <= last_thumb_rect.bottom()) {
             return;
         }
@@ -1003,7 +982,7 @@ void ThumbnailSequence::Impl::selectItemWithControl(const ItemsById::iterator& i
 
         m_rOwner.emitNewSelectionLeader(
                 m_pSelectionLeader->pageInfo,
-                m_pSelectionLeader->composite, flags
+                itemSceneRect(*m_pSelectionLeader), flags
         );
 
         return;
@@ -1014,7 +993,7 @@ void ThumbnailSequence::Impl::selectItemWithControl(const ItemsById::iterator& i
         flags |= REDUNDANT_SELECTION;
         m_rOwner.emitNewSelectionLeader(
                 m_pSelectionLeader->pageInfo,
-                m_pSelectionLeader->composite, flags
+                itemSceneRect(*m_pSelectionLeader), flags
         );
 
         return;
@@ -1057,7 +1036,7 @@ void ThumbnailSequence::Impl::selectItemWithControl(const ItemsById::iterator& i
     // No need to moveToSelected() as it was and remains selected.
 
     m_rOwner.emitNewSelectionLeader(
-            m_pSelectionLeader->pageInfo, m_pSelectionLeader->composite, flags
+            m_pSelectionLeader->pageInfo, itemSceneRect(*m_pSelectionLeader), flags
     );
 } // ThumbnailSequence::Impl::selectItemWithControl
 
@@ -1116,7 +1095,7 @@ void ThumbnailSequence::Impl::selectItemWithShift(const ItemsById::iterator& id_
     m_pSelectionLeader = &*id_it;
     m_pSelectionLeader->setSelectionLeader(true);
 
-    m_rOwner.emitNewSelectionLeader(id_it->pageInfo, id_it->composite, flags);
+    m_rOwner.emitNewSelectionLeader(id_it->pageInfo, itemSceneRect(*id_it), flags);
 } // ThumbnailSequence::Impl::selectItemWithShift
 
 void ThumbnailSequence::Impl::selectItemNoModifiers(const ItemsById::iterator& id_it) {
@@ -1131,22 +1110,17 @@ void ThumbnailSequence::Impl::selectItemNoModifiers(const ItemsById::iterator& i
     m_pSelectionLeader->setSelectionLeader(true);
     moveToSelected(m_pSelectionLeader);
 
-    m_rOwner.emitNewSelectionLeader(id_it->pageInfo, id_it->composite, flags);
+    m_rOwner.emitNewSelectionLeader(id_it->pageInfo, itemSceneRect(*id_it), flags);
 }
 
 void ThumbnailSequence::Impl::clear() {
     m_pSelectionLeader = 0;
 
-    ItemsInOrder::iterator it(m_itemsInOrder.begin());
-    const ItemsInOrder::iterator end(m_itemsInOrder.end());
-    while (it != end) {
-        delete it->composite;
-        m_itemsInOrder.erase(it++);
-    }
+    dematerializeAll();
+    m_items.clear();
 
     assert(m_graphicsScene.items().empty());
 
-    m_sceneRect = QRectF(0.0, 0.0, 0.0, 0.0);
     commitSceneRect();
 }
 
@@ -1165,7 +1139,7 @@ ThumbnailSequence::Impl::ItemsInOrder::iterator ThumbnailSequence::Impl::itemIns
         const ItemsInOrder::iterator begin,
         const ItemsInOrder::iterator end,
         const PageId& page_id,
-        const bool page_incomplete,
+        const PageOrderProvider::SortKey& page_key,
         const ItemsInOrder::iterator hint,
         int* dist_from_hint) {
     // Note that to preserve stable ordering, this function *must* return hint,
@@ -1186,8 +1160,8 @@ ThumbnailSequence::Impl::ItemsInOrder::iterator ThumbnailSequence::Impl::itemIns
     while (ins_pos != begin) {
         ItemsInOrder::iterator prev(ins_pos);
         --prev;
-        const bool precedes = m_ptrOrderProvider->precedes(
-                page_id, page_incomplete, prev->pageId(), prev->incompleteThumbnail
+        const bool precedes = m_ptrOrderProvider->keyPrecedes(
+                page_id, page_key, prev->pageId(), prev->sortKey
         );
         if (precedes) {
             ins_pos = prev;
@@ -1200,9 +1174,9 @@ ThumbnailSequence::Impl::ItemsInOrder::iterator ThumbnailSequence::Impl::itemIns
     // While the element pointed to by ins_pos is supposed to precede
     // the page we are inserting, advance ins_pos.
     while (ins_pos != end) {
-        const bool precedes = m_ptrOrderProvider->precedes(
-                ins_pos->pageId(), ins_pos->incompleteThumbnail,
-                page_id, page_incomplete
+        const bool precedes = m_ptrOrderProvider->keyPrecedes(
+                ins_pos->pageId(), ins_pos->sortKey,
+                page_id, page_key
         );
         if (precedes) {
             ++ins_pos;
@@ -1252,15 +1226,36 @@ ThumbnailSequence::Impl::getLabelGroup(const PageInfo& page_info) {
         ).arg(text).arg(page_id.imageId().page());
     }
 
-    std::unique_ptr<QGraphicsSimpleTextItem> normal_text_item(new QGraphicsSimpleTextItem);
-    normal_text_item->setText(text);
+    const char* pixmap_resource = 0;
+    switch (page_id.subPage()) {
+        case PageId::LEFT_PAGE:
+            pixmap_resource = ":/icons/left_page_thumb.png";
+            break;
+        case PageId::RIGHT_PAGE:
+            pixmap_resource = ":/icons/right_page_thumb.png";
+            break;
+        default:
+            break;
+    }
+    const QPixmap pixmap = pixmap_resource ? QPixmap(pixmap_resource) : QPixmap();
+    const int label_pixmap_spacing = 5;
 
+    std::unique_ptr<QGraphicsSimpleTextItem> normal_text_item(new QGraphicsSimpleTextItem);
     std::unique_ptr<QGraphicsSimpleTextItem> bold_text_item(new QGraphicsSimpleTextItem);
-    bold_text_item->setText(text);
     QFont bold_font(bold_text_item->font());
     bold_font.setWeight(QFont::Bold);
     bold_text_item->setFont(bold_font);
 
+    // Every thumbnail gets a slot of the same width, so a label wider
+    // than that would overlap the neighbouring ones.
+    qreal max_text_width = CompositeItem::maxLabelWidth(m_maxLogicalThumbSize);
+    if (!pixmap.isNull()) {
+        max_text_width -= pixmap.width() + label_pixmap_spacing;
+    }
+    text = QFontMetricsF(bold_font).elidedText(text, Qt::ElideLeft, max_text_width);
+    normal_text_item->setText(text);
+    bold_text_item->setText(text);
+
     bold_text_item->setBrush(ColorSchemeManager::instance()->getColorParam(
             "thumbnail_sequence_selected_item_text",
             QApplication::palette().highlightedText()));
@@ -1272,24 +1267,13 @@ ThumbnailSequence::Impl::getLabelGroup(const PageInfo& page_info) {
     normal_text_item->setPos(normal_text_box.topLeft());
     bold_text_item->setPos(bold_text_box.topLeft());
 
-    const char* pixmap_resource = 0;
-    switch (page_id.subPage()) {
-        case PageId::LEFT_PAGE:
-            pixmap_resource = ":/icons/left_page_thumb.png";
-            break;
-        case PageId::RIGHT_PAGE:
-            pixmap_resource = ":/icons/right_page_thumb.png";
-            break;
-        default:
-            return std::unique_ptr<LabelGroup>(new LabelGroup(std::move(normal_text_item), std::move(bold_text_item)));
+    if (pixmap.isNull()) {
+        return std::unique_ptr<LabelGroup>(new LabelGroup(std::move(normal_text_item), std::move(bold_text_item)));
     }
 
-    const QPixmap pixmap(pixmap_resource);
     std::unique_ptr<QGraphicsPixmapItem> pixmap_item(new QGraphicsPixmapItem);
     pixmap_item->setPixmap(pixmap);
 
-    const int label_pixmap_spacing = 5;
-
     QRectF pixmap_box(pixmap_item->boundingRect());
     pixmap_box.moveCenter(bold_text_box.center());
     pixmap_box.moveLeft(bold_text_box.right() + label_pixmap_spacing);
@@ -1311,20 +1295,158 @@ ThumbnailSequence::Impl::getCompositeItem(const Item* item, const PageInfo& page
     return composite;
 }
 
+bool ThumbnailSequence::Impl::isIncompleteThumbnail(const PageInfo& page_info) {
+    if (!m_ptrFactory) {
+        return false;
+    }
+
+    return m_ptrFactory->isIncomplete(page_info);
+}
+
+void ThumbnailSequence::Impl::updateSortKey(const Item& item) {
+    if (item.composite) {
+        item.incompleteThumbnail = item.composite->incompleteThumbnail();
+    } else {
+        item.incompleteThumbnail = isIncompleteThumbnail(item.pageInfo);
+    }
+    item.sortKey = m_ptrOrderProvider->sortKey(item.pageId(), item.incompleteThumbnail);
+}
+
+QGraphicsView* ThumbnailSequence::Impl::view() const {
+    const QList<QGraphicsView*> views(m_graphicsScene.views());
+
+    return views.empty() ? nullptr : views.front();
+}
+
+int ThumbnailSequence::Impl::numColumnsForView() const {
+    const QGraphicsView* const view = this->view();
+    if (!view) {
+        return 1;
+    }
+
+    // A thumbnail goes to the next row once the previous one crosses the
+    // right edge of the view, so a row holds one more than fully fits.
+    return static_cast<int>(view->width() / slotSize().width()) + 1;
+}
+
+QSizeF ThumbnailSequence::Impl::slotSize() const {
+    if (m_slotSize.isEmpty()) {
+        m_slotSize = CompositeItem::maxSize(m_maxLogicalThumbSize) + QSizeF(SPACING, SPACING);
+    }
+
+    return m_slotSize;
+}
+
+int ThumbnailSequence::Impl::indexOf(const Item& item) const {
+    return static_cast<int>(m_itemsInOrder.iterator_to(item) - m_itemsInOrder.begin());
+}
+
+ThumbnailGrid ThumbnailSequence::Impl::grid() const {
+    return ThumbnailGrid(QPointF(SPACING, SPACING), slotSize(), m_numColumns);
+}
+
+QPointF ThumbnailSequence::Impl::itemPosition(const int index) const {
+    return grid().position(index);
+}
+
+QRectF ThumbnailSequence::Impl::itemSceneRect(const Item& item) const {
+    const QSizeF size(slotSize() - QSizeF(SPACING, SPACING));
+    const QPointF pos(itemPosition(indexOf(item)));
+
+    return QRectF(QPointF(pos.x() - 0.5 * size.width(), pos.y() - CompositeItem::TOP_MARGIN), size);
+}
+
+void ThumbnailSequence::Impl::updateMaterializedItems() {
+    const int num_items = static_cast<int>(m_itemsInOrder.size());
+
+    int begin = 0;
+    int end = 0;
+    if (const QGraphicsView* const view = this->view()) {
+        const QRectF visible_rect(view->mapToScene(view->viewport()->rect()).boundingRect());
+        std::tie(begin, end) = grid().itemRange(
+                visible_rect, CompositeItem::TOP_MARGIN, MATERIALIZED_MARGIN_ROWS, num_items
+        );
+    }
+
+    const std::vector<const Item*> materialized(m_materializedItems);
+    for (const Item* item : materialized) {
+        const int index = indexOf(*item);
+        if ((index < begin) || (index >= end)) {
+            dematerialize(*item);
+        }
+    }
+
+    for (int index = begin; index < end; ++index) {
+        const Item& item = m_itemsInOrder[index];
+        if (item.composite) {
+            item.composite->setPos(itemPosition(index));
+        } else {
+            materialize(item, index);
+        }
+    }
+}
+
+void ThumbnailSequence::Impl::materialize(const Item& item, const int index) {
+    assert(!item.composite);
+
+    std::unique_ptr<CompositeItem> composite(getCompositeItem(&item, item.pageInfo));
+    composite->setPos(itemPosition(index));
+    composite->updateAppearence(item.isSelected(), item.isSelectionLeader());
+    item.composite = composite.get();
+    m_graphicsScene.addItem(composite.release());
+
+    m_materializedItems.push_back(&item);
+}
+
+void ThumbnailSequence::Impl::dematerialize(const Item& item) {
+    if (!item.composite) {
+        return;
+    }
+
+    delete item.composite;
+    item.composite = 0;
+
+    m_materializedItems.erase(std::find(m_materializedItems.begin(), m_materializedItems.end(), &item));
+}
+
+void ThumbnailSequence::Impl::dematerializeAll() {
+    for (const Item* item : m_materializedItems) {
+        delete item->composite;
+        item->composite = 0;
+    }
+    m_materializedItems.clear();
+}
+
 void ThumbnailSequence::Impl::commitSceneRect() {
-    if (m_sceneRect.isNull()) {
+    const int num_items = static_cast<int>(m_itemsInOrder.size());
+    if (num_items == 0) {
         m_graphicsScene.setSceneRect(QRectF(0.0, 0.0, 1.0, 1.0));
-    } else {
-        m_graphicsScene.setSceneRect(m_sceneRect);
+
+        return;
     }
+
+    // Horizontally, the scene only has to cover the thumbnails themselves,
+    // not the wider backgrounds of selected items.
+    const QSizeF slot(slotSize());
+    const int num_columns = std::min(num_items, m_numColumns);
+    const int num_rows = grid().numRows(num_items);
+    const qreal half_thumb_width = 0.5 * m_maxLogicalThumbSize.width();
+
+    m_graphicsScene.setSceneRect(
+            QRectF(
+                    QPointF(SPACING - half_thumb_width, SPACING - CompositeItem::TOP_MARGIN),
+                    QPointF(SPACING + (num_columns - 1) * slot.width() + half_thumb_width,
+                            SPACING + num_rows * slot.height() - CompositeItem::TOP_MARGIN)
+            )
+    );
 }
 
 /*==================== ThumbnailSequence::Item ======================*/
 
-ThumbnailSequence::Item::Item(const PageInfo& page_info, CompositeItem* comp_item)
+ThumbnailSequence::Item::Item(const PageInfo& page_info)
         : pageInfo(page_info),
-          composite(comp_item),
-          incompleteThumbnail(comp_item->incompleteThumbnail()),
+          composite(0),
+          incompleteThumbnail(true),
           m_isSelected(false),
           m_isSelectionLeader(false) {
 }
@@ -1335,6 +1457,11 @@ void ThumbnailSequence::Item::setSelected(bool selected) const {
     m_isSelected = selected;
     m_isSelectionLeader = m_isSelectionLeader && selected;
 
+    if (!composite) {
+        // Will be taken care of when it gets materialized.
+        return;
+    }
+
     if ((was_selected != m_isSelected) || (was_selection_leader != m_isSelectionLeader)) {
         composite->updateAppearence(m_isSelected, m_isSelectionLeader);
     }
@@ -1349,6 +1476,11 @@ void ThumbnailSequence::Item::setSelectionLeader(bool selection_leader) const {
     m_isSelected = m_isSelected || selection_leader;
     m_isSelectionLeader = selection_leader;
 
+    if (!composite) {
+        // Will be taken care of when it gets materialized.
+        return;
+    }
+
     if ((was_selected != m_isSelected) || (was_selection_leader != m_isSelectionLeader)) {
         composite->updateAppearence(m_isSelected, m_isSelectionLeader);
     }
@@ -1424,11 +1556,10 @@ ThumbnailSequence::CompositeItem::CompositeItem(ThumbnailSequence::Impl& owner,
     const QSizeF thumb_size(thumbnail->boundingRect().size());
     const QSizeF label_size(label_group->boundingRect().size());
 
-    const int thumb_label_spacing = 1;
     thumbnail->setPos(-0.5 * thumb_size.width(), 0.0);
     label_group->setPos(
             thumbnail->pos().x() + 0.5 * (thumb_size.width() - label_size.width()),
-            thumb_size.height() + thumb_label_spacing
+            thumb_size.height() + THUMB_LABEL_SPACING
     );
 
     addToGroup(thumbnail.release());
@@ -1442,32 +1573,37 @@ bool ThumbnailSequence::CompositeItem::incompleteThumbnail() const {
     return dynamic_cast<IncompleteThumbnail*>(m_pThumb) != 0;
 }
 
-void ThumbnailSequence::CompositeItem::updateSceneRect(QRectF& scene_rect) {
-    QRectF rect(m_pThumb->boundingRect());
-    rect.translate(m_pThumb->pos());
-    rect.translate(pos());
-
-    QRectF bounding_rect(boundingRect());
-    bounding_rect.translate(pos());
+void ThumbnailSequence::CompositeItem::updateAppearence(bool selected, bool selection_leader) {
+    m_pLabelGroup->updateAppearence(selected, selection_leader);
+}
 
-    rect.setTop(bounding_rect.top());
-    rect.setBottom(bounding_rect.bottom());
+QSizeF ThumbnailSequence::CompositeItem::maxSize(const QSizeF& max_thumb_size) {
+    // See ThumbnailSequence::Impl::getLabelGroup() for the label layout.
+    QGraphicsSimpleTextItem text_item(QString::fromLatin1("Xg"));
+    QFont bold_font(text_item.font());
+    bold_font.setWeight(QFont::Bold);
+    text_item.setFont(bold_font);
+    const QPixmap pixmap(":/icons/left_page_thumb.png");
+    const qreal label_height = std::max<qreal>(text_item.boundingRect().height(), pixmap.height());
 
-    scene_rect |= rect;
+    return QSizeF(
+            maxLabelWidth(max_thumb_size) + 2 * MIN_HORIZONTAL_MARGIN,
+            TOP_MARGIN + max_thumb_size.height() + THUMB_LABEL_SPACING + label_height + BOTTOM_MARGIN
+    );
 }
 
-void ThumbnailSequence::CompositeItem::updateAppearence(bool selected, bool selection_leader) {
-    m_pLabelGroup->updateAppearence(selected, selection_leader);
+qreal ThumbnailSequence::CompositeItem::maxLabelWidth(const QSizeF& max_thumb_size) {
+    return std::max<qreal>(MIN_WIDTH - 2 * MIN_HORIZONTAL_MARGIN, max_thumb_size.width());
 }
 
 QRectF ThumbnailSequence::CompositeItem::boundingRect() const {
     QRectF rect(QGraphicsItemGroup::boundingRect());
-    qreal horizontalAdjustVal = 150 - 0.5 * rect.size().width();
-    if (horizontalAdjustVal < 5) {
-        horizontalAdjustVal = 5;
+    qreal horizontalAdjustVal = 0.5 * (MIN_WIDTH - rect.size().width());
+    if (horizontalAdjustVal < MIN_HORIZONTAL_MARGIN) {
+        horizontalAdjustVal = MIN_HORIZONTAL_MARGIN;
     }
 
-    rect.adjust(-horizontalAdjustVal, -5, horizontalAdjustVal, 3);
+    rect.adjust(-horizontalAdjustVal, -TOP_MARGIN, horizontalAdjustVal, BOTTOM_MARGIN);
 
     return rect;
 }
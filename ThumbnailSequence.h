@@ -127,7 +127,9 @@ public:
      * \brief Updates appearence of all thumbnails and possibly their order.
      *
      * Whether or not order will be updated depends on whether an order provider
-     * was specified by the most recent reset() call.
+     * was specified by the most recent reset() call.  Only thumbnails near
+     * the visible area are recreated right away, the rest are created as
+     * they are scrolled into view.
      */
     void invalidateAllThumbnails();
 
@@ -233,7 +235,7 @@ private:
     class LabelGroup;
     class CompositeItem;
 
-    void emitNewSelectionLeader(const PageInfo& page_info, const CompositeItem* composite, SelectionFlags flags);
+    void emitNewSelectionLeader(const PageInfo& page_info, const QRectF& thumb_rect, SelectionFlags flags);
 
     std::unique_ptr<Impl> m_ptrImpl;
 };
@@ -27,6 +27,7 @@
 #include <tiffio.h>
 #include <cassert>
 #include <cmath>
+#include <vector>
 
 class TiffReader::TiffHeader {
 public:
@@ -289,7 +290,7 @@ static void convertAbgrToArgb(const uint32* src, uint32* dst, int count) {
     }
 }
 
-QImage TiffReader::readImage(QIODevice& device, const int page_num) {
+QImage TiffReader::readImage(QIODevice& device, const int page_num, const QSize& max_size) {
     if (!device.isReadable()) {
         return QImage();
     }
@@ -318,10 +319,17 @@ QImage TiffReader::readImage(QIODevice& device, const int page_num) {
         return QImage();
     }
 
-    const TiffInfo info(tif, header);
-
     const ImageMetadata metadata(currentPageMetadata(tif));
 
+    if (max_size.isValid() && !selectReducedImage(tif, metadata.size(), max_size)) {
+        // selectReducedImage() may have left us in a subdirectory.
+        if (!TIFFSetDirectory(tif.handle(), (uint16) page_num)) {
+            return QImage();
+        }
+    }
+
+    const TiffInfo info(tif, header);
+
     QImage image;
 
     if (info.mapsToBinaryOrIndexed8()) {
@@ -369,14 +377,59 @@ QImage TiffReader::readImage(QIODevice& device, const int page_num) {
     }
 
     if (!metadata.dpi().isNull()) {
+        // The image may come from a reduced resolution subimage.
         const Dpm dpm(metadata.dpi());
-        image.setDotsPerMeterX(dpm.horizontal());
-        image.setDotsPerMeterY(dpm.vertical());
+        image.setDotsPerMeterX(qRound(double(dpm.horizontal()) * info.width / metadata.size().width()));
+        image.setDotsPerMeterY(qRound(double(dpm.vertical()) * info.height / metadata.size().height()));
     }
 
     return image;
 } // TiffReader::readImage
 
+bool TiffReader::selectReducedImage(const TiffHandle& tif, const QSize& full_size, const QSize& max_size) {
+    uint16 num_subifds = 0;
+    toff_t* subifds = nullptr;
+    if (!TIFFGetField(tif.handle(), TIFFTAG_SUBIFD, &num_subifds, &subifds) || (num_subifds == 0)) {
+        return false;
+    }
+
+    // The array belongs to the current directory, which we are about to leave.
+    const std::vector<toff_t> offsets(subifds, subifds + num_subifds);
+
+    const QSize min_size(full_size.scaled(max_size, Qt::KeepAspectRatio));
+    toff_t best_offset = 0;
+    QSize best_size(full_size);
+
+    for (const toff_t offset : offsets) {
+        if (!TIFFSetSubDirectory(tif.handle(), offset)) {
+            continue;
+        }
+
+        uint32 subfile_type = 0;
+        uint32 width = 0, height = 0;
+        TIFFGetField(tif.handle(), TIFFTAG_SUBFILETYPE, &subfile_type);
+        TIFFGetField(tif.handle(), TIFFTAG_IMAGEWIDTH, &width);
+        TIFFGetField(tif.handle(), TIFFTAG_IMAGELENGTH, &height);
+        if (!(subfile_type & FILETYPE_REDUCEDIMAGE)) {
+            continue;
+        }
+
+        // The smallest subimage that doesn't need upscaling wins.
+        const QSize size(width, height);
+        if ((size.width() >= min_size.width()) && (size.height() >= min_size.height())
+            && (size.width() < best_size.width())) {
+            best_offset = offset;
+            best_size = size;
+        }
+    }
+
+    if (best_offset == 0) {
+        return false;
+    }
+
+    return TIFFSetSubDirectory(tif.handle(), best_offset) != 0;
+}
+
 TiffReader::TiffHeader TiffReader::readHeader(QIODevice& device) {
     unsigned char data[4];
     if (device.peek((char*) data, sizeof(data)) != sizeof(data)) {
@@ -21,6 +21,7 @@
 
 #include "ImageMetadataLoader.h"
 #include "VirtualFunction.h"
+#include <QSize>
 
 class QIODevice;
 class QImage;
@@ -41,9 +42,13 @@ public:
      *        opened for reading and must be seekable.
      * \param page_num A zero-based page number within a multi-page
      *        TIFF file.
+     * \param max_size If valid, the page may be read from one of its
+     *        reduced resolution subimages (SubIFDs), provided that one
+     *        can still be scaled down to fit \p max_size.  The resolution
+     *        of the returned image is adjusted accordingly.
      * \return The resulting image, or a null image in case of failure.
      */
-    static QImage readImage(QIODevice& device, int page_num = 0);
+    static QImage readImage(QIODevice& device, int page_num = 0, const QSize& max_size = QSize());
 
 private:
     class TiffHeader;
@@ -60,6 +65,8 @@ private:
 
     static ImageMetadata currentPageMetadata(const TiffHandle& tif);
 
+    static bool selectReducedImage(const TiffHandle& tif, const QSize& full_size, const QSize& max_size);
+
     static Dpi getDpi(float xres, float yres, unsigned res_unit);
 
     static QImage extractBinaryOrIndexed8Image(const TiffHandle& tif, const TiffInfo& info);
@@ -19,13 +19,32 @@
 #include "TiffWriter.h"
 #include "imageproc/Grayscale.h"
 #include "Dpm.h"
+#include "Tracer.h"
+#include "ParallelFor.h"
 #include "imageproc/Constants.h"
 #include <QDebug>
 #include <tiffio.h>
 #include <cmath>
 #include <QtCore/QSettings>
 #include <QtCore/QFile>
+#include <QtCore/QBuffer>
+#include <QtCore/QAtomicInt>
 #include <cassert>
+#include <cstring>
+#include <algorithm>
+
+/**
+ * The amount of uncompressed data per strip.  It's large enough to keep
+ * the per-strip overhead negligible and small enough to give every core
+ * a few strips to compress.
+ */
+static const int STRIP_BYTES = 256 * 1024;
+
+/**
+ * Cached compression settings.  Negative values mean they haven't been read yet.
+ */
+static QAtomicInt bwCompressionSetting(-1);
+static QAtomicInt colorCompressionSetting(-1);
 
 /**
  * m_reverseBitsLUT[byte] gives the same byte, but with bit order reversed.
@@ -88,9 +107,66 @@ private:
 };
 
 
+/**
+ * The tags a strip has to be encoded with.
+ */
+struct TiffWriter::StripFormat {
+    explicit StripFormat(const TiffHandle& tif);
+
+    void applyTo(TIFF* strip_tif) const;
+
+    uint32 width;
+    uint16 bitsPerSample;
+    uint16 samplesPerPixel;
+    uint16 photometric;
+    uint16 compression;
+    std::vector<uint16> colormapRed;
+    std::vector<uint16> colormapGreen;
+    std::vector<uint16> colormapBlue;
+};
+
+TiffWriter::StripFormat::StripFormat(const TiffHandle& tif)
+        : width(0),
+          bitsPerSample(1),
+          samplesPerPixel(1),
+          photometric(PHOTOMETRIC_MINISBLACK),
+          compression(COMPRESSION_NONE) {
+    TIFFGetField(tif.handle(), TIFFTAG_IMAGEWIDTH, &width);
+    TIFFGetField(tif.handle(), TIFFTAG_BITSPERSAMPLE, &bitsPerSample);
+    TIFFGetField(tif.handle(), TIFFTAG_SAMPLESPERPIXEL, &samplesPerPixel);
+    TIFFGetField(tif.handle(), TIFFTAG_PHOTOMETRIC, &photometric);
+    TIFFGetField(tif.handle(), TIFFTAG_COMPRESSION, &compression);
+
+    uint16* red = nullptr;
+    uint16* green = nullptr;
+    uint16* blue = nullptr;
+    if ((photometric == PHOTOMETRIC_PALETTE)
+        && TIFFGetField(tif.handle(), TIFFTAG_COLORMAP, &red, &green, &blue)) {
+        const int num_colors = 1 << bitsPerSample;
+        colormapRed.assign(red, red + num_colors);
+        colormapGreen.assign(green, green + num_colors);
+        colormapBlue.assign(blue, blue + num_colors);
+    }
+}
+
+void TiffWriter::StripFormat::applyTo(TIFF* strip_tif) const {
+    TIFFSetField(strip_tif, TIFFTAG_IMAGEWIDTH, width);
+    TIFFSetField(strip_tif, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_UINT);
+    TIFFSetField(strip_tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+    TIFFSetField(strip_tif, TIFFTAG_BITSPERSAMPLE, bitsPerSample);
+    TIFFSetField(strip_tif, TIFFTAG_SAMPLESPERPIXEL, samplesPerPixel);
+    TIFFSetField(strip_tif, TIFFTAG_PHOTOMETRIC, photometric);
+    TIFFSetField(strip_tif, TIFFTAG_COMPRESSION, compression);
+    if (!colormapRed.empty()) {
+        TIFFSetField(strip_tif, TIFFTAG_COLORMAP, &colormapRed[0], &colormapGreen[0], &colormapBlue[0]);
+    }
+}
+
+
 static tsize_t deviceRead(thandle_t context, tdata_t data, tsize_t size) {
-    // Not implemented.
-    return 0;
+    auto* dev = (QIODevice*) context;
+
+    return (tsize_t) dev->read(static_cast<char*>(data), size);
 }
 
 static tsize_t deviceWrite(thandle_t context, tdata_t data, tsize_t size) {
@@ -161,6 +237,8 @@ bool TiffWriter::writeImage(const QString& file_path, const QImage& image) {
 }
 
 bool TiffWriter::writeImage(QIODevice& device, const QImage& image) {
+    const TraceSpan span("io", "TiffWriter::writeImage");
+
     if (image.isNull()) {
         return false;
     }
@@ -273,11 +351,9 @@ bool TiffWriter::writeBitonalOrIndexed8Image(const TiffHandle& tif, const QImage
     }
 
     if (image.format() == QImage::Format_Indexed8) {
-        TIFFSetField(tif.handle(), TIFFTAG_COMPRESSION,
-                     uint16(QSettings().value("settings/color_compression", COMPRESSION_LZW).toInt()));
+        TIFFSetField(tif.handle(), TIFFTAG_COMPRESSION, colorCompression());
     } else {
-        TIFFSetField(tif.handle(), TIFFTAG_COMPRESSION,
-                     uint16(QSettings().value("settings/bw_compression", COMPRESSION_CCITTFAX4).toInt()));
+        TIFFSetField(tif.handle(), TIFFTAG_COMPRESSION, bwCompression());
     }
 
     TIFFSetField(tif.handle(), TIFFTAG_BITSPERSAMPLE, bits_per_sample);
@@ -302,12 +378,13 @@ bool TiffWriter::writeBitonalOrIndexed8Image(const TiffHandle& tif, const QImage
     }
 
     if (image.format() == QImage::Format_Indexed8) {
-        return write8bitLines(tif, image);
+        return writeStrips(tif, image, image.width(), &copy8bitLine);
     } else {
+        const int bpl = (image.width() + 7) / 8;
         if (image.format() == QImage::Format_MonoLSB) {
-            return writeBinaryLinesReversed(tif, image);
+            return writeStrips(tif, image, bpl, &reverseBinaryLine);
         } else {
-            return writeBinaryLinesAsIs(tif, image);
+            return writeStrips(tif, image, bpl, &copyBinaryLine);
         }
     }
 } // TiffWriter::writeBitonalOrIndexed8Image
@@ -316,130 +393,209 @@ bool TiffWriter::writeRGB32Image(const TiffHandle& tif, const QImage& image) {
     assert(image.format() == QImage::Format_RGB32);
 
     TIFFSetField(tif.handle(), TIFFTAG_SAMPLESPERPIXEL, uint16(3));
-    TIFFSetField(tif.handle(), TIFFTAG_COMPRESSION,
-                 uint16(QSettings().value("settings/color_compression", COMPRESSION_LZW).toInt()));
+    TIFFSetField(tif.handle(), TIFFTAG_COMPRESSION, colorCompression());
     TIFFSetField(tif.handle(), TIFFTAG_BITSPERSAMPLE, uint16(8));
     TIFFSetField(tif.handle(), TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
 
-    const int width = image.width();
-    const int height = image.height();
-
-    std::vector<uint8_t> tmp_line(width * 3);
-
-    // Libtiff expects "RR GG BB" sequences regardless of CPU byte order.
-
-    for (int y = 0; y < height; ++y) {
-        const auto* p_src = (const uint32_t*) image.scanLine(y);
-        uint8_t* p_dst = &tmp_line[0];
-        for (int x = 0; x < width; ++x) {
-            const uint32_t ARGB = *p_src;
-            p_dst[0] = static_cast<uint8_t>(ARGB >> 16);
-            p_dst[1] = static_cast<uint8_t>(ARGB >> 8);
-            p_dst[2] = static_cast<uint8_t>(ARGB);
-            ++p_src;
-            p_dst += 3;
-        }
-        if (TIFFWriteScanline(tif.handle(), &tmp_line[0], y) == -1) {
-            return false;
-        }
-    }
-
-    return true;
-} // TiffWriter::writeRGB32Image
+    return writeStrips(tif, image, image.width() * 3, &convertRGB32Line);
+}
 
 bool TiffWriter::writeARGB32Image(const TiffHandle& tif, const QImage& image) {
     assert(image.format() == QImage::Format_ARGB32);
 
     TIFFSetField(tif.handle(), TIFFTAG_SAMPLESPERPIXEL, uint16(4));
-    TIFFSetField(tif.handle(), TIFFTAG_COMPRESSION,
-                 uint16(QSettings().value("settings/color_compression", COMPRESSION_LZW).toInt()));
+    TIFFSetField(tif.handle(), TIFFTAG_COMPRESSION, colorCompression());
     TIFFSetField(tif.handle(), TIFFTAG_BITSPERSAMPLE, uint16(8));
     TIFFSetField(tif.handle(), TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
+    // Without this, readers take the fourth sample for something other than alpha.
+    uint16 extra_samples[] = {EXTRASAMPLE_UNASSALPHA};
+    TIFFSetField(tif.handle(), TIFFTAG_EXTRASAMPLES, uint16(1), extra_samples);
 
+    return writeStrips(tif, image, image.width() * 4, &convertARGB32Line);
+}
+
+/**
+ * Writes the image in strips of about STRIP_BYTES.  Strips are compressed
+ * in parallel, each one into its own in-memory TIFF, and then copied
+ * to \p tif as raw strips, in order.
+ */
+bool TiffWriter::writeStrips(const TiffHandle& tif,
+                             const QImage& image,
+                             const int bytes_per_line,
+                             const LineConverter convert_line) {
     const int width = image.width();
     const int height = image.height();
 
-    std::vector<uint8_t> tmp_line(width * 4);
-
-    // Libtiff expects "RR GG BB AA" sequences regardless of CPU byte order.
-
-    for (int y = 0; y < height; ++y) {
-        const auto* p_src = (const uint32_t*) image.scanLine(y);
-        uint8_t* p_dst = &tmp_line[0];
-        for (int x = 0; x < width; ++x) {
-            const uint32_t ARGB = *p_src;
-            p_dst[0] = static_cast<uint8_t>(ARGB >> 16);
-            p_dst[1] = static_cast<uint8_t>(ARGB >> 8);
-            p_dst[2] = static_cast<uint8_t>(ARGB);
-            p_dst[3] = static_cast<uint8_t>(ARGB >> 24);
-            ++p_src;
-            p_dst += 4;
+    // Multiples of 16 rows keep the JPEG codec happy.
+    int rows_per_strip = std::max(1, STRIP_BYTES / bytes_per_line);
+    rows_per_strip = std::min((rows_per_strip + 15) / 16 * 16, height);
+    const int num_strips = (height + rows_per_strip - 1) / rows_per_strip;
+    TIFFSetField(tif.handle(), TIFFTAG_ROWSPERSTRIP, uint32(rows_per_strip));
+
+    // libtiff's encoders may modify the data passed to them,
+    // so we always convert lines into a temporary buffer.
+    auto fill_strip = [&](const int strip, std::vector<uint8_t>& data) {
+        const int y_begin = strip * rows_per_strip;
+        const int y_end = std::min(y_begin + rows_per_strip, height);
+        data.resize(static_cast<size_t>(y_end - y_begin) * bytes_per_line);
+        uint8_t* p_dst = &data[0];
+        for (int y = y_begin; y < y_end; ++y) {
+            convert_line(image.constScanLine(y), p_dst, width);
+            p_dst += bytes_per_line;
         }
-        if (TIFFWriteScanline(tif.handle(), &tmp_line[0], y) == -1) {
-            return false;
-        }
-    }
 
-    return true;
-} // TiffWriter::writeARGB32Image
+        return y_end - y_begin;
+    };
 
-bool TiffWriter::write8bitLines(const TiffHandle& tif, const QImage& image) {
-    const int width = image.width();
-    const int height = image.height();
+    const StripFormat format(tif);
+
+    // JPEG strips share the tables stored in the directory, so they
+    // can't be encoded independently.  Uncompressed data isn't worth it.
+    if ((num_strips < 2) || (format.compression == COMPRESSION_NONE) || (format.compression == COMPRESSION_JPEG)) {
+        std::vector<uint8_t> data;
+        for (int strip = 0; strip < num_strips; ++strip) {
+            fill_strip(strip, data);
+            if (TIFFWriteEncodedStrip(tif.handle(), strip, &data[0], tsize_t(data.size())) == -1) {
+                return false;
+            }
+        }
+
+        return true;
+    }
 
-    // TIFFWriteScanline() can actually modify the data you pass it,
-    // so we have to use a temporary buffer even when no coversion
-    // is required.
-    std::vector<uint8_t> tmp_line(width, 0);
+    std::vector<std::vector<uint8_t>> strips(num_strips);
+    QAtomicInt failed(0);
+    parallelFor(0, num_strips, 1, [&](const int begin, const int end) {
+        for (int strip = begin; strip < end && failed.load() == 0; ++strip) {
+            const int num_rows = fill_strip(strip, strips[strip]);
+            if (!encodeStrip(format, num_rows, strips[strip])) {
+                failed.store(1);
+            }
+        }
+    });
+    if (failed.load() != 0) {
+        return false;
+    }
 
-    for (int y = 0; y < height; ++y) {
-        const uint8_t* src_line = image.scanLine(y);
-        memcpy(&tmp_line[0], src_line, tmp_line.size());
-        if (TIFFWriteScanline(tif.handle(), &tmp_line[0], y) == -1) {
+    for (int strip = 0; strip < num_strips; ++strip) {
+        std::vector<uint8_t>& data = strips[strip];
+        if (TIFFWriteRawStrip(tif.handle(), strip, &data[0], tsize_t(data.size())) == -1) {
             return false;
         }
+        std::vector<uint8_t>().swap(data);
     }
 
     return true;
-}
+} // TiffWriter::writeStrips
 
-bool TiffWriter::writeBinaryLinesAsIs(const TiffHandle& tif, const QImage& image) {
-    const int width = image.width();
-    const int height = image.height();
-    // TIFFWriteScanline() can actually modify the data you pass it,
-    // so we have to use a temporary buffer even when no coversion
-    // is required.
-    const int bpl = (width + 7) / 8;
-    std::vector<uint8_t> tmp_line(bpl, 0);
+/**
+ * Replaces the uncompressed strip in \p data with its compressed form.
+ */
+bool TiffWriter::encodeStrip(const StripFormat& format, const int num_rows, std::vector<uint8_t>& data) {
+    QBuffer buffer;
+    buffer.open(QIODevice::ReadWrite);
+
+    {
+        TiffHandle strip_tif(
+                TIFFClientOpen(
+                        "strip", "wBm", &buffer, &deviceRead, &deviceWrite,
+                        &deviceSeek, &deviceClose, &deviceSize,
+                        &deviceMap, &deviceUnmap
+                )
+        );
+        if (!strip_tif.handle()) {
+            return false;
+        }
 
-    for (int y = 0; y < height; ++y) {
-        const uint8_t* src_line = image.scanLine(y);
-        memcpy(&tmp_line[0], src_line, bpl);
-        if (TIFFWriteScanline(tif.handle(), &tmp_line[0], y) == -1) {
+        format.applyTo(strip_tif.handle());
+        TIFFSetField(strip_tif.handle(), TIFFTAG_IMAGELENGTH, uint32(num_rows));
+        TIFFSetField(strip_tif.handle(), TIFFTAG_ROWSPERSTRIP, uint32(num_rows));
+        if (TIFFWriteEncodedStrip(strip_tif.handle(), 0, &data[0], tsize_t(data.size())) == -1) {
             return false;
         }
+    }  // Closing the handle writes the directory and closes the buffer.
+
+    buffer.open(QIODevice::ReadOnly);
+    const TiffHandle strip_tif(
+            TIFFClientOpen(
+                    "strip", "rm", &buffer, &deviceRead, &deviceWrite,
+                    &deviceSeek, &deviceClose, &deviceSize,
+                    &deviceMap, &deviceUnmap
+            )
+    );
+    if (!strip_tif.handle()) {
+        return false;
     }
 
-    return true;
+    const tsize_t size = TIFFRawStripSize(strip_tif.handle(), 0);
+    if (size <= 0) {
+        return false;
+    }
+    data.resize(static_cast<size_t>(size));
+
+    return TIFFReadRawStrip(strip_tif.handle(), 0, &data[0], size) == size;
+} // TiffWriter::encodeStrip
+
+// Libtiff expects "RR GG BB" sequences regardless of CPU byte order.
+void TiffWriter::convertRGB32Line(const uint8_t* src, uint8_t* dst, const int width) {
+    const auto* p_src = reinterpret_cast<const uint32_t*>(src);
+    for (int x = 0; x < width; ++x) {
+        const uint32_t ARGB = *p_src;
+        dst[0] = static_cast<uint8_t>(ARGB >> 16);
+        dst[1] = static_cast<uint8_t>(ARGB >> 8);
+        dst[2] = static_cast<uint8_t>(ARGB);
+        ++p_src;
+        dst += 3;
+    }
 }
 
-bool TiffWriter::writeBinaryLinesReversed(const TiffHandle& tif, const QImage& image) {
-    const int width = image.width();
-    const int height = image.height();
+// Libtiff expects "RR GG BB AA" sequences regardless of CPU byte order.
+void TiffWriter::convertARGB32Line(const uint8_t* src, uint8_t* dst, const int width) {
+    const auto* p_src = reinterpret_cast<const uint32_t*>(src);
+    for (int x = 0; x < width; ++x) {
+        const uint32_t ARGB = *p_src;
+        dst[0] = static_cast<uint8_t>(ARGB >> 16);
+        dst[1] = static_cast<uint8_t>(ARGB >> 8);
+        dst[2] = static_cast<uint8_t>(ARGB);
+        dst[3] = static_cast<uint8_t>(ARGB >> 24);
+        ++p_src;
+        dst += 4;
+    }
+}
+
+void TiffWriter::copy8bitLine(const uint8_t* src, uint8_t* dst, const int width) {
+    memcpy(dst, src, static_cast<size_t>(width));
+}
+
+void TiffWriter::copyBinaryLine(const uint8_t* src, uint8_t* dst, const int width) {
+    memcpy(dst, src, static_cast<size_t>((width + 7) / 8));
+}
 
+void TiffWriter::reverseBinaryLine(const uint8_t* src, uint8_t* dst, const int width) {
     const int bpl = (width + 7) / 8;
-    std::vector<uint8_t> tmp_line(bpl, 0);
+    for (int i = 0; i < bpl; ++i) {
+        dst[i] = m_reverseBitsLUT[src[i]];
+    }
+}
 
-    for (int y = 0; y < height; ++y) {
-        const uint8_t* src_line = image.scanLine(y);
-        for (int i = 0; i < bpl; ++i) {
-            tmp_line[i] = m_reverseBitsLUT[src_line[i]];
-        }
-        if (TIFFWriteScanline(tif.handle(), &tmp_line[0], y) == -1) {
-            return false;
-        }
+void TiffWriter::reloadSettings() {
+    QSettings settings;
+    bwCompressionSetting.store(settings.value("settings/bw_compression", COMPRESSION_CCITTFAX4).toInt());
+    colorCompressionSetting.store(settings.value("settings/color_compression", COMPRESSION_LZW).toInt());
+}
+
+uint16_t TiffWriter::bwCompression() {
+    if (bwCompressionSetting.load() < 0) {
+        reloadSettings();
     }
 
-    return true;
+    return static_cast<uint16_t>(bwCompressionSetting.load());
 }
 
+uint16_t TiffWriter::colorCompression() {
+    if (colorCompressionSetting.load() < 0) {
+        reloadSettings();
+    }
+
+    return static_cast<uint16_t>(colorCompressionSetting.load());
+}
@@ -21,6 +21,7 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <vector>
 #include <tiff.h>
 
 class QIODevice;
@@ -49,9 +50,25 @@ public:
      */
     static bool writeImage(QIODevice& device, const QImage& image);
 
+    /**
+     * \brief Re-reads the compression settings from QSettings.
+     *
+     * The settings are read on first use and then cached, so that writing
+     * a file doesn't involve QSettings.  Call this whenever the settings
+     * may have changed, such as at the start of batch processing.
+     */
+    static void reloadSettings();
+
 private:
     class TiffHandle;
 
+    struct StripFormat;
+
+    /**
+     * Converts a scanline of a QImage into the form libtiff expects.
+     */
+    typedef void (* LineConverter)(const uint8_t* src, uint8_t* dst, int width);
+
     static void setDpm(const TiffHandle& tif, const Dpm& dpm);
 
     static bool writeBitonalOrIndexed8Image(const TiffHandle& tif, const QImage& image);
@@ -60,11 +77,24 @@ private:
 
     static bool writeARGB32Image(const TiffHandle& tif, const QImage& image);
 
-    static bool write8bitLines(const TiffHandle& tif, const QImage& image);
+    static bool writeStrips(const TiffHandle& tif, const QImage& image,
+                            int bytes_per_line, LineConverter convert_line);
+
+    static bool encodeStrip(const StripFormat& format, int num_rows, std::vector<uint8_t>& data);
+
+    static void convertRGB32Line(const uint8_t* src, uint8_t* dst, int width);
+
+    static void convertARGB32Line(const uint8_t* src, uint8_t* dst, int width);
+
+    static void copy8bitLine(const uint8_t* src, uint8_t* dst, int width);
+
+    static void copyBinaryLine(const uint8_t* src, uint8_t* dst, int width);
+
+    static void reverseBinaryLine(const uint8_t* src, uint8_t* dst, int width);
 
-    static bool writeBinaryLinesAsIs(const TiffHandle& tif, const QImage& image);
+    static uint16_t bwCompression();
 
-    static bool writeBinaryLinesReversed(const TiffHandle& tif, const QImage& image);
+    static uint16_t colorCompression();
 
     static const uint8_t m_reverseBitsLUT[256];
 };
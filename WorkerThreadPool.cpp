@@ -18,6 +18,7 @@
 
 #include "WorkerThreadPool.h"
 #include "OutOfMemoryHandler.h"
+#include "ParallelFor.h"
 #include <QCoreApplication>
 #include <QThreadPool>
 #include <utility>
@@ -48,9 +49,14 @@ WorkerThreadPool::WorkerThreadPool(QObject* parent)
         : QObject(parent),
           m_pPool(new QThreadPool(this)) {
     updateNumberOfThreads();
+    // parallelFor() helpers only take idle threads of our pool, so together
+    // with the page tasks they never exceed the configured number of threads.
+    setParallelForThreadPool(m_pPool);
 }
 
-WorkerThreadPool::~WorkerThreadPool() = default;
+WorkerThreadPool::~WorkerThreadPool() {
+    setParallelForThreadPool(nullptr);
+}
 
 void WorkerThreadPool::shutdown() {
     m_pPool->waitForDone();
@@ -105,20 +111,6 @@ void WorkerThreadPool::customEvent(QEvent* event) {
 }
 
 void WorkerThreadPool::updateNumberOfThreads() {
-    int max_threads;
-    if (sizeof(void*) <= 4) {
-        // Restricting num of processors for 32-bit due to
-        // address space constraints.
-        max_threads = QThread::idealThreadCount();
-        if (max_threads > 2) {
-            max_threads = 2;
-        }
-    } else {
-        max_threads = QThread::idealThreadCount();
-    }
-
-    int num_threads = m_settings.value("settings/batch_processing_threads", max_threads).toInt();
-    num_threads = std::min<int>(num_threads, max_threads);
-    m_pPool->setMaxThreadCount(num_threads);
+    m_pPool->setMaxThreadCount(maxProcessingThreads());
 }
 
@@ -22,7 +22,6 @@
 #include "BackgroundTask.h"
 #include "FilterResult.h"
 #include <QObject>
-#include <QSettings>
 #include <memory>
 
 class QThreadPool;
@@ -58,7 +57,6 @@ private:
     void updateNumberOfThreads();
 
     QThreadPool* m_pPool;
-    QSettings m_settings;
 };
 
 
@@ -0,0 +1,156 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BenchmarkRunner.h"
+#include "PerformanceTimer.h"
+#include "version.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QHash>
+#include <QSysInfo>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <vector>
+#include <iostream>
+
+namespace benchmarks {
+    BenchmarkRunner::BenchmarkRunner(const int min_iterations, const double min_seconds, const QString& filter)
+            : m_minIterations(std::max(min_iterations, 1)),
+              m_minSeconds(min_seconds),
+              m_filter(filter) {
+    }
+
+    void BenchmarkRunner::run(const QString& name, const QString& input, const std::function<void()>& body) {
+        runCase(name, input, [&body]() {
+            body();
+
+            return QByteArray();
+        }, false);
+    }
+
+    void BenchmarkRunner::runWithOutput(const QString& name,
+                                        const QString& input,
+                                        const std::function<QByteArray()>& body) {
+        runCase(name, input, body, true);
+    }
+
+    void BenchmarkRunner::runCase(const QString& name,
+                                  const QString& input,
+                                  const std::function<QByteArray()>& body,
+                                  const bool record_output) {
+        const QString id(name + '/' + input);
+        if (!id.contains(m_filter)) {
+            return;
+        }
+
+        const QByteArray output(body());  // Warm up.
+
+        std::vector<double> timings;
+        double total = 0.0;
+        while ((int(timings.size()) < m_minIterations) || (total < m_minSeconds)) {
+            const PerformanceTimer timer;
+            body();
+            timings.push_back(timer.elapsed());
+            total += timings.back();
+        }
+
+        std::sort(timings.begin(), timings.end());
+        const size_t num = timings.size();
+        const double median = (num % 2 != 0) ? timings[num / 2] : (timings[num / 2 - 1] + timings[num / 2]) / 2;
+
+        QJsonObject result;
+        result["name"] = name;
+        result["input"] = input;
+        result["iterations"] = static_cast<int>(num);
+        result["min_ms"] = timings.front() * 1000.0;
+        result["median_ms"] = median * 1000.0;
+        result["mean_ms"] = total / num * 1000.0;
+        result["max_ms"] = timings.back() * 1000.0;
+        if (record_output) {
+            result["output_sha1"] = QString::fromLatin1(
+                    QCryptographicHash::hash(output, QCryptographicHash::Sha1).toHex()
+            );
+        }
+        m_results.append(result);
+
+        std::cerr << id.toStdString() << ": " << median * 1000.0 << " ms (median of " << num << ")" << std::endl;
+    }
+
+    QJsonObject BenchmarkRunner::results() const {
+        QJsonObject info;
+        info["version"] = QString(VERSION);
+        info["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+        info["cpu_architecture"] = QSysInfo::currentCpuArchitecture();
+        info["ideal_thread_count"] = QThread::idealThreadCount();
+
+        QJsonObject root;
+        root["info"] = info;
+        root["results"] = m_results;
+
+        return root;
+    }
+
+    int BenchmarkRunner::compare(const QJsonObject& baseline,
+                                 const QJsonObject& current,
+                                 const double tolerance,
+                                 QTextStream& out) {
+        QHash<QString, double> baseline_medians;
+        QHash<QString, QString> baseline_outputs;
+        for (const QJsonValue& value : baseline["results"].toArray()) {
+            const QJsonObject result(value.toObject());
+            const QString id(result["name"].toString() + '/' + result["input"].toString());
+            baseline_medians[id] = result["median_ms"].toDouble();
+            if (result.contains("output_sha1")) {
+                baseline_outputs[id] = result["output_sha1"].toString();
+            }
+        }
+
+        int num_regressions = 0;
+        for (const QJsonValue& value : current["results"].toArray()) {
+            const QJsonObject result(value.toObject());
+            const QString id(result["name"].toString() + '/' + result["input"].toString());
+
+            const auto output_it = baseline_outputs.constFind(id);
+            if ((output_it != baseline_outputs.constEnd()) && result.contains("output_sha1")
+                && (*output_it != result["output_sha1"].toString())) {
+                ++num_regressions;
+                out << "MISMATCH   " << id << ": the output differs from the baseline\n";
+            }
+
+            const auto it = baseline_medians.constFind(id);
+            if ((it == baseline_medians.constEnd()) || (*it <= 0.0)) {
+                continue;
+            }
+
+            const double median = result["median_ms"].toDouble();
+            const double change = (median - *it) / *it;
+            const bool regression = change > tolerance;
+            if (regression) {
+                ++num_regressions;
+            }
+
+            out << (regression ? "REGRESSION " : "           ") << id << ": "
+                << *it << " ms -> " << median << " ms ("
+                << (change >= 0 ? "+" : "") << QString::number(change * 100.0, 'f', 1) << "%)\n";
+        }
+        out.flush();
+
+        return num_regressions;
+    }
+}  // namespace benchmarks
@@ -0,0 +1,88 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCANTAILOR_BENCHMARKRUNNER_H
+#define SCANTAILOR_BENCHMARKRUNNER_H
+
+#include <QByteArray>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QString>
+#include <functional>
+
+class QTextStream;
+
+namespace benchmarks {
+    /**
+     * \brief Times benchmark cases and collects the results as JSON.
+     *
+     * Each case is run once to warm up, and then repeatedly, until both
+     * the minimum number of iterations and the minimum total time are reached.
+     */
+    class BenchmarkRunner {
+    public:
+        BenchmarkRunner(int min_iterations, double min_seconds, const QString& filter);
+
+        /**
+         * \brief Runs and times a benchmark case.
+         *
+         * \param name The name of the case, such as "binarizeSauvola".
+         * \param input The name of the input, such as "synthetic@300dpi".
+         * \param body The code to time.
+         *
+         * Cases whose "name/input" don't contain the filter string are skipped.
+         */
+        void run(const QString& name, const QString& input, const std::function<void()>& body);
+
+        /**
+         * \brief Same as run(), but also records a hash of what \p body returns.
+         *
+         * compare() reports cases whose output differs from the baseline,
+         * so an optimization can be checked to preserve the results.
+         */
+        void runWithOutput(const QString& name, const QString& input, const std::function<QByteArray()>& body);
+
+        /**
+         * \brief Returns the results in the form suitable for compare().
+         */
+        QJsonObject results() const;
+
+        /**
+         * \brief Compares current results with a baseline.
+         *
+         * A case is reported as a regression if its median time exceeds the
+         * baseline median by more than \p tolerance (0.1 meaning 10%).
+         * Cases missing from either side are ignored.  Cases whose output hash
+         * differs from the baseline one are reported as mismatches.
+         *
+         * \return The number of regressions and mismatches found.
+         */
+        static int compare(const QJsonObject& baseline, const QJsonObject& current, double tolerance, QTextStream& out);
+
+    private:
+        void runCase(const QString& name, const QString& input,
+                     const std::function<QByteArray()>& body, bool record_output);
+
+        int m_minIterations;
+        double m_minSeconds;
+        QString m_filter;
+        QJsonArray m_results;
+    };
+}  // namespace benchmarks
+
+#endif //SCANTAILOR_BENCHMARKRUNNER_H
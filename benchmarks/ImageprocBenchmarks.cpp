@@ -0,0 +1,304 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BenchmarkRunner.h"
+#include "SyntheticPage.h"
+#include "Despeckle.h"
+#include "Dpi.h"
+#include "Dpm.h"
+#include "TaskStatus.h"
+#include "imageproc/BinaryImage.h"
+#include "imageproc/BinaryThreshold.h"
+#include "imageproc/Binarize.h"
+#include "imageproc/ConnectivityMap.h"
+#include "imageproc/Constants.h"
+#include "imageproc/GaussBlur.h"
+#include "imageproc/GrayImage.h"
+#include "imageproc/Grayscale.h"
+#include "imageproc/Morphology.h"
+#include "imageproc/Scale.h"
+#include "imageproc/SEDM.h"
+#include "imageproc/SeedFill.h"
+#include "imageproc/SkewFinder.h"
+#include "imageproc/Transform.h"
+#include "dewarping/CylindricalSurfaceDewarper.h"
+#include "dewarping/RasterDewarper.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QJsonDocument>
+#include <QTextStream>
+#include <QTransform>
+#include <QColor>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace imageproc;
+using namespace benchmarks;
+
+namespace {
+    class NullTaskStatus : public TaskStatus {
+    public:
+        void cancel() override {
+        }
+
+        bool isCancelled() const override {
+            return false;
+        }
+
+        void throwIfCancelled() const override {
+        }
+    };
+
+
+    struct BenchmarkInput {
+        QString name;
+        int dpi;
+        GrayImage gray;
+        BinaryImage binary;
+
+        BenchmarkInput(const QString& name, int dpi, const GrayImage& gray)
+                : name(QString("%1@%2dpi").arg(name).arg(dpi)),
+                  dpi(dpi),
+                  gray(gray),
+                  binary(gray, BinaryThreshold::otsuThreshold(gray)) {
+        }
+    };
+
+
+    /**
+     * Scales a size expressed for 300 DPI to the given DPI, keeping it odd,
+     * so that the corresponding brick or window has a center pixel.
+     */
+    QSize from300dpi(const int size, const int dpi) {
+        const int scaled = std::max(1, size * dpi / 300) | 1;
+
+        return QSize(scaled, scaled);
+    }
+
+    std::vector<QPointF> makeDirectrix(const QRectF& rect, const double y, const double bulge) {
+        std::vector<QPointF> polyline;
+        const int num_points = 64;
+        for (int i = 0; i <= num_points; ++i) {
+            const double t = double(i) / num_points;
+            polyline.emplace_back(rect.left() + t * rect.width(), y + bulge * std::sin(t * constants::PI));
+        }
+
+        return polyline;
+    }
+
+    QByteArray toByteArray(const BinaryImage& image) {
+        return QByteArray(
+                reinterpret_cast<const char*>(image.data()),
+                image.wordsPerLine() * image.height() * static_cast<int>(sizeof(uint32_t))
+        );
+    }
+
+    /**
+     * Despeckling cases record their output, so running with --baseline
+     * also verifies the despeckled images didn't change.
+     */
+    void runDespeckle(BenchmarkRunner& runner, const BenchmarkInput& input) {
+        const Dpi image_dpi(input.dpi, input.dpi);
+        const NullTaskStatus status;
+        const struct {
+            const char* name;
+            Despeckle::Level level;
+        } levels[] = {{"despeckle_cautious", Despeckle::CAUTIOUS},
+                      {"despeckle_normal", Despeckle::NORMAL},
+                      {"despeckle_aggressive", Despeckle::AGGRESSIVE}};
+
+        for (const auto& level : levels) {
+            runner.runWithOutput(level.name, input.name, [&]() {
+                return toByteArray(Despeckle::despeckle(input.binary, image_dpi, level.level, status));
+            });
+        }
+    }
+
+    void runAll(BenchmarkRunner& runner, const BenchmarkInput& input) {
+        const GrayImage& gray = input.gray;
+        const BinaryImage& binary = input.binary;
+        const int dpi = input.dpi;
+        const QString& in = input.name;
+
+        runner.run("binarizeSauvola", in, [&]() {
+            binarizeSauvola(gray, from300dpi(51, dpi), 0.34);
+        });
+        runner.run("binarizeWolf", in, [&]() {
+            binarizeWolf(gray, from300dpi(51, dpi), 1, 254, 0.3);
+        });
+
+        const QSize brick(from300dpi(7, dpi));
+        runner.run("dilateBrick", in, [&]() { dilateBrick(binary, brick); });
+        runner.run("erodeBrick", in, [&]() { erodeBrick(binary, brick); });
+        runner.run("openBrick", in, [&]() { openBrick(binary, brick); });
+        runner.run("closeBrick", in, [&]() { closeBrick(binary, brick); });
+        runner.run("dilateGray", in, [&]() { dilateGray(gray, brick); });
+        runner.run("erodeGray", in, [&]() { erodeGray(gray, brick); });
+        runner.run("openGray", in, [&]() { openGray(gray, brick, 0xff); });
+        runner.run("closeGray", in, [&]() { closeGray(gray, brick, 0xff); });
+        runner.run("openGray_1x20", in, [&]() { openGray(gray, QSize(1, 20 * dpi / 300), 0xff); });
+
+        const BinaryImage seed(erodeBrick(binary, QSize(3, 3)));
+        runner.run("seedFill", in, [&]() { seedFill(seed, binary, CONN8); });
+        const GrayImage framed(createFramedImage(gray.size()));
+        runner.run("seedFillGray", in, [&]() { seedFillGray(framed, gray, CONN8); });
+
+        runner.run("SEDM", in, [&]() { SEDM(binary, SEDM::DIST_TO_BLACK, SEDM::DIST_TO_ALL_BORDERS); });
+        runner.run("ConnectivityMap", in, [&]() { ConnectivityMap(binary, CONN8); });
+
+        const QImage& gray_qimage = gray.toQImage();
+        runner.run("transform", in, [&]() {
+            QTransform xform;
+            xform.rotate(1.5);
+            const QRect dst_rect(xform.mapRect(QRectF(gray_qimage.rect())).toRect());
+            transform(gray_qimage, xform, dst_rect, OutsidePixels::assumeColor(Qt::white));
+        });
+        runner.run("scaleToGray", in, [&]() { scaleToGray(gray, gray.size() / 2); });
+        runner.run("gaussBlur", in, [&]() {
+            const auto sigma = static_cast<float>(3.0 * dpi / 300);
+            gaussBlur(gray, sigma, sigma);
+        });
+
+        runner.run("SkewFinder", in, [&]() { SkewFinder().findSkew(binary); });
+
+        runDespeckle(runner, input);
+
+        runner.run("RasterDewarper", in, [&]() {
+            const QRectF content_rect(QRectF(gray.rect()).adjusted(
+                    gray.width() * 0.1, gray.height() * 0.1, -gray.width() * 0.1, -gray.height() * 0.1
+            ));
+            const double bulge = content_rect.height() * 0.03;
+            const dewarping::CylindricalSurfaceDewarper dewarper(
+                    makeDirectrix(content_rect, content_rect.top(), bulge),
+                    makeDirectrix(content_rect, content_rect.bottom(), bulge), 2.0
+            );
+            dewarping::RasterDewarper::dewarp(gray_qimage, gray.size(), dewarper, content_rect, Qt::white);
+        });
+    }  // runAll
+}  // namespace
+
+int main(int argc, char** argv) {
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+            "Times imageproc kernels on synthetic and reference pages "
+            "and writes the results as JSON."
+    );
+    parser.addHelpOption();
+    const QCommandLineOption dpi_option(
+            "dpi", "Comma-separated DPIs of the synthetic pages (default: 300,600).", "list", "300,600"
+    );
+    const QCommandLineOption reference_option(
+            "reference", "A reference page to benchmark on. May be given multiple times.", "file"
+    );
+    const QCommandLineOption iterations_option(
+            "iterations", "Minimum number of timed iterations per case (default: 3).", "n", "3"
+    );
+    const QCommandLineOption min_time_option(
+            "min-time", "Minimum total time per case, in seconds (default: 0.5).", "seconds", "0.5"
+    );
+    const QCommandLineOption filter_option(
+            "filter", "Only run cases whose name/input contains this string.", "string"
+    );
+    const QCommandLineOption output_option(
+            "output", "Write JSON results to this file instead of stdout.", "file"
+    );
+    const QCommandLineOption baseline_option(
+            "baseline", "Compare the results with a JSON file from a previous run.", "file"
+    );
+    const QCommandLineOption tolerance_option(
+            "tolerance", "Slowdown in percent reported as a regression (default: 10).", "percent", "10"
+    );
+    parser.addOptions({dpi_option, reference_option, iterations_option, min_time_option,
+                       filter_option, output_option, baseline_option, tolerance_option});
+    parser.process(app);
+
+    std::vector<BenchmarkInput> inputs;
+    std::vector<BenchmarkInput> speckled_inputs;
+    for (const QString& dpi_str : parser.value(dpi_option).split(',', QString::SkipEmptyParts)) {
+        SyntheticPageParams params;
+        params.dpi = dpi_str.toInt();
+        params.skewAngle = 1.0;
+        if (params.dpi <= 0) {
+            std::cerr << "Invalid DPI: " << dpi_str.toStdString() << std::endl;
+
+            return 2;
+        }
+        inputs.emplace_back("synthetic", params.dpi, generateSyntheticPage(params));
+
+        // Dense speckle noise, where despeckling is the most expensive.
+        params.speckleDensity = 200.0;
+        speckled_inputs.emplace_back("speckled", params.dpi, generateSyntheticPage(params));
+    }
+    for (const QString& file : parser.values(reference_option)) {
+        const QImage image(file);
+        if (image.isNull()) {
+            std::cerr << "Failed to load " << file.toStdString() << std::endl;
+
+            return 2;
+        }
+        const Dpi dpi(Dpm(image));
+        inputs.emplace_back(QFileInfo(file).completeBaseName(), dpi.isNull() ? 300 : dpi.horizontal(), GrayImage(image));
+    }
+
+    BenchmarkRunner runner(
+            parser.value(iterations_option).toInt(), parser.value(min_time_option).toDouble(),
+            parser.value(filter_option)
+    );
+    for (const BenchmarkInput& input : inputs) {
+        runAll(runner, input);
+    }
+    for (const BenchmarkInput& input : speckled_inputs) {
+        runDespeckle(runner, input);
+    }
+
+    const QByteArray json(QJsonDocument(runner.results()).toJson());
+    if (parser.isSet(output_option)) {
+        QFile file(parser.value(output_option));
+        if (!file.open(QIODevice::WriteOnly) || (file.write(json) != json.size())) {
+            std::cerr << "Failed to write " << file.fileName().toStdString() << std::endl;
+
+            return 2;
+        }
+    } else {
+        std::cout << json.constData();
+    }
+
+    if (parser.isSet(baseline_option)) {
+        QFile file(parser.value(baseline_option));
+        if (!file.open(QIODevice::ReadOnly)) {
+            std::cerr << "Failed to read " << file.fileName().toStdString() << std::endl;
+
+            return 2;
+        }
+        QTextStream err(stderr);
+        const int num_regressions = BenchmarkRunner::compare(
+                QJsonDocument::fromJson(file.readAll()).object(), runner.results(),
+                parser.value(tolerance_option).toDouble() / 100.0, err
+        );
+
+        return num_regressions == 0 ? 0 : 1;
+    }
+
+    return 0;
+}  // main
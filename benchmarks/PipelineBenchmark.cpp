@@ -0,0 +1,334 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ProcessStats.h"
+#include "SyntheticPage.h"
+#include "CommandLine.h"
+#include "ConsoleBatch.h"
+#include "PerformanceTimer.h"
+#include "StageSequence.h"
+#include "version.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+
+using namespace benchmarks;
+
+namespace {
+    struct BookParams {
+        int numScans = 10;
+        int dpi = 300;
+        bool twoPages = true;
+        unsigned seed = 0;
+    };
+
+
+    /**
+     * Generates a deterministic book: skewed scans of facing pages
+     * with curved text lines, occasional pictures and speckle noise.
+     */
+    QStringList generateBook(const BookParams& book, const QDir& dir) {
+        std::mt19937 rng(book.seed);
+        std::uniform_real_distribution<double> skew(-2.0, 2.0);
+        std::uniform_real_distribution<double> curvature(0.05, 0.3);
+
+        QStringList files;
+        for (int i = 0; i < book.numScans; ++i) {
+            SyntheticPageParams params;
+            params.dpi = book.dpi;
+            params.twoPages = book.twoPages;
+            params.skewAngle = skew(rng);
+            params.curvature = curvature(rng);
+            params.picture = (i % 3 == 1);
+            params.speckleDensity = 40.0;
+            params.seed = book.seed + static_cast<unsigned>(i);
+
+            const QString file(dir.filePath(QString("scan_%1.png").arg(i + 1, 4, 10, QChar('0'))));
+            if (!generateSyntheticPage(params).toQImage().save(file, "PNG")) {
+                throw std::runtime_error("Failed to write " + file.toStdString());
+            }
+            files.push_back(file);
+        }
+
+        return files;
+    }
+
+    class TaskRunnable : public QRunnable {
+    public:
+        TaskRunnable(BackgroundTaskPtr task, QMutex& mutex, QStringList& errors)
+                : m_ptrTask(std::move(task)),
+                  m_rMutex(mutex),
+                  m_rErrors(errors) {
+            setAutoDelete(true);
+        }
+
+        void run() override {
+            try {
+                (*m_ptrTask)();
+            } catch (const std::exception& e) {
+                const QMutexLocker locker(&m_rMutex);
+                m_rErrors.push_back(QString::fromLocal8Bit(e.what()));
+            }
+        }
+
+    private:
+        BackgroundTaskPtr m_ptrTask;
+        QMutex& m_rMutex;
+        QStringList& m_rErrors;
+    };
+
+
+    QJsonObject runPipeline(const QStringList& cli_args,
+                            const QStringList& files,
+                            const QString& output_dir,
+                            const int num_threads,
+                            const int first_stage,
+                            const int last_stage) {
+        QDir(output_dir).removeRecursively();
+        QDir().mkpath(output_dir);
+
+        const CommandLine cli(QStringList() << QCoreApplication::applicationFilePath() << cli_args << files << output_dir,
+                              false);
+        if (cli.isError()) {
+            throw std::runtime_error(cli.errors().join("\n").toStdString());
+        }
+
+        ConsoleBatch batch(cli.images(), cli.outputDirectory(), cli.getLayoutDirection(), cli);
+        if ((first_stage < 1) || (last_stage > batch.stages()->count()) || (first_stage > last_stage)) {
+            throw std::runtime_error("Stage range is out of bounds.");
+        }
+
+        QThreadPool pool;
+        pool.setMaxThreadCount(num_threads);
+
+        const ProcessStats run_before(ProcessStats::current());
+        int64_t run_peak_rss = 0;
+
+        // The tasks of a stage run the pages through all the stages before it,
+        // as scantailor-cli does, so the numbers measured for a stage are
+        // cumulative.  A stage's own cost is what it adds to the previous one.
+        // If the range doesn't start with the first stage, its first stage
+        // includes the ones before it.
+        QJsonArray stages;
+        double prev_wall = 0.0;
+        double prev_cpu = 0.0;
+        int64_t prev_bytes_read = 0;
+        int64_t prev_bytes_written = 0;
+        int num_pages = 0;
+        for (int stage = first_stage; stage <= last_stage; ++stage) {
+            // Make the peak RSS of this stage independent of the previous ones.
+            ProcessStats::resetPeakRss();
+            const ProcessStats before(ProcessStats::current());
+            const PerformanceTimer timer;
+
+            QMutex mutex;
+            QStringList errors;
+            const std::vector<ConsoleBatch::PageTask> tasks(batch.createFilterTasks(stage - 1));
+            for (const ConsoleBatch::PageTask& page_task : tasks) {
+                pool.start(new TaskRunnable(page_task.task, mutex, errors));
+            }
+            pool.waitForDone();
+
+            const double wall = timer.elapsed();
+            const ProcessStats after(ProcessStats::current());
+            if (!errors.isEmpty()) {
+                throw std::runtime_error(errors.front().toStdString());
+            }
+            num_pages = static_cast<int>(tasks.size());
+
+            const double cpu = after.cpuSeconds - before.cpuSeconds;
+            const int64_t bytes_read = after.bytesRead - before.bytesRead;
+            const int64_t bytes_written = after.bytesWritten - before.bytesWritten;
+
+            QJsonObject result;
+            result["stage"] = stage;
+            result["name"] = batch.stages()->filterAt(stage - 1)->getName();
+            result["pages"] = num_pages;
+            // Timing noise may make a cheap stage come out slightly negative.
+            result["wall_s"] = std::max(wall - prev_wall, 0.0);
+            result["cpu_s"] = std::max(cpu - prev_cpu, 0.0);
+            result["bytes_read"] = static_cast<double>(std::max<int64_t>(bytes_read - prev_bytes_read, 0));
+            result["bytes_written"] = static_cast<double>(std::max<int64_t>(bytes_written - prev_bytes_written, 0));
+            result["cumulative_wall_s"] = wall;
+            result["cumulative_cpu_s"] = cpu;
+            result["peak_rss_bytes"] = static_cast<double>(after.peakRssBytes);
+            run_peak_rss = std::max(run_peak_rss, after.peakRssBytes);
+            stages.append(result);
+
+            std::cerr << "threads=" << num_threads << " stage " << stage << " ("
+                      << result["name"].toString().toStdString() << "): " << result["wall_s"].toDouble()
+                      << " s wall, " << result["cpu_s"].toDouble() << " s cpu" << std::endl;
+
+            prev_wall = wall;
+            prev_cpu = cpu;
+            prev_bytes_read = bytes_read;
+            prev_bytes_written = bytes_written;
+        }
+
+        QJsonObject run;
+        run["threads"] = num_threads;
+        run["stages"] = stages;
+        // Getting all pages through the last stage is what a scantailor-cli
+        // run does, so its cumulative time is that of the whole pipeline.
+        run["pipeline_wall_s"] = prev_wall;
+        run["pages_per_second"] = prev_wall > 0.0 ? num_pages / prev_wall : 0.0;
+        const ProcessStats run_after(ProcessStats::current());
+        run["cpu_s"] = run_after.cpuSeconds - run_before.cpuSeconds;
+        run["bytes_read"] = static_cast<double>(run_after.bytesRead - run_before.bytesRead);
+        run["bytes_written"] = static_cast<double>(run_after.bytesWritten - run_before.bytesWritten);
+        run["peak_rss_bytes"] = static_cast<double>(run_peak_rss);
+
+        return run;
+    }  // runPipeline
+}  // namespace
+
+int main(int argc, char** argv) {
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+            "Runs a generated book through the processing stages and reports per-stage "
+            "wall time, CPU time, peak RSS and I/O as JSON.\n"
+            "Arguments after -- are passed on as scantailor-cli options."
+    );
+    parser.addHelpOption();
+    const QCommandLineOption scans_option("scans", "Number of scans in the book (default: 10).", "n", "10");
+    const QCommandLineOption dpi_option("dpi", "Resolution of the scans (default: 300).", "dpi", "300");
+    const QCommandLineOption single_pages_option("single-pages", "Scan single pages rather than facing pairs.");
+    const QCommandLineOption seed_option("seed", "Seed for the book generator (default: 0).", "n", "0");
+    const QCommandLineOption threads_option(
+            "threads", "Comma-separated thread counts to run the pipeline with (default: 1 and all cores).", "list",
+            QString("1,%1").arg(QThread::idealThreadCount())
+    );
+    const QCommandLineOption stages_option(
+            "stages", "Range of stages to run, such as 1-4 (default: 1-6).", "first-last", "1-6"
+    );
+    const QCommandLineOption work_dir_option(
+            "work-dir", "Where to put the book and the output (default: a temporary directory).", "dir"
+    );
+    const QCommandLineOption output_option("output", "Write JSON results to this file instead of stdout.", "file");
+    parser.addOptions({scans_option, dpi_option, single_pages_option, seed_option, threads_option,
+                       stages_option, work_dir_option, output_option});
+    parser.addPositionalArgument("cli-options", "Options passed on to the processing, as for scantailor-cli.");
+    parser.process(app);
+
+    BookParams book;
+    book.numScans = parser.value(scans_option).toInt();
+    book.dpi = parser.value(dpi_option).toInt();
+    book.twoPages = !parser.isSet(single_pages_option);
+    book.seed = parser.value(seed_option).toUInt();
+    if ((book.numScans <= 0) || (book.dpi <= 0)) {
+        std::cerr << "Invalid book parameters." << std::endl;
+
+        return 2;
+    }
+
+    const QStringList stage_range(parser.value(stages_option).split('-'));
+    const int first_stage = stage_range.front().toInt();
+    const int last_stage = stage_range.back().toInt();
+
+    QTemporaryDir temp_dir;
+    const QDir work_dir(parser.isSet(work_dir_option) ? parser.value(work_dir_option) : temp_dir.path());
+    QDir().mkpath(work_dir.filePath("book"));
+
+    QStringList cli_args(parser.positionalArguments());
+    cli_args.push_back(QString("--dpi=%1").arg(book.dpi));
+
+    // The filters consult the global command line to tell the GUI from batch
+    // processing.  Each run passes its own copy to ConsoleBatch.
+    const CommandLine global_cli(QStringList() << QCoreApplication::applicationFilePath() << cli_args, false);
+    if (global_cli.isError()) {
+        std::cerr << global_cli.errors().join("\n").toStdString() << std::endl;
+
+        return 2;
+    }
+    CommandLine::set(global_cli);
+
+    QJsonArray runs;
+    try {
+        std::cerr << "Generating " << book.numScans << " scans in "
+                  << work_dir.absolutePath().toStdString() << std::endl;
+        const QStringList files(generateBook(book, QDir(work_dir.filePath("book"))));
+
+        for (const QString& threads : parser.value(threads_option).split(',', QString::SkipEmptyParts)) {
+            const int num_threads = threads.toInt();
+            if (num_threads <= 0) {
+                std::cerr << "Invalid thread count: " << threads.toStdString() << std::endl;
+
+                return 2;
+            }
+            runs.append(runPipeline(
+                    cli_args, files, work_dir.filePath(QString("out_%1").arg(num_threads)),
+                    num_threads, first_stage, last_stage
+            ));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+
+        return 1;
+    }
+
+    QJsonObject info;
+    info["version"] = QString(VERSION);
+    info["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    info["cpu_architecture"] = QSysInfo::currentCpuArchitecture();
+    info["ideal_thread_count"] = QThread::idealThreadCount();
+
+    QJsonObject book_info;
+    book_info["scans"] = book.numScans;
+    book_info["dpi"] = book.dpi;
+    book_info["two_pages"] = book.twoPages;
+    book_info["seed"] = static_cast<int>(book.seed);
+    book_info["cli_options"] = QJsonArray::fromStringList(cli_args);
+
+    QJsonObject root;
+    root["info"] = info;
+    root["book"] = book_info;
+    root["runs"] = runs;
+
+    const QByteArray json(QJsonDocument(root).toJson());
+    if (parser.isSet(output_option)) {
+        QFile file(parser.value(output_option));
+        if (!file.open(QIODevice::WriteOnly) || (file.write(json) != json.size())) {
+            std::cerr << "Failed to write " << file.fileName().toStdString() << std::endl;
+
+            return 2;
+        }
+    } else {
+        std::cout << json.constData();
+    }
+
+    return 0;
+}  // main
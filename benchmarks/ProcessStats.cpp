@@ -0,0 +1,129 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ProcessStats.h"
+#include <QtGlobal>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#include <sys/time.h>
+#endif
+
+#if defined(Q_OS_LINUX)
+#include <QFile>
+#endif
+
+namespace benchmarks {
+#if defined(Q_OS_WIN)
+    namespace {
+        double toSeconds(const FILETIME& time) {
+            ULARGE_INTEGER value;
+            value.LowPart = time.dwLowDateTime;
+            value.HighPart = time.dwHighDateTime;
+
+            return value.QuadPart / 1e7;  // 100-nanosecond units.
+        }
+    }
+
+    ProcessStats ProcessStats::current() {
+        ProcessStats stats;
+        const HANDLE process = GetCurrentProcess();
+
+        FILETIME creation_time, exit_time, kernel_time, user_time;
+        if (GetProcessTimes(process, &creation_time, &exit_time, &kernel_time, &user_time)) {
+            stats.cpuSeconds = toSeconds(kernel_time) + toSeconds(user_time);
+        }
+
+        PROCESS_MEMORY_COUNTERS memory_counters;
+        if (GetProcessMemoryInfo(process, &memory_counters, sizeof(memory_counters))) {
+            stats.peakRssBytes = static_cast<int64_t>(memory_counters.PeakWorkingSetSize);
+        }
+
+        IO_COUNTERS io_counters;
+        if (GetProcessIoCounters(process, &io_counters)) {
+            stats.bytesRead = static_cast<int64_t>(io_counters.ReadTransferCount);
+            stats.bytesWritten = static_cast<int64_t>(io_counters.WriteTransferCount);
+        }
+
+        return stats;
+    }
+
+#elif defined(Q_OS_UNIX)
+
+    ProcessStats ProcessStats::current() {
+        ProcessStats stats;
+
+        struct rusage usage {};
+        if (getrusage(RUSAGE_SELF, &usage) == 0) {
+            stats.cpuSeconds = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6
+                               + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+#if defined(Q_OS_MAC)
+            stats.peakRssBytes = usage.ru_maxrss;  // Already in bytes.
+#else
+            stats.peakRssBytes = static_cast<int64_t>(usage.ru_maxrss) * 1024;
+#endif
+        }
+
+#if defined(Q_OS_LINUX)
+        // rchar and wchar count all bytes passed through read() and write()
+        // family calls, whether or not they were served from the page cache.
+        QFile io_file("/proc/self/io");
+        if (io_file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            for (const QByteArray& line : io_file.readAll().split('\n')) {
+                if (line.startsWith("rchar:")) {
+                    stats.bytesRead = line.mid(6).trimmed().toLongLong();
+                } else if (line.startsWith("wchar:")) {
+                    stats.bytesWritten = line.mid(6).trimmed().toLongLong();
+                }
+            }
+        }
+
+        // Unlike ru_maxrss, VmHWM is reset by resetPeakRss().
+        QFile status_file("/proc/self/status");
+        if (status_file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            for (const QByteArray& line : status_file.readAll().split('\n')) {
+                if (line.startsWith("VmHWM:")) {
+                    stats.peakRssBytes = line.mid(6).trimmed().split(' ').front().toLongLong() * 1024;
+                }
+            }
+        }
+#endif
+
+        return stats;
+    }
+
+#else
+
+    ProcessStats ProcessStats::current() {
+        return ProcessStats();
+    }
+
+#endif
+
+    void ProcessStats::resetPeakRss() {
+#if defined(Q_OS_LINUX)
+        QFile clear_refs("/proc/self/clear_refs");
+        if (clear_refs.open(QIODevice::WriteOnly)) {
+            clear_refs.write("5");
+        }
+#endif
+    }
+}  // namespace benchmarks
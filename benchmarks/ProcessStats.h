@@ -0,0 +1,55 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCANTAILOR_PROCESSSTATS_H
+#define SCANTAILOR_PROCESSSTATS_H
+
+#include <cstdint>
+
+namespace benchmarks {
+    /**
+     * \brief Resource usage counters of the current process.
+     *
+     * Counters that aren't available on the current platform are left at zero.
+     */
+    struct ProcessStats {
+        /**
+         * User plus system CPU time of all threads, in seconds.
+         */
+        double cpuSeconds = 0.0;
+
+        /**
+         * The peak resident set size, in bytes.  That's the peak since the last
+         * resetPeakRss() call where supported, or since the process was started.
+         */
+        int64_t peakRssBytes = 0;
+
+        int64_t bytesRead = 0;
+
+        int64_t bytesWritten = 0;
+
+        static ProcessStats current();
+
+        /**
+         * Starts tracking the peak resident set size anew.  Only supported on Linux.
+         */
+        static void resetPeakRss();
+    };
+}  // namespace benchmarks
+
+#endif //SCANTAILOR_PROCESSSTATS_H
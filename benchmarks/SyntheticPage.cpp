@@ -0,0 +1,245 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SyntheticPage.h"
+#include "Dpm.h"
+#include "Dpi.h"
+#include "imageproc/Constants.h"
+#include <QRect>
+#include <QtMath>
+#include <algorithm>
+#include <random>
+#include <cmath>
+
+namespace benchmarks {
+    namespace {
+        const double PAGE_WIDTH_INCHES = 8.27;
+        const double PAGE_HEIGHT_INCHES = 11.69;
+        const double MARGIN_INCHES = 0.8;
+        const double LINE_SPACING_INCHES = 0.18;
+        const double X_HEIGHT_INCHES = 0.06;
+
+        enum SpinePosition { NO_SPINE, SPINE_LEFT, SPINE_RIGHT };
+
+        void fillRect(imageproc::GrayImage& image, int left, int top, int width, int height, uint8_t color) {
+            const int x0 = std::max(left, 0);
+            const int y0 = std::max(top, 0);
+            const int x1 = std::min(left + width, image.width());
+            const int y1 = std::min(top + height, image.height());
+            if ((x0 >= x1) || (y0 >= y1)) {
+                return;
+            }
+
+            const int stride = image.stride();
+            uint8_t* line = image.data() + y0 * stride;
+            for (int y = y0; y < y1; ++y) {
+                std::fill(line + x0, line + x1, color);
+                line += stride;
+            }
+        }
+
+        void drawBackground(imageproc::GrayImage& image, std::mt19937& rng) {
+            std::uniform_int_distribution<int> noise(-4, 4);
+            const int width = image.width();
+            const int height = image.height();
+            const int stride = image.stride();
+            uint8_t* line = image.data();
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    // Darker towards the bottom right corner, like a page
+                    // that wasn't lit evenly by the scanner.
+                    const double falloff = 25.0 * (double(x) / width + double(y) / height) / 2.0;
+                    const int level = static_cast<int>(std::lround(240.0 - falloff)) + noise(rng);
+                    line[x] = static_cast<uint8_t>(qBound(0, level, 255));
+                }
+                line += stride;
+            }
+        }
+
+        void drawGutter(imageproc::GrayImage& image, const int spine_x, const int dpi) {
+            const int half_width = dpi / 4;
+            const int stride = image.stride();
+            for (int x = std::max(0, spine_x - half_width); x < std::min(image.width(), spine_x + half_width); ++x) {
+                // The shadow gets deeper towards the spine.
+                const double closeness = 1.0 - std::abs(x - spine_x) / double(half_width);
+                const double factor = 1.0 - 0.6 * closeness * closeness;
+                uint8_t* p = image.data() + x;
+                for (int y = 0; y < image.height(); ++y, p += stride) {
+                    *p = static_cast<uint8_t>(*p * factor);
+                }
+            }
+        }
+
+        QRect pictureArea(const QRect& page, const int dpi) {
+            const int margin = static_cast<int>(MARGIN_INCHES * dpi);
+
+            return QRect(page.left() + margin, page.top() + page.height() / 3, page.width() - 2 * margin, page.height() / 4);
+        }
+
+        void drawPicture(imageproc::GrayImage& image, const QRect& area, std::mt19937& rng) {
+            std::uniform_int_distribution<int> noise(-10, 10);
+            const QRect rect(area.intersected(image.rect()));
+            const int stride = image.stride();
+            uint8_t* line = image.data() + rect.top() * stride;
+            for (int y = rect.top(); y <= rect.bottom(); ++y) {
+                for (int x = rect.left(); x <= rect.right(); ++x) {
+                    const double val = 128.0 + 80.0 * std::sin(x / 7.0) * std::cos(y / 11.0)
+                                       - 40.0 * double(y - rect.top()) / rect.height();
+                    line[x] = static_cast<uint8_t>(qBound(0, static_cast<int>(val) + noise(rng), 255));
+                }
+                line += stride;
+            }
+        }
+
+        /**
+         * Returns the vertical displacement of a text line at \p x
+         * due to page curvature.
+         */
+        double curvatureOffset(const QRect& page, const int x, const double amplitude, const SpinePosition spine) {
+            const double t = double(x - page.left()) / page.width();
+            switch (spine) {
+                case SPINE_LEFT:
+                    return amplitude * (1.0 - t) * (1.0 - t);
+                case SPINE_RIGHT:
+                    return amplitude * t * t;
+                default:
+                    return amplitude * std::sin(t * imageproc::constants::PI);
+            }
+        }
+
+        void drawTextBlock(imageproc::GrayImage& image,
+                           const QRect& page,
+                           const SpinePosition spine,
+                           const QRect& picture_area,
+                           const SyntheticPageParams& params,
+                           std::mt19937& rng) {
+            const double dpi = params.dpi;
+            const int margin = static_cast<int>(MARGIN_INCHES * dpi);
+            const int line_spacing = static_cast<int>(LINE_SPACING_INCHES * dpi);
+            const int x_height = std::max(2, static_cast<int>(X_HEIGHT_INCHES * dpi));
+            const int stroke = std::max(1, x_height / 6);
+            const double slope = std::tan(qDegreesToRadians(params.skewAngle));
+            const double curvature = params.curvature * dpi;
+            const int page_center_x = page.left() + page.width() / 2;
+
+            std::uniform_int_distribution<int> glyph_width(x_height / 2, x_height);
+            std::uniform_int_distribution<int> word_length(1, 9);
+            std::uniform_int_distribution<int> glyph_kind(0, 5);
+            std::uniform_int_distribution<int> ink(10, 60);
+
+            const int right_limit = page.left() + page.width() - margin;
+            for (int baseline = page.top() + margin + line_spacing; baseline < page.top() + page.height() - margin;
+                 baseline += line_spacing) {
+                int x = page.left() + margin;
+                while (x < right_limit) {
+                    const int num_glyphs = word_length(rng);
+                    for (int i = 0; (i < num_glyphs) && (x < right_limit); ++i) {
+                        const int w = glyph_width(rng);
+                        const auto y = static_cast<int>(
+                                baseline + slope * (x - page_center_x) + curvatureOffset(page, x, curvature, spine)
+                        );
+                        const auto color = static_cast<uint8_t>(ink(rng));
+                        const int kind = glyph_kind(rng);
+                        if (picture_area.contains(x, baseline)) {
+                            x += w + stroke * 2;
+                            continue;
+                        }
+                        switch (kind) {
+                            case 0:  // Ascender.
+                                fillRect(image, x, y - 2 * x_height, stroke, 2 * x_height, color);
+                                fillRect(image, x, y - x_height, w, stroke, color);
+                                fillRect(image, x + w - stroke, y - x_height, stroke, x_height, color);
+                                break;
+                            case 1:  // Descender.
+                                fillRect(image, x, y - x_height, stroke, 2 * x_height, color);
+                                fillRect(image, x, y - x_height, w, stroke, color);
+                                fillRect(image, x, y - stroke, w, stroke, color);
+                                break;
+                            default:  // A box-like lowercase glyph.
+                                fillRect(image, x, y - x_height, stroke, x_height, color);
+                                fillRect(image, x + w - stroke, y - x_height, stroke, x_height, color);
+                                fillRect(image, x, y - x_height, w, stroke, color);
+                                fillRect(image, x, y - stroke, w, stroke, color);
+                                break;
+                        }
+                        x += w + stroke * 2;
+                    }
+                    x += x_height;  // Word spacing.
+                }
+            }
+        }  // drawTextBlock
+
+        void drawSpeckles(imageproc::GrayImage& image, const SyntheticPageParams& params, std::mt19937& rng) {
+            const double area_sq_inches = double(image.width()) * image.height() / (double(params.dpi) * params.dpi);
+            const auto num_speckles = static_cast<int>(params.speckleDensity * area_sq_inches);
+            const int max_size = std::max(1, params.dpi / 150);
+
+            std::uniform_int_distribution<int> pos_x(0, image.width() - 1);
+            std::uniform_int_distribution<int> pos_y(0, image.height() - 1);
+            std::uniform_int_distribution<int> size(1, max_size);
+            std::uniform_int_distribution<int> ink(0, 80);
+            for (int i = 0; i < num_speckles; ++i) {
+                const int x = pos_x(rng);
+                const int y = pos_y(rng);
+                const int s = size(rng);
+                fillRect(image, x, y, s, s, static_cast<uint8_t>(ink(rng)));
+            }
+        }
+
+        void drawPage(imageproc::GrayImage& image,
+                      const QRect& page,
+                      const SpinePosition spine,
+                      const SyntheticPageParams& params,
+                      std::mt19937& rng) {
+            QRect picture_area;
+            if (params.picture) {
+                picture_area = pictureArea(page, params.dpi);
+                drawPicture(image, picture_area, rng);
+            }
+            drawTextBlock(image, page, spine, picture_area, params, rng);
+        }
+    }  // namespace
+
+    imageproc::GrayImage generateSyntheticPage(const SyntheticPageParams& params) {
+        const QSize page_size(
+                static_cast<int>(PAGE_WIDTH_INCHES * params.dpi),
+                static_cast<int>(PAGE_HEIGHT_INCHES * params.dpi)
+        );
+        const QSize size(params.twoPages ? page_size.width() * 2 : page_size.width(), page_size.height());
+
+        std::mt19937 rng(params.seed);
+        imageproc::GrayImage image(size);
+        drawBackground(image, rng);
+        if (params.twoPages) {
+            drawPage(image, QRect(QPoint(0, 0), page_size), SPINE_RIGHT, params, rng);
+            drawPage(image, QRect(QPoint(page_size.width(), 0), page_size), SPINE_LEFT, params, rng);
+            drawGutter(image, page_size.width(), params.dpi);
+        } else {
+            drawPage(image, QRect(QPoint(0, 0), page_size), NO_SPINE, params, rng);
+        }
+        if (params.speckleDensity > 0.0) {
+            drawSpeckles(image, params, rng);
+        }
+
+        const Dpm dpm(Dpi(params.dpi, params.dpi));
+        image.setDotsPerMeterX(dpm.horizontal());
+        image.setDotsPerMeterY(dpm.vertical());
+
+        return image;
+    }
+}  // namespace benchmarks
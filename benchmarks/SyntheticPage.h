@@ -0,0 +1,71 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCANTAILOR_SYNTHETICPAGE_H
+#define SCANTAILOR_SYNTHETICPAGE_H
+
+#include "imageproc/GrayImage.h"
+
+namespace benchmarks {
+    /**
+     * \brief Parameters of a generated page.
+     *
+     * Pages generated with equal parameters are identical,
+     * so benchmark results are comparable across runs and commits.
+     */
+    struct SyntheticPageParams {
+        int dpi = 300;
+
+        /**
+         * Clockwise rotation of the text block, in degrees.
+         */
+        double skewAngle = 0.0;
+
+        /**
+         * How much text lines bend towards the spine, in inches.
+         * For single pages, lines bow in the middle instead.
+         */
+        double curvature = 0.0;
+
+        /**
+         * Whether to render two facing pages on a single scan.
+         */
+        bool twoPages = false;
+
+        /**
+         * Whether to put a halftone-like picture into each page.
+         */
+        bool picture = false;
+
+        /**
+         * The number of dark speckles per square inch.
+         */
+        double speckleDensity = 0.0;
+
+        unsigned seed = 0;
+    };
+
+    /**
+     * \brief Renders a grayscale A4 page (or a spread of two of them)
+     *        with lines of glyph-like strokes on a slightly unevenly
+     *        lit background.
+     */
+    imageproc::GrayImage generateSyntheticPage(const SyntheticPageParams& params);
+}  // namespace benchmarks
+
+#endif //SCANTAILOR_SYNTHETICPAGE_H
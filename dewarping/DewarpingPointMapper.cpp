@@ -19,6 +19,7 @@
 #include "DewarpingPointMapper.h"
 #include "DistortionModel.h"
 #include <QTransform>
+#include <QRect>
 
 namespace dewarping {
     DewarpingPointMapper::DewarpingPointMapper(const DistortionModel& distortion_model,
@@ -26,19 +27,40 @@ namespace dewarping {
                                                const QTransform& distortion_model_to_output,
                                                const QRect& output_content_rect,
                                                const QTransform& postTransform)
-            : m_dewarper(
-            CylindricalSurfaceDewarper(
-                    distortion_model.topCurve().polyline(),
-                    distortion_model.bottomCurve().polyline(),
-                    depth_perception
-            )
-    ),
+            : m_postTransform(postTransform) {
+        const CylindricalSurfaceDewarper dewarper(
+                distortion_model.topCurve().polyline(),
+                distortion_model.bottomCurve().polyline(),
+                depth_perception
+        );
+        initModelDomain(dewarper, distortion_model, distortion_model_to_output, output_content_rect);
+
+        // This constructor is used to map a handful of points, so we map them exactly
+        // rather than sample a generatrix for every output column.
+        m_ptrGeneratrixTable.reset(new GeneratrixTable(dewarper));
+    }
+
+    DewarpingPointMapper::DewarpingPointMapper(std::shared_ptr<const GeneratrixTable> generatrix_table,
+                                               const DistortionModel& distortion_model,
+                                               const QTransform& distortion_model_to_output,
+                                               const QRect& output_content_rect,
+                                               const QTransform& postTransform)
+            : m_ptrGeneratrixTable(std::move(generatrix_table)),
               m_postTransform(postTransform) {
+        initModelDomain(
+                m_ptrGeneratrixTable->dewarper(), distortion_model, distortion_model_to_output, output_content_rect
+        );
+    }
+
+    QRect DewarpingPointMapper::initModelDomain(const CylindricalSurfaceDewarper& dewarper,
+                                                const DistortionModel& distortion_model,
+                                                const QTransform& distortion_model_to_output,
+                                                const QRect& output_content_rect) {
         // Model domain is a rectangle in output image coordinates that
         // will be mapped to our curved quadrilateral.
         const QRect model_domain(
                 distortion_model.modelDomain(
-                        m_dewarper, distortion_model_to_output, output_content_rect
+                        dewarper, distortion_model_to_output, output_content_rect
                 ).toRect()
         );
 
@@ -52,10 +74,12 @@ namespace dewarping {
         m_modelDomainTop = model_domain.top();
         m_modelYScaleFromNormalized = model_domain.bottom() - model_domain.top();
         m_modelYScaleToNormalized = 1.0 / m_modelYScaleFromNormalized;
+
+        return model_domain;
     }
 
     QPointF DewarpingPointMapper::mapToDewarpedSpace(const QPointF& warped_pt) const {
-        const QPointF crv_pt(m_dewarper.mapToDewarpedSpace(warped_pt));
+        const QPointF crv_pt(m_ptrGeneratrixTable->mapToDewarpedSpace(warped_pt));
         const double dewarped_x = crv_pt.x() * m_modelXScaleFromNormalized + m_modelDomainLeft;
         const double dewarped_y = crv_pt.y() * m_modelYScaleFromNormalized + m_modelDomainTop;
 
@@ -68,6 +92,6 @@ namespace dewarping {
         const double crv_x = (dewarped_pt_m.x() - m_modelDomainLeft) * m_modelXScaleToNormalized;
         const double crv_y = (dewarped_pt_m.y() - m_modelDomainTop) * m_modelYScaleToNormalized;
 
-        return m_dewarper.mapToWarpedSpace(QPointF(crv_x, crv_y));
+        return m_ptrGeneratrixTable->mapToWarpedSpace(QPointF(crv_x, crv_y));
     }
 }  // namespace dewarping
\ No newline at end of file
@@ -20,7 +20,8 @@
 #define DEWARPING_DEWARPING_POINT_MAPPER_H_
 
 #include <QtGui/QTransform>
-#include "CylindricalSurfaceDewarper.h"
+#include "GeneratrixTable.h"
+#include <memory>
 
 class QRect;
 
@@ -29,12 +30,27 @@ namespace dewarping {
 
     class DewarpingPointMapper {
     public:
+        /**
+         * Maps points with CylindricalSurfaceDewarper directly.
+         */
         DewarpingPointMapper(const dewarping::DistortionModel& distortion_model,
                              double depth_perception,
                              const QTransform& distortion_model_to_output,
                              const QRect& output_content_rect,
                              const QTransform& postTransform = QTransform());
 
+        /**
+         * Same as above, but reuses a generatrix table, typically the one
+         * the dewarped image was rendered with.  The table must have been
+         * built for the same distortion model and depth perception, without
+         * transforming the model.
+         */
+        DewarpingPointMapper(std::shared_ptr<const GeneratrixTable> generatrix_table,
+                             const dewarping::DistortionModel& distortion_model,
+                             const QTransform& distortion_model_to_output,
+                             const QRect& output_content_rect,
+                             const QTransform& postTransform = QTransform());
+
         /**
          * Similar to CylindricalSurfaceDewarper::mapToDewarpedSpace(),
          * except it maps to dewarped image coordinates rather than
@@ -50,7 +66,12 @@ namespace dewarping {
         QPointF mapToWarpedSpace(const QPointF& dewarped_pt) const;
 
     private:
-        CylindricalSurfaceDewarper m_dewarper;
+        QRect initModelDomain(const CylindricalSurfaceDewarper& dewarper,
+                              const dewarping::DistortionModel& distortion_model,
+                              const QTransform& distortion_model_to_output,
+                              const QRect& output_content_rect);
+
+        std::shared_ptr<const GeneratrixTable> m_ptrGeneratrixTable;
         double m_modelDomainLeft;
         double m_modelDomainTop;
         double m_modelXScaleFromNormalized;
@@ -29,10 +29,13 @@
 #include "spfit/SplineFitter.h"
 #include "spfit/LinearForceBalancer.h"
 #include "spfit/ConstraintSet.h"
+#include "Tracer.h"
+#include "ParallelFor.h"
 #include <QImage>
 #include <QPainter>
 #include <QDebug>
 #include <boost/foreach.hpp>
+#include <memory>
 
 using namespace imageproc;
 
@@ -77,7 +80,17 @@ namespace dewarping {
                 : m_rAllCurves(all_curves) {
         }
 
-        void buildAndAssessModel(const TracedCurve* top_curve, const TracedCurve* bottom_curve);
+        /**
+         * Queues a pair of curves to be assessed by assessCandidates().
+         */
+        void addCandidate(const TracedCurve* top_curve, const TracedCurve* bottom_curve);
+
+        /**
+         * Assesses the queued candidates in parallel and updates the best model.
+         * Among candidates with equal errors, the one queued first wins,
+         * just like it would if they were assessed one by one.
+         */
+        void assessCandidates();
 
         RansacModel& bestModel() {
             return m_bestModel;
@@ -88,9 +101,17 @@ namespace dewarping {
         }
 
     private:
+        /**
+         * Builds a model from a pair of curves and calculates its error.
+         *
+         * \return false if no valid model could be built.
+         */
+        bool assessModel(const TracedCurve* top_curve, const TracedCurve* bottom_curve, double& error) const;
+
         double calcReferenceHeight(const CylindricalSurfaceDewarper& dewarper, const QPointF& loc);
 
         RansacModel m_bestModel;
+        std::vector<RansacModel> m_candidates;
         const std::vector<TracedCurve>& m_rAllCurves;
     };
 
@@ -150,20 +171,31 @@ namespace dewarping {
     }
 
     DistortionModel DistortionModelBuilder::tryBuildModel(DebugImages* dbg, const QImage* dbg_background) const {
+        const TraceSpan span("dewarping", "DistortionModelBuilder::tryBuildModel");
+
         auto num_curves = static_cast<int>(m_ltrPolylines.size());
 
         if ((num_curves < 2) || (m_bound1.p1() == m_bound1.p2()) || (m_bound2.p1() == m_bound2.p2())) {
             return DistortionModel();
         }
 
+        // Curves are fitted in parallel, but collected in their original order.
+        std::vector<std::unique_ptr<TracedCurve>> fitted_curves(static_cast<size_t>(num_curves));
+        parallelFor(0, num_curves, 1, [&](const int first, const int last) {
+            for (int i = first; i < last; ++i) {
+                try {
+                    fitted_curves[i].reset(new TracedCurve(polylineToCurve(m_ltrPolylines[i])));
+                } catch (const BadCurve&) {
+                    // Just skip it.
+                }
+            }
+        });
+
         std::vector<TracedCurve> ordered_curves;
         ordered_curves.reserve(num_curves);
-
-        for (const std::vector<QPointF>& polyline : m_ltrPolylines) {
-            try {
-                ordered_curves.push_back(polylineToCurve(polyline));
-            } catch (const BadCurve&) {
-                // Just skip it.
+        for (const std::unique_ptr<TracedCurve>& curve : fitted_curves) {
+            if (curve) {
+                ordered_curves.push_back(std::move(*curve));
             }
         }
         num_curves = static_cast<int>(ordered_curves.size());
@@ -183,7 +215,7 @@ namespace dewarping {
         for (int i = 0; i < std::min<int>(3, num_curves); ++i) {
             for (int j = std::max<int>(0, num_curves - 3); j < num_curves; ++j) {
                 if (i < j) {
-                    ransac.buildAndAssessModel(&ordered_curves[i], &ordered_curves[j]);
+                    ransac.addCandidate(&ordered_curves[i], &ordered_curves[j]);
                 }
             }
         }
@@ -197,9 +229,10 @@ namespace dewarping {
                 std::swap(i, j);
             }
             if (i < j) {
-                ransac.buildAndAssessModel(&ordered_curves[i], &ordered_curves[j]);
+                ransac.addCandidate(&ordered_curves[i], &ordered_curves[j]);
             }
         }
+        ransac.assessCandidates();
 
         if (dbg && dbg_background) {
             dbg->add(visualizeTrimmedPolylines(*dbg_background, ordered_curves), "trimmed_polylines");
@@ -443,14 +476,42 @@ namespace dewarping {
 
 /*============================== RansacAlgo ============================*/
 
-    void DistortionModelBuilder::RansacAlgo::buildAndAssessModel(const TracedCurve* top_curve,
-                                                                 const TracedCurve* bottom_curve)
+    void DistortionModelBuilder::RansacAlgo::addCandidate(const TracedCurve* top_curve,
+                                                          const TracedCurve* bottom_curve) {
+        RansacModel candidate;
+        candidate.topCurve = top_curve;
+        candidate.bottomCurve = bottom_curve;
+        m_candidates.push_back(candidate);
+    }
+
+    void DistortionModelBuilder::RansacAlgo::assessCandidates() {
+        const auto num_candidates = static_cast<int>(m_candidates.size());
+        std::vector<char> valid(m_candidates.size(), 0);
+
+        parallelFor(0, num_candidates, 1, [&](const int first, const int last) {
+            for (int i = first; i < last; ++i) {
+                RansacModel& candidate = m_candidates[i];
+                valid[i] = assessModel(candidate.topCurve, candidate.bottomCurve, candidate.totalError);
+            }
+        });
+
+        for (int i = 0; i < num_candidates; ++i) {
+            if (valid[i] && (m_candidates[i].totalError < m_bestModel.totalError)) {
+                m_bestModel = m_candidates[i];
+            }
+        }
+        m_candidates.clear();
+    }
+
+    bool DistortionModelBuilder::RansacAlgo::assessModel(const TracedCurve* top_curve,
+                                                         const TracedCurve* bottom_curve,
+                                                         double& error) const
     try {
         DistortionModel model;
         model.setTopCurve(Curve(top_curve->extendedPolyline));
         model.setBottomCurve(Curve(bottom_curve->extendedPolyline));
         if (!model.isValid()) {
-            return;
+            return false;
         }
 
         const double depth_perception = 2.0;  // Doesn't matter much here.
@@ -458,7 +519,7 @@ namespace dewarping {
                 top_curve->extendedPolyline, bottom_curve->extendedPolyline, depth_perception
         );
 
-        double error = 0;
+        error = 0;
         for (const TracedCurve& curve : m_rAllCurves) {
             const size_t polyline_size = curve.trimmedPolyline.size();
             const double r_reference_height = 1.0 / 1.0;  // calcReferenceHeight(dewarper, curve.centroid);
@@ -514,14 +575,11 @@ namespace dewarping {
             }
         }
 
-        if (error < m_bestModel.totalError) {
-            m_bestModel.topCurve = top_curve;
-            m_bestModel.bottomCurve = bottom_curve;
-            m_bestModel.totalError = error;
-        }
-    }      // DistortionModelBuilder::RansacAlgo::buildAndAssessModel
+        return true;
+    }      // DistortionModelBuilder::RansacAlgo::assessModel
     catch (const std::runtime_error&) {
         // Probably CylindricalSurfaceDewarper didn't like something.
+        return false;
     }
 
 #if 0
@@ -0,0 +1,67 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "GeneratrixTable.h"
+#include <algorithm>
+
+namespace dewarping {
+    GeneratrixTable::GeneratrixTable(const CylindricalSurfaceDewarper& dewarper,
+                                     const QRectF& model_domain,
+                                     const int num_columns)
+            : m_dewarper(dewarper),
+              m_modelDomain(model_domain),
+              m_modelXScale(1.0 / (model_domain.right() - model_domain.left())) {
+        const double model_domain_left = model_domain.left();
+
+        m_generatrices.reserve(static_cast<size_t>(num_columns + 1));
+
+        CylindricalSurfaceDewarper::State state;
+        for (int x = 0; x <= num_columns; ++x) {
+            const double model_x = (x - model_domain_left) * m_modelXScale;
+            m_generatrices.push_back(m_dewarper.mapGeneratrix(model_x, state));
+        }
+    }
+
+    GeneratrixTable::GeneratrixTable(const CylindricalSurfaceDewarper& dewarper)
+            : m_dewarper(dewarper),
+              m_modelXScale(1.0) {
+    }
+
+    QPointF GeneratrixTable::mapToWarpedSpace(const QPointF& crv_pt) const {
+        if (m_generatrices.empty()) {
+            return m_dewarper.mapToWarpedSpace(crv_pt);
+        }
+
+        const double column = crv_pt.x() * (m_modelDomain.right() - m_modelDomain.left()) + m_modelDomain.left();
+        const int last_column = numColumns();
+        if (!(column >= 0) || !(column <= last_column)) {
+            return m_dewarper.mapToWarpedSpace(crv_pt);
+        }
+
+        const int left = std::min(static_cast<int>(column), std::max(last_column - 1, 0));
+        const int right = std::min(left + 1, last_column);
+        const double alpha = column - left;
+
+        const CylindricalSurfaceDewarper::Generatrix& gtx1 = m_generatrices[left];
+        const CylindricalSurfaceDewarper::Generatrix& gtx2 = m_generatrices[right];
+        const QPointF pt1(gtx1.imgLine.pointAt(gtx1.pln2img(crv_pt.y())));
+        const QPointF pt2(gtx2.imgLine.pointAt(gtx2.pln2img(crv_pt.y())));
+
+        return pt1 + (pt2 - pt1) * alpha;
+    }
+}  // namespace dewarping
@@ -0,0 +1,101 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCANTAILOR_GENERATRIXTABLE_H
+#define SCANTAILOR_GENERATRIXTABLE_H
+
+#include "CylindricalSurfaceDewarper.h"
+#include <QRectF>
+#include <QPointF>
+#include <vector>
+
+namespace dewarping {
+    /**
+     * \brief Generatrices of a CylindricalSurfaceDewarper, sampled once per output column.
+     *
+     * Evaluating CylindricalSurfaceDewarper::mapGeneratrix() involves arc length
+     * mapping, polyline intersections and setting up a homography.  This table
+     * does that once for every column of the output image, after which the
+     * rasterizer and point mappers can share it.  The table is immutable and
+     * may be used from multiple threads at once.
+     */
+    class GeneratrixTable {
+    public:
+        /**
+         * \brief Samples generatrices for output columns [0, num_columns].
+         *
+         * Column x is mapped to crv_x = (x - model_domain.left()) / model_domain.width(),
+         * which is what RasterDewarper does.  There is one more sample than columns,
+         * as both edges of every column are needed.
+         *
+         * \throw std::runtime_error if a generatrix can't be built.
+         */
+        GeneratrixTable(const CylindricalSurfaceDewarper& dewarper, const QRectF& model_domain, int num_columns);
+
+        /**
+         * \brief Creates an empty table, which maps every point with the dewarper.
+         *
+         * Sampling generatrices only pays off when many points are mapped.
+         */
+        explicit GeneratrixTable(const CylindricalSurfaceDewarper& dewarper);
+
+        const CylindricalSurfaceDewarper& dewarper() const {
+            return m_dewarper;
+        }
+
+        const QRectF& modelDomain() const {
+            return m_modelDomain;
+        }
+
+        int numColumns() const {
+            return static_cast<int>(m_generatrices.size()) - 1;
+        }
+
+        /**
+         * \brief Returns the generatrix at the left edge of an output column.
+         *
+         * \p column must be in [0, numColumns()].
+         */
+        const CylindricalSurfaceDewarper::Generatrix& generatrix(int column) const {
+            return m_generatrices[column];
+        }
+
+        /**
+         * Same as CylindricalSurfaceDewarper::mapToWarpedSpace(), but interpolates
+         * linearly between the neighbouring sampled generatrices.  Points outside
+         * of the sampled range are mapped by the dewarper directly.
+         */
+        QPointF mapToWarpedSpace(const QPointF& crv_pt) const;
+
+        /**
+         * Same as CylindricalSurfaceDewarper::mapToDewarpedSpace().
+         */
+        QPointF mapToDewarpedSpace(const QPointF& img_pt) const {
+            return m_dewarper.mapToDewarpedSpace(img_pt);
+        }
+
+    private:
+        CylindricalSurfaceDewarper m_dewarper;
+        QRectF m_modelDomain;
+        double m_modelXScale;
+        std::vector<CylindricalSurfaceDewarper::Generatrix> m_generatrices;
+    };
+}  // namespace dewarping
+
+
+#endif //SCANTAILOR_GENERATRIXTABLE_H
@@ -18,8 +18,10 @@
 
 #include "RasterDewarper.h"
 #include "CylindricalSurfaceDewarper.h"
+#include "GeneratrixTable.h"
 #include "imageproc/ColorMixer.h"
 #include "imageproc/GrayImage.h"
+#include "Tracer.h"
 #include <QDebug>
 #include <cmath>
 
@@ -40,27 +42,19 @@ namespace dewarping {
                            PixelType* const dst_data,
                            const QSize dst_size,
                            const int dst_stride,
-                           const CylindricalSurfaceDewarper& distortion_model,
-                           const QRectF& model_domain,
+                           const GeneratrixTable& generatrix_table,
                            const PixelType bg_color) {
             const int src_width = src_size.width();
             const int src_height = src_size.height();
             const int dst_width = dst_size.width();
             const int dst_height = dst_size.height();
 
-            CylindricalSurfaceDewarper::State state;
-
-            const double model_domain_left = model_domain.left();
-            const double model_x_scale = 1.0 / (model_domain.right() - model_domain.left());
-
+            const QRectF& model_domain = generatrix_table.modelDomain();
             const float model_domain_top = model_domain.top();
             const float model_y_scale = 1.0 / (model_domain.bottom() - model_domain.top());
 
             for (int dst_x = 0; dst_x < dst_width; ++dst_x) {
-                const double model_x = (dst_x - model_domain_left) * model_x_scale;
-                const CylindricalSurfaceDewarper::Generatrix generatrix(
-                    distortion_model.mapGeneratrix(model_x, state)
-                );
+                const CylindricalSurfaceDewarper::Generatrix& generatrix = generatrix_table.generatrix(dst_x);
 
                 const HomographicTransform<1, float> homog(generatrix.pln2img.mat());
                 const Vec2f origin(generatrix.imgLine.p1());
@@ -88,27 +82,21 @@ namespace dewarping {
                            PixelType* const dst_data,
                            const QSize dst_size,
                            const int dst_stride,
-                           const CylindricalSurfaceDewarper& distortion_model,
-                           const QRectF& model_domain,
+                           const GeneratrixTable& generatrix_table,
                            const PixelType bg_color) {
             const int src_width = src_size.width();
             const int src_height = src_size.height();
             const int dst_width = dst_size.width();
             const int dst_height = dst_size.height();
 
-            CylindricalSurfaceDewarper::State state;
-
-            const double model_domain_left = model_domain.left() - 0.5f;
-            const double model_x_scale = 1.0 / (model_domain.right() - model_domain.left());
-
+            // Note: unlike the vertical one, the horizontal half-pixel shift
+            // isn't applied, as generatrices come from the table.
+            const QRectF& model_domain = generatrix_table.modelDomain();
             const float model_domain_top = model_domain.top() - 0.5f;
             const float model_y_scale = 1.0 / (model_domain.bottom() - model_domain.top());
 
             for (int dst_x = 0; dst_x < dst_width; ++dst_x) {
-                const double model_x = (dst_x - model_domain_left) * model_x_scale;
-                const CylindricalSurfaceDewarper::Generatrix generatrix(
-                    distortion_model.mapGeneratrix(model_x, state)
-                );
+                const CylindricalSurfaceDewarper::Generatrix& generatrix = generatrix_table.generatrix(dst_x);
 
                 const HomographicTransform<1, float> homog(generatrix.pln2img.mat());
                 const Vec2f origin(generatrix.imgLine.p1());
@@ -419,19 +407,14 @@ namespace dewarping {
                            PixelType* const dst_data,
                            const QSize dst_size,
                            const int dst_stride,
-                           const CylindricalSurfaceDewarper& distortion_model,
-                           const QRectF& model_domain,
+                           const GeneratrixTable& generatrix_table,
                            const PixelType bg_color) {
             const int src_width = src_size.width();
             const int src_height = src_size.height();
             const int dst_width = dst_size.width();
             const int dst_height = dst_size.height();
 
-            CylindricalSurfaceDewarper::State state;
-
-            const double model_domain_left = model_domain.left();
-            const double model_x_scale = 1.0 / (model_domain.right() - model_domain.left());
-
+            const QRectF& model_domain = generatrix_table.modelDomain();
             const auto model_domain_top = static_cast<const float>(model_domain.top());
             const auto model_y_scale = static_cast<const float>(1.0 / (model_domain.bottom() - model_domain.top()));
 
@@ -439,10 +422,7 @@ namespace dewarping {
             std::vector<Vec2f> next_grid_column(dst_height + 1);
 
             for (int dst_x = 0; dst_x <= dst_width; ++dst_x) {
-                const double model_x = (dst_x - model_domain_left) * model_x_scale;
-                const CylindricalSurfaceDewarper::Generatrix generatrix(
-                        distortion_model.mapGeneratrix(model_x, state)
-                );
+                const CylindricalSurfaceDewarper::Generatrix& generatrix = generatrix_table.generatrix(dst_x);
 
                 const HomographicTransform<1, float> homog(generatrix.pln2img.mat());
                 const Vec2f origin(generatrix.imgLine.p1());
@@ -472,8 +452,7 @@ namespace dewarping {
 
         QImage dewarpGrayscale(const QImage& src,
                                const QSize& dst_size,
-                               const CylindricalSurfaceDewarper& distortion_model,
-                               const QRectF& model_domain,
+                               const GeneratrixTable& generatrix_table,
                                const QColor& bg_color) {
             GrayImage dst(dst_size);
             const auto bg_sample = static_cast<const uint8_t>(qGray(bg_color.rgb()));
@@ -481,7 +460,7 @@ namespace dewarping {
             dewarpGeneric<GrayColorMixer<MixingWeight>, uint8_t>(
                     src.bits(), src.size(), src.bytesPerLine(),
                     dst.data(), dst_size, dst.stride(),
-                    distortion_model, model_domain, bg_sample
+                    generatrix_table, bg_sample
             );
 
             return dst.toQImage();
@@ -489,15 +468,14 @@ namespace dewarping {
 
         QImage dewarpRgb(const QImage& src,
                          const QSize& dst_size,
-                         const CylindricalSurfaceDewarper& distortion_model,
-                         const QRectF& model_domain,
+                         const GeneratrixTable& generatrix_table,
                          const QColor& bg_color) {
             QImage dst(dst_size, QImage::Format_RGB32);
             dst.fill(bg_color.rgb());
             dewarpGeneric<RgbColorMixer<MixingWeight>, uint32_t>(
                     (const uint32_t*) src.bits(), src.size(), src.bytesPerLine() / 4,
                     (uint32_t*) dst.bits(), dst_size, dst.bytesPerLine() / 4,
-                    distortion_model, model_domain, bg_color.rgb()
+                    generatrix_table, bg_color.rgb()
             );
 
             return dst;
@@ -505,15 +483,14 @@ namespace dewarping {
 
         QImage dewarpArgb(const QImage& src,
                           const QSize& dst_size,
-                          const CylindricalSurfaceDewarper& distortion_model,
-                          const QRectF& model_domain,
+                          const GeneratrixTable& generatrix_table,
                           const QColor& bg_color) {
             QImage dst(dst_size, QImage::Format_ARGB32);
             dst.fill(bg_color.rgba());
             dewarpGeneric<ArgbColorMixer<MixingWeight>, uint32_t>(
                     (const uint32_t*) src.bits(), src.size(), src.bytesPerLine() / 4,
                     (uint32_t*) dst.bits(), dst_size, dst.bytesPerLine() / 4,
-                    distortion_model, model_domain, bg_color.rgba()
+                    generatrix_table, bg_color.rgba()
             );
 
             return dst;
@@ -529,21 +506,36 @@ namespace dewarping {
             throw std::invalid_argument("RasterDewarper: model_domain is empty.");
         }
 
+        return dewarp(src, dst_size, GeneratrixTable(distortion_model, model_domain, dst_size.width()), bg_color);
+    }
+
+    QImage RasterDewarper::dewarp(const QImage& src,
+                                  const QSize& dst_size,
+                                  const GeneratrixTable& generatrix_table,
+                                  const QColor& bg_color) {
+        const TraceSpan span("dewarping", "RasterDewarper::dewarp");
+
+        if (generatrix_table.modelDomain().isEmpty()) {
+            throw std::invalid_argument("RasterDewarper: model_domain is empty.");
+        }
+        if (generatrix_table.numColumns() < dst_size.width()) {
+            throw std::invalid_argument("RasterDewarper: generatrix_table is too narrow.");
+        }
+
         switch (src.format()) {
             case QImage::Format_Invalid:
                 return QImage();
             case QImage::Format_RGB32:
-                return dewarpRgb(src, dst_size, distortion_model, model_domain, bg_color);
+                return dewarpRgb(src, dst_size, generatrix_table, bg_color);
             case QImage::Format_ARGB32:
-                return dewarpArgb(src, dst_size, distortion_model, model_domain, bg_color);
+                return dewarpArgb(src, dst_size, generatrix_table, bg_color);
             case QImage::Format_Indexed8:
                 if (src.isGrayscale()) {
-                    return dewarpGrayscale(src, dst_size, distortion_model, model_domain, bg_color);
+                    return dewarpGrayscale(src, dst_size, generatrix_table, bg_color);
                 } else if (src.allGray()) {
                     // Only shades of gray but non-standard palette.
                     return dewarpGrayscale(
-                            GrayImage(src).toQImage(), dst_size, distortion_model,
-                            model_domain, bg_color
+                            GrayImage(src).toQImage(), dst_size, generatrix_table, bg_color
                     );
                 }
                 break;
@@ -552,7 +544,7 @@ namespace dewarping {
                 if (src.allGray()) {
                     return dewarpGrayscale(
                             GrayImage(src).toQImage(),
-                            dst_size, distortion_model, model_domain, bg_color
+                            dst_size, generatrix_table, bg_color
                     );
                 }
                 break;
@@ -562,12 +554,12 @@ namespace dewarping {
         if (src.hasAlphaChannel()) {
             return dewarpArgb(
                     src.convertToFormat(QImage::Format_ARGB32),
-                    dst_size, distortion_model, model_domain, bg_color
+                    dst_size, generatrix_table, bg_color
             );
         } else {
             return dewarpRgb(
                     src.convertToFormat(QImage::Format_RGB32),
-                    dst_size, distortion_model, model_domain, bg_color
+                    dst_size, generatrix_table, bg_color
             );
         }
     }  // RasterDewarper::dewarp
@@ -26,6 +26,7 @@ class QColor;
 
 namespace dewarping {
     class CylindricalSurfaceDewarper;
+    class GeneratrixTable;
 
     class RasterDewarper {
     public:
@@ -34,6 +35,15 @@ namespace dewarping {
                              const CylindricalSurfaceDewarper& distortion_model,
                              const QRectF& model_domain,
                              const QColor& background_color);
+
+        /**
+         * Same as above, but takes generatrices from a precomputed table,
+         * which must cover at least dst_size.width() columns.
+         */
+        static QImage dewarp(const QImage& src,
+                             const QSize& dst_size,
+                             const GeneratrixTable& generatrix_table,
+                             const QColor& background_color);
     };
 }  // namespace dewarping
 #endif
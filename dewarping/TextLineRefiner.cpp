@@ -21,11 +21,13 @@
 #include "DebugImages.h"
 #include "imageproc/GaussBlur.h"
 #include "imageproc/Sobel.h"
+#include "ParallelFor.h"
 #include <boost/foreach.hpp>
 #include <boost/lambda/lambda.hpp>
 #include <boost/lambda/bind.hpp>
 #include <QPainter>
 #include <QDebug>
+#include <algorithm>
 #include <cmath>
 
 using namespace imageproc;
@@ -103,8 +105,10 @@ namespace dewarping {
               m_unitDownVec(unit_down_vector) {
     }
 
-    void
-    TextLineRefiner::refine(std::list<std::vector<QPointF>>& polylines, const int iterations, DebugImages* dbg) const {
+    void TextLineRefiner::refine(std::list<std::vector<QPointF>>& polylines,
+                                 const int iterations,
+                                 DebugImages* dbg,
+                                 const int band_margin) const {
         if (polylines.empty()) {
             return;
         }
@@ -121,16 +125,25 @@ namespace dewarping {
             dbg->add(visualizeSnakes(snakes), "initial_snakes");
         }
 
+        std::vector<Band> bands;
+        if (band_margin > 0) {
+            bands = calcBands(polylines, band_margin);
+        }
+
         Grid<float> gradient(m_image.width(), m_image.height(),  /*padding=*/ 0);
+        const auto num_snakes = static_cast<int>(snakes.size());
 
         // Start with a rather strong blur.
         float h_sigma = (4.0f / 200.f) * m_dpi.horizontal();
         float v_sigma = (4.0f / 200.f) * m_dpi.vertical();
-        calcBlurredGradient(gradient, h_sigma, v_sigma);
+        calcBlurredGradient(gradient, bands, h_sigma, v_sigma);
 
-        for (Snake& snake : snakes) {
-            evolveSnake(snake, gradient, ON_CONVERGENCE_STOP);
-        }
+        // Snakes evolve independently from each other.
+        parallelFor(0, num_snakes, 1, [&](const int first, const int last) {
+            for (int i = first; i < last; ++i) {
+                evolveSnake(snakes[i], gradient, ON_CONVERGENCE_STOP);
+            }
+        });
         if (dbg) {
             dbg->add(visualizeSnakes(snakes, &gradient), "evolved_snakes1");
         }
@@ -138,11 +151,13 @@ namespace dewarping {
         // Less blurring this time.
         h_sigma *= 0.5f;
         v_sigma *= 0.5f;
-        calcBlurredGradient(gradient, h_sigma, v_sigma);
+        calcBlurredGradient(gradient, bands, h_sigma, v_sigma);
 
-        for (Snake& snake : snakes) {
-            evolveSnake(snake, gradient, ON_CONVERGENCE_GO_FINER);
-        }
+        parallelFor(0, num_snakes, 1, [&](const int first, const int last) {
+            for (int i = first; i < last; ++i) {
+                evolveSnake(snakes[i], gradient, ON_CONVERGENCE_GO_FINER);
+            }
+        });
         if (dbg) {
             dbg->add(visualizeSnakes(snakes, &gradient), "evolved_snakes2");
         }
@@ -159,30 +174,107 @@ namespace dewarping {
         }
     }  // TextLineRefiner::refine
 
-    void TextLineRefiner::calcBlurredGradient(Grid<float>& gradient, float h_sigma, float v_sigma) const {
+    std::vector<TextLineRefiner::Band>
+    TextLineRefiner::calcBands(const std::list<std::vector<QPointF>>& polylines, const int band_margin) const {
+        std::vector<Band> bands;
+        for (const std::vector<QPointF>& polyline : polylines) {
+            if (polyline.empty()) {
+                continue;
+            }
+
+            double min_y = polyline.front().y();
+            double max_y = min_y;
+            for (const QPointF& pt : polyline) {
+                min_y = std::min(min_y, pt.y());
+                max_y = std::max(max_y, pt.y());
+            }
+
+            const int top = std::max(0, static_cast<int>(std::floor(min_y)) - band_margin);
+            const int bottom = std::min(m_image.height(), static_cast<int>(std::ceil(max_y)) + band_margin + 1);
+            if (top < bottom) {
+                bands.emplace_back(top, bottom);
+            }
+        }
+
+        // Merge overlapping bands.
+        std::sort(bands.begin(), bands.end());
+        std::vector<Band> merged;
+        for (const Band& band : bands) {
+            if (!merged.empty() && (band.first <= merged.back().second)) {
+                merged.back().second = std::max(merged.back().second, band.second);
+            } else {
+                merged.push_back(band);
+            }
+        }
+
+        return merged;
+    }
+
+    void TextLineRefiner::calcBlurredGradient(Grid<float>& gradient,
+                                              const int top,
+                                              const float h_sigma,
+                                              const float v_sigma) const {
         using namespace boost::lambda;
 
+        const int width = gradient.width();
+        const int height = gradient.height();
+        const uint8_t* image_data = m_image.data() + top * m_image.stride();
+
         const float downscale = 1.0f / (255.0f * 8.0f);
-        Grid<float> vert_grad(m_image.width(), m_image.height(),  /*padding=*/ 0);
+        Grid<float> vert_grad(width, height,  /*padding=*/ 0);
         horizontalSobel<float>(
-                m_image.width(), m_image.height(), m_image.data(), m_image.stride(), _1 * downscale,
+                width, height, image_data, m_image.stride(), _1 * downscale,
                 gradient.data(), gradient.stride(), _1 = _2, _1,
                 gradient.data(), gradient.stride(), _1 = _2
         );
         verticalSobel<float>(
-                m_image.width(), m_image.height(), m_image.data(), m_image.stride(), _1 * downscale,
+                width, height, image_data, m_image.stride(), _1 * downscale,
                 vert_grad.data(), vert_grad.stride(), _1 = _2, _1,
                 gradient.data(), gradient.stride(),
                 _1 = _1 * m_unitDownVec[0] + _2 * m_unitDownVec[1]
         );
         Grid<float>().swap(vert_grad);  // Save memory.
         gaussBlurGeneric(
-                m_image.size(), h_sigma, v_sigma,
+                QSize(width, height), h_sigma, v_sigma,
                 gradient.data(), gradient.stride(), _1,
                 gradient.data(), gradient.stride(), _1 = _2
         );
     }
 
+    void TextLineRefiner::calcBlurredGradient(Grid<float>& gradient,
+                                              const std::vector<Band>& bands,
+                                              const float h_sigma,
+                                              const float v_sigma) const {
+        if (bands.empty()) {
+            calcBlurredGradient(gradient, 0, h_sigma, v_sigma);
+
+            return;
+        }
+
+        gradient.initInterior(0.0f);
+
+        // Bands are extended by enough rows for the blur not to notice the cut.
+        const int padding = static_cast<int>(std::ceil(3.0f * v_sigma)) + 1;
+        const int width = m_image.width();
+        const int height = m_image.height();
+
+        parallelFor(0, static_cast<int>(bands.size()), 1, [&](const int first, const int last) {
+            for (int i = first; i < last; ++i) {
+                const Band& band = bands[i];
+                const int top = std::max(0, band.first - padding);
+                const int bottom = std::min(height, band.second + padding);
+
+                Grid<float> band_gradient(width, bottom - top,  /*padding=*/ 0);
+                calcBlurredGradient(band_gradient, top, h_sigma, v_sigma);
+
+                for (int y = band.first; y < band.second; ++y) {
+                    const float* src_line = band_gradient.data() + (y - top) * band_gradient.stride();
+                    std::copy(src_line, src_line + width, gradient.data() + y * gradient.stride());
+                }
+            }
+        });
+    }
+
     float TextLineRefiner::externalEnergyAt(const Grid<float>& gradient, const Vec2f& pos, float penalty_if_outside) {
         const auto x_base = static_cast<const float>(floor(pos[0]));
         const auto y_base = static_cast<const float>(floor(pos[1]));
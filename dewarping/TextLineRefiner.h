@@ -27,6 +27,7 @@
 #include <QLineF>
 #include <vector>
 #include <list>
+#include <utility>
 #include <cstdint>
 
 class Dpi;
@@ -38,7 +39,16 @@ namespace dewarping {
     public:
         TextLineRefiner(const imageproc::GrayImage& image, const Dpi& dpi, const Vec2f& unit_down_vector);
 
-        void refine(std::list<std::vector<QPointF>>& polylines, int iterations, DebugImages* dbg) const;
+        /**
+         * \param band_margin If positive, the image gradient is only computed
+         *        within horizontal bands spanning the vertical extent of each
+         *        polyline, extended by this many pixels up and down.  Snakes
+         *        are not attracted to anything outside of these bands.
+         */
+        void refine(std::list<std::vector<QPointF>>& polylines,
+                    int iterations,
+                    DebugImages* dbg,
+                    int band_margin = 0) const;
 
     private:
         enum OnConvergence {
@@ -72,7 +82,22 @@ namespace dewarping {
             float pathCost{ 0 };
         };
 
-        void calcBlurredGradient(Grid<float>& gradient, float h_sigma, float v_sigma) const;
+        /**
+         * A range of rows, end exclusive.
+         */
+        typedef std::pair<int, int> Band;
+
+        std::vector<Band> calcBands(const std::list<std::vector<QPointF>>& polylines, int band_margin) const;
+
+        /**
+         * Calculates the blurred gradient of rows [top, top + gradient.height()) of the image.
+         */
+        void calcBlurredGradient(Grid<float>& gradient, int top, float h_sigma, float v_sigma) const;
+
+        void calcBlurredGradient(Grid<float>& gradient,
+                                 const std::vector<Band>& bands,
+                                 float h_sigma,
+                                 float v_sigma) const;
 
         static float externalEnergyAt(const Grid<float>& gradient, const Vec2f& pos, float penalty_if_outside);
 
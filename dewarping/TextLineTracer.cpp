@@ -41,6 +41,7 @@
 #include "imageproc/SeedFill.h"
 #include "imageproc/LocalMinMaxGeneric.h"
 #include "imageproc/SEDM.h"
+#include "Tracer.h"
 #include <QPainter>
 #include <boost/foreach.hpp>
 #include <boost/lambda/lambda.hpp>
@@ -56,8 +57,9 @@ namespace dewarping {
                                const QRect& content_rect,
                                DistortionModelBuilder& output,
                                const TaskStatus& status,
-                               DebugImages* dbg) {
-        using namespace boost::lambda;
+                               DebugImages* dbg,
+                               const Mode mode) {
+        const TraceSpan span("dewarping", "TextLineTracer::trace");
 
         GrayImage downscaled(downscale(input, dpi));
         if (dbg) {
@@ -73,49 +75,57 @@ namespace dewarping {
         to_orig.scale(1.0 / downscale_x_factor, 1.0 / downscale_y_factor);
 
         const QRect downscaled_content_rect(to_orig.inverted().mapRect(content_rect));
-        const Dpi downscaled_dpi(
-                qRound(dpi.horizontal() * downscale_x_factor),
-                qRound(dpi.vertical() * downscale_y_factor)
-        );
-
-        BinaryImage binarized(binarizeWolf(downscaled, QSize(31, 31)));
-        if (dbg) {
-            dbg->add(binarized, "binarized");
-        }
-        // detectVertContentBounds() is sensitive to clutter and speckles, so let's try to remove it.
-        sanitizeBinaryImage(binarized, downscaled_content_rect);
-        if (dbg) {
-            dbg->add(binarized, "sanitized");
-        }
-
-        std::pair<QLineF, QLineF> vert_bounds(detectVertContentBounds(binarized, dbg));
-        if (dbg) {
-            dbg->add(visualizeVerticalBounds(binarized.toQImage(), vert_bounds), "vert_bounds");
-        }
 
+        std::pair<QLineF, QLineF> vert_bounds;
         std::list<std::vector<QPointF>> polylines;
-        extractTextLines(polylines, stretchGrayRange(downscaled), vert_bounds, dbg);
-        if (dbg) {
-            dbg->add(visualizePolylines(downscaled, polylines), "traced");
+        if (mode == PYRAMID) {
+            const GrayImage coarse(
+                    scaleToGray(
+                            downscaled,
+                            QSize(std::max(1, downscaled_width / 2), std::max(1, downscaled_height / 2))
+                    )
+            );
+            QTransform coarse_to_downscaled;
+            coarse_to_downscaled.scale(
+                    double(downscaled_width) / coarse.width(), double(downscaled_height) / coarse.height()
+            );
+
+            detectTextLines(
+                    polylines, vert_bounds, coarse,
+                    coarse_to_downscaled.inverted().mapRect(downscaled_content_rect), 0.5f, dbg
+            );
+
+            vert_bounds.first = coarse_to_downscaled.map(vert_bounds.first);
+            vert_bounds.second = coarse_to_downscaled.map(vert_bounds.second);
+            for (std::vector<QPointF>& polyline : polylines) {
+                for (QPointF& pt : polyline) {
+                    pt = coarse_to_downscaled.map(pt);
+                }
+            }
+        } else {
+            detectTextLines(polylines, vert_bounds, downscaled, downscaled_content_rect, 1.0f, dbg);
         }
 
-        filterShortCurves(polylines, vert_bounds.first, vert_bounds.second);
-        filterOutOfBoundsCurves(polylines, vert_bounds.first, vert_bounds.second);
-        if (dbg) {
-            dbg->add(visualizePolylines(downscaled, polylines), "filtered1");
-        }
+        status.throwIfCancelled();
 
-        Vec2f unit_down_vector(calcAvgUnitVector(vert_bounds));
-        unit_down_vector /= sqrt(unit_down_vector.squaredNorm());
-        if (unit_down_vector[1] < 0) {
-            unit_down_vector = -unit_down_vector;
-        }
-        TextLineRefiner refiner(downscaled, Dpi(200, 200), unit_down_vector);
-        refiner.refine(polylines,  /*iterations=*/ 100, dbg);
+        {
+            const TraceSpan level_span("dewarping", "TextLineTracer::refineTextLines");
 
-        filterEdgyCurves(polylines);
-        if (dbg) {
-            dbg->add(visualizePolylines(downscaled, polylines), "filtered2");
+            Vec2f unit_down_vector(calcAvgUnitVector(vert_bounds));
+            unit_down_vector /= sqrt(unit_down_vector.squaredNorm());
+            if (unit_down_vector[1] < 0) {
+                unit_down_vector = -unit_down_vector;
+            }
+            // In pyramid mode, lines are already known to within a couple of pixels,
+            // so there is no point looking far away from them.
+            const int band_margin = (mode == PYRAMID) ? 20 : 0;
+            TextLineRefiner refiner(downscaled, Dpi(200, 200), unit_down_vector);
+            refiner.refine(polylines,  /*iterations=*/ 100, dbg, band_margin);
+
+            filterEdgyCurves(polylines);
+            if (dbg) {
+                dbg->add(visualizePolylines(downscaled, polylines), "filtered2");
+            }
         }
 
 
@@ -133,6 +143,46 @@ namespace dewarping {
         }
     }  // TextLineTracer::trace
 
+    void TextLineTracer::detectTextLines(std::list<std::vector<QPointF>>& polylines,
+                                         std::pair<QLineF, QLineF>& vert_bounds,
+                                         const GrayImage& image,
+                                         const QRect& content_rect,
+                                         const float scale,
+                                         DebugImages* dbg) {
+        const TraceSpan span("dewarping", "TextLineTracer::detectTextLines");
+
+        const int binarization_window = scaledOddSize(31, scale);
+        BinaryImage binarized(binarizeWolf(image, QSize(binarization_window, binarization_window)));
+        if (dbg) {
+            dbg->add(binarized, "binarized");
+        }
+        // detectVertContentBounds() is sensitive to clutter and speckles, so let's try to remove it.
+        sanitizeBinaryImage(binarized, content_rect, scale);
+        if (dbg) {
+            dbg->add(binarized, "sanitized");
+        }
+
+        vert_bounds = detectVertContentBounds(binarized, dbg);
+        if (dbg) {
+            dbg->add(visualizeVerticalBounds(binarized.toQImage(), vert_bounds), "vert_bounds");
+        }
+
+        extractTextLines(polylines, stretchGrayRange(image), vert_bounds, scale, dbg);
+        if (dbg) {
+            dbg->add(visualizePolylines(image, polylines), "traced");
+        }
+
+        filterShortCurves(polylines, vert_bounds.first, vert_bounds.second);
+        filterOutOfBoundsCurves(polylines, vert_bounds.first, vert_bounds.second);
+        if (dbg) {
+            dbg->add(visualizePolylines(image, polylines), "filtered1");
+        }
+    }
+
+    int TextLineTracer::scaledOddSize(const int size, const float scale) {
+        return std::max(1, qRound(size * scale)) | 1;
+    }
+
     GrayImage TextLineTracer::downscale(const GrayImage& input, const Dpi& dpi) {
         // Downscale to 200 DPI.
         QSize downscaled_size(input.size());
@@ -144,7 +194,7 @@ namespace dewarping {
         return scaleToGray(input, downscaled_size);
     }
 
-    void TextLineTracer::sanitizeBinaryImage(BinaryImage& image, const QRect& content_rect) {
+    void TextLineTracer::sanitizeBinaryImage(BinaryImage& image, const QRect& content_rect, const float scale) {
         // Kill connected components touching the borders.
         BinaryImage seed(image.size(), WHITE);
         seed.fillExcept(seed.rect().adjusted(1, 1, -1, -1), BLACK);
@@ -153,8 +203,10 @@ namespace dewarping {
         rasterOp<RopSubtract<RopDst, RopSrc>>(image, touching_border.release());
 
         // Poor man's despeckle.
-        BinaryImage content_seeds(openBrick(image, QSize(2, 3), WHITE));
-        rasterOp<RopOr<RopSrc, RopDst>>(content_seeds, openBrick(image, QSize(3, 2), WHITE));
+        const int brick_short = std::max(1, qRound(2 * scale));
+        const int brick_long = std::max(1, qRound(3 * scale));
+        BinaryImage content_seeds(openBrick(image, QSize(brick_short, brick_long), WHITE));
+        rasterOp<RopOr<RopSrc, RopDst>>(content_seeds, openBrick(image, QSize(brick_long, brick_short), WHITE));
         image = seedFill(content_seeds.release(), image, CONN8);
         // Clear margins.
         image.fillExcept(content_rect, WHITE);
@@ -288,6 +340,7 @@ namespace dewarping {
     void TextLineTracer::extractTextLines(std::list<std::vector<QPointF>>& out,
                                           const imageproc::GrayImage& image,
                                           const std::pair<QLineF, QLineF>& bounds,
+                                          const float scale,
                                           DebugImages* dbg) {
         using namespace boost::lambda;
 
@@ -314,7 +367,7 @@ namespace dewarping {
         }
 
         gaussBlurGeneric(
-                size, 6.0f, 6.0f,
+                size, 6.0f * scale, 6.0f * scale,
                 main_grid.data(), main_grid.stride(), _1,
                 main_grid.data(), main_grid.stride(), _1 = _2
         );
@@ -365,7 +418,7 @@ namespace dewarping {
         }
 
         gaussBlurGeneric(
-                size, 12.0f, 12.0f,
+                size, 12.0f * scale, 12.0f * scale,
                 aux_grid.data(), aux_grid.stride(), _1,
                 aux_grid.data(), aux_grid.stride(), _1 = _2
         );
@@ -401,7 +454,10 @@ namespace dewarping {
         }
 
         Grid<float>().swap(aux_grid);  // Save memory.
-        initial_binarization = closeWithObstacles(initial_binarization, obstacles, QSize(21, 21));
+        const int closing_brick = scaledOddSize(21, scale);
+        initial_binarization = closeWithObstacles(
+                initial_binarization, obstacles, QSize(closing_brick, closing_brick)
+        );
         if (dbg) {
             dbg->add(initial_binarization, "initial_closed");
         }
@@ -428,7 +484,7 @@ namespace dewarping {
 
             {
                 TowardsLineTracer tracer(&sedm, &main_grid, bounds.first, seed);
-                while (const QPoint* pt = tracer.trace(10.0f)) {
+                while (const QPoint* pt = tracer.trace(10.0f * scale)) {
                     polyline.emplace_back(*pt);
                 }
                 std::reverse(polyline.begin(), polyline.end());
@@ -438,7 +494,7 @@ namespace dewarping {
 
             {
                 TowardsLineTracer tracer(&sedm, &main_grid, bounds.second, seed);
-                while (const QPoint* pt = tracer.trace(10.0f)) {
+                while (const QPoint* pt = tracer.trace(10.0f * scale)) {
                     polyline.emplace_back(*pt);
                 }
             }
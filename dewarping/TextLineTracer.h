@@ -48,21 +48,52 @@ namespace dewarping {
 
     class TextLineTracer {
     public:
+        enum Mode {
+            /**
+             * Text lines are both detected and refined at 200 DPI.
+             */
+            FULL_RESOLUTION,
+
+            /**
+             * Text lines and vertical content bounds are detected at 100 DPI,
+             * then refined at 200 DPI, looking only at narrow bands around them.
+             * The two levels are timed by the "TextLineTracer::detectTextLines"
+             * and "TextLineTracer::refineTextLines" trace spans.
+             */
+            PYRAMID
+        };
+
         static void trace(const imageproc::GrayImage& input,
                           const Dpi& dpi,
                           const QRect& content_rect,
                           DistortionModelBuilder& output,
                           const TaskStatus& status,
-                          DebugImages* dbg = nullptr);
+                          DebugImages* dbg = nullptr,
+                          Mode mode = FULL_RESOLUTION);
 
     private:
         static imageproc::GrayImage downscale(const imageproc::GrayImage& input, const Dpi& dpi);
 
-        static void sanitizeBinaryImage(imageproc::BinaryImage& image, const QRect& content_rect);
+        /**
+         * Finds the vertical content bounds and rough text lines.
+         *
+         * \param scale The resolution of \p image relative to 200 DPI.
+         */
+        static void detectTextLines(std::list<std::vector<QPointF>>& polylines,
+                                    std::pair<QLineF, QLineF>& vert_bounds,
+                                    const imageproc::GrayImage& image,
+                                    const QRect& content_rect,
+                                    float scale,
+                                    DebugImages* dbg);
+
+        static int scaledOddSize(int size, float scale);
+
+        static void sanitizeBinaryImage(imageproc::BinaryImage& image, const QRect& content_rect, float scale);
 
         static void extractTextLines(std::list<std::vector<QPointF>>& out,
                                      const imageproc::GrayImage& image,
                                      const std::pair<QLineF, QLineF>& bounds,
+                                     float scale,
                                      DebugImages* dbg);
 
         static Vec2f calcAvgUnitVector(const std::pair<QLineF, QLineF>& bounds);
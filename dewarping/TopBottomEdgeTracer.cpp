@@ -21,7 +21,6 @@
 #include "TaskStatus.h"
 #include "DebugImages.h"
 #include "NumericTraits.h"
-#include "PriorityQueue.h"
 #include "ToLineProjector.h"
 #include "LineBoundedByRect.h"
 #include "GridLineTraverser.h"
@@ -30,12 +29,15 @@
 #include "imageproc/Scale.h"
 #include "imageproc/Constants.h"
 #include "imageproc/GaussBlur.h"
+#include "ParallelFor.h"
 #include <QPainter>
 #include <QDebug>
 #include <boost/foreach.hpp>
 #include <boost/lambda/lambda.hpp>
 #include <boost/lambda/bind.hpp>
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 
 using namespace imageproc;
 
@@ -127,26 +129,134 @@ namespace dewarping {
     };
 
 
-    class TopBottomEdgeTracer::PrioQueue : public PriorityQueue<uint32_t, PrioQueue> {
+    /**
+     * \brief The state of the shortest path search, kept apart from GridNode.
+     *
+     * The layout matches that of a Grid<GridNode> with a padding of 1, so the same
+     * neighbour offsets apply.  Padding nodes and nodes outside of the band between
+     * the vertical bounds have a negative path cost, which keeps them out of the search.
+     */
+    struct TopBottomEdgeTracer::SearchGrid {
+        static const uint8_t NO_PREV_NEIGHBOUR = 0xff;
+
+        int width;
+        int height;
+        int stride;
+
+        /**
+         * The cost of passing through a node, that is 1 - |dirDeriv|.
+         */
+        std::vector<float> weight;
+
+        std::vector<float> pathCost;
+
+        /**
+         * See GridNode::prevNeighbourIdx().
+         */
+        std::vector<uint8_t> prevNeighbour;
+
+        explicit SearchGrid(const Grid<GridNode>& grid)
+                : width(grid.width()),
+                  height(grid.height()),
+                  stride(grid.stride()),
+                  weight(static_cast<size_t>(stride * (height + 2)), 0.0f),
+                  pathCost(weight.size(), -1.0f),
+                  prevNeighbour(weight.size(), NO_PREV_NEIGHBOUR) {
+        }
+
+        /**
+         * Converts an offset relative to Grid::data() to an index into our arrays.
+         */
+        int index(int offset) const {
+            return offset + stride + 1;
+        }
+    };
+
+
+    /**
+     * \brief A monotone priority queue for non-negative float keys.
+     *
+     * Non-negative floats compare the same way as their bit patterns, which makes
+     * it possible to use a radix heap.  Keys pushed may not be less than the last
+     * key popped, which holds for shortest path searches.  Decreasing a key is done
+     * by pushing the item again.  Stale entries are to be skipped by the caller.
+     */
+    class TopBottomEdgeTracer::RadixHeap {
     public:
-        explicit PrioQueue(Grid<GridNode>& grid)
-                : m_pData(grid.data()) {
+        struct Entry {
+            uint32_t key;
+            int idx;
+        };
+
+        RadixHeap()
+                : m_lastKey(0),
+                  m_size(0) {
         }
 
-        bool higherThan(uint32_t lhs, uint32_t rhs) const {
-            return m_pData[lhs].pathCost < m_pData[rhs].pathCost;
+        static uint32_t keyFor(float cost) {
+            assert(cost >= 0);
+            uint32_t key;
+            memcpy(&key, &cost, sizeof(key));
+
+            return key;
         }
 
-        void setIndex(uint32_t grid_idx, size_t heap_idx) {
-            m_pData[grid_idx].setHeapIdx(static_cast<uint32_t>(heap_idx));
+        bool empty() const {
+            return m_size == 0;
         }
 
-        void reposition(GridNode* node) {
-            PriorityQueue<uint32_t, PrioQueue>::reposition(node->heapIdx());
+        void push(const float cost, const int idx) {
+            const uint32_t key = keyFor(cost);
+            assert(key >= m_lastKey);
+            m_buckets[bucketFor(key)].push_back(Entry{ key, idx });
+            ++m_size;
+        }
+
+        Entry pop() {
+            assert(!empty());
+
+            if (m_buckets[0].empty()) {
+                int i = 1;
+                while (m_buckets[i].empty()) {
+                    ++i;
+                }
+
+                std::vector<Entry>& bucket = m_buckets[i];
+                uint32_t min_key = bucket.front().key;
+                for (const Entry& entry : bucket) {
+                    min_key = std::min(min_key, entry.key);
+                }
+
+                // Redistribute relative to the new minimum.  Everything goes
+                // into lower buckets, as all the keys share the higher bits.
+                m_lastKey = min_key;
+                for (const Entry& entry : bucket) {
+                    m_buckets[bucketFor(entry.key)].push_back(entry);
+                }
+                bucket.clear();
+            }
+
+            const Entry entry(m_buckets[0].back());
+            m_buckets[0].pop_back();
+            --m_size;
+
+            return entry;
         }
 
     private:
-        GridNode* const m_pData;
+        int bucketFor(uint32_t key) const {
+            const uint64_t diff = key ^ m_lastKey;
+            int bucket = 0;
+            while (diff >> bucket) {
+                ++bucket;
+            }
+
+            return bucket;
+        }
+
+        std::vector<Entry> m_buckets[33];
+        uint32_t m_lastKey;
+        size_t m_size;
     };
 
 
@@ -234,12 +344,9 @@ namespace dewarping {
 
         status.throwIfCancelled();
 
-        PrioQueue queue(grid);
-
         // Shortest paths from bounds.first towards bounds.second.
-        prepareForShortestPathsFrom(queue, grid, bounds.first);
         const Vec2f dir_1st_to_2nd(directionFromPointToLine(bounds.first.pointAt(0.5), bounds.second));
-        propagateShortestPaths(dir_1st_to_2nd, queue, grid);
+        findShortestPaths(grid, bounds, dir_1st_to_2nd);
         const std::vector<QPoint> endpoints1(locateBestPathEndpoints(grid, bounds.second));
         if (dbg) {
             dbg->add(visualizePaths(downscaled, grid, bounds, endpoints1), "best_paths_ltr");
@@ -247,23 +354,29 @@ namespace dewarping {
 
         gaussBlurGradient(grid);
 
-        std::vector<std::vector<QPointF>> snakes;
-        snakes.reserve(endpoints1.size());
+        // The snakes, typically one for the top and one for the bottom edge,
+        // are independent from each other.
+        const auto num_snakes = static_cast<int>(endpoints1.size());
+        std::vector<std::vector<QPointF>> snakes(endpoints1.size());
 
-        for (QPoint endpoint : endpoints1) {
-            snakes.push_back(pathToSnake(grid, endpoint));
-            const Vec2f dir(downTheHillDirection(downscaled.rect(), snakes.back(), avg_bounds_dir));
-            downTheHillSnake(snakes.back(), grid, dir);
-        }
+        parallelFor(0, num_snakes, 1, [&](const int first, const int last) {
+            for (int i = first; i < last; ++i) {
+                snakes[i] = pathToSnake(grid, endpoints1[i]);
+                const Vec2f dir(downTheHillDirection(downscaled.rect(), snakes[i], avg_bounds_dir));
+                downTheHillSnake(snakes[i], grid, dir);
+            }
+        });
         if (dbg) {
             const QImage background(visualizeBlurredGradient(grid));
             dbg->add(visualizeSnakes(background, snakes, bounds), "down_the_hill_snakes");
         }
 
-        for (std::vector<QPointF>& snake : snakes) {
-            const Vec2f dir(-downTheHillDirection(downscaled.rect(), snake, avg_bounds_dir));
-            upTheHillSnake(snake, grid, dir);
-        }
+        parallelFor(0, num_snakes, 1, [&](const int first, const int last) {
+            for (int i = first; i < last; ++i) {
+                const Vec2f dir(-downTheHillDirection(downscaled.rect(), snakes[i], avg_bounds_dir));
+                upTheHillSnake(snakes[i], grid, dir);
+            }
+        });
         if (dbg) {
             const QImage background(visualizeGradient(grid));
             dbg->add(visualizeSnakes(background, snakes, bounds), "up_the_hill_snakes");
@@ -450,7 +563,16 @@ namespace dewarping {
         return vec;
     }
 
-    void TopBottomEdgeTracer::prepareForShortestPathsFrom(PrioQueue& queue, Grid<GridNode>& grid, const QLineF& from) {
+    void TopBottomEdgeTracer::findShortestPaths(Grid<GridNode>& grid,
+                                                const std::pair<QLineF, QLineF>& bounds,
+                                                const Vec2f& direction) {
+        SearchGrid search_grid(grid);
+        RadixHeap queue;
+
+        prepareForShortestPathsFrom(queue, search_grid, grid, bounds);
+        propagateShortestPaths(direction, queue, search_grid);
+
+        // Write the results back for the rest of the pipeline.
         GridNode padding_node{ };
         padding_node.setupForPadding();
         grid.initPadding(padding_node);
@@ -458,61 +580,107 @@ namespace dewarping {
         const int width = grid.width();
         const int height = grid.height();
         const int stride = grid.stride();
-        GridNode* const data = grid.data();
-
         GridNode* line = grid.data();
         for (int y = 0; y < height; ++y) {
+            const int row_idx = search_grid.index(y * stride);
             for (int x = 0; x < width; ++x) {
-                GridNode* node = line + x;
-                node->setupForInterior();
+                GridNode& node = line[x];
                 // This doesn't modify dirDeriv, which is why
                 // we can't use grid.initInterior().
+                node.setupForInterior();
+
+                const float cost = search_grid.pathCost[row_idx + x];
+                if (cost >= 0) {
+                    node.pathCost = cost;
+                }
+                const uint8_t prev_nbh = search_grid.prevNeighbour[row_idx + x];
+                if (prev_nbh != SearchGrid::NO_PREV_NEIGHBOUR) {
+                    node.setPrevNeighbourIdx(prev_nbh);
+                }
             }
             line += stride;
         }
+    }  // TopBottomEdgeTracer::findShortestPaths
+
+    void TopBottomEdgeTracer::prepareForShortestPathsFrom(RadixHeap& queue,
+                                                          SearchGrid& search_grid,
+                                                          const Grid<GridNode>& grid,
+                                                          const std::pair<QLineF, QLineF>& bounds) {
+        const int width = search_grid.width;
+        const int height = search_grid.height;
+        const int stride = search_grid.stride;
+
+        // Unit normals pointing from each bound towards the other one.
+        QLineF normal1(bounds.first.normalVector().unitVector());
+        QLineF normal2(bounds.second.normalVector().unitVector());
+        Vec2d n1(normal1.p2() - normal1.p1());
+        Vec2d n2(normal2.p2() - normal2.p1());
+        if (n1.dot(Vec2d(bounds.second.pointAt(0.5) - bounds.first.p1())) < 0) {
+            n1 = -n1;
+        }
+        if (n2.dot(Vec2d(bounds.first.pointAt(0.5) - bounds.second.p1())) < 0) {
+            n2 = -n2;
+        }
+        const double c1 = n1.dot(Vec2d(bounds.first.p1()));
+        const double c2 = n2.dot(Vec2d(bounds.second.p1()));
+
+        // Nodes more than a pixel outside of the band between the bounds
+        // don't take part in the search.
+        const double margin = 1.0;
+        const GridNode* grid_line = grid.data();
+        for (int y = 0; y < height; ++y) {
+            const int row_idx = search_grid.index(y * stride);
+            for (int x = 0; x < width; ++x) {
+                const double d1 = n1[0] * x + n1[1] * y - c1;
+                const double d2 = n2[0] * x + n2[1] * y - c2;
+                if ((d1 >= -margin) && (d2 >= -margin)) {
+                    assert(std::fabs(grid_line[x].dirDeriv) <= 1.0);
+                    search_grid.weight[row_idx + x] = 1.0f - std::fabs(grid_line[x].dirDeriv);
+                    search_grid.pathCost[row_idx + x] = NumericTraits<float>::max();
+                }
+            }
+            grid_line += grid.stride();
+        }
 
-        GridLineTraverser traverser(from);
+        GridLineTraverser traverser(bounds.first);
         while (traverser.hasNext()) {
             const QPoint pt(traverser.next());
 
             // intersectWithRect() ensures that.
             assert(pt.x() >= 0 && pt.y() >= 0 && pt.x() < width && pt.y() < height);
 
-            const int offset = pt.y() * stride + pt.x();
-            data[offset].pathCost = 0;
-            queue.push(offset);
+            const int idx = search_grid.index(pt.y() * stride + pt.x());
+            search_grid.weight[idx] = 1.0f - std::fabs(grid.data()[pt.y() * grid.stride() + pt.x()].dirDeriv);
+            search_grid.pathCost[idx] = 0;
+            queue.push(0, idx);
         }
-    }
+    }  // TopBottomEdgeTracer::prepareForShortestPathsFrom
 
-    void TopBottomEdgeTracer::propagateShortestPaths(const Vec2f& direction, PrioQueue& queue, Grid<GridNode>& grid) {
-        GridNode* const data = grid.data();
+    void
+    TopBottomEdgeTracer::propagateShortestPaths(const Vec2f& direction, RadixHeap& queue, SearchGrid& search_grid) {
+        const float* const weight = search_grid.weight.data();
+        float* const path_cost = search_grid.pathCost.data();
+        uint8_t* const prev_neighbour = search_grid.prevNeighbour.data();
 
         int next_nbh_offsets[8];
         int prev_nbh_indexes[8];
-        const int num_neighbours = initNeighbours(next_nbh_offsets, prev_nbh_indexes, grid.stride(), direction);
+        const int num_neighbours = initNeighbours(next_nbh_offsets, prev_nbh_indexes, search_grid.stride, direction);
 
         while (!queue.empty()) {
-            const int grid_idx = queue.front();
-            GridNode* node = data + grid_idx;
-            assert(node->pathCost >= 0);
-            queue.pop();
-            node->setHeapIdx(GridNode::INVALID_HEAP_IDX);
+            const RadixHeap::Entry entry(queue.pop());
+            const int idx = entry.idx;
+            if (entry.key != RadixHeap::keyFor(path_cost[idx])) {
+                continue;  // A stale entry.
+            }
 
+            // The path cost is the highest weight along the path.
+            const float new_cost = std::max(path_cost[idx], weight[idx]);
             for (int i = 0; i < num_neighbours; ++i) {
-                const int nbh_grid_idx = grid_idx + next_nbh_offsets[i];
-                GridNode* nbh_node = data + nbh_grid_idx;
-
-                assert(std::fabs(node->dirDeriv) <= 1.0);
-                const float new_cost = std::max<float>(node->pathCost,
-                                                       static_cast<const float&>(1.0f - std::fabs(node->dirDeriv)));
-                if (new_cost < nbh_node->pathCost) {
-                    nbh_node->pathCost = new_cost;
-                    nbh_node->setPrevNeighbourIdx(prev_nbh_indexes[i]);
-                    if (nbh_node->heapIdx() == GridNode::INVALID_HEAP_IDX) {
-                        queue.push(nbh_grid_idx);
-                    } else {
-                        queue.reposition(nbh_node);
-                    }
+                const int nbh_idx = idx + next_nbh_offsets[i];
+                if (new_cost < path_cost[nbh_idx]) {
+                    path_cost[nbh_idx] = new_cost;
+                    prev_neighbour[nbh_idx] = static_cast<uint8_t>(prev_nbh_indexes[i]);
+                    queue.push(new_cost, nbh_idx);
                 }
             }
         }
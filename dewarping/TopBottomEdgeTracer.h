@@ -51,7 +51,9 @@ namespace dewarping {
     private:
         struct GridNode;
 
-        class PrioQueue;
+        struct SearchGrid;
+
+        class RadixHeap;
 
         struct Step;
 
@@ -71,9 +73,20 @@ namespace dewarping {
 
         static Vec2f directionFromPointToLine(const QPointF& pt, const QLineF& line);
 
-        static void prepareForShortestPathsFrom(PrioQueue& queue, Grid<GridNode>& grid, const QLineF& from);
+        /**
+         * Finds the minimax paths from bounds.first to every node between the bounds,
+         * and stores their costs and directions in \p grid.
+         */
+        static void findShortestPaths(Grid<GridNode>& grid,
+                                      const std::pair<QLineF, QLineF>& bounds,
+                                      const Vec2f& direction);
+
+        static void prepareForShortestPathsFrom(RadixHeap& queue,
+                                                SearchGrid& search_grid,
+                                                const Grid<GridNode>& grid,
+                                                const std::pair<QLineF, QLineF>& bounds);
 
-        static void propagateShortestPaths(const Vec2f& direction, PrioQueue& queue, Grid<GridNode>& grid);
+        static void propagateShortestPaths(const Vec2f& direction, RadixHeap& queue, SearchGrid& search_grid);
 
         static int initNeighbours(int* next_nbh_offsets, int* prev_nbh_indexes, int stride, const Vec2f& direction);
 
@@ -30,6 +30,22 @@ class ThumbnailCollector : public AbstractFilterDataCollector {
 public:
     virtual void processThumbnail(std::unique_ptr<QGraphicsItem>) = 0;
 
+    /**
+     * \brief Whether the thumbnail itself is needed.
+     *
+     * If not, filters call processIncompleteness() instead of building
+     * a thumbnail and passing it to processThumbnail().
+     */
+    virtual bool needThumbnail() const {
+        return true;
+    }
+
+    /**
+     * \brief Tells whether the thumbnail would be an IncompleteThumbnail.
+     */
+    virtual void processIncompleteness(bool incomplete) {
+    }
+
     virtual intrusive_ptr<ThumbnailPixmapCache> thumbnailCache() = 0;
 
     virtual QSizeF maxLogicalThumbSize() const = 0;
@@ -44,6 +44,11 @@ namespace deskew {
         if (!params || (!deps.matches(params->dependencies())
                         && (params->mode() == MODE_AUTO))) {
             if (auto* thumb_col = dynamic_cast<ThumbnailCollector*>(collector)) {
+                if (!thumb_col->needThumbnail()) {
+                    thumb_col->processIncompleteness(true);
+
+                    return;
+                }
                 thumb_col->processThumbnail(
                         std::unique_ptr<QGraphicsItem>(
                                 new IncompleteThumbnail(
@@ -68,6 +73,11 @@ namespace deskew {
         }
 
         if (auto* thumb_col = dynamic_cast<ThumbnailCollector*>(collector)) {
+            if (!thumb_col->needThumbnail()) {
+                thumb_col->processIncompleteness(false);
+
+                return;
+            }
             thumb_col->processThumbnail(
                     std::unique_ptr<QGraphicsItem>(
                             new Thumbnail(
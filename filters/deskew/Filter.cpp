@@ -87,6 +87,7 @@ namespace deskew {
         m_ptrSettings->clear();
 
         const QDomElement filter_el(filters_el.namedItem("deskew").toElement());
+        std::unordered_map<PageId, Params> params_by_page;
 
         const QString page_tag_name("page");
         QDomNode node(filter_el.firstChild());
@@ -115,9 +116,10 @@ namespace deskew {
                 continue;
             }
 
-            const Params params(params_el);
-            m_ptrSettings->setPageParams(page_id, params);
+            params_by_page.insert_or_assign(page_id, Params(params_el));
         }
+
+        m_ptrSettings->setPageParams(params_by_page);
     }      // Filter::loadSettings
 
     void Filter::writePageSettings(QDomDocument& doc,
@@ -17,7 +17,6 @@
  */
 
 #include "Settings.h"
-#include "Utils.h"
 #include "RelinkablePath.h"
 #include "AbstractRelinker.h"
 
@@ -25,11 +24,9 @@ namespace deskew {
     Settings::Settings() {
         m_deviationProvider.setComputeValueByKey(
                 [this](const PageId& pageId) -> double {
-                    auto it(m_perPageParams.find(pageId));
-                    if (it != m_perPageParams.end()) {
-                        const Params& params = it->second;
-
-                        return params.deskewAngle();
+                    const std::shared_ptr<const Params> params(m_perPageParams.find(pageId));
+                    if (params) {
+                        return params->deskewAngle();
                     } else {
                         return .0;
                     };
@@ -47,29 +44,41 @@ namespace deskew {
 
     void Settings::performRelinking(const AbstractRelinker& relinker) {
         QMutexLocker locker(&m_mutex);
-        PerPageParams new_params;
+        PerPageParams::Map new_params;
 
-        for (const PerPageParams::value_type& kv : m_perPageParams) {
-            const RelinkablePath old_path(kv.first.imageId().filePath(), RelinkablePath::File);
-            PageId new_page_id(kv.first);
+        m_perPageParams.forEach([&](const PageId& page_id, const Params& params) {
+            const RelinkablePath old_path(page_id.imageId().filePath(), RelinkablePath::File);
+            PageId new_page_id(page_id);
             new_page_id.imageId().setFilePath(relinker.substitutionPathFor(old_path));
-            new_params.insert(PerPageParams::value_type(new_page_id, kv.second));
-        }
+            new_params.insert(PerPageParams::Map::value_type(new_page_id, params));
+        });
 
-        m_perPageParams.swap(new_params);
+        m_perPageParams.assign(new_params);
 
         m_deviationProvider.clear();
-        for (const PerPageParams::value_type& kv : m_perPageParams) {
+        for (const PerPageParams::Map::value_type& kv : new_params) {
             m_deviationProvider.addOrUpdate(kv.first);
         }
     }
 
     void Settings::setPageParams(const PageId& page_id, const Params& params) {
         QMutexLocker locker(&m_mutex);
-        Utils::mapSetValue(m_perPageParams, page_id, params);
+        m_perPageParams.set(page_id, params);
         m_deviationProvider.addOrUpdate(page_id);
     }
 
+    void Settings::setPageParams(const std::unordered_map<PageId, Params>& params) {
+        QMutexLocker locker(&m_mutex);
+        PerPageParams::Batch batch(m_perPageParams);
+
+        for (const std::pair<const PageId, Params>& kv : params) {
+            batch.set(kv.first, kv.second);
+            m_deviationProvider.addOrUpdate(kv.first, kv.second.deskewAngle());
+        }
+
+        batch.commit();
+    }
+
     void Settings::clearPageParams(const PageId& page_id) {
         QMutexLocker locker(&m_mutex);
         m_perPageParams.erase(page_id);
@@ -78,11 +87,9 @@ namespace deskew {
 
     std::unique_ptr<Params>
     Settings::getPageParams(const PageId& page_id) const {
-        QMutexLocker locker(&m_mutex);
-
-        auto it(m_perPageParams.find(page_id));
-        if (it != m_perPageParams.end()) {
-            return std::make_unique<Params>(it->second);
+        const std::shared_ptr<const Params> params(m_perPageParams.find(page_id));
+        if (params) {
+            return std::make_unique<Params>(*params);
         } else {
             return nullptr;
         }
@@ -90,16 +97,18 @@ namespace deskew {
 
     void Settings::setDegrees(const std::set<PageId>& pages, const Params& params) {
         const QMutexLocker locker(&m_mutex);
+        PerPageParams::Batch batch(m_perPageParams);
+
         for (const PageId& page : pages) {
-            Utils::mapSetValue(m_perPageParams, page, params);
-            m_deviationProvider.addOrUpdate(page);
+            batch.set(page, params);
+            m_deviationProvider.addOrUpdate(page, params.deskewAngle());
         }
+
+        batch.commit();
     }
 
     bool Settings::isParamsNull(const PageId& page_id) const {
-        QMutexLocker locker(&m_mutex);
-
-        return (m_perPageParams.find(page_id) == m_perPageParams.end());
+        return !m_perPageParams.contains(page_id);
     }
 
     const DeviationProvider<PageId>& Settings::deviationProvider() const {
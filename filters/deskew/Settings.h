@@ -23,6 +23,7 @@
 #include "NonCopyable.h"
 #include "PageId.h"
 #include "Params.h"
+#include "SnapshotMap.h"
 #include <QMutex>
 #include <memory>
 #include <unordered_map>
@@ -46,6 +47,11 @@ namespace deskew {
 
         void setPageParams(const PageId& page_id, const Params& params);
 
+        /**
+         * \brief Sets the params of many pages at once.
+         */
+        void setPageParams(const std::unordered_map<PageId, Params>& params);
+
         void clearPageParams(const PageId& page_id);
 
         std::unique_ptr<Params> getPageParams(const PageId& page_id) const;
@@ -57,8 +63,11 @@ namespace deskew {
         const DeviationProvider<PageId>& deviationProvider() const;
 
     private:
-        typedef std::unordered_map<PageId, Params> PerPageParams;
+        typedef SnapshotMap<PageId, Params> PerPageParams;
 
+        /**
+         * Serializes writers.  Readers of m_perPageParams don't need it.
+         */
         mutable QMutex m_mutex;
         PerPageParams m_perPageParams;
         DeviationProvider<PageId> m_deviationProvider;
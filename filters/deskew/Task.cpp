@@ -37,6 +37,7 @@
 #include "imageproc/UpscaleIntegerTimes.h"
 #include "imageproc/SeedFill.h"
 #include "imageproc/Morphology.h"
+#include "Tracer.h"
 
 namespace deskew {
     using namespace imageproc;
@@ -88,6 +89,8 @@ namespace deskew {
     Task::~Task() = default;
 
     FilterResultPtr Task::process(const TaskStatus& status, const FilterData& data) {
+        const TraceSpan span("stage", "deskew::Task");
+
         status.throwIfCancelled();
 
         const Dependencies deps(data.xform().preCropArea(), data.xform().preRotation());
@@ -123,13 +126,13 @@ namespace deskew {
             status.throwIfCancelled();
 
             if (bounded_image_area.isValid()) {
+                const AnalysisPyramid& pyramid = data.analysisPyramid();
                 BinaryImage rotated_image(
                         orthogonalRotation(
                                 BinaryImage(
-                                        data.isBlackOnWhite() ? data.grayImage() : data.grayImage().inverted(),
+                                        pyramid.normalizedGray(),
                                         bounded_image_area,
-                                        data.isBlackOnWhite() ? data.bwThreshold()
-                                                              : BinaryThreshold(256 - int(data.bwThreshold()))
+                                        pyramid.normalizedThreshold()
                                 ),
                                 data.xform().preRotation().toDegrees()
                         )
@@ -53,6 +53,11 @@ namespace fix_orientation {
         }
 
         if (auto* thumb_col = dynamic_cast<ThumbnailCollector*>(collector)) {
+            if (!thumb_col->needThumbnail()) {
+                thumb_col->processIncompleteness(false);
+
+                return;
+            }
             thumb_col->processThumbnail(
                     std::unique_ptr<QGraphicsItem>(
                             new ThumbnailBase(
@@ -29,6 +29,7 @@
 #include "ImageView.h"
 #include "FilterUiInterface.h"
 #include "Dpm.h"
+#include "Tracer.h"
 
 namespace fix_orientation {
     using imageproc::BinaryThreshold;
@@ -74,6 +75,8 @@ namespace fix_orientation {
     FilterResultPtr Task::process(const TaskStatus& status, const FilterData& data) {
         // This function is executed from the worker thread.
 
+        const TraceSpan span("stage", "fix_orientation::Task");
+
         status.throwIfCancelled();
 
         ImageTransformation xform(data.xform());
@@ -151,6 +151,12 @@ namespace output {
                 }
             } while (false);
 
+            if (!thumb_col->needThumbnail()) {
+                thumb_col->processIncompleteness(need_reprocess);
+
+                return;
+            }
+
             if (need_reprocess) {
                 thumb_col->processThumbnail(
                         std::unique_ptr<QGraphicsItem>(
@@ -60,6 +60,7 @@ namespace output {
         }
 
         ui.dewarpingPostDeskewCB->setChecked(dewarpingOptions.needPostDeskew());
+        ui.pyramidTracingCB->setChecked(dewarpingOptions.needPyramidTracing());
         // No, we don't leak memory here.
         new QtSignalForwarder(ui.offRB, SIGNAL(clicked(bool)), var(m_dewarpingMode) = OFF);
         new QtSignalForwarder(ui.autoRB, SIGNAL(clicked(bool)), var(m_dewarpingMode) = AUTO);
@@ -76,6 +77,7 @@ namespace output {
 
         m_dewarpingOptions.setDewarpingMode(m_dewarpingMode);
         m_dewarpingOptions.setPostDeskew(ui.dewarpingPostDeskewCB->isChecked());
+        m_dewarpingOptions.setPyramidTracing(ui.pyramidTracingCB->isChecked());
 
         if (ui.thisPageRB->isChecked()) {
             pages.insert(m_curPage);
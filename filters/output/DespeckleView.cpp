@@ -193,10 +193,10 @@ namespace output {
         if (dbg && !dbg->empty()) {
             auto tab_widget = std::make_unique<TabbedDebugImages>();
             tab_widget->addTab(widget.release(), "Main");
-            AutoRemovingFile file;
+            intrusive_ptr<DebugImage> image;
             QString label;
-            while (!(file = dbg->retrieveNext(&label)).get().isNull()) {
-                tab_widget->addTab(new DebugImageView(file), label);
+            while ((image = dbg->retrieveNext(&label))) {
+                tab_widget->addTab(new DebugImageView(image), label);
             }
             widget = std::move(tab_widget);
         }
@@ -22,25 +22,29 @@
 namespace output {
     DewarpingOptions::DewarpingOptions(DewarpingMode mode, bool needPostDeskew)
             : m_mode(mode),
-              postDeskew(needPostDeskew) {
+              postDeskew(needPostDeskew),
+              pyramidTracing(false) {
     }
 
     DewarpingOptions::DewarpingOptions(const QDomElement& el)
             : m_mode(parseDewarpingMode(el.attribute("mode"))),
-              postDeskew(el.attribute("postDeskew", "1") == "1") {
+              postDeskew(el.attribute("postDeskew", "1") == "1"),
+              pyramidTracing(el.attribute("pyramidTracing", "0") == "1") {
     }
 
     QDomElement DewarpingOptions::toXml(QDomDocument& doc, const QString& name) const {
         QDomElement el(doc.createElement(name));
         el.setAttribute("mode", formatDewarpingMode(m_mode));
         el.setAttribute("postDeskew", postDeskew ? "1" : "0");
+        el.setAttribute("pyramidTracing", pyramidTracing ? "1" : "0");
 
         return el;
     }
 
     bool DewarpingOptions::operator==(const DewarpingOptions& other) const {
         return (m_mode == other.m_mode)
-               && (postDeskew == other.postDeskew);
+               && (postDeskew == other.postDeskew)
+               && (pyramidTracing == other.pyramidTracing);
     }
 
     bool DewarpingOptions::operator!=(const DewarpingOptions& other) const {
@@ -59,6 +63,14 @@ namespace output {
         return postDeskew;
     }
 
+    void DewarpingOptions::setPyramidTracing(bool pyramidTracing) {
+        DewarpingOptions::pyramidTracing = pyramidTracing;
+    }
+
+    bool DewarpingOptions::needPyramidTracing() const {
+        return pyramidTracing;
+    }
+
     DewarpingMode DewarpingOptions::dewarpingMode() const {
         return m_mode;
     }
@@ -50,6 +50,14 @@ namespace output {
 
         void setPostDeskew(bool postDeskew);
 
+        /**
+         * Whether automatic dewarping traces text lines coarse-to-fine
+         * on the analysis pyramid instead of at full resolution.
+         */
+        bool needPyramidTracing() const;
+
+        void setPyramidTracing(bool pyramidTracing);
+
         static DewarpingMode parseDewarpingMode(const QString& str);
 
         static QString formatDewarpingMode(DewarpingMode mode);
@@ -57,6 +65,7 @@ namespace output {
     private:
         DewarpingMode m_mode;
         bool postDeskew;
+        bool pyramidTracing;
     };
 }
 #endif
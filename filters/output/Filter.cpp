@@ -103,6 +103,12 @@ namespace output {
                 filters_el.namedItem("output").toElement()
         );
 
+        std::unordered_map<PageId, ZoneSet> picture_zones_by_page;
+        std::unordered_map<PageId, ZoneSet> fill_zones_by_page;
+        std::unordered_map<PageId, Params> params_by_page;
+        std::unordered_map<PageId, OutputProcessingParams> output_processing_params_by_page;
+        std::unordered_map<PageId, OutputParams> output_params_by_page;
+
         const QString page_tag_name("page");
         QDomNode node(filter_el.firstChild());
         for (; !node.isNull(); node = node.nextSibling()) {
@@ -127,32 +133,37 @@ namespace output {
 
             const ZoneSet picture_zones(el.namedItem("zones").toElement(), m_pictureZonePropFactory);
             if (!picture_zones.empty()) {
-                m_ptrSettings->setPictureZones(page_id, picture_zones);
+                picture_zones_by_page.insert_or_assign(page_id, picture_zones);
             }
 
             const ZoneSet fill_zones(el.namedItem("fill-zones").toElement(), m_fillZonePropFactory);
             if (!fill_zones.empty()) {
-                m_ptrSettings->setFillZones(page_id, fill_zones);
+                fill_zones_by_page.insert_or_assign(page_id, fill_zones);
             }
 
             const QDomElement params_el(el.namedItem("params").toElement());
             if (!params_el.isNull()) {
-                const Params params(params_el);
-                m_ptrSettings->setParams(page_id, params);
+                params_by_page.insert_or_assign(page_id, Params(params_el));
             }
 
             const QDomElement output_processing_params_el(el.namedItem("processing-params").toElement());
             if (!output_processing_params_el.isNull()) {
-                const OutputProcessingParams output_processing_params(output_processing_params_el);
-                m_ptrSettings->setOutputProcessingParams(page_id, output_processing_params);
+                output_processing_params_by_page.insert_or_assign(
+                        page_id, OutputProcessingParams(output_processing_params_el)
+                );
             }
 
             const QDomElement output_params_el(el.namedItem("output-params").toElement());
             if (!output_params_el.isNull()) {
-                const OutputParams output_params(output_params_el);
-                m_ptrSettings->setOutputParams(page_id, output_params);
+                output_params_by_page.insert_or_assign(page_id, OutputParams(output_params_el));
             }
         }
+
+        m_ptrSettings->setPictureZones(picture_zones_by_page);
+        m_ptrSettings->setFillZones(fill_zones_by_page);
+        m_ptrSettings->setParams(params_by_page);
+        m_ptrSettings->setOutputProcessingParams(output_processing_params_by_page);
+        m_ptrSettings->setOutputParams(output_params_by_page);
     }      // Filter::loadSettings
 
     intrusive_ptr<Task>
@@ -253,9 +253,7 @@ namespace output {
     }
 
     void OptionsWidget::dpiChanged(const std::set<PageId>& pages, const Dpi& dpi) {
-        for (const PageId& page_id : pages) {
-            m_ptrSettings->setDpi(page_id, dpi);
-        }
+        m_ptrSettings->setDpi(pages, dpi);
 
         if (pages.size() > 1) {
             emit invalidateAllThumbnails();
@@ -273,10 +271,8 @@ namespace output {
     }
 
     void OptionsWidget::applyColorsConfirmed(const std::set<PageId>& pages) {
-        for (const PageId& page_id : pages) {
-            m_ptrSettings->setColorParams(page_id, m_colorParams);
-            m_ptrSettings->setPictureShapeOptions(page_id, m_pictureShapeOptions);
-        }
+        m_ptrSettings->setColorParams(pages, m_colorParams);
+        m_ptrSettings->setPictureShapeOptions(pages, m_pictureShapeOptions);
 
         if (pages.size() > 1) {
             emit invalidateAllThumbnails();
@@ -305,9 +301,7 @@ namespace output {
     }
 
     void OptionsWidget::applySplittingOptionsConfirmed(const std::set<PageId>& pages) {
-        for (const PageId& page_id : pages) {
-            m_ptrSettings->setSplittingOptions(page_id, m_splittingOptions);
-        }
+        m_ptrSettings->setSplittingOptions(pages, m_splittingOptions);
 
         if (pages.size() > 1) {
             emit invalidateAllThumbnails();
@@ -367,9 +361,7 @@ namespace output {
     }
 
     void OptionsWidget::applyDespeckleConfirmed(const std::set<PageId>& pages) {
-        for (const PageId& page_id : pages) {
-            m_ptrSettings->setDespeckleLevel(page_id, m_despeckleLevel);
-        }
+        m_ptrSettings->setDespeckleLevel(pages, m_despeckleLevel);
 
         if (pages.size() > 1) {
             emit invalidateAllThumbnails();
@@ -397,9 +389,7 @@ namespace output {
     }
 
     void OptionsWidget::dewarpingChanged(const std::set<PageId>& pages, const DewarpingOptions& opt) {
-        for (const PageId& page_id : pages) {
-            m_ptrSettings->setDewarpingOptions(page_id, opt);
-        }
+        m_ptrSettings->setDewarpingOptions(pages, opt);
 
         if (pages.size() > 1) {
             emit invalidateAllThumbnails();
@@ -453,9 +443,7 @@ namespace output {
     }
 
     void OptionsWidget::applyDepthPerceptionConfirmed(const std::set<PageId>& pages) {
-        for (const PageId& page_id : pages) {
-            m_ptrSettings->setDepthPerception(page_id, m_depthPerception);
-        }
+        m_ptrSettings->setDepthPerception(pages, m_depthPerception);
 
         if (pages.size() > 1) {
             emit invalidateAllThumbnails();
@@ -31,6 +31,7 @@
 #include "dewarping/DistortionModelBuilder.h"
 #include "dewarping/DewarpingPointMapper.h"
 #include "dewarping/RasterDewarper.h"
+#include "dewarping/GeneratrixTable.h"
 #include "imageproc/Binarize.h"
 #include "imageproc/Transform.h"
 #include "imageproc/Scale.h"
@@ -48,6 +49,7 @@
 #include "imageproc/PolygonRasterizer.h"
 #include "imageproc/ConnectivityMap.h"
 #include "imageproc/InfluenceMap.h"
+#include "imageproc/HitMissReplaceCascade.h"
 #include <boost/bind.hpp>
 #include <QPainter>
 #include <QDebug>
@@ -57,6 +59,7 @@
 #include <imageproc/ColorTable.h>
 #include <imageproc/ImageCombination.h>
 #include "imageproc/OrthogonalRotation.h"
+#include "Tracer.h"
 
 using namespace imageproc;
 using namespace dewarping;
@@ -326,6 +329,8 @@ namespace output {
                                                          const QRect& target_rect,
                                                          GrayImage* background,
                                                          DebugImages* const dbg) {
+        const TraceSpan span("output", "OutputGenerator::normalizeIlluminationGray");
+
         GrayImage to_be_normalized(
                 transformToGray(
                         input, xform, target_rect, OutsidePixels::assumeWeakNearest()
@@ -349,6 +354,14 @@ namespace output {
 
         status.throwIfCancelled();
 
+        if (!background && !dbg) {
+            // Normalize against the surface as it's being rendered,
+            // without materializing the background image.
+            bg_ps.applyGrayRasterOp<RaiseAboveBackground>(to_be_normalized);
+
+            return to_be_normalized;
+        }
+
         GrayImage bg_img(bg_ps.render(to_be_normalized.size()));
         if (dbg) {
             dbg->add(bg_img, "background");
@@ -372,6 +385,8 @@ namespace output {
                                                                      const QRect& source_rect,
                                                                      const QRect& source_sub_rect,
                                                                      DebugImages* const dbg) const {
+        const TraceSpan span("output", "OutputGenerator::estimateBinarizationMask");
+
         assert(source_rect.contains(source_sub_rect));
 
         // If we need to strip some of the margins from a grayscale
@@ -502,6 +517,8 @@ namespace output {
                                                     const PageId& p_pageId,
                                                     const intrusive_ptr<Settings>& p_settings,
                                                     SplitImage* splitImage) {
+        const TraceSpan span("output", "OutputGenerator::processWithoutDewarping");
+
         const RenderParams render_params(m_colorParams, m_splittingOptions);
 
         const QSize target_size(m_outRect.size().expandedTo(QSize(1, 1)));
@@ -560,7 +577,7 @@ namespace output {
         QPolygonF normalize_illumination_crop_area(m_xform.resultingPreCropArea());
         normalize_illumination_crop_area.translate(-normalize_illumination_rect.topLeft());
 
-        const GrayImage inputGrayImage = input.isBlackOnWhite() ? input.grayImage() : input.grayImage().inverted();
+        const GrayImage inputGrayImage(input.analysisPyramid().normalizedGray());
         const QImage inputOrigImage = [&input]() {
             QImage result = input.origImage();
             if (!input.isBlackOnWhite()) {
@@ -1063,6 +1080,8 @@ namespace output {
                                                  const PageId& p_pageId,
                                                  const intrusive_ptr<Settings>& p_settings,
                                                  SplitImage* splitImage) {
+        const TraceSpan span("output", "OutputGenerator::processWithDewarping");
+
         const RenderParams render_params(m_colorParams, m_splittingOptions);
 
         const QSize target_size(m_outRect.size().expandedTo(QSize(1, 1)));
@@ -1117,7 +1136,7 @@ namespace output {
         QPolygonF normalize_illumination_crop_area(m_xform.resultingPreCropArea());
         normalize_illumination_crop_area.translate(-normalize_illumination_rect.topLeft());
 
-        const GrayImage inputGrayImage = input.isBlackOnWhite() ? input.grayImage() : input.grayImage().inverted();
+        const GrayImage inputGrayImage(input.analysisPyramid().normalizedGray());
         const QImage inputOrigImage = [&input]() {
             QImage result = input.origImage();
             if (!input.isBlackOnWhite()) {
@@ -1311,8 +1330,13 @@ namespace output {
             const QRect content_rect(
                     contentRect.translated(-normalize_illumination_rect.topLeft())
             );
+            // Coarse-to-fine tracing is faster, but not the default, as it's less
+            // tested and its models may differ slightly from the full resolution ones.
+            const TextLineTracer::Mode trace_mode = m_dewarpingOptions.needPyramidTracing()
+                                                    ? TextLineTracer::PYRAMID
+                                                    : TextLineTracer::FULL_RESOLUTION;
             TextLineTracer::trace(
-                    warped_gray_output, m_dpi, content_rect, model_builder, status, dbg
+                    warped_gray_output, m_dpi, content_rect, model_builder, status, dbg, trace_mode
             );
             model_builder.transform(norm_illum_to_original);
 
@@ -1522,21 +1546,23 @@ namespace output {
 
         status.throwIfCancelled();
 
-        QImage dewarped;
+        // Everything dewarped into the output image, as well as the point mapper,
+        // shares the same generatrices.
+        std::shared_ptr<const GeneratrixTable> generatrix_table;
         try {
-            dewarped = dewarp(
-                    QTransform(), normalized_original, m_xform.transform(),
-                    distortion_model, depth_perception, outsideBackgroundColor
+            generatrix_table = createGeneratrixTable(
+                    QTransform(), m_xform.transform(), distortion_model, depth_perception
             );
         } catch (const std::runtime_error&) {
             // Probably an impossible distortion model.  Let's fall back to a trivial one.
             setupTrivialDistortionModel(distortion_model);
-            dewarped = dewarp(
-                    QTransform(), normalized_original, m_xform.transform(),
-                    distortion_model, depth_perception, outsideBackgroundColor
+            generatrix_table = createGeneratrixTable(
+                    QTransform(), m_xform.transform(), distortion_model, depth_perception
             );
         }
 
+        QImage dewarped(dewarp(*generatrix_table, normalized_original, outsideBackgroundColor));
+
         normalized_original = QImage();  // Save memory.
         if (dbg) {
             dbg->add(dewarped, "dewarped");
@@ -1546,7 +1572,7 @@ namespace output {
 
         std::shared_ptr<DewarpingPointMapper> mapper(
                 new DewarpingPointMapper(
-                        distortion_model, depth_perception.value(),
+                        generatrix_table, distortion_model,
                         m_xform.transform(), contentRect
                 )
         );
@@ -1575,10 +1601,7 @@ namespace output {
         }
         fillMarginsInPlace(dewarping_content_area_mask, content_area, WHITE);
         QImage dewarping_content_area_mask_dewarped(
-                dewarp(
-                        QTransform(), dewarping_content_area_mask.toQImage(), m_xform.transform(),
-                        distortion_model, depth_perception, Qt::white
-                )
+                dewarp(*generatrix_table, dewarping_content_area_mask.toQImage(), Qt::white)
         );
         deskew(&dewarping_content_area_mask_dewarped, deskew_angle, Qt::white);
         dewarping_content_area_mask = BinaryImage(dewarping_content_area_mask_dewarped);
@@ -1745,16 +1768,7 @@ namespace output {
                 status.throwIfCancelled();
 
                 if (render_params.needMorphologicalSmoothing()) {
-                    morphologicalSmoothInPlace(dewarped_bw_content, status);
-                    if (dbg) {
-                        dbg->add(dewarped_bw_content, "edges_smoothed");
-                    }
-                }
-
-                status.throwIfCancelled();
-
-                if (render_params.needMorphologicalSmoothing()) {
-                    morphologicalSmoothInPlace(dewarped_bw_content, status);
+                    morphologicalSmoothInPlace(dewarped_bw_content, status, 2);
                     if (dbg) {
                         dbg->add(dewarped_bw_content, "edges_smoothed");
                     }
@@ -1788,20 +1802,7 @@ namespace output {
 
                     status.throwIfCancelled();
 
-                    try {
-                        dewarped = dewarp(
-                                QTransform(), orig_without_illumination,
-                                m_xform.transform(),
-                                distortion_model, depth_perception, outsideBackgroundColor
-                        );
-                    } catch (const std::runtime_error&) {
-                        setupTrivialDistortionModel(distortion_model);
-                        dewarped = dewarp(
-                                QTransform(), orig_without_illumination,
-                                m_xform.transform(),
-                                distortion_model, depth_perception, outsideBackgroundColor
-                        );
-                    }
+                    dewarped = dewarp(*generatrix_table, orig_without_illumination, outsideBackgroundColor);
                     orig_without_illumination = QImage();
 
                     deskew(&dewarped, deskew_angle, outsideBackgroundColor);
@@ -2001,6 +2002,17 @@ namespace output {
                                    const DistortionModel& distortion_model,
                                    const DepthPerception& depth_perception,
                                    const QColor& bg_color) const {
+        return dewarp(
+                *createGeneratrixTable(orig_to_src, src_to_output, distortion_model, depth_perception),
+                src, bg_color
+        );
+    }
+
+    std::shared_ptr<const GeneratrixTable>
+    OutputGenerator::createGeneratrixTable(const QTransform& orig_to_src,
+                                           const QTransform& src_to_output,
+                                           const DistortionModel& distortion_model,
+                                           const DepthPerception& depth_perception) const {
         const CylindricalSurfaceDewarper dewarper(
                 createDewarper(distortion_model, orig_to_src, depth_perception.value())
         );
@@ -2012,7 +2024,17 @@ namespace output {
                         dewarper, orig_to_src * src_to_output, outputContentRect()
                 ).toRect()
         );
-        if (model_domain.isEmpty()) {
+        const int num_columns = model_domain.isEmpty() ? -1 : m_outRect.width();
+
+        return std::shared_ptr<const GeneratrixTable>(new GeneratrixTable(dewarper, model_domain, num_columns));
+    }
+
+    QImage OutputGenerator::dewarp(const GeneratrixTable& generatrix_table,
+                                   const QImage& src,
+                                   const QColor& bg_color) const {
+        const TraceSpan span("output", "OutputGenerator::dewarp");
+
+        if (generatrix_table.modelDomain().isEmpty()) {
             GrayImage out(src.size());
             out.fill(0xff);  // white
 
@@ -2020,7 +2042,7 @@ namespace output {
         }
 
         return RasterDewarper::dewarp(
-                src, m_outRect.size(), dewarper, model_domain, bg_color
+                src, m_outRect.size(), generatrix_table, bg_color
         );
     }
 
@@ -2125,6 +2147,8 @@ namespace output {
     GrayImage OutputGenerator::detectPictures(const GrayImage& input_300dpi,
                                               const TaskStatus& status,
                                               DebugImages* const dbg) const {
+        const TraceSpan span("output", "OutputGenerator::detectPictures");
+
         // We stretch the range of gray levels to cover the whole
         // range of [0, 255].  We do it because we want text
         // and background to be equally far from the center
@@ -2205,6 +2229,8 @@ namespace output {
     }  // OutputGenerator::detectPictures
 
     QImage OutputGenerator::smoothToGrayscale(const QImage& src, const Dpi& dpi) {
+        const TraceSpan span("output", "OutputGenerator::smoothToGrayscale");
+
         const int min_dpi = std::min(dpi.horizontal(), dpi.vertical());
         int window;
         int degree;
@@ -2262,6 +2288,8 @@ namespace output {
     }
 
     BinaryImage OutputGenerator::binarize(const QImage& image) const {
+        const TraceSpan span("output", "OutputGenerator::binarize");
+
         if ((image.format() == QImage::Format_Mono)
             || (image.format() == QImage::Format_MonoLSB)) {
             return BinaryImage(image);
@@ -2365,6 +2393,8 @@ namespace output {
                                                 const Dpi& dpi,
                                                 const TaskStatus& status,
                                                 DebugImages* dbg) const {
+        const TraceSpan span("output", "OutputGenerator::maybeDespeckleInPlace");
+
         const QRect src_rect(mask_rect.translated(-image_rect.topLeft()));
         const QRect dst_rect(mask_rect);
 
@@ -2406,7 +2436,23 @@ namespace output {
         }
     }  // OutputGenerator::maybeDespeckleInPlace
 
-    void OutputGenerator::morphologicalSmoothInPlace(BinaryImage& bin_img, const TaskStatus& status) {
+    void OutputGenerator::morphologicalSmoothInPlace(BinaryImage& bin_img,
+                                                     const TaskStatus& status,
+                                                     const int passes) {
+        const TraceSpan span("output", "OutputGenerator::morphologicalSmoothInPlace");
+
+        static const HitMissReplaceCascade cascade(createSmoothingCascade());
+
+        for (int i = 0; i < passes; ++i) {
+            status.throwIfCancelled();
+
+            cascade.applyInPlace(bin_img);
+        }
+    }  // OutputGenerator::morphologicalSmoothInPlace
+
+    HitMissReplaceCascade OutputGenerator::createSmoothingCascade() {
+        HitMissReplaceCascade cascade;
+
         // When removing black noise, remove small ones first.
 
         {
@@ -2414,11 +2460,9 @@ namespace output {
                     = "XXX"
                             " - "
                             "   ";
-            hitMissReplaceAllDirections(bin_img, pattern, 3, 3);
+            cascade.addRuleAllDirections(pattern, 3, 3);
         }
 
-        status.throwIfCancelled();
-
         {
             const char pattern[]
                     = "X ?"
@@ -2427,11 +2471,9 @@ namespace output {
                             "X- "
                             "X  "
                             "X ?";
-            hitMissReplaceAllDirections(bin_img, pattern, 3, 6);
+            cascade.addRuleAllDirections(pattern, 3, 6);
         }
 
-        status.throwIfCancelled();
-
         {
             const char pattern[]
                     = "X ?"
@@ -2443,11 +2485,9 @@ namespace output {
                             "X  "
                             "X ?"
                             "X ?";
-            hitMissReplaceAllDirections(bin_img, pattern, 3, 9);
+            cascade.addRuleAllDirections(pattern, 3, 9);
         }
 
-        status.throwIfCancelled();
-
         {
             const char pattern[]
                     = "XX?"
@@ -2459,11 +2499,9 @@ namespace output {
                             "XX "
                             "XX?"
                             "XX?";
-            hitMissReplaceAllDirections(bin_img, pattern, 3, 9);
+            cascade.addRuleAllDirections(pattern, 3, 9);
         }
 
-        status.throwIfCancelled();
-
         {
             const char pattern[]
                     = "XX?"
@@ -2472,67 +2510,19 @@ namespace output {
                             "X+ "
                             "XX "
                             "XX?";
-            hitMissReplaceAllDirections(bin_img, pattern, 3, 6);
+            cascade.addRuleAllDirections(pattern, 3, 6);
         }
 
-        status.throwIfCancelled();
-
         {
             const char pattern[]
                     = "   "
                             "X+X"
                             "XXX";
-            hitMissReplaceAllDirections(bin_img, pattern, 3, 3);
+            cascade.addRuleAllDirections(pattern, 3, 3);
         }
-    }  // OutputGenerator::morphologicalSmoothInPlace
 
-    void OutputGenerator::hitMissReplaceAllDirections(imageproc::BinaryImage& img,
-                                                      const char* const pattern,
-                                                      const int pattern_width,
-                                                      const int pattern_height) {
-        hitMissReplaceInPlace(img, WHITE, pattern, pattern_width, pattern_height);
-
-        std::vector<char> pattern_data(static_cast<unsigned long long int>(pattern_width * pattern_height), ' ');
-        char* const new_pattern = &pattern_data[0];
-
-        // Rotate 90 degrees clockwise.
-        const char* p = pattern;
-        int new_width = pattern_height;
-        int new_height = pattern_width;
-        for (int y = 0; y < pattern_height; ++y) {
-            for (int x = 0; x < pattern_width; ++x, ++p) {
-                const int new_x = pattern_height - 1 - y;
-                const int new_y = x;
-                new_pattern[new_y * new_width + new_x] = *p;
-            }
-        }
-        hitMissReplaceInPlace(img, WHITE, new_pattern, new_width, new_height);
-
-        // Rotate upside down.
-        p = pattern;
-        new_width = pattern_width;
-        new_height = pattern_height;
-        for (int y = 0; y < pattern_height; ++y) {
-            for (int x = 0; x < pattern_width; ++x, ++p) {
-                const int new_x = pattern_width - 1 - x;
-                const int new_y = pattern_height - 1 - y;
-                new_pattern[new_y * new_width + new_x] = *p;
-            }
-        }
-        hitMissReplaceInPlace(img, WHITE, new_pattern, new_width, new_height);
-        // Rotate 90 degrees counter-clockwise.
-        p = pattern;
-        new_width = pattern_height;
-        new_height = pattern_width;
-        for (int y = 0; y < pattern_height; ++y) {
-            for (int x = 0; x < pattern_width; ++x, ++p) {
-                const int new_x = y;
-                const int new_y = pattern_width - 1 - x;
-                new_pattern[new_y * new_width + new_x] = *p;
-            }
-        }
-        hitMissReplaceInPlace(img, WHITE, new_pattern, new_width, new_height);
-    }  // OutputGenerator::hitMissReplaceAllDirections
+        return cascade;
+    }  // OutputGenerator::createSmoothingCascade
 
     QSize OutputGenerator::calcLocalWindowSize(const Dpi& dpi) {
         const QSizeF size_mm(3, 30);
@@ -2769,6 +2759,8 @@ namespace output {
     }
 
     void OutputGenerator::deskew(QImage* image, const double angle, const QColor& outside_color) const {
+        const TraceSpan span("output", "OutputGenerator::deskew");
+
         if (angle == .0) {
             return;
         }
@@ -2850,6 +2842,8 @@ namespace output {
     }
 
     QImage OutputGenerator::segmentImage(const BinaryImage& image, const QImage& color_image) const {
+        const TraceSpan span("output", "OutputGenerator::segmentImage");
+
         const BlackWhiteOptions::ColorSegmenterOptions& segmenterOptions
                 = m_colorParams.blackWhiteOptions().getColorSegmenterOptions();
         if (!color_image.allGray()) {
@@ -2867,6 +2861,8 @@ namespace output {
     }
 
     QImage OutputGenerator::posterizeImage(const QImage& image, const QColor& background_color) const {
+        const TraceSpan span("output", "OutputGenerator::posterizeImage");
+
         const ColorCommonOptions::PosterizationOptions& posterizationOptions
                 = m_colorParams.colorCommonOptions().getPosterizationOptions();
 
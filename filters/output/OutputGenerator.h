@@ -37,6 +37,7 @@
 #include <QPolygonF>
 #include <vector>
 #include <utility>
+#include <memory>
 #include <cstdint>
 #include "Params.h"
 #include "PageId.h"
@@ -62,11 +63,14 @@ namespace imageproc {
     class BinaryThreshold;
 
     class GrayImage;
+
+    class HitMissReplaceCascade;
 }
 
 namespace dewarping {
     class DistortionModel;
     class CylindricalSurfaceDewarper;
+    class GeneratrixTable;
 }
 using namespace imageproc;
 namespace output {
@@ -197,6 +201,21 @@ namespace output {
                       const DepthPerception& depth_perception,
                       const QColor& bg_color) const;
 
+        /**
+         * Builds a table of generatrices for dewarping into the output image.
+         * The same table serves all the dewarp() calls with the same parameters,
+         * as well as DewarpingPointMapper.
+         */
+        std::shared_ptr<const dewarping::GeneratrixTable>
+        createGeneratrixTable(const QTransform& orig_to_src,
+                              const QTransform& src_to_output,
+                              const dewarping::DistortionModel& distortion_model,
+                              const DepthPerception& depth_perception) const;
+
+        QImage dewarp(const dewarping::GeneratrixTable& generatrix_table,
+                      const QImage& src,
+                      const QColor& bg_color) const;
+
         static QSize from300dpi(const QSize& size, const Dpi& target_dpi);
 
         static QSize to300dpi(const QSize& size, const Dpi& source_dpi);
@@ -263,12 +282,12 @@ namespace output {
 
         static QImage smoothToGrayscale(const QImage& src, const Dpi& dpi);
 
-        static void morphologicalSmoothInPlace(imageproc::BinaryImage& img, const TaskStatus& status);
+        /**
+         * Smooths the edges of B/W content, applying the smoothing rules \p passes times.
+         */
+        static void morphologicalSmoothInPlace(imageproc::BinaryImage& img, const TaskStatus& status, int passes = 1);
 
-        static void hitMissReplaceAllDirections(imageproc::BinaryImage& img,
-                                                const char* pattern,
-                                                int pattern_width,
-                                                int pattern_height);
+        static imageproc::HitMissReplaceCascade createSmoothingCascade();
 
         static QSize calcLocalWindowSize(const Dpi& dpi);
 
@@ -20,9 +20,51 @@
 #include "FillColorProperty.h"
 #include "RelinkablePath.h"
 #include "AbstractRelinker.h"
-#include "../../Utils.h"
 
 namespace output {
+    namespace {
+        template<typename PerPageMap>
+        void relinkPages(PerPageMap& map, const AbstractRelinker& relinker) {
+            typename PerPageMap::Map new_map;
+
+            map.forEach([&](const PageId& page_id, const typename PerPageMap::Map::mapped_type& value) {
+                const RelinkablePath old_path(page_id.imageId().filePath(), RelinkablePath::File);
+                PageId new_page_id(page_id);
+                new_page_id.imageId().setFilePath(relinker.substitutionPathFor(old_path));
+                new_map.insert(typename PerPageMap::Map::value_type(new_page_id, value));
+            });
+
+            map.assign(new_map);
+        }
+
+        template<typename PerPageMap>
+        void setPages(PerPageMap& map, const typename PerPageMap::Map& values) {
+            typename PerPageMap::Batch batch(map);
+            for (const typename PerPageMap::Map::value_type& kv : values) {
+                batch.set(kv.first, kv.second);
+            }
+            batch.commit();
+        }
+
+        /**
+         * Calls modify(value) on a copy of each page's value, or of a default
+         * constructed one if the page has none, and writes the results back.
+         */
+        template<typename PerPageMap, typename Modifier>
+        void modifyPages(PerPageMap& map, const std::set<PageId>& pages, Modifier modify) {
+            typedef typename PerPageMap::Map::mapped_type Value;
+
+            typename PerPageMap::Batch batch(map);
+            for (const PageId& page_id : pages) {
+                const std::shared_ptr<const Value> old_value(map.find(page_id));
+                Value value(old_value ? *old_value : Value());
+                modify(value);
+                batch.set(page_id, value);
+            }
+            batch.commit();
+        }
+    }
+
     Settings::Settings()
             : m_defaultPictureZoneProps(initialPictureZoneProps()),
               m_defaultFillZoneProps(initialFillZoneProps()) {
@@ -45,60 +87,17 @@ namespace output {
     void Settings::performRelinking(const AbstractRelinker& relinker) {
         const QMutexLocker locker(&m_mutex);
 
-        PerPageParams new_params;
-        PerPageOutputParams new_output_params;
-        PerPageZones new_picture_zones;
-        PerPageZones new_fill_zones;
-        PerPageOutputProcessingParams new_output_processing_params;
-
-        for (const PerPageParams::value_type& kv : m_perPageParams) {
-            const RelinkablePath old_path(kv.first.imageId().filePath(), RelinkablePath::File);
-            PageId new_page_id(kv.first);
-            new_page_id.imageId().setFilePath(relinker.substitutionPathFor(old_path));
-            new_params.insert(PerPageParams::value_type(new_page_id, kv.second));
-        }
-
-        for (const PerPageOutputParams::value_type& kv : m_perPageOutputParams) {
-            const RelinkablePath old_path(kv.first.imageId().filePath(), RelinkablePath::File);
-            PageId new_page_id(kv.first);
-            new_page_id.imageId().setFilePath(relinker.substitutionPathFor(old_path));
-            new_output_params.insert(PerPageOutputParams::value_type(new_page_id, kv.second));
-        }
-
-        for (const PerPageZones::value_type& kv : m_perPagePictureZones) {
-            const RelinkablePath old_path(kv.first.imageId().filePath(), RelinkablePath::File);
-            PageId new_page_id(kv.first);
-            new_page_id.imageId().setFilePath(relinker.substitutionPathFor(old_path));
-            new_picture_zones.insert(PerPageZones::value_type(new_page_id, kv.second));
-        }
-
-        for (const PerPageZones::value_type& kv : m_perPageFillZones) {
-            const RelinkablePath old_path(kv.first.imageId().filePath(), RelinkablePath::File);
-            PageId new_page_id(kv.first);
-            new_page_id.imageId().setFilePath(relinker.substitutionPathFor(old_path));
-            new_fill_zones.insert(PerPageZones::value_type(new_page_id, kv.second));
-        }
-
-        for (const PerPageOutputProcessingParams::value_type& kv : m_perPageOutputProcessingParams) {
-            const RelinkablePath old_path(kv.first.imageId().filePath(), RelinkablePath::File);
-            PageId new_page_id(kv.first);
-            new_page_id.imageId().setFilePath(relinker.substitutionPathFor(old_path));
-            new_output_processing_params.insert(PerPageOutputProcessingParams::value_type(new_page_id, kv.second));
-        }
-
-        m_perPageParams.swap(new_params);
-        m_perPageOutputParams.swap(new_output_params);
-        m_perPagePictureZones.swap(new_picture_zones);
-        m_perPageFillZones.swap(new_fill_zones);
-        m_perPageOutputProcessingParams.swap(new_output_processing_params);
-    }      // Settings::performRelinking
+        relinkPages(m_perPageParams, relinker);
+        relinkPages(m_perPageOutputParams, relinker);
+        relinkPages(m_perPagePictureZones, relinker);
+        relinkPages(m_perPageFillZones, relinker);
+        relinkPages(m_perPageOutputProcessingParams, relinker);
+    }
 
     Params Settings::getParams(const PageId& page_id) const {
-        const QMutexLocker locker(&m_mutex);
-
-        const auto it(m_perPageParams.find(page_id));
-        if (it != m_perPageParams.end()) {
-            return it->second;
+        const std::shared_ptr<const Params> value(m_perPageParams.find(page_id));
+        if (value) {
+            return *value;
         } else {
             return Params();
         }
@@ -106,120 +105,132 @@ namespace output {
 
     void Settings::setParams(const PageId& page_id, const Params& params) {
         const QMutexLocker locker(&m_mutex);
-        Utils::mapSetValue(m_perPageParams, page_id, params);
+        m_perPageParams.set(page_id, params);
+    }
+
+    void Settings::setParams(const std::unordered_map<PageId, Params>& params) {
+        const QMutexLocker locker(&m_mutex);
+        setPages(m_perPageParams, params);
     }
 
     void Settings::setColorParams(const PageId& page_id, const ColorParams& prms) {
         const QMutexLocker locker(&m_mutex);
 
-        const auto it(m_perPageParams.find(page_id));
-        if (it == m_perPageParams.end()) {
-            Params params;
+        Params params(getParams(page_id));
+        params.setColorParams(prms);
+        m_perPageParams.set(page_id, params);
+    }
+
+    void Settings::setColorParams(const std::set<PageId>& pages, const ColorParams& prms) {
+        const QMutexLocker locker(&m_mutex);
+        modifyPages(m_perPageParams, pages, [&](Params& params) {
             params.setColorParams(prms);
-            m_perPageParams.insert(it, PerPageParams::value_type(page_id, params));
-        } else {
-            it->second.setColorParams(prms);
-        }
+        });
     }
 
     void Settings::setPictureShapeOptions(const PageId& page_id, PictureShapeOptions picture_shape_options) {
         const QMutexLocker locker(&m_mutex);
 
-        const auto it(m_perPageParams.find(page_id));
-        if (it == m_perPageParams.end()) {
-            Params params;
+        Params params(getParams(page_id));
+        params.setPictureShapeOptions(picture_shape_options);
+        m_perPageParams.set(page_id, params);
+    }
+
+    void Settings::setPictureShapeOptions(const std::set<PageId>& pages, PictureShapeOptions picture_shape_options) {
+        const QMutexLocker locker(&m_mutex);
+        modifyPages(m_perPageParams, pages, [&](Params& params) {
             params.setPictureShapeOptions(picture_shape_options);
-            m_perPageParams.insert(it, PerPageParams::value_type(page_id, params));
-        } else {
-            it->second.setPictureShapeOptions(picture_shape_options);
-        }
+        });
     }
 
     void Settings::setDpi(const PageId& page_id, const Dpi& dpi) {
         const QMutexLocker locker(&m_mutex);
 
-        const auto it(m_perPageParams.find(page_id));
-        if (it == m_perPageParams.end()) {
-            Params params;
+        Params params(getParams(page_id));
+        params.setOutputDpi(dpi);
+        m_perPageParams.set(page_id, params);
+    }
+
+    void Settings::setDpi(const std::set<PageId>& pages, const Dpi& dpi) {
+        const QMutexLocker locker(&m_mutex);
+        modifyPages(m_perPageParams, pages, [&](Params& params) {
             params.setOutputDpi(dpi);
-            m_perPageParams.insert(it, PerPageParams::value_type(page_id, params));
-        } else {
-            it->second.setOutputDpi(dpi);
-        }
+        });
     }
 
     void Settings::setDewarpingOptions(const PageId& page_id, const DewarpingOptions& opt) {
         const QMutexLocker locker(&m_mutex);
 
-        const auto it(m_perPageParams.find(page_id));
-        if (it == m_perPageParams.end()) {
-            Params params;
+        Params params(getParams(page_id));
+        params.setDewarpingOptions(opt);
+        m_perPageParams.set(page_id, params);
+    }
+
+    void Settings::setDewarpingOptions(const std::set<PageId>& pages, const DewarpingOptions& opt) {
+        const QMutexLocker locker(&m_mutex);
+        modifyPages(m_perPageParams, pages, [&](Params& params) {
             params.setDewarpingOptions(opt);
-            m_perPageParams.insert(it, PerPageParams::value_type(page_id, params));
-        } else {
-            it->second.setDewarpingOptions(opt);
-        }
+        });
     }
 
     void Settings::setSplittingOptions(const PageId& page_id, const SplittingOptions& opt) {
         const QMutexLocker locker(&m_mutex);
 
-        const auto it(m_perPageParams.find(page_id));
-        if (it == m_perPageParams.end()) {
-            Params params;
+        Params params(getParams(page_id));
+        params.setSplittingOptions(opt);
+        m_perPageParams.set(page_id, params);
+    }
+
+    void Settings::setSplittingOptions(const std::set<PageId>& pages, const SplittingOptions& opt) {
+        const QMutexLocker locker(&m_mutex);
+        modifyPages(m_perPageParams, pages, [&](Params& params) {
             params.setSplittingOptions(opt);
-            m_perPageParams.insert(it, PerPageParams::value_type(page_id, params));
-        } else {
-            it->second.setSplittingOptions(opt);
-        }
+        });
     }
 
     void Settings::setDistortionModel(const PageId& page_id, const dewarping::DistortionModel& model) {
         const QMutexLocker locker(&m_mutex);
 
-        const auto it(m_perPageParams.find(page_id));
-        if (it == m_perPageParams.end()) {
-            Params params;
-            params.setDistortionModel(model);
-            m_perPageParams.insert(it, PerPageParams::value_type(page_id, params));
-        } else {
-            it->second.setDistortionModel(model);
-        }
+        Params params(getParams(page_id));
+        params.setDistortionModel(model);
+        m_perPageParams.set(page_id, params);
     }
 
     void Settings::setDepthPerception(const PageId& page_id, const DepthPerception& depth_perception) {
         const QMutexLocker locker(&m_mutex);
 
-        const auto it(m_perPageParams.find(page_id));
-        if (it == m_perPageParams.end()) {
-            Params params;
+        Params params(getParams(page_id));
+        params.setDepthPerception(depth_perception);
+        m_perPageParams.set(page_id, params);
+    }
+
+    void Settings::setDepthPerception(const std::set<PageId>& pages, const DepthPerception& depth_perception) {
+        const QMutexLocker locker(&m_mutex);
+        modifyPages(m_perPageParams, pages, [&](Params& params) {
             params.setDepthPerception(depth_perception);
-            m_perPageParams.insert(it, PerPageParams::value_type(page_id, params));
-        } else {
-            it->second.setDepthPerception(depth_perception);
-        }
+        });
     }
 
     void Settings::setDespeckleLevel(const PageId& page_id, DespeckleLevel level) {
         const QMutexLocker locker(&m_mutex);
 
-        const auto it(m_perPageParams.find(page_id));
-        if (it == m_perPageParams.end()) {
-            Params params;
+        Params params(getParams(page_id));
+        params.setDespeckleLevel(level);
+        m_perPageParams.set(page_id, params);
+    }
+
+    void Settings::setDespeckleLevel(const std::set<PageId>& pages, DespeckleLevel level) {
+        const QMutexLocker locker(&m_mutex);
+        modifyPages(m_perPageParams, pages, [&](Params& params) {
             params.setDespeckleLevel(level);
-            m_perPageParams.insert(it, PerPageParams::value_type(page_id, params));
-        } else {
-            it->second.setDespeckleLevel(level);
-        }
+        });
     }
 
     std::unique_ptr<OutputParams>
     Settings::getOutputParams(const PageId& page_id) const {
-        const QMutexLocker locker(&m_mutex);
-
-        const auto it(m_perPageOutputParams.find(page_id));
-        if (it != m_perPageOutputParams.end()) {
-            return std::make_unique<OutputParams>(it->second);
+        const std::shared_ptr<const OutputParams> params(m_perPageOutputParams.find(page_id));
+        if (params) {
+            return std::make_unique<OutputParams>(*params);
         } else {
             return nullptr;
         }
@@ -232,26 +243,27 @@ namespace output {
 
     void Settings::setOutputParams(const PageId& page_id, const OutputParams& params) {
         const QMutexLocker locker(&m_mutex);
-        Utils::mapSetValue(m_perPageOutputParams, page_id, params);
+        m_perPageOutputParams.set(page_id, params);
     }
 
-    ZoneSet Settings::pictureZonesForPage(const PageId& page_id) const {
+    void Settings::setOutputParams(const std::unordered_map<PageId, OutputParams>& params) {
         const QMutexLocker locker(&m_mutex);
+        setPages(m_perPageOutputParams, params);
+    }
 
-        const auto it(m_perPagePictureZones.find(page_id));
-        if (it != m_perPagePictureZones.end()) {
-            return it->second;
+    ZoneSet Settings::pictureZonesForPage(const PageId& page_id) const {
+        const std::shared_ptr<const ZoneSet> value(m_perPagePictureZones.find(page_id));
+        if (value) {
+            return *value;
         } else {
             return ZoneSet();
         }
     }
 
     ZoneSet Settings::fillZonesForPage(const PageId& page_id) const {
-        const QMutexLocker locker(&m_mutex);
-
-        const auto it(m_perPageFillZones.find(page_id));
-        if (it != m_perPageFillZones.end()) {
-            return it->second;
+        const std::shared_ptr<const ZoneSet> value(m_perPageFillZones.find(page_id));
+        if (value) {
+            return *value;
         } else {
             return ZoneSet();
         }
@@ -259,12 +271,22 @@ namespace output {
 
     void Settings::setPictureZones(const PageId& page_id, const ZoneSet& zones) {
         const QMutexLocker locker(&m_mutex);
-        Utils::mapSetValue(m_perPagePictureZones, page_id, zones);
+        m_perPagePictureZones.set(page_id, zones);
+    }
+
+    void Settings::setPictureZones(const std::unordered_map<PageId, ZoneSet>& zones) {
+        const QMutexLocker locker(&m_mutex);
+        setPages(m_perPagePictureZones, zones);
     }
 
     void Settings::setFillZones(const PageId& page_id, const ZoneSet& zones) {
         const QMutexLocker locker(&m_mutex);
-        Utils::mapSetValue(m_perPageFillZones, page_id, zones);
+        m_perPageFillZones.set(page_id, zones);
+    }
+
+    void Settings::setFillZones(const std::unordered_map<PageId, ZoneSet>& zones) {
+        const QMutexLocker locker(&m_mutex);
+        setPages(m_perPageFillZones, zones);
     }
 
     PropertySet Settings::defaultPictureZoneProperties() const {
@@ -304,11 +326,9 @@ namespace output {
     }
 
     OutputProcessingParams Settings::getOutputProcessingParams(const PageId& page_id) const {
-        const QMutexLocker locker(&m_mutex);
-
-        const auto it(m_perPageOutputProcessingParams.find(page_id));
-        if (it != m_perPageOutputProcessingParams.end()) {
-            return it->second;
+        const std::shared_ptr<const OutputProcessingParams> value(m_perPageOutputProcessingParams.find(page_id));
+        if (value) {
+            return *value;
         } else {
             return OutputProcessingParams();
         }
@@ -317,12 +337,15 @@ namespace output {
     void Settings::setOutputProcessingParams(const PageId& page_id,
                                              const OutputProcessingParams& output_processing_params) {
         const QMutexLocker locker(&m_mutex);
-        Utils::mapSetValue(m_perPageOutputProcessingParams, page_id, output_processing_params);
+        m_perPageOutputProcessingParams.set(page_id, output_processing_params);
     }
 
-    bool Settings::isParamsNull(const PageId& page_id) const {
+    void Settings::setOutputProcessingParams(const std::unordered_map<PageId, OutputProcessingParams>& params) {
         const QMutexLocker locker(&m_mutex);
+        setPages(m_perPageOutputProcessingParams, params);
+    }
 
-        return m_perPageParams.find(page_id) == m_perPageParams.end();
+    bool Settings::isParamsNull(const PageId& page_id) const {
+        return !m_perPageParams.contains(page_id);
     }
 }  // namespace output
\ No newline at end of file
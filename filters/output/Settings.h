@@ -32,9 +32,11 @@
 #include "ZoneSet.h"
 #include "PropertySet.h"
 #include "OutputProcessingParams.h"
+#include "SnapshotMap.h"
 #include <QMutex>
-#include <unordered_map>
 #include <memory>
+#include <set>
+#include <unordered_map>
 
 class AbstractRelinker;
 
@@ -57,38 +59,64 @@ namespace output {
 
         void setParams(const PageId& page_id, const Params& params);
 
+        /**
+         * The overloads taking many pages write them all at once, which is
+         * much cheaper than writing them one by one.
+         */
+        void setParams(const std::unordered_map<PageId, Params>& params);
+
         bool isParamsNull(const PageId& page_id) const;
 
         void setColorParams(const PageId& page_id, const ColorParams& prms);
 
+        void setColorParams(const std::set<PageId>& pages, const ColorParams& prms);
+
         void setPictureShapeOptions(const PageId& page_id, PictureShapeOptions picture_shape_options);
 
+        void setPictureShapeOptions(const std::set<PageId>& pages, PictureShapeOptions picture_shape_options);
+
         void setDpi(const PageId& page_id, const Dpi& dpi);
 
+        void setDpi(const std::set<PageId>& pages, const Dpi& dpi);
+
         void setDewarpingOptions(const PageId& page_id, const DewarpingOptions& opt);
 
+        void setDewarpingOptions(const std::set<PageId>& pages, const DewarpingOptions& opt);
+
         void setSplittingOptions(const PageId& page_id, const SplittingOptions& opt);
 
+        void setSplittingOptions(const std::set<PageId>& pages, const SplittingOptions& opt);
+
         void setDistortionModel(const PageId& page_id, const dewarping::DistortionModel& model);
 
         void setDepthPerception(const PageId& page_id, const DepthPerception& depth_perception);
 
+        void setDepthPerception(const std::set<PageId>& pages, const DepthPerception& depth_perception);
+
         void setDespeckleLevel(const PageId& page_id, DespeckleLevel level);
 
+        void setDespeckleLevel(const std::set<PageId>& pages, DespeckleLevel level);
+
         std::unique_ptr<OutputParams> getOutputParams(const PageId& page_id) const;
 
         void removeOutputParams(const PageId& page_id);
 
         void setOutputParams(const PageId& page_id, const OutputParams& params);
 
+        void setOutputParams(const std::unordered_map<PageId, OutputParams>& params);
+
         ZoneSet pictureZonesForPage(const PageId& page_id) const;
 
         ZoneSet fillZonesForPage(const PageId& page_id) const;
 
         void setPictureZones(const PageId& page_id, const ZoneSet& zones);
 
+        void setPictureZones(const std::unordered_map<PageId, ZoneSet>& zones);
+
         void setFillZones(const PageId& page_id, const ZoneSet& zones);
 
+        void setFillZones(const std::unordered_map<PageId, ZoneSet>& zones);
+
         /**
          * For now, default zone properties are not persistent.
          * They may become persistent later though.
@@ -105,16 +133,22 @@ namespace output {
 
         void setOutputProcessingParams(const PageId& page_id, const OutputProcessingParams& output_processing_params);
 
+        void setOutputProcessingParams(const std::unordered_map<PageId, OutputProcessingParams>& params);
+
     private:
-        typedef std::unordered_map<PageId, Params> PerPageParams;
-        typedef std::unordered_map<PageId, OutputParams> PerPageOutputParams;
-        typedef std::unordered_map<PageId, ZoneSet> PerPageZones;
-        typedef std::unordered_map<PageId, OutputProcessingParams> PerPageOutputProcessingParams;
+        typedef SnapshotMap<PageId, Params> PerPageParams;
+        typedef SnapshotMap<PageId, OutputParams> PerPageOutputParams;
+        typedef SnapshotMap<PageId, ZoneSet> PerPageZones;
+        typedef SnapshotMap<PageId, OutputProcessingParams> PerPageOutputProcessingParams;
 
         static PropertySet initialPictureZoneProps();
 
         static PropertySet initialFillZoneProps();
 
+        /**
+         * Serializes writers and guards the default zone properties.
+         * The per-page maps are read without it.
+         */
         mutable QMutex m_mutex;
         PerPageParams m_perPageParams;
         PerPageOutputParams m_perPageOutputParams;
@@ -44,6 +44,7 @@
 #include "ImageLoader.h"
 #include "ErrorWidget.h"
 #include "imageproc/PolygonUtils.h"
+#include "Tracer.h"
 #include <boost/bind.hpp>
 #include <QDir>
 #include <utility>
@@ -124,6 +125,8 @@ namespace output {
 
     FilterResultPtr
     Task::process(const TaskStatus& status, const FilterData& data, const QPolygonF& content_rect_phys) {
+        const TraceSpan span("stage", "output::Task");
+
         status.throwIfCancelled();
 
         Params params(m_ptrSettings->getParams(m_pageId));
@@ -47,6 +47,11 @@ namespace page_layout {
         );
         if (!params || !params->contentSizeMM().isValid()) {
             if (auto* thumb_col = dynamic_cast<ThumbnailCollector*>(collector)) {
+                if (!thumb_col->needThumbnail()) {
+                    thumb_col->processIncompleteness(true);
+
+                    return;
+                }
                 thumb_col->processThumbnail(
                         std::unique_ptr<QGraphicsItem>(
                                 new IncompleteThumbnail(
@@ -83,6 +88,11 @@ namespace page_layout {
         }
 
         if (auto* thumb_col = dynamic_cast<ThumbnailCollector*>(collector)) {
+            if (!thumb_col->needThumbnail()) {
+                thumb_col->processIncompleteness(false);
+
+                return;
+            }
             thumb_col->processThumbnail(
                     std::unique_ptr<QGraphicsItem>(
                             new Thumbnail(
@@ -147,6 +147,8 @@ namespace page_layout {
             m_ptrSettings->setContentRect(XmlUnmarshaller::rectF(rect_el));
         }
 
+        std::unordered_map<PageId, Params> params_by_page;
+
         const QString page_tag_name("page");
         QDomNode node(filter_el.firstChild());
         for (; !node.isNull(); node = node.nextSibling()) {
@@ -174,9 +176,10 @@ namespace page_layout {
                 continue;
             }
 
-            const Params params(params_el);
-            m_ptrSettings->setPageParams(page_id, params);
+            params_by_page.insert_or_assign(page_id, Params(params_el));
         }
+
+        m_ptrSettings->setPageParams(params_by_page);
     }      // Filter::loadSettings
 
     void Filter::setContentBox(const PageId& page_id, const ImageTransformation& xform, const QRectF& content_rect) {
@@ -354,18 +354,15 @@ namespace page_layout {
             return;
         }
 
-        const bool autoMarginsEnabled = m_ptrSettings->isPageAutoMarginsEnabled(m_pageId);
-        for (const PageId& page_id : pages) {
-            if (page_id == m_pageId) {
-                continue;
-            }
+        std::set<PageId> other_pages(pages);
+        other_pages.erase(m_pageId);
 
-            m_ptrSettings->setPageAutoMarginsEnabled(page_id, autoMarginsEnabled);
-            if (autoMarginsEnabled) {
-                m_ptrSettings->invalidateContentSize(page_id);
-            } else {
-                m_ptrSettings->setHardMarginsMM(page_id, m_marginsMM);
-            }
+        const bool autoMarginsEnabled = m_ptrSettings->isPageAutoMarginsEnabled(m_pageId);
+        m_ptrSettings->setPageAutoMarginsEnabled(other_pages, autoMarginsEnabled);
+        if (autoMarginsEnabled) {
+            m_ptrSettings->invalidateContentSize(other_pages);
+        } else {
+            m_ptrSettings->setHardMarginsMM(other_pages, m_marginsMM);
         }
 
         emit aggregateHardSizeChanged();
@@ -377,13 +374,10 @@ namespace page_layout {
             return;
         }
 
-        for (const PageId& page_id : pages) {
-            if (page_id == m_pageId) {
-                continue;
-            }
+        std::set<PageId> other_pages(pages);
+        other_pages.erase(m_pageId);
 
-            m_ptrSettings->setPageAlignment(page_id, m_alignment);
-        }
+        m_ptrSettings->setPageAlignment(other_pages, m_alignment);
 
         emit invalidateAllThumbnails();
     }
@@ -26,38 +26,21 @@ namespace page_layout {
             : m_ptrSettings(std::move(settings)) {
     }
 
-    bool OrderByHeightProvider::precedes(const PageId& lhs_page,
-                                         const bool lhs_incomplete,
-                                         const PageId& rhs_page,
-                                         const bool rhs_incomplete) const {
-        const std::unique_ptr<Params> lhs_params(m_ptrSettings->getPageParams(lhs_page));
-        const std::unique_ptr<Params> rhs_params(m_ptrSettings->getPageParams(rhs_page));
-
-        QSizeF lhs_size;
-        if (lhs_params) {
-            const Margins margins(lhs_params->hardMarginsMM());
-            lhs_size = lhs_params->contentSizeMM();
-            lhs_size += QSizeF(
-                    margins.left() + margins.right(), margins.top() + margins.bottom()
-            );
-        }
-        QSizeF rhs_size;
-        if (rhs_params) {
-            const Margins margins(rhs_params->hardMarginsMM());
-            rhs_size = rhs_params->contentSizeMM();
-            rhs_size += QSizeF(
+    PageOrderProvider::SortKey OrderByHeightProvider::sortKey(const PageId& page, const bool incomplete) const {
+        const std::unique_ptr<Params> params(m_ptrSettings->getPageParams(page));
+
+        QSizeF size;
+        if (params) {
+            const Margins margins(params->hardMarginsMM());
+            size = params->contentSizeMM();
+            size += QSizeF(
                     margins.left() + margins.right(), margins.top() + margins.bottom()
             );
         }
 
-        const bool lhs_valid = !lhs_incomplete && lhs_size.isValid();
-        const bool rhs_valid = !rhs_incomplete && rhs_size.isValid();
+        // Invalid (unknown) sizes go to the back.
+        const bool valid = !incomplete && size.isValid();
 
-        if (lhs_valid != rhs_valid) {
-            // Invalid (unknown) sizes go to the back.
-            return lhs_valid;
-        }
-
-        return lhs_size.height() < rhs_size.height();
-    } // OrderByHeightProvider::precedes
+        return SortKey(valid ? 0 : 1, size.height());
+    }
 }  // namespace page_layout
\ No newline at end of file
@@ -22,6 +22,7 @@
 #include "Params.h"
 #include "RelinkablePath.h"
 #include "AbstractRelinker.h"
+#include "SnapshotMap.h"
 #include <QMutex>
 #include <boost/foreach.hpp>
 #include <boost/multi_index_container.hpp>
@@ -144,6 +145,8 @@ namespace page_layout {
 
         void setPageParams(const PageId& page_id, const Params& params);
 
+        void setPageParams(const std::unordered_map<PageId, Params>& params);
+
         Params updateContentSizeAndGetParams(const PageId& page_id,
                                              const QRectF& page_rect,
                                              const QRectF& content_rect,
@@ -170,14 +173,20 @@ namespace page_layout {
 
         void setHardMarginsMM(const PageId& page_id, const Margins& margins_mm);
 
+        void setHardMarginsMM(const std::set<PageId>& pages, const Margins& margins_mm);
+
         Alignment getPageAlignment(const PageId& page_id) const;
 
         AggregateSizeChanged setPageAlignment(const PageId& page_id, const Alignment& alignment);
 
+        AggregateSizeChanged setPageAlignment(const std::set<PageId>& pages, const Alignment& alignment);
+
         AggregateSizeChanged setContentSizeMM(const PageId& page_id, const QSizeF& content_size_mm);
 
         void invalidateContentSize(const PageId& page_id);
 
+        void invalidateContentSize(const std::set<PageId>& pages);
+
         QSizeF getAggregateHardSizeMM() const;
 
         QSizeF getAggregateHardSizeMMLocked() const;
@@ -189,6 +198,8 @@ namespace page_layout {
 
         void setPageAutoMarginsEnabled(const PageId& page_id, bool state);
 
+        void setPageAutoMarginsEnabled(const std::set<PageId>& pages, bool state);
+
         const DeviationProvider<PageId>& deviationProvider() const;
 
     private:
@@ -234,9 +245,43 @@ namespace page_layout {
         typedef Container::index<SequencedTag>::type UnorderedItems;
         typedef Container::index<DescWidthTag>::type DescWidthOrder;
         typedef Container::index<DescHeightTag>::type DescHeightOrder;
+        typedef SnapshotMap<PageId, Item> PublishedItems;
+
+        /**
+         * \brief Makes the current state of an item visible to readers that don't take m_mutex.
+         */
+        void publishLocked(const Item& item);
+
+        /**
+         * \brief Same as publishLocked(const Item&), but the item only becomes
+         *        visible once the batch is committed.
+         */
+        void publishLocked(PublishedItems::Batch& batch, const Item& item);
+
+        /*
+         * These do the work of the public setters.  They leave publishing
+         * to the caller, so that changes to many pages can be published
+         * in one batch.
+         */
 
+        void setPageParamsLocked(PublishedItems::Batch& batch, const PageId& page_id, const Params& params);
+
+        void setHardMarginsMMLocked(PublishedItems::Batch& batch, const PageId& page_id, const Margins& margins_mm);
+
+        void setPageAlignmentLocked(PublishedItems::Batch& batch, const PageId& page_id, const Alignment& alignment);
+
+        void invalidateContentSizeLocked(PublishedItems::Batch& batch, const PageId& page_id);
+
+        void setPageAutoMarginsEnabledLocked(PublishedItems::Batch& batch, const PageId& page_id, bool state);
+
+        /**
+         * Guards m_items and the aggregate state derived from it.
+         * Per-page lookups go to m_publishedItems instead, which is
+         * updated along with m_items.
+         */
         mutable QMutex m_mutex;
         Container m_items;
+        PublishedItems m_publishedItems;
         UnorderedItems& m_unorderedItems;
         DescWidthOrder& m_descWidthOrder;
         DescHeightOrder& m_descHeightOrder;
@@ -284,6 +329,10 @@ namespace page_layout {
         return m_ptrImpl->setPageParams(page_id, params);
     }
 
+    void Settings::setPageParams(const std::unordered_map<PageId, Params>& params) {
+        m_ptrImpl->setPageParams(params);
+    }
+
     Params Settings::updateContentSizeAndGetParams(const PageId& page_id,
                                                    const QRectF& page_rect,
                                                    const QRectF& content_rect,
@@ -322,6 +371,10 @@ namespace page_layout {
         m_ptrImpl->setHardMarginsMM(page_id, margins_mm);
     }
 
+    void Settings::setHardMarginsMM(const std::set<PageId>& pages, const Margins& margins_mm) {
+        m_ptrImpl->setHardMarginsMM(pages, margins_mm);
+    }
+
     Alignment Settings::getPageAlignment(const PageId& page_id) const {
         return m_ptrImpl->getPageAlignment(page_id);
     }
@@ -330,6 +383,11 @@ namespace page_layout {
         return m_ptrImpl->setPageAlignment(page_id, alignment);
     }
 
+    Settings::AggregateSizeChanged
+    Settings::setPageAlignment(const std::set<PageId>& pages, const Alignment& alignment) {
+        return m_ptrImpl->setPageAlignment(pages, alignment);
+    }
+
     Settings::AggregateSizeChanged Settings::setContentSizeMM(const PageId& page_id, const QSizeF& content_size_mm) {
         return m_ptrImpl->setContentSizeMM(page_id, content_size_mm);
     }
@@ -338,6 +396,10 @@ namespace page_layout {
         return m_ptrImpl->invalidateContentSize(page_id);
     }
 
+    void Settings::invalidateContentSize(const std::set<PageId>& pages) {
+        m_ptrImpl->invalidateContentSize(pages);
+    }
+
     QSizeF Settings::getAggregateHardSizeMM() const {
         return m_ptrImpl->getAggregateHardSizeMM();
     }
@@ -355,6 +417,10 @@ namespace page_layout {
         return m_ptrImpl->setPageAutoMarginsEnabled(page_id, state);
     }
 
+    void Settings::setPageAutoMarginsEnabled(const std::set<PageId>& pages, const bool state) {
+        m_ptrImpl->setPageAutoMarginsEnabled(pages, state);
+    }
+
     bool Settings::isParamsNull(const PageId& page_id) const {
         return m_ptrImpl->isParamsNull(page_id);
     }
@@ -433,6 +499,7 @@ namespace page_layout {
     void Settings::Impl::clear() {
         const QMutexLocker locker(&m_mutex);
         m_items.clear();
+        m_publishedItems.clear();
         m_deviationProvider.clear();
     }
 
@@ -449,10 +516,13 @@ namespace page_layout {
 
         m_items.swap(new_items);
 
+        PublishedItems::Map published_items;
         m_deviationProvider.clear();
         for (const Item& item : m_unorderedItems) {
+            published_items.insert(PublishedItems::Map::value_type(item.pageId, item));
             m_deviationProvider.addOrUpdate(item.pageId);
         }
+        m_publishedItems.assign(published_items);
     }
 
     void Settings::Impl::removePagesMissingFrom(const PageSequence& pages) {
@@ -466,6 +536,7 @@ namespace page_layout {
         }
         std::sort(sorted_pages.begin(), sorted_pages.end());
 
+        PublishedItems::Batch batch(m_publishedItems);
         UnorderedItems::const_iterator it(m_unorderedItems.begin());
         const UnorderedItems::const_iterator end(m_unorderedItems.end());
         while (it != end) {
@@ -473,9 +544,11 @@ namespace page_layout {
                 ++it;
             } else {
                 m_deviationProvider.remove(it->pageId);
+                batch.erase(it->pageId);
                 m_unorderedItems.erase(it++);
             }
         }
+        batch.commit();
     }
 
     bool Settings::Impl::checkEverythingDefined(const PageSequence& pages, const PageId* ignore) const {
@@ -496,22 +569,38 @@ namespace page_layout {
 
     std::unique_ptr<Params>
     Settings::Impl::getPageParams(const PageId& page_id) const {
-        const QMutexLocker locker(&m_mutex);
-
-        const Container::iterator it(m_items.find(page_id));
-        if (it == m_items.end()) {
+        const std::shared_ptr<const Item> item(m_publishedItems.find(page_id));
+        if (!item) {
             return nullptr;
         }
 
         return std::make_unique<Params>(
-                it->hardMarginsMM, it->pageRect, it->contentRect,
-                it->contentSizeMM, it->alignment, it->autoMargins
+                item->hardMarginsMM, item->pageRect, item->contentRect,
+                item->contentSizeMM, item->alignment, item->autoMargins
         );
     }
 
     void Settings::Impl::setPageParams(const PageId& page_id, const Params& params) {
         const QMutexLocker locker(&m_mutex);
+        PublishedItems::Batch batch(m_publishedItems);
 
+        setPageParamsLocked(batch, page_id, params);
+        batch.commit();
+    }
+
+    void Settings::Impl::setPageParams(const std::unordered_map<PageId, Params>& params) {
+        const QMutexLocker locker(&m_mutex);
+        PublishedItems::Batch batch(m_publishedItems);
+
+        for (const std::pair<const PageId, Params>& kv : params) {
+            setPageParamsLocked(batch, kv.first, kv.second);
+        }
+        batch.commit();
+    }
+
+    void Settings::Impl::setPageParamsLocked(PublishedItems::Batch& batch,
+                                             const PageId& page_id,
+                                             const Params& params) {
         const Item new_item(
                 page_id, params.hardMarginsMM(), params.pageRect(),
                 params.contentRect(), params.contentSizeMM(), params.alignment(), params.isAutoMarginsEnabled()
@@ -524,6 +613,7 @@ namespace page_layout {
             m_items.replace(it, new_item);
         }
 
+        publishLocked(batch, new_item);
         m_deviationProvider.addOrUpdate(page_id);
     }
 
@@ -551,6 +641,7 @@ namespace page_layout {
         } else {
             m_items.modify(it, ModifyContentSize(content_size_mm, content_rect, page_rect));
         }
+        publishLocked(*item_it);
 
         if (agg_hard_size_after) {
             *agg_hard_size_after = getAggregateHardSizeMMLocked();
@@ -609,68 +700,114 @@ namespace page_layout {
     }      // Settings::Impl::updateContentRect
 
     Margins Settings::Impl::getHardMarginsMM(const PageId& page_id) const {
-        const QMutexLocker locker(&m_mutex);
-
-        const Container::iterator it(m_items.find(page_id));
-        if (it == m_items.end()) {
+        const std::shared_ptr<const Item> item(m_publishedItems.find(page_id));
+        if (!item) {
             return m_defaultHardMarginsMM;
         } else {
-            return it->hardMarginsMM;
+            return item->hardMarginsMM;
         }
     }
 
     void Settings::Impl::setHardMarginsMM(const PageId& page_id, const Margins& margins_mm) {
         const QMutexLocker locker(&m_mutex);
+        PublishedItems::Batch batch(m_publishedItems);
+
+        setHardMarginsMMLocked(batch, page_id, margins_mm);
+        batch.commit();
+    }
+
+    void Settings::Impl::setHardMarginsMM(const std::set<PageId>& pages, const Margins& margins_mm) {
+        const QMutexLocker locker(&m_mutex);
+        PublishedItems::Batch batch(m_publishedItems);
 
+        for (const PageId& page_id : pages) {
+            setHardMarginsMMLocked(batch, page_id, margins_mm);
+        }
+        batch.commit();
+    }
+
+    void Settings::Impl::setHardMarginsMMLocked(PublishedItems::Batch& batch,
+                                                const PageId& page_id,
+                                                const Margins& margins_mm) {
         const Container::iterator it(m_items.lower_bound(page_id));
+        Container::iterator item_it(it);
         if ((it == m_items.end()) || (page_id < it->pageId)) {
             const Item item(
                     page_id, margins_mm, m_invalidRect, m_invalidRect,
                     m_invalidSize, m_defaultAlignment, m_autoMarginsDefault
             );
-            m_items.insert(it, item);
+            item_it = m_items.insert(it, item);
         } else {
             m_items.modify(it, ModifyMargins(margins_mm, it->autoMargins));
         }
+        publishLocked(batch, *item_it);
 
         m_deviationProvider.addOrUpdate(page_id);
     }
 
     Alignment Settings::Impl::getPageAlignment(const PageId& page_id) const {
-        const QMutexLocker locker(&m_mutex);
-
-        const Container::iterator it(m_items.find(page_id));
-        if (it == m_items.end()) {
+        const std::shared_ptr<const Item> item(m_publishedItems.find(page_id));
+        if (!item) {
             return m_defaultAlignment;
         } else {
-            return it->alignment;
+            return item->alignment;
         }
     }
 
     Settings::AggregateSizeChanged Settings::Impl::setPageAlignment(const PageId& page_id, const Alignment& alignment) {
         const QMutexLocker locker(&m_mutex);
+        PublishedItems::Batch batch(m_publishedItems);
 
         const QSizeF agg_size_before(getAggregateHardSizeMMLocked());
 
+        setPageAlignmentLocked(batch, page_id, alignment);
+        batch.commit();
+
+        const QSizeF agg_size_after(getAggregateHardSizeMMLocked());
+        if (agg_size_before == agg_size_after) {
+            return AGGREGATE_SIZE_UNCHANGED;
+        } else {
+            return AGGREGATE_SIZE_CHANGED;
+        }
+    }
+
+    Settings::AggregateSizeChanged
+    Settings::Impl::setPageAlignment(const std::set<PageId>& pages, const Alignment& alignment) {
+        const QMutexLocker locker(&m_mutex);
+        PublishedItems::Batch batch(m_publishedItems);
+
+        const QSizeF agg_size_before(getAggregateHardSizeMMLocked());
+
+        for (const PageId& page_id : pages) {
+            setPageAlignmentLocked(batch, page_id, alignment);
+        }
+        batch.commit();
+
+        const QSizeF agg_size_after(getAggregateHardSizeMMLocked());
+        if (agg_size_before == agg_size_after) {
+            return AGGREGATE_SIZE_UNCHANGED;
+        } else {
+            return AGGREGATE_SIZE_CHANGED;
+        }
+    }
+
+    void Settings::Impl::setPageAlignmentLocked(PublishedItems::Batch& batch,
+                                                const PageId& page_id,
+                                                const Alignment& alignment) {
         const Container::iterator it(m_items.lower_bound(page_id));
+        Container::iterator item_it(it);
         if ((it == m_items.end()) || (page_id < it->pageId)) {
             const Item item(
                     page_id, m_defaultHardMarginsMM, m_invalidRect, m_invalidRect,
                     m_invalidSize, alignment, m_autoMarginsDefault
             );
-            m_items.insert(it, item);
+            item_it = m_items.insert(it, item);
         } else {
             m_items.modify(it, ModifyAlignment(alignment));
         }
+        publishLocked(batch, *item_it);
 
         m_deviationProvider.addOrUpdate(page_id);
-
-        const QSizeF agg_size_after(getAggregateHardSizeMMLocked());
-        if (agg_size_before == agg_size_after) {
-            return AGGREGATE_SIZE_UNCHANGED;
-        } else {
-            return AGGREGATE_SIZE_CHANGED;
-        }
     }
 
     Settings::AggregateSizeChanged
@@ -680,15 +817,17 @@ namespace page_layout {
         const QSizeF agg_size_before(getAggregateHardSizeMMLocked());
 
         const Container::iterator it(m_items.lower_bound(page_id));
+        Container::iterator item_it(it);
         if ((it == m_items.end()) || (page_id < it->pageId)) {
             const Item item(
                     page_id, m_defaultHardMarginsMM, m_invalidRect, m_invalidRect,
                     content_size_mm, m_defaultAlignment, m_autoMarginsDefault
             );
-            m_items.insert(it, item);
+            item_it = m_items.insert(it, item);
         } else {
             m_items.modify(it, ModifyContentSize(content_size_mm, m_invalidRect, it->pageRect));
         }
+        publishLocked(*item_it);
 
         m_deviationProvider.addOrUpdate(page_id);
 
@@ -702,10 +841,27 @@ namespace page_layout {
 
     void Settings::Impl::invalidateContentSize(const PageId& page_id) {
         const QMutexLocker locker(&m_mutex);
+        PublishedItems::Batch batch(m_publishedItems);
+
+        invalidateContentSizeLocked(batch, page_id);
+        batch.commit();
+    }
+
+    void Settings::Impl::invalidateContentSize(const std::set<PageId>& pages) {
+        const QMutexLocker locker(&m_mutex);
+        PublishedItems::Batch batch(m_publishedItems);
+
+        for (const PageId& page_id : pages) {
+            invalidateContentSizeLocked(batch, page_id);
+        }
+        batch.commit();
+    }
 
+    void Settings::Impl::invalidateContentSizeLocked(PublishedItems::Batch& batch, const PageId& page_id) {
         const Container::iterator it(m_items.find(page_id));
         if (it != m_items.end()) {
             m_items.modify(it, ModifyContentSize(m_invalidSize, m_invalidRect, it->pageRect));
+            publishLocked(batch, *it);
         }
 
         m_deviationProvider.addOrUpdate(page_id);
@@ -784,38 +940,62 @@ namespace page_layout {
     }  // Settings::Impl::getAggregateHardSizeMM
 
     bool Settings::Impl::isPageAutoMarginsEnabled(const PageId& page_id) {
-        const QMutexLocker locker(&m_mutex);
-
-        const Container::iterator it(m_items.find(page_id));
-        if (it == m_items.end()) {
+        const std::shared_ptr<const Item> item(m_publishedItems.find(page_id));
+        if (!item) {
             return m_autoMarginsDefault;
         } else {
-            return it->autoMargins;
+            return item->autoMargins;
         }
     }
 
     void Settings::Impl::setPageAutoMarginsEnabled(const PageId& page_id, const bool state) {
         const QMutexLocker locker(&m_mutex);
+        PublishedItems::Batch batch(m_publishedItems);
+
+        setPageAutoMarginsEnabledLocked(batch, page_id, state);
+        batch.commit();
+    }
+
+    void Settings::Impl::setPageAutoMarginsEnabled(const std::set<PageId>& pages, const bool state) {
+        const QMutexLocker locker(&m_mutex);
+        PublishedItems::Batch batch(m_publishedItems);
 
+        for (const PageId& page_id : pages) {
+            setPageAutoMarginsEnabledLocked(batch, page_id, state);
+        }
+        batch.commit();
+    }
+
+    void Settings::Impl::setPageAutoMarginsEnabledLocked(PublishedItems::Batch& batch,
+                                                         const PageId& page_id,
+                                                         const bool state) {
         const Container::iterator it(m_items.lower_bound(page_id));
+        Container::iterator item_it(it);
         if ((it == m_items.end()) || (page_id < it->pageId)) {
             const Item item(
                     page_id, m_defaultHardMarginsMM, m_invalidRect, m_invalidRect,
                     m_invalidSize, m_defaultAlignment, state
             );
-            m_items.insert(it, item);
+            item_it = m_items.insert(it, item);
         } else {
             m_items.modify(it, ModifyMargins(it->hardMarginsMM, state));
         }
+        publishLocked(batch, *item_it);
     }
 
     bool Settings::Impl::isParamsNull(const PageId& page_id) const {
-        const QMutexLocker locker(&m_mutex);
-
-        return (m_items.find(page_id) == m_items.end());
+        return !m_publishedItems.contains(page_id);
     }
 
     const DeviationProvider<PageId>& Settings::Impl::deviationProvider() const {
         return m_deviationProvider;
     }
+
+    void Settings::Impl::publishLocked(const Item& item) {
+        m_publishedItems.set(item.pageId, item);
+    }
+
+    void Settings::Impl::publishLocked(PublishedItems::Batch& batch, const Item& item) {
+        batch.set(item.pageId, item);
+    }
 }  // namespace page_layout
\ No newline at end of file
@@ -23,6 +23,8 @@
 #include "ref_countable.h"
 #include "Margins.h"
 #include <memory>
+#include <set>
+#include <unordered_map>
 #include <DeviationProvider.h>
 
 class PageId;
@@ -85,6 +87,14 @@ namespace page_layout {
          */
         void setPageParams(const PageId& page_id, const Params& params);
 
+        /**
+         * \brief Set all parameters of many pages at once.
+         *
+         * This and the other overloads taking many pages publish the
+         * changes together, which is much cheaper than one page at a time.
+         */
+        void setPageParams(const std::unordered_map<PageId, Params>& params);
+
         /**
          * \brief Updates content size and returns all parameters at once.
          */
@@ -125,6 +135,8 @@ namespace page_layout {
          */
         void setHardMarginsMM(const PageId& page_id, const Margins& margins_mm);
 
+        void setHardMarginsMM(const std::set<PageId>& pages, const Margins& margins_mm);
+
         /**
          * \brief Returns the alignment for the specified page.
          *
@@ -143,6 +155,8 @@ namespace page_layout {
          */
         AggregateSizeChanged setPageAlignment(const PageId& page_id, const Alignment& alignment);
 
+        AggregateSizeChanged setPageAlignment(const std::set<PageId>& pages, const Alignment& alignment);
+
         /**
          * \brief Sets content size in millimeters for the specified page.
          *
@@ -152,6 +166,8 @@ namespace page_layout {
 
         void invalidateContentSize(const PageId& page_id);
 
+        void invalidateContentSize(const std::set<PageId>& pages);
+
         /**
          * \brief Returns the aggregate (max width + max height) hard page size.
          */
@@ -171,6 +187,8 @@ namespace page_layout {
 
         void setPageAutoMarginsEnabled(const PageId& page_id, bool state);
 
+        void setPageAutoMarginsEnabled(const std::set<PageId>& pages, bool state);
+
         const DeviationProvider<PageId>& deviationProvider() const;
 
     private:
@@ -30,6 +30,7 @@
 #include "ImageView.h"
 #include "filters/output/Task.h"
 #include "Dpm.h"
+#include "Tracer.h"
 
 namespace page_layout {
     class Task::UiUpdater : public FilterResult {
@@ -81,6 +82,8 @@ namespace page_layout {
                                   const FilterData& data,
                                   const QRectF& page_rect,
                                   const QRectF& content_rect) {
+        const TraceSpan span("stage", "page_layout::Task");
+
         status.throwIfCancelled();
 
         const QSizeF content_size_mm(
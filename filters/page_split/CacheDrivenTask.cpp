@@ -71,6 +71,11 @@ namespace page_split {
 
         if (!params || !deps.compatibleWith(*params)) {
             if (auto* thumb_col = dynamic_cast<ThumbnailCollector*>(collector)) {
+                if (!thumb_col->needThumbnail()) {
+                    thumb_col->processIncompleteness(true);
+
+                    return;
+                }
                 thumb_col->processThumbnail(
                         std::unique_ptr<QGraphicsItem>(
                                 new IncompleteThumbnail(
@@ -102,6 +107,11 @@ namespace page_split {
         }
 
         if (auto* thumb_col = dynamic_cast<ThumbnailCollector*>(collector)) {
+            if (!thumb_col->needThumbnail()) {
+                thumb_col->processIncompleteness(false);
+
+                return;
+            }
             thumb_col->processThumbnail(
                     std::unique_ptr<QGraphicsItem>(
                             new Thumbnail(
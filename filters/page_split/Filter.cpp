@@ -105,6 +105,8 @@ namespace page_split {
                 layoutTypeFromString(default_layout_type)
         );
 
+        std::vector<std::pair<ImageId, Settings::UpdateAction>> updates;
+
         const QString image_tag_name("image");
         QDomNode node(filter_el.firstChild());
         for (; !node.isNull(); node = node.nextSibling()) {
@@ -139,8 +141,10 @@ namespace page_split {
                 update.setParams(Params(params_el));
             }
 
-            m_ptrSettings->updatePage(image_id, update);
+            updates.emplace_back(image_id, update);
         }
+
+        m_ptrSettings->updatePages(updates);
     }  // Filter::loadSettings
 
     void Filter::pageOrientationUpdate(const ImageId& image_id, const OrthogonalRotation& orientation) {
@@ -235,6 +235,7 @@ namespace page_split {
 
         const Params params = *(m_ptrSettings->getPageRecord(m_pageId.imageId()).params());
 
+        std::vector<std::pair<ImageId, Settings::UpdateAction>> updates;
         if (layout_type != AUTO_LAYOUT_TYPE) {
             for (const PageId& page_id : pages) {
                 if (m_pageId == page_id) {
@@ -246,7 +247,8 @@ namespace page_split {
                 if (apply_cut && (layout_type != SINGLE_PAGE_UNCUT)) {
                     Params new_params(params);
 
-                    const Params* old_params = m_ptrSettings->getPageRecord(page_id.imageId()).params();
+                    const Settings::Record old_record(m_ptrSettings->getPageRecord(page_id.imageId()));
+                    const Params* old_params = old_record.params();
                     if (old_params != nullptr) {
                         std::unique_ptr<PageLayout> newPageLayout =
                                 PageLayoutAdapter::adaptPageLayout(params.pageLayout(),
@@ -262,7 +264,7 @@ namespace page_split {
 
                     update_params.setParams(new_params);
                 }
-                m_ptrSettings->updatePage(page_id.imageId(), update_params);
+                updates.emplace_back(page_id.imageId(), update_params);
             }
         } else {
             for (const PageId& page_id : pages) {
@@ -272,9 +274,10 @@ namespace page_split {
 
                 Settings::UpdateAction update_params;
                 update_params.setLayoutType(layout_type);
-                m_ptrSettings->updatePage(page_id.imageId(), update_params);
+                updates.emplace_back(page_id.imageId(), update_params);
             }
         }
+        m_ptrSettings->updatePages(updates);
 
         if (pages.size() > 1) {
             emit invalidateAllThumbnails();
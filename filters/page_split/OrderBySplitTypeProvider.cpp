@@ -18,7 +18,6 @@
  */
 
 #include "OrderBySplitTypeProvider.h"
-#include <cassert>
 #include <utility>
 
 namespace page_split {
@@ -26,48 +25,35 @@ namespace page_split {
             : m_ptrSettings(std::move(settings)) {
     }
 
-    bool OrderBySplitTypeProvider::precedes(const PageId& lhs_page,
-                                            const bool lhs_incomplete,
-                                            const PageId& rhs_page,
-                                            const bool rhs_incomplete) const {
-        if (lhs_incomplete != rhs_incomplete) {
+    PageOrderProvider::SortKey OrderBySplitTypeProvider::sortKey(const PageId& page, const bool incomplete) const {
+        if (incomplete) {
             // Pages with question mark go to the bottom.
-            return rhs_incomplete;
-        } else if (lhs_incomplete) {
-            assert(rhs_incomplete);
-            // Two pages with question marks are ordered naturally.
-            return lhs_page < rhs_page;
+            return SortKey(1000, 0.0);
         }
 
-        assert(!lhs_incomplete);
-        assert(!rhs_incomplete);
-
-        const Settings::Record lhs_record(m_ptrSettings->getPageRecord(lhs_page.imageId()));
-        const Settings::Record rhs_record(m_ptrSettings->getPageRecord(rhs_page.imageId()));
+        const Settings::Record record(m_ptrSettings->getPageRecord(page.imageId()));
 
-        const Params* lhs_params = lhs_record.params();
-        const Params* rhs_params = rhs_record.params();
-
-        int lhs_layout_type = lhs_record.combinedLayoutType();
-        if (lhs_params) {
-            lhs_layout_type = lhs_params->pageLayout().toLayoutType();
+        int layout_type = record.combinedLayoutType();
+        if (const Params* params = record.params()) {
+            layout_type = params->pageLayout().toLayoutType();
         }
-        if (lhs_layout_type == AUTO_LAYOUT_TYPE) {
-            lhs_layout_type = 100;  // To force it below pages with known layout.
+        if (layout_type == AUTO_LAYOUT_TYPE) {
+            layout_type = 100;  // To force it below pages with known layout.
         }
 
-        int rhs_layout_type = rhs_record.combinedLayoutType();
-        if (rhs_params) {
-            rhs_layout_type = rhs_params->pageLayout().toLayoutType();
-        }
-        if (rhs_layout_type == AUTO_LAYOUT_TYPE) {
-            rhs_layout_type = 100;  // To force it below pages with known layout.
-        }
+        return SortKey(layout_type, 0.0);
+    }
 
-        if (lhs_layout_type == rhs_layout_type) {
+    bool OrderBySplitTypeProvider::keyPrecedes(const PageId& lhs_page,
+                                               const SortKey& lhs_key,
+                                               const PageId& rhs_page,
+                                               const SortKey& rhs_key) const {
+        if (lhs_key.group == rhs_key.group) {
+            // Pages of the same layout type, as well as pages with
+            // question marks, are ordered naturally.
             return lhs_page < rhs_page;
         } else {
-            return lhs_layout_type < rhs_layout_type;
+            return lhs_key.group < rhs_key.group;
         }
-    }  // OrderBySplitTypeProvider::precedes
+    }
 }  // namespace page_split
\ No newline at end of file
@@ -29,10 +29,12 @@ namespace page_split {
     public:
         explicit OrderBySplitTypeProvider(intrusive_ptr<Settings> settings);
 
-        bool precedes(const PageId& lhs_page,
-                      bool lhs_incomplete,
-                      const PageId& rhs_page,
-                      bool rhs_incomplete) const override;
+        SortKey sortKey(const PageId& page, bool incomplete) const override;
+
+        bool keyPrecedes(const PageId& lhs_page,
+                         const SortKey& lhs_key,
+                         const PageId& rhs_page,
+                         const SortKey& rhs_key) const override;
 
     private:
         intrusive_ptr<Settings> m_ptrSettings;
@@ -25,6 +25,7 @@
 #include "ProjectPages.h"
 #include "DebugImages.h"
 #include "ImageTransformation.h"
+#include "AnalysisPyramid.h"
 #include "imageproc/Binarize.h"
 #include "imageproc/BinaryThreshold.h"
 #include "imageproc/Morphology.h"
@@ -209,22 +210,21 @@ namespace page_split {
     }  // anonymous namespace
 
     PageLayout PageLayoutEstimator::estimatePageLayout(const LayoutType layout_type,
-                                                       const QImage& input,
+                                                       const AnalysisPyramid& pyramid,
                                                        const ImageTransformation& pre_xform,
-                                                       const BinaryThreshold bw_threshold,
                                                        DebugImages* const dbg) {
         if (layout_type == SINGLE_PAGE_UNCUT) {
             return PageLayout(pre_xform.resultingRect());
         }
 
         std::unique_ptr<PageLayout> layout(
-                tryCutAtFoldingLine(layout_type, input, pre_xform, dbg)
+                tryCutAtFoldingLine(layout_type, pyramid.normalizedGray(), pre_xform, dbg)
         );
         if (layout) {
             return *layout;
         }
 
-        return cutAtWhitespace(layout_type, input, pre_xform, bw_threshold, dbg);
+        return cutAtWhitespace(layout_type, pyramid, pre_xform, dbg);
     }
 
     namespace {
@@ -347,24 +347,21 @@ namespace page_split {
  * \param layout_type The type of a layout to detect.  If set to
  *        something other than AUTO_LAYOUT_TYPE, the returned
  *        layout will have the same type.
- * \param input The input image.  Will be converted to grayscale unless
- *        it's already grayscale.
+ * \param pyramid The input image along with its reduced versions.
  * \param pre_xform The logical transformation applied to the input image.
  *        The resulting page layout will be in transformed coordinates.
- * \param bw_threshold The global binarization threshold for the input image.
  * \param dbg An optional sink for debugging images.
  * \return Even if no suitable whitespace was found, this function
  *         will return a PageLayout consistent with the layout_type requested.
  */
     PageLayout PageLayoutEstimator::cutAtWhitespace(const LayoutType layout_type,
-                                                    const QImage& input,
+                                                    const AnalysisPyramid& pyramid,
                                                     const ImageTransformation& pre_xform,
-                                                    const BinaryThreshold bw_threshold,
                                                     DebugImages* const dbg) {
         QTransform xform;
 
         // Convert to B/W and rotate.
-        BinaryImage img(to300DpiBinary(input, xform, bw_threshold));
+        BinaryImage img(to300DpiBinary(pyramid, xform));
         // Note: here we assume the only transformation applied
         // to the input image is orthogonal rotation.
         img = orthogonalRotation(img, pre_xform.preRotation().toDegrees());
@@ -509,26 +506,10 @@ namespace page_split {
         }
     }  // PageLayoutEstimator::cutAtWhitespaceDeskewed150
 
-    imageproc::BinaryImage PageLayoutEstimator::to300DpiBinary(const QImage& img,
-                                                               QTransform& xform,
-                                                               const BinaryThreshold binary_threshold) {
-        const double xfactor = (300.0 * constants::DPI2DPM) / img.dotsPerMeterX();
-        const double yfactor = (300.0 * constants::DPI2DPM) / img.dotsPerMeterY();
-        if ((fabs(xfactor - 1.0) < 0.1) && (fabs(yfactor - 1.0) < 0.1)) {
-            return BinaryImage(img, binary_threshold);
-        }
-
-        QTransform scale_xform;
-        scale_xform.scale(xfactor, yfactor);
-        xform *= scale_xform;
-        const QSize new_size(
-                std::max(1, (int) ceil(xfactor * img.width())),
-                std::max(1, (int) ceil(yfactor * img.height()))
-        );
-
-        const GrayImage new_image(scaleToGray(GrayImage(img), new_size));
+    imageproc::BinaryImage PageLayoutEstimator::to300DpiBinary(const AnalysisPyramid& pyramid, QTransform& xform) {
+        xform *= pyramid.origToDpi(300);
 
-        return BinaryImage(new_image, binary_threshold);
+        return pyramid.binaryAtDpi(300);
     }
 
     BinaryImage PageLayoutEstimator::removeGarbageAnd2xDownscale(const BinaryImage& image, DebugImages* dbg) {
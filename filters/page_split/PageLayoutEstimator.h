@@ -30,6 +30,7 @@ class QPoint;
 class QImage;
 class QTransform;
 class ImageTransformation;
+class AnalysisPyramid;
 class DebugImages;
 class Span;
 
@@ -49,20 +50,16 @@ namespace page_split {
          * \param layout_type The type of a layout to detect.  If set to
          *        something other than Rule::AUTO_DETECT, the returned
          *        layout will have the same type.
-         * \param input The input image.  Will be converted to grayscale unless
-         *        it's already grayscale.
+         * \param pyramid The input image along with its reduced versions.
          * \param pre_xform The logical transformation applied to the input image.
          *        The resulting page layout will be in transformed coordinates.
-         * \param bw_threshold The global binarization threshold for the
-         *        input image.
          * \param dbg An optional sink for debugging images.
          * \return The estimated PageLayout of type consistent with the
          *         requested layout type.
          */
         static PageLayout estimatePageLayout(LayoutType layout_type,
-                                             const QImage& input,
+                                             const AnalysisPyramid& pyramid,
                                              const ImageTransformation& pre_xform,
-                                             imageproc::BinaryThreshold bw_threshold,
                                              DebugImages* dbg = nullptr);
 
     private:
@@ -72,9 +69,8 @@ namespace page_split {
                                                                DebugImages* dbg);
 
         static PageLayout cutAtWhitespace(LayoutType layout_type,
-                                          const QImage& input,
+                                          const AnalysisPyramid& pyramid,
                                           const ImageTransformation& pre_xform,
-                                          imageproc::BinaryThreshold bw_threshold,
                                           DebugImages* dbg);
 
         static PageLayout cutAtWhitespaceDeskewed150(LayoutType layout_type,
@@ -84,9 +80,7 @@ namespace page_split {
                                                      bool right_offcut,
                                                      DebugImages* dbg);
 
-        static imageproc::BinaryImage to300DpiBinary(const QImage& img,
-                                                     QTransform& xform,
-                                                     imageproc::BinaryThreshold threshold);
+        static imageproc::BinaryImage to300DpiBinary(const AnalysisPyramid& pyramid, QTransform& xform);
 
         static imageproc::BinaryImage
         removeGarbageAnd2xDownscale(const imageproc::BinaryImage& image, DebugImages* dbg);
@@ -37,96 +37,93 @@ namespace page_split {
 
     void Settings::performRelinking(const AbstractRelinker& relinker) {
         QMutexLocker locker(&m_mutex);
-        PerPageRecords new_records;
+        PerPageRecords::Map new_records;
 
-        for (const PerPageRecords::value_type& kv : m_perPageRecords) {
-            const RelinkablePath old_path(kv.first.filePath(), RelinkablePath::File);
-            ImageId new_image_id(kv.first);
+        m_perPageRecords.forEach([&](const ImageId& image_id, const BaseRecord& record) {
+            const RelinkablePath old_path(image_id.filePath(), RelinkablePath::File);
+            ImageId new_image_id(image_id);
             new_image_id.setFilePath(relinker.substitutionPathFor(old_path));
-            new_records.insert(PerPageRecords::value_type(new_image_id, kv.second));
-        }
+            new_records.insert(PerPageRecords::Map::value_type(new_image_id, record));
+        });
 
-        m_perPageRecords.swap(new_records);
+        m_perPageRecords.assign(new_records);
     }
 
     LayoutType Settings::defaultLayoutType() const {
-        QMutexLocker locker(&m_mutex);
-
         return m_defaultLayoutType;
     }
 
     void Settings::setLayoutTypeForAllPages(const LayoutType layout_type) {
         QMutexLocker locker(&m_mutex);
+        PerPageRecords::Map new_records;
 
-        auto it(m_perPageRecords.begin());
-        const auto end(m_perPageRecords.end());
-        while (it != end) {
-            if (it->second.hasLayoutTypeConflict(layout_type)) {
-                m_perPageRecords.erase(it++);
-            } else {
-                it->second.clearLayoutType();
-                ++it;
+        m_perPageRecords.forEach([&](const ImageId& image_id, const BaseRecord& record) {
+            if (!record.hasLayoutTypeConflict(layout_type)) {
+                BaseRecord new_record(record);
+                new_record.clearLayoutType();
+                new_records.insert(PerPageRecords::Map::value_type(image_id, new_record));
             }
-        }
+        });
 
+        m_perPageRecords.assign(new_records);
         m_defaultLayoutType = layout_type;
     }
 
     void Settings::setLayoutTypeFor(const LayoutType layout_type, const std::set<PageId>& pages) {
         QMutexLocker locker(&m_mutex);
+        PerPageRecords::Batch batch(m_perPageRecords);
 
         UpdateAction action;
+        action.setLayoutType(layout_type);
 
         for (const PageId& page_id : pages) {
-            updatePageLocked(page_id.imageId(), action);
+            updatePageLocked(batch, page_id.imageId(), action);
         }
+
+        batch.commit();
     }
 
     Settings::Record Settings::getPageRecord(const ImageId& image_id) const {
-        QMutexLocker locker(&m_mutex);
-
-        return getPageRecordLocked(image_id);
+        const std::shared_ptr<const BaseRecord> base_record(m_perPageRecords.find(image_id));
+        if (!base_record) {
+            return Record(m_defaultLayoutType);
+        } else {
+            return Record(*base_record, m_defaultLayoutType);
+        }
     }
 
-    Settings::Record Settings::getPageRecordLocked(const ImageId& image_id) const {
-        auto it(m_perPageRecords.find(image_id));
-        if (it == m_perPageRecords.end()) {
+    Settings::Record Settings::getPageRecord(const PerPageRecords::Batch& batch, const ImageId& image_id) const {
+        const std::shared_ptr<const BaseRecord> base_record(batch.find(image_id));
+        if (!base_record) {
             return Record(m_defaultLayoutType);
         } else {
-            return Record(it->second, m_defaultLayoutType);
+            return Record(*base_record, m_defaultLayoutType);
         }
     }
 
     void Settings::updatePage(const ImageId& image_id, const UpdateAction& action) {
         QMutexLocker locker(&m_mutex);
-        updatePageLocked(image_id, action);
-    }
+        PerPageRecords::Batch batch(m_perPageRecords);
 
-    void Settings::updatePageLocked(const ImageId& image_id, const UpdateAction& action) {
-        auto it(m_perPageRecords.find(image_id));
-        if (it == m_perPageRecords.end()) {
-            // No record exists for this page.
-
-            Record record(m_defaultLayoutType);
-            record.update(action);
+        updatePageLocked(batch, image_id, action);
+        batch.commit();
+    }
 
-            if (record.hasLayoutTypeConflict()) {
-                record.clearParams();
-            }
+    void Settings::updatePages(const std::vector<std::pair<ImageId, UpdateAction>>& updates) {
+        QMutexLocker locker(&m_mutex);
+        PerPageRecords::Batch batch(m_perPageRecords);
 
-            if (!record.isNull()) {
-                m_perPageRecords.insert(
-                        it, PerPageRecords::value_type(image_id, record)
-                );
-            }
-        } else {
-            // A record was found.
-            updatePageLocked(it, action);
+        for (const std::pair<ImageId, UpdateAction>& update : updates) {
+            updatePageLocked(batch, update.first, update.second);
         }
+
+        batch.commit();
     }
 
-    void Settings::updatePageLocked(const PerPageRecords::iterator it, const UpdateAction& action) {
-        Record record(it->second, m_defaultLayoutType);
+    void Settings::updatePageLocked(PerPageRecords::Batch& batch,
+                                    const ImageId& image_id,
+                                    const UpdateAction& action) {
+        Record record(getPageRecord(batch, image_id));
         record.update(action);
 
         if (record.hasLayoutTypeConflict()) {
@@ -134,68 +131,39 @@ namespace page_split {
         }
 
         if (record.isNull()) {
-            m_perPageRecords.erase(it);
+            batch.erase(image_id);
         } else {
-            it->second = record;
+            batch.set(image_id, record);
         }
     }
 
     Settings::Record Settings::conditionalUpdate(const ImageId& image_id, const UpdateAction& action, bool* conflict) {
         QMutexLocker locker(&m_mutex);
 
-        auto it(m_perPageRecords.find(image_id));
-        if (it == m_perPageRecords.end()) {
-            // No record exists for this page.
-
-            Record record(m_defaultLayoutType);
-            record.update(action);
-
-            if (record.hasLayoutTypeConflict()) {
-                if (conflict) {
-                    *conflict = true;
-                }
-
-                return Record(m_defaultLayoutType);
-            }
-
-            if (!record.isNull()) {
-                m_perPageRecords.insert(
-                        it, PerPageRecords::value_type(image_id, record)
-                );
-            }
+        const Record old_record(getPageRecord(image_id));
+        Record record(old_record);
+        record.update(action);
 
+        if (record.hasLayoutTypeConflict()) {
             if (conflict) {
-                *conflict = false;
+                *conflict = true;
             }
 
-            return record;
-        } else {
-            // A record was found.
-
-            Record record(it->second, m_defaultLayoutType);
-            record.update(action);
-
-            if (record.hasLayoutTypeConflict()) {
-                if (conflict) {
-                    *conflict = true;
-                }
-
-                return Record(it->second, m_defaultLayoutType);
-            }
+            return old_record;
+        }
 
-            if (conflict) {
-                *conflict = false;
-            }
+        if (conflict) {
+            *conflict = false;
+        }
 
-            if (record.isNull()) {
-                m_perPageRecords.erase(it);
+        if (record.isNull()) {
+            m_perPageRecords.erase(image_id);
 
-                return Record(m_defaultLayoutType);
-            } else {
-                it->second = record;
+            return Record(m_defaultLayoutType);
+        } else {
+            m_perPageRecords.set(image_id, record);
 
-                return record;
-            }
+            return record;
         }
     }  // Settings::conditionalUpdate
 
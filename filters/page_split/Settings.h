@@ -26,10 +26,13 @@
 #include "Params.h"
 #include "ImageId.h"
 #include "PageId.h"
+#include "SnapshotMap.h"
 #include <QMutex>
+#include <atomic>
 #include <memory>
-#include <unordered_map>
 #include <set>
+#include <utility>
+#include <vector>
 
 class AbstractRelinker;
 
@@ -163,6 +166,14 @@ namespace page_split {
          */
         void updatePage(const ImageId& image_id, const UpdateAction& action);
 
+        /**
+         * \brief Performs updatePage() for each of the updates, in order.
+         *
+         * The results become visible all at once, which is much cheaper
+         * than updating the pages one by one.
+         */
+        void updatePages(const std::vector<std::pair<ImageId, UpdateAction>>& updates);
+
         /**
          * \brief Performs a conditional update on the page.
          *
@@ -174,17 +185,20 @@ namespace page_split {
         Record conditionalUpdate(const ImageId& image_id, const UpdateAction& action, bool* conflict = nullptr);
 
     private:
-        typedef std::unordered_map<ImageId, BaseRecord> PerPageRecords;
+        typedef SnapshotMap<ImageId, BaseRecord> PerPageRecords;
 
-        Record getPageRecordLocked(const ImageId& image_id) const;
+        Record getPageRecord(const PerPageRecords::Batch& batch, const ImageId& image_id) const;
 
-        void updatePageLocked(const ImageId& image_id, const UpdateAction& action);
-
-        void updatePageLocked(PerPageRecords::iterator it, const UpdateAction& action);
+        void updatePageLocked(PerPageRecords::Batch& batch, const ImageId& image_id, const UpdateAction& action);
 
+        /**
+         * Serializes writers.  Readers don't need it, which means that while
+         * setLayoutTypeForAllPages() is in progress, they may see the new
+         * records combined with the old default layout type.
+         */
         mutable QMutex m_mutex;
         PerPageRecords m_perPageRecords;
-        LayoutType m_defaultLayoutType;
+        std::atomic<LayoutType> m_defaultLayoutType;
     };
 }  // namespace page_split
 #endif // ifndef PAGE_SPLIT_SETTINGS_H_
@@ -33,6 +33,7 @@
 #include "FilterUiInterface.h"
 #include "DebugImages.h"
 #include "PageLayoutAdapter.h"
+#include "Tracer.h"
 
 namespace page_split {
     using imageproc::BinaryThreshold;
@@ -102,6 +103,8 @@ namespace page_split {
     Task::~Task() = default;
 
     FilterResultPtr Task::process(const TaskStatus& status, const FilterData& data) {
+        const TraceSpan span("stage", "page_split::Task");
+
         status.throwIfCancelled();
 
         Settings::Record record(m_ptrSettings->getPageRecord(m_pageInfo.imageId()));
@@ -125,10 +128,8 @@ namespace page_split {
                 if (!params || ((record.layoutType() == nullptr) || (*record.layoutType() == AUTO_LAYOUT_TYPE))) {
                     new_layout = PageLayoutEstimator::estimatePageLayout(
                             record.combinedLayoutType(),
-                            data.isBlackOnWhite() ? data.grayImage() : data.grayImage().inverted(),
+                            data.analysisPyramid(),
                             data.xform(),
-                            data.isBlackOnWhite() ? data.bwThreshold()
-                                                  : BinaryThreshold(256 - int(data.bwThreshold())),
                             m_ptrDbg.get()
                     );
 
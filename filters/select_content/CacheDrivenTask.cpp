@@ -45,6 +45,11 @@ namespace select_content {
         const Dependencies deps(xform.resultingPreCropArea());
         if (!params || !params->dependencies().matches(deps)) {
             if (auto* thumb_col = dynamic_cast<ThumbnailCollector*>(collector)) {
+                if (!thumb_col->needThumbnail()) {
+                    thumb_col->processIncompleteness(true);
+
+                    return;
+                }
                 thumb_col->processThumbnail(
                         std::unique_ptr<QGraphicsItem>(
                                 new IncompleteThumbnail(
@@ -70,6 +75,11 @@ namespace select_content {
         }
 
         if (auto* thumb_col = dynamic_cast<ThumbnailCollector*>(collector)) {
+            if (!thumb_col->needThumbnail()) {
+                thumb_col->processIncompleteness(false);
+
+                return;
+            }
             thumb_col->processThumbnail(
                     std::unique_ptr<QGraphicsItem>(
                             new Thumbnail(
@@ -97,13 +97,14 @@ namespace select_content {
             return QRectF();
         }
 
-        const GrayImage dataGrayImage = data.isBlackOnWhite() ? data.grayImage() : data.grayImage().inverted();
-        const uint8_t darkest_gray_level = darkestGrayLevel(dataGrayImage);
+        // Start from the shared 150 DPI level rather than the full resolution image.
+        const AnalysisPyramid& pyramid = data.analysisPyramid();
+        const uint8_t darkest_gray_level = pyramid.darkestGrayLevel();
         const QColor outside_color(darkest_gray_level, darkest_gray_level, darkest_gray_level);
 
         QImage gray150(
                 transformToGray(
-                        dataGrayImage, xform_150dpi.transform(),
+                        pyramid.grayAtDpi(150), pyramid.origToDpi(150).inverted() * xform_150dpi.transform(),
                         xform_150dpi.resultingRect().toRect(),
                         OutsidePixels::assumeColor(outside_color)
                 )
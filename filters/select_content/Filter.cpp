@@ -137,6 +137,8 @@ namespace select_content {
 
         m_ptrSettings->setPageDetectionTolerance(filter_el.attribute("pageDetectionTolerance", "0.1").toDouble());
 
+        std::unordered_map<PageId, Params> params_by_page;
+
         const QString page_tag_name("page");
         QDomNode node(filter_el.firstChild());
         for (; !node.isNull(); node = node.nextSibling()) {
@@ -164,9 +166,10 @@ namespace select_content {
                 continue;
             }
 
-            const Params params(params_el);
-            m_ptrSettings->setPageParams(page_id, params);
+            params_by_page.insert_or_assign(page_id, Params(params_el));
         }
+
+        m_ptrSettings->setPageParams(params_by_page);
     }      // Filter::loadSettings
 
     intrusive_ptr<Task>
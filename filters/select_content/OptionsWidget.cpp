@@ -300,6 +300,7 @@ namespace select_content {
                 m_uiData.isPageDetectionEnabled(), m_uiData.isFineTuningCornersEnabled()
         );
 
+        std::unordered_map<PageId, Params> params_by_page;
         for (const PageId& page_id : pages) {
             if (m_pageId == page_id) {
                 continue;
@@ -330,9 +331,11 @@ namespace select_content {
                 }
             }
 
-            m_ptrSettings->setPageParams(page_id, new_params);
+            params_by_page.insert(std::make_pair(page_id, new_params));
         }
 
+        m_ptrSettings->setPageParams(params_by_page);
+
         if (pages.size() > 1) {
             emit invalidateAllThumbnails();
         } else {
@@ -25,30 +25,17 @@ namespace select_content {
             : m_ptrSettings(std::move(settings)) {
     }
 
-    bool OrderByHeightProvider::precedes(const PageId& lhs_page,
-                                         const bool lhs_incomplete,
-                                         const PageId& rhs_page,
-                                         const bool rhs_incomplete) const {
-        const std::unique_ptr<Params> lhs_params(m_ptrSettings->getPageParams(lhs_page));
-        const std::unique_ptr<Params> rhs_params(m_ptrSettings->getPageParams(rhs_page));
-
-        QSizeF lhs_size;
-        if (lhs_params) {
-            lhs_size = lhs_params->contentRect().size();
-        }
-        QSizeF rhs_size;
-        if (rhs_params) {
-            rhs_size = rhs_params->contentRect().size();
-        }
+    PageOrderProvider::SortKey OrderByHeightProvider::sortKey(const PageId& page, const bool incomplete) const {
+        const std::unique_ptr<Params> params(m_ptrSettings->getPageParams(page));
 
-        const bool lhs_valid = !lhs_incomplete && lhs_size.isValid();
-        const bool rhs_valid = !rhs_incomplete && rhs_size.isValid();
-
-        if (lhs_valid != rhs_valid) {
-            // Invalid (unknown) sizes go to the back.
-            return lhs_valid;
+        QSizeF size;
+        if (params) {
+            size = params->contentRect().size();
         }
 
-        return lhs_size.height() < rhs_size.height();
+        // Invalid (unknown) sizes go to the back.
+        const bool valid = !incomplete && size.isValid();
+
+        return SortKey(valid ? 0 : 1, size.height());
     }
 }  // namespace select_content
\ No newline at end of file
@@ -28,10 +28,7 @@ namespace select_content {
     public:
         explicit OrderByWidthProvider(intrusive_ptr<Settings> settings);
 
-        bool precedes(const PageId& lhs_page,
-                      bool lhs_incomplete,
-                      const PageId& rhs_page,
-                      bool rhs_incomplete) const override;
+        SortKey sortKey(const PageId& page, bool incomplete) const override;
 
     private:
         intrusive_ptr<Settings> m_ptrSettings;
@@ -17,7 +17,6 @@
  */
 
 #include "Settings.h"
-#include "Utils.h"
 #include "RelinkablePath.h"
 #include "AbstractRelinker.h"
 #include <iostream>
@@ -28,10 +27,9 @@ namespace select_content {
               m_pageDetectionTolerance(0.1) {
         m_deviationProvider.setComputeValueByKey(
                 [this](const PageId& pageId) -> double {
-                    auto it(m_pageParams.find(pageId));
-                    if (it != m_pageParams.end()) {
-                        const Params& params = it->second;
-                        const QSizeF& contentSize = params.contentRect().size();
+                    const std::shared_ptr<const Params> params(m_pageParams.find(pageId));
+                    if (params) {
+                        const QSizeF& contentSize = params->contentRect().size();
 
                         return std::sqrt(contentSize.width() * contentSize.height() / 4 / 600);
                     } else {
@@ -51,29 +49,44 @@ namespace select_content {
 
     void Settings::performRelinking(const AbstractRelinker& relinker) {
         QMutexLocker locker(&m_mutex);
-        PageParams new_params;
+        PageParams::Map new_params;
 
-        for (const PageParams::value_type& kv : m_pageParams) {
-            const RelinkablePath old_path(kv.first.imageId().filePath(), RelinkablePath::File);
-            PageId new_page_id(kv.first);
+        m_pageParams.forEach([&](const PageId& page_id, const Params& params) {
+            const RelinkablePath old_path(page_id.imageId().filePath(), RelinkablePath::File);
+            PageId new_page_id(page_id);
             new_page_id.imageId().setFilePath(relinker.substitutionPathFor(old_path));
-            new_params.insert(PageParams::value_type(new_page_id, kv.second));
-        }
+            new_params.insert(PageParams::Map::value_type(new_page_id, params));
+        });
 
-        m_pageParams.swap(new_params);
+        m_pageParams.assign(new_params);
 
         m_deviationProvider.clear();
-        for (const PageParams::value_type& kv : m_pageParams) {
+        for (const PageParams::Map::value_type& kv : new_params) {
             m_deviationProvider.addOrUpdate(kv.first);
         }
     }
 
     void Settings::setPageParams(const PageId& page_id, const Params& params) {
         QMutexLocker locker(&m_mutex);
-        Utils::mapSetValue(m_pageParams, page_id, params);
+        m_pageParams.set(page_id, params);
         m_deviationProvider.addOrUpdate(page_id);
     }
 
+    void Settings::setPageParams(const std::unordered_map<PageId, Params>& params) {
+        QMutexLocker locker(&m_mutex);
+        PageParams::Batch batch(m_pageParams);
+
+        for (const std::pair<const PageId, Params>& kv : params) {
+            batch.set(kv.first, kv.second);
+        }
+
+        batch.commit();
+
+        for (const std::pair<const PageId, Params>& kv : params) {
+            m_deviationProvider.addOrUpdate(kv.first);
+        }
+    }
+
     void Settings::clearPageParams(const PageId& page_id) {
         QMutexLocker locker(&m_mutex);
         m_pageParams.erase(page_id);
@@ -82,20 +95,16 @@ namespace select_content {
 
     std::unique_ptr<Params>
     Settings::getPageParams(const PageId& page_id) const {
-        QMutexLocker locker(&m_mutex);
-
-        const auto it(m_pageParams.find(page_id));
-        if (it != m_pageParams.end()) {
-            return std::make_unique<Params>(it->second);
+        const std::shared_ptr<const Params> params(m_pageParams.find(page_id));
+        if (params) {
+            return std::make_unique<Params>(*params);
         } else {
             return nullptr;
         }
     }
 
     bool Settings::isParamsNull(const PageId& page_id) const {
-        QMutexLocker locker(&m_mutex);
-
-        return (m_pageParams.find(page_id) == m_pageParams.end());
+        return !m_pageParams.contains(page_id);
     }
 
     QSizeF Settings::pageDetectionBox() const {
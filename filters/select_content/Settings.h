@@ -23,6 +23,7 @@
 #include "NonCopyable.h"
 #include "PageId.h"
 #include "Params.h"
+#include "SnapshotMap.h"
 #include <QMutex>
 #include <memory>
 #include <unordered_map>
@@ -45,6 +46,11 @@ namespace select_content {
 
         void setPageParams(const PageId& page_id, const Params& params);
 
+        /**
+         * \brief Sets the params of many pages at once.
+         */
+        void setPageParams(const std::unordered_map<PageId, Params>& params);
+
         void clearPageParams(const PageId& page_id);
 
         std::unique_ptr<Params> getPageParams(const PageId& page_id) const;
@@ -62,8 +68,11 @@ namespace select_content {
         const DeviationProvider<PageId>& deviationProvider() const;
 
     private:
-        typedef std::unordered_map<PageId, Params> PageParams;
+        typedef SnapshotMap<PageId, Params> PageParams;
 
+        /**
+         * Serializes writers.  Readers of m_pageParams don't need it.
+         */
         mutable QMutex m_mutex;
         PageParams m_pageParams;
         QSizeF m_pageDetectionBox;
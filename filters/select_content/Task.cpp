@@ -32,6 +32,7 @@
 #include <utility>
 #include <UnitsProvider.h>
 #include "Dpm.h"
+#include "Tracer.h"
 
 namespace select_content {
     class Task::UiUpdater : public FilterResult {
@@ -81,6 +82,8 @@ namespace select_content {
     Task::~Task() = default;
 
     FilterResultPtr Task::process(const TaskStatus& status, const FilterData& data) {
+        const TraceSpan span("stage", "select_content::Task");
+
         status.throwIfCancelled();
 
         const Dependencies deps(data.xform().resultingPreCropArea());
@@ -0,0 +1,206 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ParallelFor.h"
+#include "Tracer.h"
+#include <QAtomicInt>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QAtomicPointer>
+#include <QSettings>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QWaitCondition>
+#include <exception>
+#include <memory>
+#include <algorithm>
+
+namespace {
+    class ParallelForState {
+    public:
+        ParallelForState(int begin, int end, int grain, const std::function<void(int, int)>& body)
+                : m_body(body),
+                  m_begin(begin),
+                  m_end(end),
+                  m_grain(grain),
+                  m_numChunks((end - begin + grain - 1) / grain),
+                  m_page(Tracer::currentPage()),
+                  m_nextChunk(0),
+                  m_failed(0),
+                  m_doneChunks(0) {
+        }
+
+        int numChunks() const {
+            return m_numChunks;
+        }
+
+        /**
+         * The trace page label of the calling thread.
+         */
+        const QString& page() const {
+            return m_page;
+        }
+
+        /**
+         * Claims and processes the next chunk.
+         * Returns false if there were no chunks left.
+         */
+        bool processNextChunk() {
+            const int chunk = m_nextChunk.fetchAndAddOrdered(1);
+            if (chunk >= m_numChunks) {
+                return false;
+            }
+
+            if (m_failed.load() == 0) {
+                const int from = m_begin + chunk * m_grain;
+                const int to = std::min(from + m_grain, m_end);
+                try {
+                    m_body(from, to);
+                } catch (...) {
+                    QMutexLocker locker(&m_mutex);
+                    if (!m_exception) {
+                        m_exception = std::current_exception();
+                    }
+                    m_failed.store(1);
+                }
+            }
+
+            QMutexLocker locker(&m_mutex);
+            if (++m_doneChunks == m_numChunks) {
+                m_allDone.wakeAll();
+            }
+
+            return true;
+        }
+
+        void waitForDone() {
+            QMutexLocker locker(&m_mutex);
+            while (m_doneChunks < m_numChunks) {
+                m_allDone.wait(&m_mutex);
+            }
+
+            if (m_exception) {
+                std::rethrow_exception(m_exception);
+            }
+        }
+
+    private:
+        const std::function<void(int, int)> m_body;
+        const int m_begin;
+        const int m_end;
+        const int m_grain;
+        const int m_numChunks;
+        const QString m_page;
+        QAtomicInt m_nextChunk;
+        QAtomicInt m_failed;
+        QMutex m_mutex;
+        QWaitCondition m_allDone;
+        int m_doneChunks;
+        std::exception_ptr m_exception;
+    };
+
+
+    class ParallelForRunnable : public QRunnable {
+    public:
+        explicit ParallelForRunnable(std::shared_ptr<ParallelForState> state)
+                : m_ptrState(std::move(state)) {
+            setAutoDelete(true);
+        }
+
+        void run() override {
+            // Spans recorded by helpers belong to the caller's page.
+            const TracePageScope page_scope(m_ptrState->page());
+
+            while (m_ptrState->processNextChunk()) {
+            }
+        }
+
+    private:
+        // The state may outlive the parallelFor() call, in case this runnable
+        // got started after the calling thread had processed all the chunks.
+        std::shared_ptr<ParallelForState> m_ptrState;
+    };
+
+
+    QAtomicPointer<QThreadPool> customPool(nullptr);
+
+    QThreadPool* defaultPool() {
+        struct DefaultPool : QThreadPool {
+            DefaultPool() {
+                // The calling thread takes part in processing as well.
+                setMaxThreadCount(maxProcessingThreads() - 1);
+            }
+        };
+        static DefaultPool pool;
+
+        return &pool;
+    }
+
+    QThreadPool* currentPool() {
+        QThreadPool* pool = customPool.loadAcquire();
+
+        return pool ? pool : defaultPool();
+    }
+}  // namespace
+
+void parallelFor(const int begin, const int end, const int grain, const std::function<void(int, int)>& body) {
+    if (begin >= end) {
+        return;
+    }
+
+    const int chunk_size = std::max(grain, 1);
+    if (end - begin <= chunk_size) {
+        body(begin, end);
+        return;
+    }
+
+    auto state = std::make_shared<ParallelForState>(begin, end, chunk_size, body);
+
+    QThreadPool* pool = currentPool();
+    const int max_helpers = std::min(state->numChunks() - 1, pool->maxThreadCount());
+    for (int i = 0; i < max_helpers; ++i) {
+        auto* runnable = new ParallelForRunnable(state);
+        if (!pool->tryStart(runnable)) {
+            delete runnable;
+            break;
+        }
+    }
+
+    while (state->processNextChunk()) {
+    }
+
+    state->waitForDone();
+}
+
+void setParallelForThreadPool(QThreadPool* pool) {
+    customPool.storeRelease(pool);
+}
+
+int maxProcessingThreads() {
+    int max_threads = QThread::idealThreadCount();
+    if (sizeof(void*) <= 4) {
+        // Restricting num of processors for 32-bit due to
+        // address space constraints.
+        max_threads = std::min(max_threads, 2);
+    }
+
+    const int num_threads = QSettings().value("settings/batch_processing_threads", max_threads).toInt();
+
+    return std::max(1, std::min(num_threads, max_threads));
+}
@@ -0,0 +1,63 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCANTAILOR_PARALLELFOR_H
+#define SCANTAILOR_PARALLELFOR_H
+
+#include <functional>
+
+class QThreadPool;
+
+/**
+ * \brief Processes the [begin, end) range in chunks, spreading them
+ *        across idle threads of the pool set by setParallelForThreadPool().
+ *
+ * The calling thread always takes part in processing, so the call makes
+ * progress even when no pool threads are available.  That also makes nested
+ * calls safe.  The function returns once every chunk has been processed.
+ * If \p body throws, the remaining chunks are skipped and the first exception
+ * is rethrown on the calling thread.
+ *
+ * \param begin The first index of the range.
+ * \param end The index past the last one of the range.
+ * \param grain The minimum number of indices per chunk.
+ * \param body A functor called as body(chunk_begin, chunk_end) for each chunk.
+ *        It may be called concurrently from different threads.
+ */
+void parallelFor(int begin, int end, int grain, const std::function<void(int, int)>& body);
+
+/**
+ * \brief Makes parallelFor() take its helper threads from \p pool.
+ *
+ * Helpers only ever occupy idle threads, so passing the pool that runs the
+ * page processing tasks keeps the total number of busy threads within its
+ * limit.  Passing null restores the default pool, which is sized by
+ * maxProcessingThreads().  The pool must outlive its use by parallelFor().
+ */
+void setParallelForThreadPool(QThreadPool* pool);
+
+/**
+ * \brief Returns the number of threads processing is allowed to use.
+ *
+ * That's the "settings/batch_processing_threads" setting, limited by the
+ * number of CPU cores, and by 2 on 32-bit systems due to address space
+ * constraints.
+ */
+int maxProcessingThreads();
+
+#endif //SCANTAILOR_PARALLELFOR_H
@@ -20,8 +20,7 @@
 #include <QDebug>
 
 void PerformanceTimer::print(const char* prefix) {
-    const clock_t now = clock();
-    const double sec = double(now - m_start) / CLOCKS_PER_SEC;
+    const double sec = elapsed();
     if (sec > 10.0) {
         qDebug() << prefix << (long) sec << " sec";
     } else if (sec > 0.01) {
@@ -19,18 +19,28 @@
 #ifndef PERFORMANCETIMER_H_
 #define PERFORMANCETIMER_H_
 
-#include <ctime>
+#include <chrono>
 
+/**
+ * \brief Measures wall clock time elapsed since construction.
+ */
 class PerformanceTimer {
 public:
     PerformanceTimer()
-            : m_start(clock()) {
+            : m_start(std::chrono::steady_clock::now()) {
+    }
+
+    /**
+     * \brief Returns the number of seconds elapsed since construction.
+     */
+    double elapsed() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
     }
 
     void print(const char* prefix = "");
 
 private:
-    const clock_t m_start;
+    const std::chrono::steady_clock::time_point m_start;
 };
 
 
@@ -0,0 +1,313 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCANTAILOR_SNAPSHOTMAP_H
+#define SCANTAILOR_SNAPSHOTMAP_H
+
+#include "NonCopyable.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+/**
+ * \brief A hash map for many concurrent readers and few writers.
+ *
+ * Entries are spread over a fixed number of shards by key hash.  Every shard
+ * is an immutable std::unordered_map.  A reader takes the shard's mutex just
+ * long enough to copy the pointer to its current version, then looks up
+ * without holding any lock.  Readers of different shards don't contend,
+ * while readers of the same shard still share the mutex and the reference
+ * count of its current version.  Writers copy the shard they modify and
+ * publish the copy, so a write costs about size() / NUM_SHARDS value copies.
+ * That suits per-page settings, which are read many times for every write.
+ * Use a Batch to write many entries at once.
+ *
+ * A value returned by find() is never modified and stays valid for as long
+ * as the caller holds on to it, even if the entry is replaced or erased.
+ *
+ * Writers are not synchronized with each other.  The owner is expected to
+ * serialize them, normally with the mutex that guards the rest of its state.
+ */
+template<typename K, typename V, typename Hash = std::hash<K>>
+class SnapshotMap {
+DECLARE_NON_COPYABLE(SnapshotMap)
+
+public:
+    typedef std::unordered_map<K, V, Hash> Map;
+
+    class Batch;
+
+    SnapshotMap();
+
+    /**
+     * \brief Returns the value for a key, or null if there is no such key.
+     */
+    std::shared_ptr<const V> find(const K& key) const;
+
+    bool contains(const K& key) const;
+
+    /**
+     * \brief Calls visitor(key, value) for every entry.
+     *
+     * Shards are visited one after another, so writes that happen in the
+     * meantime may or may not be seen.
+     */
+    template<typename Visitor>
+    void forEach(Visitor visitor) const;
+
+    /**
+     * \brief Inserts or replaces an entry.
+     */
+    void set(const K& key, const V& value);
+
+    void erase(const K& key);
+
+    void clear();
+
+    /**
+     * \brief Replaces all entries with the ones from \p map.
+     */
+    void assign(const Map& map);
+
+private:
+    enum { NUM_SHARDS_LOG2 = 5, NUM_SHARDS = 1 << NUM_SHARDS_LOG2 };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::shared_ptr<const Map> map;
+    };
+
+    static size_t shardIndex(const K& key);
+
+    std::shared_ptr<const Map> loadShard(size_t idx) const;
+
+    void storeShard(size_t idx, std::shared_ptr<const Map> shard);
+
+    Shard m_shards[NUM_SHARDS];
+};
+
+
+/**
+ * \brief Collects writes to a SnapshotMap and publishes them together.
+ *
+ * Every shard touched is copied once, however many of its entries change,
+ * so writing all n entries costs n value copies rather than n * n / NUM_SHARDS.
+ * Nothing is visible to readers before commit(), which publishes the changed
+ * shards one after another.  A batch that is never committed changes nothing.
+ *
+ * Like any other write, a batch has to be serialized with the other writers.
+ */
+template<typename K, typename V, typename Hash>
+class SnapshotMap<K, V, Hash>::Batch {
+DECLARE_NON_COPYABLE(Batch)
+
+public:
+    explicit Batch(SnapshotMap& map);
+
+    /**
+     * \brief Like SnapshotMap::find(), but sees the writes made through this batch.
+     *
+     * Unlike with SnapshotMap::find(), the value is only guaranteed to stay
+     * as it is until the next write through this batch.
+     */
+    std::shared_ptr<const V> find(const K& key) const;
+
+    void set(const K& key, const V& value);
+
+    void erase(const K& key);
+
+    void commit();
+
+private:
+    Map& shardFor(const K& key);
+
+    SnapshotMap& m_rMap;
+    std::shared_ptr<Map> m_shards[NUM_SHARDS];
+};
+
+
+template<typename K, typename V, typename Hash>
+SnapshotMap<K, V, Hash>::SnapshotMap() {
+    const std::shared_ptr<const Map> empty(std::make_shared<Map>());
+    for (Shard& shard : m_shards) {
+        shard.map = empty;
+    }
+}
+
+template<typename K, typename V, typename Hash>
+std::shared_ptr<const V> SnapshotMap<K, V, Hash>::find(const K& key) const {
+    std::shared_ptr<const Map> shard(loadShard(shardIndex(key)));
+
+    const auto it(shard->find(key));
+    if (it == shard->end()) {
+        return nullptr;
+    }
+
+    // Shares ownership of the whole shard, which keeps the value alive.
+    return std::shared_ptr<const V>(std::move(shard), &it->second);
+}
+
+template<typename K, typename V, typename Hash>
+bool SnapshotMap<K, V, Hash>::contains(const K& key) const {
+    const std::shared_ptr<const Map> shard(loadShard(shardIndex(key)));
+
+    return shard->find(key) != shard->end();
+}
+
+template<typename K, typename V, typename Hash>
+template<typename Visitor>
+void SnapshotMap<K, V, Hash>::forEach(Visitor visitor) const {
+    for (size_t i = 0; i < NUM_SHARDS; ++i) {
+        const std::shared_ptr<const Map> shard(loadShard(i));
+        for (const typename Map::value_type& kv : *shard) {
+            visitor(kv.first, kv.second);
+        }
+    }
+}
+
+template<typename K, typename V, typename Hash>
+void SnapshotMap<K, V, Hash>::set(const K& key, const V& value) {
+    const size_t idx = shardIndex(key);
+    auto shard(std::make_shared<Map>(*loadShard(idx)));
+    shard->insert_or_assign(key, value);
+    storeShard(idx, std::move(shard));
+}
+
+template<typename K, typename V, typename Hash>
+void SnapshotMap<K, V, Hash>::erase(const K& key) {
+    const size_t idx = shardIndex(key);
+    const std::shared_ptr<const Map> old_shard(loadShard(idx));
+    if (old_shard->find(key) == old_shard->end()) {
+        return;
+    }
+
+    auto shard(std::make_shared<Map>(*old_shard));
+    shard->erase(key);
+    storeShard(idx, std::move(shard));
+}
+
+template<typename K, typename V, typename Hash>
+void SnapshotMap<K, V, Hash>::clear() {
+    const std::shared_ptr<const Map> empty(std::make_shared<Map>());
+    for (size_t i = 0; i < NUM_SHARDS; ++i) {
+        storeShard(i, empty);
+    }
+}
+
+template<typename K, typename V, typename Hash>
+void SnapshotMap<K, V, Hash>::assign(const Map& map) {
+    std::shared_ptr<Map> shards[NUM_SHARDS];
+    for (std::shared_ptr<Map>& shard : shards) {
+        shard = std::make_shared<Map>();
+    }
+    for (const typename Map::value_type& kv : map) {
+        shards[shardIndex(kv.first)]->insert(kv);
+    }
+    for (size_t i = 0; i < NUM_SHARDS; ++i) {
+        storeShard(i, std::move(shards[i]));
+    }
+}
+
+template<typename K, typename V, typename Hash>
+size_t SnapshotMap<K, V, Hash>::shardIndex(const K& key) {
+    // Fibonacci hashing, so that shards don't correlate with the buckets
+    // of the unordered_map within a shard.
+    const uint64_t h = static_cast<uint64_t>(Hash()(key)) * UINT64_C(0x9E3779B97F4A7C15);
+
+    return static_cast<size_t>(h >> (64 - NUM_SHARDS_LOG2));
+}
+
+template<typename K, typename V, typename Hash>
+std::shared_ptr<const typename SnapshotMap<K, V, Hash>::Map> SnapshotMap<K, V, Hash>::loadShard(const size_t idx) const {
+    const std::lock_guard<std::mutex> guard(m_shards[idx].mutex);
+
+    return m_shards[idx].map;
+}
+
+template<typename K, typename V, typename Hash>
+void SnapshotMap<K, V, Hash>::storeShard(const size_t idx, std::shared_ptr<const Map> shard) {
+    std::shared_ptr<const Map> old_shard(std::move(shard));
+    {
+        const std::lock_guard<std::mutex> guard(m_shards[idx].mutex);
+        m_shards[idx].map.swap(old_shard);
+    }
+    // The old version, if this was its last reference, is destroyed
+    // outside of the lock.
+}
+
+template<typename K, typename V, typename Hash>
+SnapshotMap<K, V, Hash>::Batch::Batch(SnapshotMap& map)
+        : m_rMap(map) {
+}
+
+template<typename K, typename V, typename Hash>
+std::shared_ptr<const V> SnapshotMap<K, V, Hash>::Batch::find(const K& key) const {
+    const std::shared_ptr<Map>& shard = m_shards[shardIndex(key)];
+    if (!shard) {
+        return m_rMap.find(key);
+    }
+
+    const auto it(shard->find(key));
+    if (it == shard->end()) {
+        return nullptr;
+    }
+
+    return std::shared_ptr<const V>(shard, &it->second);
+}
+
+template<typename K, typename V, typename Hash>
+void SnapshotMap<K, V, Hash>::Batch::set(const K& key, const V& value) {
+    shardFor(key).insert_or_assign(key, value);
+}
+
+template<typename K, typename V, typename Hash>
+void SnapshotMap<K, V, Hash>::Batch::erase(const K& key) {
+    const size_t idx = shardIndex(key);
+    if (!m_shards[idx]) {
+        const std::shared_ptr<const Map> shard(m_rMap.loadShard(idx));
+        if (shard->find(key) == shard->end()) {
+            return;
+        }
+    }
+    shardFor(key).erase(key);
+}
+
+template<typename K, typename V, typename Hash>
+void SnapshotMap<K, V, Hash>::Batch::commit() {
+    for (size_t i = 0; i < NUM_SHARDS; ++i) {
+        if (m_shards[i]) {
+            m_rMap.storeShard(i, std::move(m_shards[i]));
+            m_shards[i] = nullptr;
+        }
+    }
+}
+
+template<typename K, typename V, typename Hash>
+typename SnapshotMap<K, V, Hash>::Map& SnapshotMap<K, V, Hash>::Batch::shardFor(const K& key) {
+    const size_t idx = shardIndex(key);
+    if (!m_shards[idx]) {
+        m_shards[idx] = std::make_shared<Map>(*m_rMap.loadShard(idx));
+    }
+
+    return *m_shards[idx];
+}
+
+#endif //SCANTAILOR_SNAPSHOTMAP_H
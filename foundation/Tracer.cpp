@@ -0,0 +1,212 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Tracer.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <chrono>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+namespace {
+    struct TraceEvent {
+        const char* category;
+        const char* name;
+        QString page;
+        int64_t start;
+        int64_t duration;
+        int thread;
+    };
+
+    /**
+     * Guards against unbounded memory growth when tracing is left on.
+     */
+    const size_t MAX_EVENTS = 1 << 20;
+
+    QMutex eventsMutex;
+    std::vector<TraceEvent> events;
+
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+    QAtomicInt nextThreadId(1);
+
+    thread_local QString currentPageLabel;
+
+    int currentThreadId() {
+        thread_local const int id = nextThreadId.fetchAndAddRelaxed(1);
+
+        return id;
+    }
+
+    std::vector<TraceEvent> takeSnapshot() {
+        const QMutexLocker locker(&eventsMutex);
+
+        return events;
+    }
+}  // namespace
+
+QAtomicInt Tracer::m_enabled(0);
+
+void Tracer::setEnabled(const bool enabled) {
+    m_enabled.store(enabled ? 1 : 0);
+}
+
+void Tracer::clear() {
+    const QMutexLocker locker(&eventsMutex);
+    events.clear();
+}
+
+int64_t Tracer::now() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Tracer::record(const char* category, const char* name, const int64_t start_us, const int64_t end_us) {
+    TraceEvent event{category, name, currentPageLabel, start_us, end_us - start_us, currentThreadId()};
+
+    const QMutexLocker locker(&eventsMutex);
+    if (events.size() < MAX_EVENTS) {
+        events.push_back(std::move(event));
+    }
+}
+
+QString Tracer::currentPage() {
+    return currentPageLabel;
+}
+
+void Tracer::setCurrentPage(const QString& page) {
+    currentPageLabel = page;
+}
+
+QByteArray Tracer::toChromeTraceJson() {
+    const std::vector<TraceEvent> snapshot(takeSnapshot());
+
+    QJsonArray trace_events;
+    for (const TraceEvent& event : snapshot) {
+        QJsonObject obj;
+        obj["name"] = QString::fromLatin1(event.name);
+        obj["cat"] = QString::fromLatin1(event.category);
+        obj["ph"] = "X";
+        obj["ts"] = double(event.start);
+        obj["dur"] = double(event.duration);
+        obj["pid"] = 1;
+        obj["tid"] = event.thread;
+        if (!event.page.isEmpty()) {
+            QJsonObject args;
+            args["page"] = event.page;
+            obj["args"] = args;
+        }
+        trace_events.append(obj);
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = trace_events;
+    root["displayTimeUnit"] = "ms";
+
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+bool Tracer::writeChromeTrace(const QString& file_path) {
+    QFile file(file_path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    const QByteArray json(toChromeTraceJson());
+
+    return file.write(json) == json.size();
+}
+
+QString Tracer::summary() {
+    std::vector<TraceEvent> snapshot(takeSnapshot());
+
+    // Sorting by thread and start time (longer spans first on ties) lets us
+    // find the parent of each span with a per-thread stack.
+    std::sort(snapshot.begin(), snapshot.end(), [](const TraceEvent& lhs, const TraceEvent& rhs) {
+        if (lhs.thread != rhs.thread) {
+            return lhs.thread < rhs.thread;
+        }
+        if (lhs.start != rhs.start) {
+            return lhs.start < rhs.start;
+        }
+
+        return lhs.duration > rhs.duration;
+    });
+
+    struct Stats {
+        int count = 0;
+        int64_t total = 0;
+        int64_t self = 0;
+        int64_t max = 0;
+    };
+
+    std::map<std::pair<QString, QString>, Stats> stats;
+    std::vector<size_t> stack;
+    std::vector<int64_t> self_times(snapshot.size());
+
+    for (size_t i = 0; i < snapshot.size(); ++i) {
+        const TraceEvent& event = snapshot[i];
+        self_times[i] = event.duration;
+
+        while (!stack.empty()) {
+            const TraceEvent& top = snapshot[stack.back()];
+            if ((top.thread == event.thread) && (event.start < top.start + top.duration)) {
+                break;
+            }
+            stack.pop_back();
+        }
+
+        // Subtract from the nearest enclosing span of the same category.
+        for (auto it = stack.rbegin(); it != stack.rend(); ++it) {
+            if (qstrcmp(snapshot[*it].category, event.category) == 0) {
+                self_times[*it] -= event.duration;
+                break;
+            }
+        }
+
+        stack.push_back(i);
+    }
+
+    for (size_t i = 0; i < snapshot.size(); ++i) {
+        const TraceEvent& event = snapshot[i];
+        Stats& s = stats[std::make_pair(QString::fromLatin1(event.category), QString::fromLatin1(event.name))];
+        ++s.count;
+        s.total += event.duration;
+        s.self += self_times[i];
+        s.max = std::max(s.max, event.duration);
+    }
+
+    QString result(
+            QString("%1%2%3%4%5%6%7\n")
+                    .arg("category", -12).arg("name", -44).arg("count", 8)
+                    .arg("total ms", 12).arg("self ms", 12).arg("mean ms", 12).arg("max ms", 12)
+    );
+    for (const auto& entry : stats) {
+        const Stats& s = entry.second;
+        result += QString("%1%2%3%4%5%6%7\n")
+                .arg(entry.first.first, -12).arg(entry.first.second, -44).arg(s.count, 8)
+                .arg(s.total / 1000.0, 12, 'f', 2).arg(s.self / 1000.0, 12, 'f', 2)
+                .arg(s.total / 1000.0 / s.count, 12, 'f', 2).arg(s.max / 1000.0, 12, 'f', 2);
+    }
+
+    return result;
+}
@@ -0,0 +1,149 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCANTAILOR_TRACER_H
+#define SCANTAILOR_TRACER_H
+
+#include "NonCopyable.h"
+#include <QString>
+#include <QAtomicInt>
+#include <cstdint>
+
+/**
+ * \brief Collects timed spans for performance analysis.
+ *
+ * Tracing is compiled in but disabled by default.  While disabled, a TraceSpan
+ * costs a single relaxed atomic load.  While enabled, every finished span is
+ * recorded together with the id of the thread that executed it and the label
+ * of the page being processed by that thread (see TracePageScope).
+ *
+ * The recorded spans can be exported in the Chrome trace event format
+ * (viewable in chrome://tracing or Perfetto) or aggregated into a textual
+ * per-span summary.
+ */
+class Tracer {
+public:
+    static bool isEnabled() {
+        return m_enabled.load() != 0;
+    }
+
+    static void setEnabled(bool enabled);
+
+    /**
+     * \brief Discards all the recorded spans.
+     */
+    static void clear();
+
+    /**
+     * \brief Returns the number of microseconds since the tracing epoch.
+     */
+    static int64_t now();
+
+    /**
+     * \brief Records a finished span.
+     *
+     * \p category and \p name must be string literals or otherwise outlive the tracer.
+     */
+    static void record(const char* category, const char* name, int64_t start_us, int64_t end_us);
+
+    /**
+     * \brief Returns the recorded spans in the Chrome trace event JSON format.
+     */
+    static QByteArray toChromeTraceJson();
+
+    /**
+     * \brief Returns a table of per-span statistics aggregated by category and name.
+     *
+     * Self time excludes the time spent in spans of the same category nested
+     * on the same thread.
+     */
+    static QString summary();
+
+    /**
+     * \brief Writes the Chrome trace JSON to \p file_path.
+     *
+     * \return true on success.
+     */
+    static bool writeChromeTrace(const QString& file_path);
+
+    /**
+     * \brief Returns the page label of the current thread, as set by TracePageScope.
+     */
+    static QString currentPage();
+
+    static void setCurrentPage(const QString& page);
+
+private:
+    static QAtomicInt m_enabled;
+};
+
+
+/**
+ * \brief Records the time between its construction and destruction.
+ *
+ * \code
+ * TraceSpan span("imageproc", "binarizeWolf");
+ * \endcode
+ */
+class TraceSpan {
+DECLARE_NON_COPYABLE(TraceSpan)
+
+public:
+    TraceSpan(const char* category, const char* name)
+            : m_category(category),
+              m_name(name),
+              m_start(Tracer::isEnabled() ? Tracer::now() : -1) {
+    }
+
+    ~TraceSpan() {
+        if (m_start >= 0) {
+            Tracer::record(m_category, m_name, m_start, Tracer::now());
+        }
+    }
+
+private:
+    const char* m_category;
+    const char* m_name;
+    const int64_t m_start;
+};
+
+
+/**
+ * \brief Labels the spans recorded by the current thread with a page.
+ *
+ * The previous label is restored on destruction.
+ */
+class TracePageScope {
+DECLARE_NON_COPYABLE(TracePageScope)
+
+public:
+    explicit TracePageScope(const QString& page)
+            : m_prevPage(Tracer::currentPage()) {
+        Tracer::setCurrentPage(page);
+    }
+
+    ~TracePageScope() {
+        Tracer::setCurrentPage(m_prevPage);
+    }
+
+private:
+    const QString m_prevPage;
+};
+
+
+#endif //SCANTAILOR_TRACER_H
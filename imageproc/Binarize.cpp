@@ -20,16 +20,21 @@
 #include "BinaryImage.h"
 #include "Grayscale.h"
 #include "IntegralImage.h"
+#include "Tracer.h"
 #include <QDebug>
 #include <cassert>
 #include <cmath>
 
 namespace imageproc {
     BinaryImage binarizeOtsu(const QImage& src) {
+        const TraceSpan span("imageproc", "binarizeOtsu");
+
         return BinaryImage(src, BinaryThreshold::otsuThreshold(src));
     }
 
     BinaryImage binarizeMokji(const QImage& src, const unsigned max_edge_width, const unsigned min_edge_magnitude) {
+        const TraceSpan span("imageproc", "binarizeMokji");
+
         const BinaryThreshold threshold(
                 BinaryThreshold::mokjiThreshold(
                         src, max_edge_width, min_edge_magnitude
@@ -40,6 +45,8 @@ namespace imageproc {
     }
 
     BinaryImage binarizeSauvola(const QImage& src, const QSize window_size, const double k) {
+        const TraceSpan span("imageproc", "binarizeSauvola");
+
         if (window_size.isEmpty()) {
             throw std::invalid_argument("binarizeSauvola: invalid window_size");
         }
@@ -122,6 +129,8 @@ namespace imageproc {
                              const unsigned char lower_bound,
                              const unsigned char upper_bound,
                              const double k) {
+        const TraceSpan span("imageproc", "binarizeWolf");
+
         if (window_size.isEmpty()) {
             throw std::invalid_argument("binarizeWolf: invalid window_size");
         }
@@ -20,6 +20,7 @@
 #include "BinaryImage.h"
 #include "InfluenceMap.h"
 #include "BitOps.h"
+#include "Tracer.h"
 #include <QImage>
 #include <QDebug>
 
@@ -56,6 +57,8 @@ namespace imageproc {
               m_size(image.size()),
               m_stride(0),
               m_maxLabel(0) {
+        const TraceSpan span("imageproc", "ConnectivityMap");
+
         if (m_size.isEmpty()) {
             return;
         }
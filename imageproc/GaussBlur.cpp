@@ -22,8 +22,10 @@
 #include "GaussBlur.h"
 #include "GrayImage.h"
 #include "Constants.h"
+#include "Tracer.h"
 #include <boost/lambda/lambda.hpp>
 #include <boost/lambda/bind.hpp>
+#include <algorithm>
 #include <cmath>
 
 namespace imageproc {
@@ -89,9 +91,20 @@ namespace imageproc {
                 bd_m[i] = d_m[i] * b;
             }
         }          // find_iir_constants
+
+        int columnBlocksPerChunk(const int height) {
+            // Aim for at least 64K grid cells per chunk.
+            return std::max(1, (1 << 16) / (COLUMN_BLOCK_SIZE * std::max(height, 1)));
+        }
+
+        int rowsPerChunk(const int width) {
+            return std::max(1, (1 << 16) / std::max(width, 1));
+        }
     }      // namespace gauss_blur_impl
 
     GrayImage gaussBlur(const GrayImage& src, float h_sigma, float v_sigma) {
+        const TraceSpan span("imageproc", "gaussBlur");
+
         using namespace boost::lambda;
 
         if (src.isNull()) {
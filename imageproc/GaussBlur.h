@@ -23,8 +23,10 @@
 #define IMAGEPROC_GAUSSBLUR_H_
 
 #include "ValueConv.h"
+#include "ParallelFor.h"
 #include <QSize>
 #include <boost/scoped_array.hpp>
+#include <algorithm>
 #include <iterator>
 #include <cstring>
 
@@ -82,6 +84,8 @@ namespace imageproc {
  * // Convert to uint8_t, with rounding and clipping.
  * gaussBlurGeneric(..., _1 = bind<uint8_t>(RoundAndClipValueConv<uint8_t>(), _2);
  * \endcode
+ * The work is spread across threads with parallelFor(), so both functors
+ * may be called concurrently.
  */
     template<typename SrcIt, typename DstIt, typename FloatReader, typename FloatWriter>
     void gaussBlurGeneric(QSize size,
@@ -114,6 +118,21 @@ namespace imageproc {
                 dst = src;
             }
         };
+
+        /**
+         * The number of adjacent columns the vertical pass processes together.
+         */
+        static const int COLUMN_BLOCK_SIZE = 16;
+
+        /**
+         * The number of column blocks per parallelFor() chunk for a grid of the given height.
+         */
+        int columnBlocksPerChunk(int height);
+
+        /**
+         * The number of rows per parallelFor() chunk for a grid of the given width.
+         */
+        int rowsPerChunk(int width);
     }  // namespace gauss_blur_impl
 
     template<typename SrcIt, typename DstIt, typename FloatReader, typename FloatWriter>
@@ -126,94 +145,126 @@ namespace imageproc {
                           const DstIt output,
                           const int output_stride,
                           const FloatWriter float_writer) {
+        using namespace gauss_blur_impl;
+
         if (size.isEmpty()) {
             return;
         }
 
         const int width = size.width();
         const int height = size.height();
-        const int width_height_max = width > height ? width : height;
 
-        boost::scoped_array<float> val_p(new float[width_height_max]);
-        boost::scoped_array<float> val_m(new float[width_height_max]);
         boost::scoped_array<float> intermediate_image(new float[width * height]);
         const int intermediate_stride = width;
 
         // IIR parameters.
         float n_p[5], n_m[5], d_p[5], d_m[5], bd_p[5], bd_m[5];
         // Vertical pass.
-        gauss_blur_impl::find_iir_constants(n_p, n_m, d_p, d_m, bd_p, bd_m, v_sigma);
-        for (int x = 0; x < width; ++x) {
-            memset(&val_p[0], 0, height * sizeof(val_p[0]));
-            memset(&val_m[0], 0, height * sizeof(val_m[0]));
-
-            SrcIt sp_p(input + x);
-            SrcIt sp_m(sp_p + (height - 1) * input_stride);
-            float* vp = &val_p[0];
-            float* vm = &val_m[0] + height - 1;
-            const float initial_p = float_reader(sp_p[0]);
-            const float initial_m = float_reader(sp_m[0]);
-
-            for (int y = 0; y < height; ++y) {
-                const int terms = y < 4 ? y : 4;
-                int i = 0;
-                int sp_off = 0;
-                for (; i <= terms; ++i, sp_off += input_stride) {
-                    *vp += n_p[i] * float_reader(sp_p[-sp_off]) - d_p[i] * vp[-i];
-                    *vm += n_m[i] * float_reader(sp_m[sp_off]) - d_m[i] * vm[i];
-                }
-                for (; i <= 4; ++i) {
-                    *vp += (n_p[i] - bd_p[i]) * initial_p;
-                    *vm += (n_m[i] - bd_m[i]) * initial_m;
+        // Adjacent columns are processed together, so that memory is accessed
+        // row by row and the innermost loops (over columns of a block)
+        // are simple enough for the compiler to vectorize them.
+        find_iir_constants(n_p, n_m, d_p, d_m, bd_p, bd_m, v_sigma);
+        const int num_column_blocks = (width + COLUMN_BLOCK_SIZE - 1) / COLUMN_BLOCK_SIZE;
+        parallelFor(0, num_column_blocks, columnBlocksPerChunk(height), [&](const int first_block,
+                                                                            const int last_block) {
+            boost::scoped_array<float> val_p(new float[height * COLUMN_BLOCK_SIZE]);
+            boost::scoped_array<float> val_m(new float[height * COLUMN_BLOCK_SIZE]);
+            float initial_p[COLUMN_BLOCK_SIZE];
+            float initial_m[COLUMN_BLOCK_SIZE];
+
+            for (int block = first_block; block < last_block; ++block) {
+                const int x0 = block * COLUMN_BLOCK_SIZE;
+                const int block_width = std::min(COLUMN_BLOCK_SIZE, width - x0);
+
+                memset(&val_p[0], 0, height * COLUMN_BLOCK_SIZE * sizeof(val_p[0]));
+                memset(&val_m[0], 0, height * COLUMN_BLOCK_SIZE * sizeof(val_m[0]));
+
+                const SrcIt first_line(input + x0);
+                const SrcIt last_line(first_line + (height - 1) * input_stride);
+                for (int j = 0; j < block_width; ++j) {
+                    initial_p[j] = float_reader(first_line[j]);
+                    initial_m[j] = float_reader(last_line[j]);
                 }
-                sp_p += input_stride;
-                sp_m -= input_stride;
-                ++vp;
-                --vm;
-            }
 
-            gauss_blur_impl::save(
-                    height, &val_p[0], &val_m[0], &intermediate_image[0] + x,
-                    intermediate_stride, gauss_blur_impl::FloatToFloatWriter()
-            );
-        }
-        // Horizontal pass.
-        gauss_blur_impl::find_iir_constants(n_p, n_m, d_p, d_m, bd_p, bd_m, h_sigma);
-        const float* intermediate_line = &intermediate_image[0];
-        DstIt output_line(output);
-        for (int y = 0; y < height; ++y) {
-            memset(&val_p[0], 0, width * sizeof(val_p[0]));
-            memset(&val_m[0], 0, width * sizeof(val_m[0]));
-
-            const float* sp_p = intermediate_line;
-            const float* sp_m = intermediate_line + width - 1;
-            float* vp = &val_p[0];
-            float* vm = &val_m[0] + width - 1;
-            const float initial_p = sp_p[0];
-            const float initial_m = sp_m[0];
-
-            for (int x = 0; x < width; ++x) {
-                const int terms = x < 4 ? x : 4;
-                int i = 0;
-                for (; i <= terms; ++i) {
-                    *vp += n_p[i] * sp_p[-i] - d_p[i] * vp[-i];
-                    *vm += n_m[i] * sp_m[i] - d_m[i] * vm[i];
+                for (int y = 0; y < height; ++y) {
+                    const SrcIt sp_p(first_line + y * input_stride);
+                    const SrcIt sp_m(last_line - y * input_stride);
+                    float* const vp = &val_p[0] + y * COLUMN_BLOCK_SIZE;
+                    float* const vm = &val_m[0] + (height - 1 - y) * COLUMN_BLOCK_SIZE;
+
+                    const int terms = y < 4 ? y : 4;
+                    int i = 0;
+                    for (; i <= terms; ++i) {
+                        const SrcIt sp_p_i(sp_p - i * input_stride);
+                        const SrcIt sp_m_i(sp_m + i * input_stride);
+                        const float* const vp_i = vp - i * COLUMN_BLOCK_SIZE;
+                        const float* const vm_i = vm + i * COLUMN_BLOCK_SIZE;
+                        for (int j = 0; j < block_width; ++j) {
+                            vp[j] += n_p[i] * float_reader(sp_p_i[j]) - d_p[i] * vp_i[j];
+                            vm[j] += n_m[i] * float_reader(sp_m_i[j]) - d_m[i] * vm_i[j];
+                        }
+                    }
+                    for (; i <= 4; ++i) {
+                        for (int j = 0; j < block_width; ++j) {
+                            vp[j] += (n_p[i] - bd_p[i]) * initial_p[j];
+                            vm[j] += (n_m[i] - bd_m[i]) * initial_m[j];
+                        }
+                    }
                 }
-                for (; i <= 4; ++i) {
-                    *vp += (n_p[i] - bd_p[i]) * initial_p;
-                    *vm += (n_m[i] - bd_m[i]) * initial_m;
+
+                const float* vp = &val_p[0];
+                const float* vm = &val_m[0];
+                float* intermediate_line = &intermediate_image[0] + x0;
+                for (int y = 0; y < height; ++y) {
+                    save(block_width, vp, vm, intermediate_line, 1, FloatToFloatWriter());
+                    vp += COLUMN_BLOCK_SIZE;
+                    vm += COLUMN_BLOCK_SIZE;
+                    intermediate_line += intermediate_stride;
                 }
-                ++sp_p;
-                --sp_m;
-                ++vp;
-                --vm;
             }
+        });
+        // Horizontal pass.
+        find_iir_constants(n_p, n_m, d_p, d_m, bd_p, bd_m, h_sigma);
+        parallelFor(0, height, rowsPerChunk(width), [&](const int first_line, const int last_line) {
+            boost::scoped_array<float> val_p(new float[width]);
+            boost::scoped_array<float> val_m(new float[width]);
 
-            gauss_blur_impl::save(width, &val_p[0], &val_m[0], output_line, 1, float_writer);
+            const float* intermediate_line = &intermediate_image[0] + first_line * intermediate_stride;
+            DstIt output_line(output + first_line * output_stride);
+            for (int y = first_line; y < last_line; ++y) {
+                memset(&val_p[0], 0, width * sizeof(val_p[0]));
+                memset(&val_m[0], 0, width * sizeof(val_m[0]));
 
-            intermediate_line += intermediate_stride;
-            output_line += output_stride;
-        }
+                const float* sp_p = intermediate_line;
+                const float* sp_m = intermediate_line + width - 1;
+                float* vp = &val_p[0];
+                float* vm = &val_m[0] + width - 1;
+                const float initial_p = sp_p[0];
+                const float initial_m = sp_m[0];
+
+                for (int x = 0; x < width; ++x) {
+                    const int terms = x < 4 ? x : 4;
+                    int i = 0;
+                    for (; i <= terms; ++i) {
+                        *vp += n_p[i] * sp_p[-i] - d_p[i] * vp[-i];
+                        *vm += n_m[i] * sp_m[i] - d_m[i] * vm[i];
+                    }
+                    for (; i <= 4; ++i) {
+                        *vp += (n_p[i] - bd_p[i]) * initial_p;
+                        *vm += (n_m[i] - bd_m[i]) * initial_m;
+                    }
+                    ++sp_p;
+                    --sp_m;
+                    ++vp;
+                    --vm;
+                }
+
+                save(width, &val_p[0], &val_m[0], output_line, 1, float_writer);
+
+                intermediate_line += intermediate_stride;
+                output_line += output_stride;
+            }
+        });
     }  // gaussBlurGeneric
 }  // namespace imageproc
 #endif // ifndef IMAGEPROC_GAUSSBLUR_H_
@@ -0,0 +1,346 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HitMissReplaceCascade.h"
+#include "BinaryImage.h"
+#include "ParallelFor.h"
+#include "Tracer.h"
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+namespace imageproc {
+    namespace {
+        /**
+         * The number of output rows per band.  Every band is extended by the
+         * rows its rules reach into, which are processed redundantly.
+         */
+        const int BAND_HEIGHT = 512;
+
+        const int MAX_PATTERN_SIZE = 32;
+
+        /**
+         * Returns a word whose pixel x is the pixel (x + dx) of \p row.
+         * The words at row[-1] and row[wpl] must exist.  |dx| must be below 32.
+         */
+        inline uint32_t shiftedWord(const uint32_t* row, const int i, const int dx) {
+            if (dx == 0) {
+                return row[i];
+            } else if (dx > 0) {
+                return (row[i] << dx) | (row[i + 1] >> (32 - dx));
+            } else {
+                return (row[i] >> -dx) | (row[i - 1] << (32 + dx));
+            }
+        }
+
+        /**
+         * Rows of a band buffer, each one padded by a zero word on either side.
+         */
+        class RowBuffer {
+        public:
+            RowBuffer(const int first_row, const int num_rows, const int wpl)
+                    : m_firstRow(first_row),
+                      m_stride(wpl + 2),
+                      m_data(static_cast<size_t>(num_rows) * m_stride, 0) {
+            }
+
+            uint32_t* row(const int y) {
+                return &m_data[(y - m_firstRow) * m_stride + 1];
+            }
+
+            const uint32_t* row(const int y) const {
+                return &m_data[(y - m_firstRow) * m_stride + 1];
+            }
+
+            void swap(RowBuffer& other) {
+                std::swap(m_firstRow, other.m_firstRow);
+                std::swap(m_stride, other.m_stride);
+                m_data.swap(other.m_data);
+            }
+
+        private:
+            int m_firstRow;
+            int m_stride;
+            std::vector<uint32_t> m_data;
+        };
+    }  // namespace
+
+    void HitMissReplaceCascade::addRule(const char* const pattern, const int pattern_width, const int pattern_height) {
+        if ((pattern_width > MAX_PATTERN_SIZE) || (pattern_height > MAX_PATTERN_SIZE)) {
+            throw std::invalid_argument("HitMissReplaceCascade: pattern is too big");
+        }
+
+        // Same as in hitMissReplaceInPlace(), as the origin affects
+        // which matches are considered to be inside the image.
+        const int pattern_len = pattern_width * pattern_height;
+        const auto* const minus_pos = (const char*) memchr(pattern, '-', pattern_len);
+        const auto* const plus_pos = (const char*) memchr(pattern, '+', pattern_len);
+        const char* origin_pos;
+        if (minus_pos && plus_pos) {
+            origin_pos = std::min(minus_pos, plus_pos);
+        } else if (minus_pos) {
+            origin_pos = minus_pos;
+        } else if (plus_pos) {
+            origin_pos = plus_pos;
+        } else {
+            // No replacements requested - nothing to do.
+            return;
+        }
+
+        const QPoint origin(
+                static_cast<int>((origin_pos - pattern) % pattern_width),
+                static_cast<int>((origin_pos - pattern) / pattern_width)
+        );
+
+        Rule rule;
+
+        const char* p = pattern;
+        for (int y = 0; y < pattern_height; ++y) {
+            for (int x = 0; x < pattern_width; ++x, ++p) {
+                switch (*p) {
+                    case '-':
+                        rule.blackToWhite.push_back(QPoint(x, y) - origin);
+                        // fall through
+                    case 'X':
+                        rule.hits.push_back(QPoint(x, y) - origin);
+                        break;
+                    case '+':
+                        rule.whiteToBlack.push_back(QPoint(x, y) - origin);
+                        // fall through
+                    case ' ':
+                        rule.misses.push_back(QPoint(x, y) - origin);
+                        break;
+                    case '?':
+                        break;
+                    default:
+                        throw std::invalid_argument(
+                                "HitMissReplaceCascade: invalid character in pattern"
+                        );
+                }
+            }
+        }
+
+        std::vector<QPoint> tests(rule.hits);
+        tests.insert(tests.end(), rule.misses.begin(), rule.misses.end());
+        std::vector<QPoint> replacements(rule.whiteToBlack);
+        replacements.insert(replacements.end(), rule.blackToWhite.begin(), rule.blackToWhite.end());
+
+        rule.reachUp = 0;
+        rule.reachDown = 0;
+        rule.minReplacementY = replacements.front().y();
+        rule.maxReplacementY = replacements.front().y();
+        for (const QPoint& repl : replacements) {
+            rule.minReplacementY = std::min(rule.minReplacementY, repl.y());
+            rule.maxReplacementY = std::max(rule.maxReplacementY, repl.y());
+            for (const QPoint& test : tests) {
+                rule.reachUp = std::max(rule.reachUp, repl.y() - test.y());
+                rule.reachDown = std::max(rule.reachDown, test.y() - repl.y());
+            }
+        }
+
+        m_rules.push_back(rule);
+    }  // HitMissReplaceCascade::addRule
+
+    void HitMissReplaceCascade::addRuleAllDirections(const char* const pattern,
+                                                     const int pattern_width,
+                                                     const int pattern_height) {
+        addRule(pattern, pattern_width, pattern_height);
+
+        std::vector<char> pattern_data(static_cast<size_t>(pattern_width * pattern_height), ' ');
+        char* const new_pattern = &pattern_data[0];
+
+        // Rotate 90 degrees clockwise.
+        const char* p = pattern;
+        for (int y = 0; y < pattern_height; ++y) {
+            for (int x = 0; x < pattern_width; ++x, ++p) {
+                new_pattern[x * pattern_height + (pattern_height - 1 - y)] = *p;
+            }
+        }
+        addRule(new_pattern, pattern_height, pattern_width);
+
+        // Rotate upside down.
+        p = pattern;
+        for (int y = 0; y < pattern_height; ++y) {
+            for (int x = 0; x < pattern_width; ++x, ++p) {
+                new_pattern[(pattern_height - 1 - y) * pattern_width + (pattern_width - 1 - x)] = *p;
+            }
+        }
+        addRule(new_pattern, pattern_width, pattern_height);
+
+        // Rotate 90 degrees counter-clockwise.
+        p = pattern;
+        for (int y = 0; y < pattern_height; ++y) {
+            for (int x = 0; x < pattern_width; ++x, ++p) {
+                new_pattern[(pattern_width - 1 - x) * pattern_height + y] = *p;
+            }
+        }
+        addRule(new_pattern, pattern_height, pattern_width);
+    }
+
+    void HitMissReplaceCascade::applyInPlace(BinaryImage& img) const {
+        const TraceSpan span("imageproc", "HitMissReplaceCascade::applyInPlace");
+
+        if (img.isNull() || m_rules.empty()) {
+            return;
+        }
+
+        // Bands read the rows of their neighbours, so the results
+        // can't be written back in place.
+        const BinaryImage src(img);
+        BinaryImage dst(img.size());
+        uint32_t* const dst_data = dst.data();
+        const int dst_wpl = dst.wordsPerLine();
+        const int height = img.height();
+
+        const int num_bands = (height + BAND_HEIGHT - 1) / BAND_HEIGHT;
+        parallelFor(0, num_bands, 1, [&](const int begin, const int end) {
+            for (int band = begin; band < end; ++band) {
+                const int band_top = band * BAND_HEIGHT;
+                processBand(src, dst_data, dst_wpl, band_top, std::min(band_top + BAND_HEIGHT, height));
+            }
+        });
+
+        img.swap(dst);
+    }
+
+    void HitMissReplaceCascade::processBand(const BinaryImage& src,
+                                            uint32_t* const dst_data,
+                                            const int dst_wpl,
+                                            const int band_top,
+                                            const int band_bottom) const {
+        const int width = src.width();
+        const int height = src.height();
+        const int wpl = src.wordsPerLine();
+        const uint32_t last_word_mask = ~uint32_t(0) << (31 - (width - 1) % 32);
+        const auto num_rules = static_cast<int>(m_rules.size());
+
+        // Rule k reads rows [top[k], bottom[k]) of its input and produces
+        // rows [top[k + 1], bottom[k + 1]) of its output.
+        std::vector<int> top(num_rules + 1);
+        std::vector<int> bottom(num_rules + 1);
+        top[num_rules] = band_top;
+        bottom[num_rules] = band_bottom;
+        int match_margin = 0;
+        for (int k = num_rules - 1; k >= 0; --k) {
+            const Rule& rule = m_rules[k];
+            top[k] = std::max(0, top[k + 1] - rule.reachUp);
+            bottom[k] = std::min(height, bottom[k + 1] + rule.reachDown);
+            match_margin = std::max(match_margin, std::max(-rule.minReplacementY, rule.maxReplacementY));
+        }
+
+        const int win_top = top[0];
+        const int win_bottom = bottom[0];
+        RowBuffer cur(win_top, win_bottom - win_top, wpl);
+        RowBuffer next(win_top, win_bottom - win_top, wpl);
+        RowBuffer matches(win_top - match_margin, win_bottom - win_top + 2 * match_margin, wpl);
+        const std::vector<uint32_t> zero_row(static_cast<size_t>(wpl + 2), 0);
+
+        // The lines each pattern position refers to, for the current row.
+        std::vector<const uint32_t*> hit_lines(MAX_PATTERN_SIZE * MAX_PATTERN_SIZE);
+        std::vector<const uint32_t*> miss_lines(MAX_PATTERN_SIZE * MAX_PATTERN_SIZE);
+        std::vector<const uint32_t*> w2b_lines(MAX_PATTERN_SIZE * MAX_PATTERN_SIZE);
+        std::vector<const uint32_t*> b2w_lines(MAX_PATTERN_SIZE * MAX_PATTERN_SIZE);
+
+        const uint32_t* src_line = src.data() + win_top * wpl;
+        for (int y = win_top; y < win_bottom; ++y, src_line += wpl) {
+            uint32_t* const line = cur.row(y);
+            memcpy(line, src_line, wpl * sizeof(uint32_t));
+            line[wpl - 1] &= last_word_mask;
+        }
+
+        for (int k = 0; k < num_rules; ++k) {
+            const Rule& rule = m_rules[k];
+            const int in_top = top[k];
+            const int in_bottom = bottom[k];
+            const int out_top = top[k + 1];
+            const int out_bottom = bottom[k + 1];
+
+            // Rows outside of the input range are either outside of the image,
+            // and therefore white, or don't affect the rows we need.
+            auto input_row = [&](const int y) -> const uint32_t* {
+                if ((y < in_top) || (y >= in_bottom)) {
+                    return &zero_row[1];
+                }
+
+                return cur.row(y);
+            };
+            // Matches are only possible inside the image.
+            auto match_row = [&](const int y) -> const uint32_t* {
+                if ((y < 0) || (y >= height)) {
+                    return &zero_row[1];
+                }
+
+                return matches.row(y);
+            };
+
+            const int match_top = std::max(0, out_top - rule.maxReplacementY);
+            const int match_bottom = std::min(height, out_bottom - rule.minReplacementY);
+            for (int y = match_top; y < match_bottom; ++y) {
+                for (size_t j = 0; j < rule.hits.size(); ++j) {
+                    hit_lines[j] = input_row(y + rule.hits[j].y());
+                }
+                for (size_t j = 0; j < rule.misses.size(); ++j) {
+                    miss_lines[j] = input_row(y + rule.misses[j].y());
+                }
+
+                uint32_t* const match_line = matches.row(y);
+                for (int i = 0; i < wpl; ++i) {
+                    uint32_t word = ~uint32_t(0);
+                    for (size_t j = 0; j < rule.hits.size(); ++j) {
+                        word &= shiftedWord(hit_lines[j], i, rule.hits[j].x());
+                    }
+                    for (size_t j = 0; j < rule.misses.size(); ++j) {
+                        word &= ~shiftedWord(miss_lines[j], i, rule.misses[j].x());
+                    }
+                    match_line[i] = word;
+                }
+                match_line[wpl - 1] &= last_word_mask;
+            }
+
+            for (int y = out_top; y < out_bottom; ++y) {
+                for (size_t j = 0; j < rule.whiteToBlack.size(); ++j) {
+                    w2b_lines[j] = match_row(y - rule.whiteToBlack[j].y());
+                }
+                for (size_t j = 0; j < rule.blackToWhite.size(); ++j) {
+                    b2w_lines[j] = match_row(y - rule.blackToWhite[j].y());
+                }
+
+                const uint32_t* const in_line = input_row(y);
+                uint32_t* const out_line = next.row(y);
+                for (int i = 0; i < wpl; ++i) {
+                    uint32_t word = in_line[i];
+                    for (size_t j = 0; j < rule.whiteToBlack.size(); ++j) {
+                        word |= shiftedWord(w2b_lines[j], i, -rule.whiteToBlack[j].x());
+                    }
+                    for (size_t j = 0; j < rule.blackToWhite.size(); ++j) {
+                        word &= ~shiftedWord(b2w_lines[j], i, -rule.blackToWhite[j].x());
+                    }
+                    out_line[i] = word;
+                }
+                out_line[wpl - 1] &= last_word_mask;
+            }
+
+            cur.swap(next);
+        }
+
+        uint32_t* dst_line = dst_data + band_top * dst_wpl;
+        for (int y = band_top; y < band_bottom; ++y, dst_line += dst_wpl) {
+            memcpy(dst_line, cur.row(y), wpl * sizeof(uint32_t));
+        }
+    }  // HitMissReplaceCascade::processBand
+}  // namespace imageproc
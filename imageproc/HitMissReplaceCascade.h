@@ -0,0 +1,96 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCANTAILOR_HITMISSREPLACECASCADE_H
+#define SCANTAILOR_HITMISSREPLACECASCADE_H
+
+#include <QPoint>
+#include <vector>
+#include <cstdint>
+
+namespace imageproc {
+    class BinaryImage;
+
+    /**
+     * \brief Applies a sequence of hit-miss replacement rules in a single pass.
+     *
+     * The result is bit-exact with calling
+     * \code
+     * hitMissReplaceInPlace(img, WHITE, pattern, pattern_width, pattern_height);
+     * \endcode
+     * for every rule, in the order they were added.  Instead of a few full image
+     * passes with temporary images per rule, the image is processed in horizontal
+     * bands small enough to stay in cache.  Every rule is applied to a band,
+     * 32 pixels at a time, before moving on to the next band, and the bands are
+     * processed in parallel.
+     *
+     * The pattern syntax is the one of hitMissReplaceInPlace().  Patterns may not
+     * exceed 32x32 pixels.
+     */
+    class HitMissReplaceCascade {
+    public:
+        /**
+         * \brief Appends a rule.
+         *
+         * \throw std::invalid_argument if the pattern is too big or contains invalid characters.
+         */
+        void addRule(const char* pattern, int pattern_width, int pattern_height);
+
+        /**
+         * \brief Appends a rule in four orientations.
+         *
+         * The rule is added as is, then rotated by 90 degrees clockwise,
+         * then upside down and finally 90 degrees counter-clockwise.
+         */
+        void addRuleAllDirections(const char* pattern, int pattern_width, int pattern_height);
+
+        bool isEmpty() const {
+            return m_rules.empty();
+        }
+
+        void applyInPlace(BinaryImage& img) const;
+
+    private:
+        struct Rule {
+            std::vector<QPoint> hits;
+            std::vector<QPoint> misses;
+            std::vector<QPoint> whiteToBlack;
+            std::vector<QPoint> blackToWhite;
+
+            /**
+             * The number of rows above and below an output row
+             * that affect it.
+             */
+            int reachUp;
+            int reachDown;
+
+            /**
+             * The vertical range of replacement offsets.
+             */
+            int minReplacementY;
+            int maxReplacementY;
+        };
+
+        void processBand(const BinaryImage& src, uint32_t* dst_data, int dst_wpl, int band_top, int band_bottom) const;
+
+        std::vector<Rule> m_rules;
+    };
+}  // namespace imageproc
+
+
+#endif //SCANTAILOR_HITMISSREPLACECASCADE_H
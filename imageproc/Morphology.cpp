@@ -21,9 +21,12 @@
 #include "GrayImage.h"
 #include "RasterOp.h"
 #include "Grayscale.h"
+#include "Tracer.h"
+#include "ParallelFor.h"
 #include <QDebug>
 #include <cassert>
 #include <cmath>
+#include <cstring>
 
 namespace imageproc {
     Brick::Brick(const QSize& size) {
@@ -572,6 +575,28 @@ namespace imageproc {
             );
         }
 
+        /**
+         * dst[x] = MinOrMax::select(src1[x], src2[x]) for a whole row.
+         * \p dst may be the same as \p src1 or \p src2.
+         */
+        template<typename MinOrMax>
+        void selectRows(uint8_t* dst, const uint8_t* src1, const uint8_t* src2, const int width) {
+            // A simple loop like this gets vectorized by the compiler.
+            for (int x = 0; x < width; ++x) {
+                dst[x] = MinOrMax::select(src1[x], src2[x]);
+            }
+        }
+
+        /**
+         * The number of rows per parallelFor() chunk of the vertical spread.
+         */
+        const int MIN_VERT_SPREAD_ROWS_PER_CHUNK = 64;
+
+        /**
+         * Same as spreadGrayHorizontal(), but operates on whole rows rather than
+         * individual pixels, so that memory is accessed sequentially.
+         * Row segments are independent from each other and are processed in parallel.
+         */
         template<typename MinOrMax>
         void spreadGrayVertical(GrayImage& dst, const GrayImage& src, const int dx, const int dy1, const int dy2) {
             const int src_stride = src.stride();
@@ -583,13 +608,16 @@ namespace imageproc {
             const int dst_height = dst.height();
 
             const int se_len = dy2 - dy1 + 1;
+            const int num_segments = (dst_height + se_len - 1) / se_len;
+            const int segments_per_chunk = std::max(1, MIN_VERT_SPREAD_ROWS_PER_CHUNK / se_len);
 
-            std::vector<uint8_t> min_max_array(se_len * 2 - 1, 0);
-            uint8_t* const array_center = &min_max_array[se_len - 1];
+            parallelFor(0, num_segments, segments_per_chunk, [&](const int first_segment, const int last_segment) {
+                // Every element of the extremum array is a whole row here.
+                std::vector<uint8_t> min_max_rows(static_cast<size_t>(se_len * 2 - 1) * dst_width);
+                uint8_t* const center_row = &min_max_rows[static_cast<size_t>(se_len - 1) * dst_width];
 
-            for (int x = 0; x < dst_width; ++x) {
-                for (int dst_segment_first = 0; dst_segment_first < dst_height;
-                     dst_segment_first += se_len) {
+                for (int segment = first_segment; segment < last_segment; ++segment) {
+                    const int dst_segment_first = segment * se_len;
                     const int dst_segment_last = std::min(
                             dst_segment_first + se_len, dst_height
                     ) - 1; // inclusive
@@ -598,29 +626,43 @@ namespace imageproc {
                     const int src_segment_center
                             = (src_segment_first + src_segment_last) >> 1;
 
-                    fillExtremumArrayLeftHalf<MinOrMax>(
-                            array_center, src_data + x + src_segment_center * src_stride,
-                            src_stride, src_segment_first, src_segment_center
-                    );
+                    const uint8_t* const src_center = src_data + src_segment_center * src_stride;
+                    memcpy(center_row, src_center, static_cast<size_t>(dst_width));
 
-                    fillExtremumArrayRightHalf<MinOrMax>(
-                            array_center, src_data + x + src_segment_center * src_stride,
-                            src_stride, src_segment_center, src_segment_last
-                    );
+                    // The left half of the extremum array.
+                    const uint8_t* src_line = src_center;
+                    uint8_t* row = center_row;
+                    for (int i = src_segment_center - 1; i >= src_segment_first; --i) {
+                        src_line -= src_stride;
+                        selectRows<MinOrMax>(row - dst_width, row, src_line, dst_width);
+                        row -= dst_width;
+                    }
 
-                    uint8_t* dst = dst_data + x + dst_segment_first * dst_stride;
+                    // The right half of the extremum array.
+                    src_line = src_center;
+                    row = center_row;
+                    for (int i = src_segment_center + 1; i <= src_segment_last; ++i) {
+                        src_line += src_stride;
+                        selectRows<MinOrMax>(row + dst_width, row, src_line, dst_width);
+                        row += dst_width;
+                    }
+
+                    uint8_t* dst_line = dst_data + dst_segment_first * dst_stride;
                     for (int y = dst_segment_first; y <= dst_segment_last; ++y) {
                         const int src_first = y + dy1;
                         const int src_last = y + dy2;  // inclusive
                         assert(src_segment_center >= src_first);
                         assert(src_segment_center <= src_last);
-                        uint8_t v1 = array_center[src_first - src_segment_center];
-                        uint8_t v2 = array_center[src_last - src_segment_center];
-                        *dst = MinOrMax::select(v1, v2);
-                        dst += dst_stride;
+                        selectRows<MinOrMax>(
+                                dst_line,
+                                center_row + (src_first - src_segment_center) * dst_width,
+                                center_row + (src_last - src_segment_center) * dst_width,
+                                dst_width
+                        );
+                        dst_line += dst_stride;
                     }
                 }
-            }
+            });
         }  // spreadGrayVertical
 
         template<typename MinOrMax>
@@ -801,6 +843,8 @@ namespace imageproc {
                             const Brick& brick,
                             const QRect& dst_area,
                             const BWColor src_surroundings) {
+        const TraceSpan span("imageproc", "dilateBrick");
+
         if (src.isNull()) {
             throw std::invalid_argument("dilateBrick: src image is null");
         }
@@ -822,6 +866,8 @@ namespace imageproc {
                          const Brick& brick,
                          const QRect& dst_area,
                          const unsigned char src_surroundings) {
+        const TraceSpan span("imageproc", "dilateGray");
+
         if (src.isNull()) {
             throw std::invalid_argument("dilateGray: src image is null");
         }
@@ -845,6 +891,8 @@ namespace imageproc {
 
     BinaryImage erodeBrick(const BinaryImage& src, const Brick& brick, const QRect& dst_area,
                            const BWColor src_surroundings) {
+        const TraceSpan span("imageproc", "erodeBrick");
+
         if (src.isNull()) {
             throw std::invalid_argument("erodeBrick: src image is null");
         }
@@ -868,6 +916,8 @@ namespace imageproc {
                         const Brick& brick,
                         const QRect& dst_area,
                         const unsigned char src_surroundings) {
+        const TraceSpan span("imageproc", "erodeGray");
+
         if (src.isNull()) {
             throw std::invalid_argument("erodeGray: src image is null");
         }
@@ -935,6 +985,8 @@ namespace imageproc {
 
     GrayImage openGray(const GrayImage& src, const QSize& brick, const QRect& dst_area,
                        const unsigned char src_surroundings) {
+        const TraceSpan span("imageproc", "openGray");
+
         if (src.isNull()) {
             throw std::invalid_argument("openGray: src image is null");
         }
@@ -1014,6 +1066,8 @@ namespace imageproc {
                         const QSize& brick,
                         const QRect& dst_area,
                         const unsigned char src_surroundings) {
+        const TraceSpan span("imageproc", "closeGray");
+
         if (src.isNull()) {
             throw std::invalid_argument("closeGray: src image is null");
         }
@@ -1150,6 +1204,8 @@ namespace imageproc {
                                const char* const pattern,
                                const int pattern_width,
                                const int pattern_height) {
+        const TraceSpan span("imageproc", "hitMissReplace");
+
         BinaryImage dst(src);
 
         hitMissReplaceInPlace(
@@ -19,10 +19,47 @@
 #include "OrthogonalRotation.h"
 #include "BinaryImage.h"
 #include "RasterOp.h"
+#include "BitOps.h"
+#include "Tracer.h"
+#include "ParallelFor.h"
+#include <algorithm>
 
 namespace imageproc {
-    static inline uint32_t mask(int x) {
-        return (uint32_t(1) << 31) >> (x % 32);
+    /**
+     * The number of 32x32 blocks rows per parallelFor() chunk.
+     */
+    static const int BLOCK_ROWS_PER_CHUNK = 4;
+
+    /**
+     * Returns 32 pixels of a line, starting from \p x, which doesn't have
+     * to be word-aligned.  Pixels outside of the line's words are white.
+     */
+    static inline uint32_t loadWord(const uint32_t* line, const int wpl, const int x) {
+        const int word_idx = (x >= 0) ? (x / 32) : -((31 - x) / 32);
+        const int shift = x - word_idx * 32;
+        const uint32_t hi = (word_idx >= 0 && word_idx < wpl) ? line[word_idx] : 0;
+        if (shift == 0) {
+            return hi;
+        }
+        const uint32_t lo = (word_idx + 1 >= 0 && word_idx + 1 < wpl) ? line[word_idx + 1] : 0;
+
+        return (hi << shift) | (lo >> (32 - shift));
+    }
+
+    /**
+     * Transposes a 32x32 bit matrix in place, where a[row] holds the row
+     * with column 0 in the most significant bit.
+     * See Hacker's Delight, section 7-3.
+     */
+    static void transpose32(uint32_t* a) {
+        uint32_t m = 0x0000ffff;
+        for (int j = 16; j != 0; j >>= 1, m ^= (m << j)) {
+            for (int k = 0; k < 32; k = (k + j + 1) & ~j) {
+                const uint32_t t = (a[k] ^ (a[k + j] >> j)) & m;
+                a[k] ^= t;
+                a[k + j] ^= (t << j);
+            }
+        }
     }
 
     static BinaryImage rotate0(const BinaryImage& src, const QRect& src_rect) {
@@ -36,16 +73,60 @@ namespace imageproc {
         return dst;
     }
 
-    static BinaryImage rotate90(const BinaryImage& src, const QRect& src_rect) {
+    /**
+     * Implements rotate90() and rotate270(), which are transpositions
+     * combined with reversing the order of either columns or rows.
+     * Each 32x32 block of dst is built by transposing a block of src.
+     */
+    static BinaryImage rotateByTransposition(const BinaryImage& src, const QRect& src_rect, const bool clockwise) {
         const int dst_w = src_rect.height();
         const int dst_h = src_rect.width();
         BinaryImage dst(dst_w, dst_h);
-        dst.fill(WHITE);
         const int src_wpl = src.wordsPerLine();
         const int dst_wpl = dst.wordsPerLine();
-        const uint32_t* const src_data = src.data() + src_rect.bottom() * src_wpl;
-        uint32_t* dst_line = dst.data();
+        const uint32_t* const src_data = src.data();
+        uint32_t* const dst_data = dst.data();
+
+        const int num_block_rows = (dst_h + 31) / 32;
+        parallelFor(0, num_block_rows, BLOCK_ROWS_PER_CHUNK, [&](const int first_block_row, const int last_block_row) {
+            uint32_t block[32];
+
+            for (int block_row = first_block_row; block_row < last_block_row; ++block_row) {
+                const int dst_y0 = block_row * 32;
+                const int rows_in_block = std::min(32, dst_h - dst_y0);
+
+                // Column c of the block goes to dst line dst_y0 + c when rotating
+                // clockwise, and to dst_y0 + 31 - c otherwise.
+                const int src_x = clockwise ? (src_rect.left() + dst_y0) : (src_rect.right() - dst_y0 - 31);
+
+                for (int dst_word = 0; dst_word < dst_wpl; ++dst_word) {
+                    const int dst_x0 = dst_word * 32;
+                    const int cols_in_block = std::min(32, dst_w - dst_x0);
+
+                    // Row k of the block goes to dst column dst_x0 + k.
+                    for (int k = 0; k < cols_in_block; ++k) {
+                        const int src_y = clockwise ? (src_rect.bottom() - dst_x0 - k) : (src_rect.top() + dst_x0 + k);
+                        block[k] = loadWord(src_data + src_y * src_wpl, src_wpl, src_x);
+                    }
+                    for (int k = cols_in_block; k < 32; ++k) {
+                        block[k] = 0;
+                    }
+
+                    transpose32(block);
+
+                    uint32_t* dst_pword = dst_data + dst_y0 * dst_wpl + dst_word;
+                    for (int c = 0; c < rows_in_block; ++c) {
+                        *dst_pword = block[clockwise ? c : 31 - c];
+                        dst_pword += dst_wpl;
+                    }
+                }
+            }
+        });
 
+        return dst;
+    }  // rotateByTransposition
+
+    static BinaryImage rotate90(const BinaryImage& src, const QRect& src_rect) {
         /*
          *   dst
          *  ----->
@@ -54,33 +135,17 @@ namespace imageproc {
          * |
          */
 
-        for (int dst_y = 0; dst_y < dst_h; ++dst_y) {
-            const int src_x = src_rect.left() + dst_y;
-            const uint32_t* src_pword = src_data + src_x / 32;
-            const uint32_t src_mask = mask(src_x);
-
-            for (int dst_x = 0; dst_x < dst_w; ++dst_x) {
-                if (*src_pword & src_mask) {
-                    dst_line[dst_x / 32] |= mask(dst_x);
-                }
-                src_pword -= src_wpl;
-            }
-
-            dst_line += dst_wpl;
-        }
-
-        return dst;
+        return rotateByTransposition(src, src_rect, true);
     }
 
     static BinaryImage rotate180(const BinaryImage& src, const QRect& src_rect) {
         const int dst_w = src_rect.width();
         const int dst_h = src_rect.height();
         BinaryImage dst(dst_w, dst_h);
-        dst.fill(WHITE);
         const int src_wpl = src.wordsPerLine();
         const int dst_wpl = dst.wordsPerLine();
-        const uint32_t* src_line = src.data() + src_rect.bottom() * src_wpl;
-        uint32_t* dst_line = dst.data();
+        const uint32_t* const src_data = src.data();
+        uint32_t* const dst_data = dst.data();
 
         /*
          *  dst
@@ -89,31 +154,26 @@ namespace imageproc {
          *  src
          */
 
-        for (int dst_y = 0; dst_y < dst_h; ++dst_y) {
-            int src_x = src_rect.right();
-            for (int dst_x = 0; dst_x < dst_w; --src_x, ++dst_x) {
-                if (src_line[src_x / 32] & mask(src_x)) {
-                    dst_line[dst_x / 32] |= mask(dst_x);
+        // Pixels past the right edge of dst must stay white.
+        const int last_word_bits = dst_w - (dst_wpl - 1) * 32;
+        const uint32_t last_word_mask = ~uint32_t(0) << (32 - last_word_bits);
+
+        parallelFor(0, dst_h, BLOCK_ROWS_PER_CHUNK * 32, [&](const int first_row, const int last_row) {
+            for (int dst_y = first_row; dst_y < last_row; ++dst_y) {
+                const uint32_t* const src_line = src_data + (src_rect.bottom() - dst_y) * src_wpl;
+                uint32_t* const dst_line = dst_data + dst_y * dst_wpl;
+                for (int dst_word = 0; dst_word < dst_wpl; ++dst_word) {
+                    const int src_x = src_rect.right() - dst_word * 32 - 31;
+                    dst_line[dst_word] = reverseBits(loadWord(src_line, src_wpl, src_x));
                 }
+                dst_line[dst_wpl - 1] &= last_word_mask;
             }
-
-            src_line -= src_wpl;
-            dst_line += dst_wpl;
-        }
+        });
 
         return dst;
     }
 
     static BinaryImage rotate270(const BinaryImage& src, const QRect& src_rect) {
-        const int dst_w = src_rect.height();
-        const int dst_h = src_rect.width();
-        BinaryImage dst(dst_w, dst_h);
-        dst.fill(WHITE);
-        const int src_wpl = src.wordsPerLine();
-        const int dst_wpl = dst.wordsPerLine();
-        const uint32_t* const src_data = src.data() + src_rect.top() * src_wpl;
-        uint32_t* dst_line = dst.data();
-
         /*
          *  dst
          * ----->
@@ -122,25 +182,12 @@ namespace imageproc {
          *       v
          */
 
-        for (int dst_y = 0; dst_y < dst_h; ++dst_y) {
-            const int src_x = src_rect.right() - dst_y;
-            const uint32_t* src_pword = src_data + src_x / 32;
-            const uint32_t src_mask = mask(src_x);
-
-            for (int dst_x = 0; dst_x < dst_w; ++dst_x) {
-                if (*src_pword & src_mask) {
-                    dst_line[dst_x / 32] |= mask(dst_x);
-                }
-                src_pword += src_wpl;
-            }
-
-            dst_line += dst_wpl;
-        }
-
-        return dst;
+        return rotateByTransposition(src, src_rect, false);
     }
 
     BinaryImage orthogonalRotation(const BinaryImage& src, const QRect& src_rect, const int degrees) {
+        const TraceSpan span("imageproc", "orthogonalRotation");
+
         if (src.isNull() || src_rect.isNull()) {
             return BinaryImage();
         }
@@ -26,16 +26,29 @@
 #include "MatT.h"
 #include "VecT.h"
 #include "MatrixCalc.h"
+#include "Tracer.h"
+#include "ParallelFor.h"
 #include <stdexcept>
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <cassert>
+#include <cstring>
+#include <vector>
 
 namespace imageproc {
+    namespace {
+        /**
+         * The number of rows per parallelFor() chunk in renderRows().
+         */
+        const int RENDER_ROWS_PER_CHUNK = 32;
+    }
+
     PolynomialSurface::PolynomialSurface(const int hor_degree, const int vert_degree, const GrayImage& src)
             : m_horDegree(hor_degree),
               m_vertDegree(vert_degree) {
+        const TraceSpan span("imageproc", "PolynomialSurface");
+
         // Note: m_horDegree and m_vertDegree may still change!
 
         if (hor_degree < 0) {
@@ -80,6 +93,8 @@ namespace imageproc {
                                          const BinaryImage& mask)
             : m_horDegree(hor_degree),
               m_vertDegree(vert_degree) {
+        const TraceSpan span("imageproc", "PolynomialSurface");
+
         // Note: m_horDegree and m_vertDegree may still change!
 
         if (hor_degree < 0) {
@@ -127,59 +142,76 @@ namespace imageproc {
         }
 
         GrayImage image(size);
+        unsigned char* const data = image.data();
+        const int bpl = image.stride();
+        const int width = size.width();
+
+        renderRows(size, [data, bpl, width](const int y, const uint8_t* row) {
+            memcpy(data + y * bpl, row, static_cast<size_t>(width));
+        });
+
+        return image;
+    }
+
+    void PolynomialSurface::renderRows(const QSize& size,
+                                       const std::function<void(int, const uint8_t*)>& row_handler) const {
+        const TraceSpan span("imageproc", "PolynomialSurface::renderRows");
+
+        if (size.isEmpty()) {
+            return;
+        }
+
         const int width = size.width();
         const int height = size.height();
-        unsigned char* line = image.data();
-        const int bpl = image.stride();
-        const auto num_coeffs = static_cast<const int>(m_coeffs.size());
+        const int num_hor_coeffs = m_horDegree + 1;
 
         // Pretend that both x and y positions of pixels
         // lie in range of [0, 1].
         const double xscale = calcScale(width);
         const double yscale = calcScale(height);
 
-        AlignedArray<float, 4> vert_matrix(num_coeffs * height);
-        float* out = &vert_matrix[0];
-        for (int y = 0; y < height; ++y) {
-            const double y_adjusted = y * yscale;
-            double pow = 1.0;
-            int pos = 0;
-            for (int i = 0; i <= m_vertDegree; ++i) {
-                for (int j = 0; j <= m_horDegree; ++j, ++pos, ++out) {
-                    *out = static_cast<float>(m_coeffs[pos] * pow);
-                }
-                pow *= y_adjusted;
-            }
+        AlignedArray<float, 4> x_values(width);
+        for (int x = 0; x < width; ++x) {
+            x_values[x] = static_cast<float>(x * xscale);
         }
 
-        AlignedArray<float, 4> hor_matrix(num_coeffs * width);
-        out = &hor_matrix[0];
-        for (int x = 0; x < width; ++x) {
-            const double x_adjusted = x * xscale;
-            for (int i = 0; i <= m_vertDegree; ++i) {
-                double pow = 1.0;
-                for (int j = 0; j <= m_horDegree; ++j, ++out) {
-                    *out = static_cast<float>(pow);
-                    pow *= x_adjusted;
+        parallelFor(0, height, RENDER_ROWS_PER_CHUNK, [&](const int first_row, const int last_row) {
+            AlignedArray<float, 4> acc(width);
+            std::vector<uint8_t> row(static_cast<size_t>(width));
+            std::vector<double> row_coeffs(static_cast<size_t>(num_hor_coeffs));
+
+            for (int y = first_row; y < last_row; ++y) {
+                // Collapse the polynomial into one of x only, using Horner's method in y.
+                const double y_adjusted = y * yscale;
+                for (int j = 0; j < num_hor_coeffs; ++j) {
+                    double coeff = m_coeffs[m_vertDegree * num_hor_coeffs + j];
+                    for (int i = m_vertDegree - 1; i >= 0; --i) {
+                        coeff = coeff * y_adjusted + m_coeffs[i * num_hor_coeffs + j];
+                    }
+                    row_coeffs[j] = coeff;
                 }
-            }
-        }
 
-        const float* vert_line = &vert_matrix[0];
-        for (int y = 0; y < height; ++y, line += bpl, vert_line += num_coeffs) {
-            const float* hor_line = &hor_matrix[0];
-            for (int x = 0; x < width; ++x, hor_line += num_coeffs) {
-                float sum = 0.5f / 255.0f;  // for rounding purposes.
-                for (int i = 0; i < num_coeffs; ++i) {
-                    sum += hor_line[i] * vert_line[i];
+                // Horner's method in x, for the whole row at once.
+                const float top_coeff = static_cast<float>(row_coeffs[m_horDegree]);
+                for (int x = 0; x < width; ++x) {
+                    acc[x] = top_coeff;
+                }
+                for (int j = m_horDegree - 1; j >= 0; --j) {
+                    const auto coeff = static_cast<float>(row_coeffs[j]);
+                    for (int x = 0; x < width; ++x) {
+                        acc[x] = acc[x] * x_values[x] + coeff;
+                    }
                 }
-                const auto isum = (int) (sum * 255.0);
-                line[x] = static_cast<unsigned char>(qBound(0, isum, 255));
-            }
-        }
 
-        return image;
-    } // PolynomialSurface::render
+                for (int x = 0; x < width; ++x) {
+                    const auto isum = static_cast<int>(acc[x] * 255.0f + 0.5f);  // + 0.5 for rounding purposes.
+                    row[x] = static_cast<uint8_t>(qBound(0, isum, 255));
+                }
+
+                row_handler(y, row.data());
+            }
+        });
+    }  // PolynomialSurface::renderRows
 
     void PolynomialSurface::maybeReduceDegrees(const int num_data_points) {
         assert(num_data_points > 0);
@@ -19,14 +19,15 @@
 #ifndef IMAGEPROC_POLYNOMIAL_SURFACE_H_
 #define IMAGEPROC_POLYNOMIAL_SURFACE_H_
 
+#include "GrayImage.h"
 #include "MatT.h"
 #include "VecT.h"
 #include <QSize>
 #include <cstdint>
+#include <functional>
 
 namespace imageproc {
     class BinaryImage;
-    class GrayImage;
 
 /**
  * \brief A polynomial function describing a 2D surface.
@@ -80,6 +81,26 @@ namespace imageproc {
          */
         GrayImage render(const QSize& size) const;
 
+        /**
+         * \brief Renders the surface a row at a time, without allocating a full image.
+         *
+         * Produces the same rows as render(), passing each of them to
+         * \p row_handler as (y, row) instead of storing it.  Rows are rendered
+         * in parallel, so the handler may be called concurrently, though never
+         * twice for the same row.
+         */
+        void renderRows(const QSize& size, const std::function<void(int, const uint8_t*)>& row_handler) const;
+
+        /**
+         * \brief Combines an image with the surface, without rendering the surface into an image.
+         *
+         * Gives the same result as grayRasterOp<GRop>(render(image.size()), image),
+         * only stored in \p image.  The image is the source of the operation,
+         * and the surface is its destination.
+         */
+        template<typename GRop>
+        void applyGrayRasterOp(GrayImage& image) const;
+
     private:
         void maybeReduceDegrees(int num_data_points);
 
@@ -106,6 +127,20 @@ namespace imageproc {
         int m_horDegree;
         int m_vertDegree;
     };
+
+
+    template<typename GRop>
+    void PolynomialSurface::applyGrayRasterOp(GrayImage& image) const {
+        uint8_t* const data = image.data();
+        const int stride = image.stride();
+        const int width = image.width();
+        renderRows(image.size(), [data, stride, width](const int y, const uint8_t* surface_line) {
+            uint8_t* line = data + y * stride;
+            for (int x = 0; x < width; ++x) {
+                line[x] = GRop::transform(line[x], surface_line[x]);
+            }
+        });
+    }
 }  // namespace imageproc
 
 #endif // ifndef IMAGEPROC_POLYNOMIAL_SURFACE_H_
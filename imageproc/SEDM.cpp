@@ -25,6 +25,10 @@
 #include "Morphology.h"
 #include "SeedFill.h"
 #include "RasterOp.h"
+#include "Tracer.h"
+#include "ParallelFor.h"
+#include <algorithm>
+#include <cstring>
 
 namespace imageproc {
 // Note that -1 is an implementation detail.
@@ -41,6 +45,8 @@ namespace imageproc {
             : m_pData(nullptr),
               m_size(image.size()),
               m_stride(0) {
+        const TraceSpan span("imageproc", "SEDM");
+
         if (image.isNull()) {
             return;
         }
@@ -211,178 +217,204 @@ namespace imageproc {
         return dx_sq + dy_sq;
     }
 
-    void SEDM::processColumns() {
-        const int width = m_size.width() + 2;
-        const int height = m_size.height() + 2;
+    namespace {
+        /**
+         * The number of adjacent columns processed together by processColumns(),
+         * so that memory is accessed row by row rather than column by column.
+         */
+        const int COLUMN_BLOCK_SIZE = 16;
+
+        /**
+         * The number of cells to process per parallelFor() chunk.
+         */
+        const int CELLS_PER_CHUNK = 1 << 16;
 
-        uint32_t* p_sqd = &m_data[0];
-        for (int x = 0; x < width; ++x, ++p_sqd) {
-            // (d + 1)^2 = d^2 + 2d + 1
-            uint32_t b = 1;  // 2d + 1 in the above formula.
-            for (int todo = height - 1; todo > 0; --todo) {
-                const uint32_t sqd = *p_sqd + b;
-                p_sqd += width;
-                if (*p_sqd > sqd) {
-                    *p_sqd = sqd;
-                    b += 2;
+        int columnBlocksPerChunk(const int height) {
+            return std::max(1, CELLS_PER_CHUNK / (COLUMN_BLOCK_SIZE * std::max(height, 1)));
+        }
+
+        int rowsPerChunk(const int width) {
+            return std::max(1, CELLS_PER_CHUNK / std::max(width, 1));
+        }
+
+        /**
+         * Propagates distances from \p prev_line to \p line, for columns [0, num_cols).
+         * \p b holds 2d + 1 for every column, as in (d + 1)^2 = d^2 + 2d + 1.
+         */
+        inline void propagateLine(const uint32_t* prev_line, uint32_t* line, uint32_t* b, const int num_cols) {
+            for (int i = 0; i < num_cols; ++i) {
+                const uint32_t sqd = prev_line[i] + b[i];
+                if (line[i] > sqd) {
+                    line[i] = sqd;
+                    b[i] += 2;
                 } else {
-                    b = 1;
+                    b[i] = 1;
                 }
             }
+        }
 
-            b = 1;
-            for (int todo = height - 1; todo > 0; --todo) {
-                const uint32_t sqd = *p_sqd + b;
-                p_sqd -= width;
-                if (*p_sqd > sqd) {
-                    *p_sqd = sqd;
-                    b += 2;
+        /**
+         * Same as above, but also propagates connectivity map labels.
+         */
+        inline void propagateLine(const uint32_t* prev_line, uint32_t* line,
+                                  const uint32_t* prev_label_line, uint32_t* label_line,
+                                  uint32_t* b, const int num_cols) {
+            for (int i = 0; i < num_cols; ++i) {
+                const uint32_t sqd = prev_line[i] + b[i];
+                if (sqd < line[i]) {
+                    line[i] = sqd;
+                    label_line[i] = prev_label_line[i];
+                    b[i] += 2;
                 } else {
-                    b = 1;
+                    b[i] = 1;
                 }
             }
         }
-    }  // SEDM::processColumns
+    }  // namespace
 
-    void SEDM::processColumns(ConnectivityMap& cmap) {
+    void SEDM::processColumns() {
         const int width = m_size.width() + 2;
         const int height = m_size.height() + 2;
+        uint32_t* const data = &m_data[0];
+
+        const int num_blocks = (width + COLUMN_BLOCK_SIZE - 1) / COLUMN_BLOCK_SIZE;
+        parallelFor(0, num_blocks, columnBlocksPerChunk(height), [&](const int first_block, const int last_block) {
+            uint32_t b[COLUMN_BLOCK_SIZE];
+            for (int block = first_block; block < last_block; ++block) {
+                const int x0 = block * COLUMN_BLOCK_SIZE;
+                const int num_cols = std::min(COLUMN_BLOCK_SIZE, width - x0);
+
+                std::fill(b, b + num_cols, 1);
+                uint32_t* p_sqd = data + x0;
+                for (int todo = height - 1; todo > 0; --todo, p_sqd += width) {
+                    propagateLine(p_sqd, p_sqd + width, b, num_cols);
+                }
 
-        uint32_t* p_sqd = &m_data[0];
-        uint32_t* p_label = cmap.paddedData();
-        for (int x = 0; x < width; ++x, ++p_sqd, ++p_label) {
-            // (d + 1)^2 = d^2 + 2d + 1
-            uint32_t b = 1;  // 2d + 1 in the above formula.
-            for (int todo = height - 1; todo > 0; --todo) {
-                const uint32_t sqd = *p_sqd + b;
-                p_sqd += width;
-                p_label += width;
-                if (sqd < *p_sqd) {
-                    *p_sqd = sqd;
-                    *p_label = p_label[-width];
-                    b += 2;
-                } else {
-                    b = 1;
+                std::fill(b, b + num_cols, 1);
+                for (int todo = height - 1; todo > 0; --todo, p_sqd -= width) {
+                    propagateLine(p_sqd, p_sqd - width, b, num_cols);
                 }
             }
+        });
+    }  // SEDM::processColumns
 
-            b = 1;
-            for (int todo = height - 1; todo > 0; --todo) {
-                const uint32_t sqd = *p_sqd + b;
-                p_sqd -= width;
-                p_label -= width;
-                if (sqd < *p_sqd) {
-                    *p_sqd = sqd;
-                    *p_label = p_label[width];
-                    b += 2;
-                } else {
-                    b = 1;
+    void SEDM::processColumns(ConnectivityMap& cmap) {
+        const int width = m_size.width() + 2;
+        const int height = m_size.height() + 2;
+        uint32_t* const data = &m_data[0];
+        uint32_t* const labels = cmap.paddedData();
+
+        const int num_blocks = (width + COLUMN_BLOCK_SIZE - 1) / COLUMN_BLOCK_SIZE;
+        parallelFor(0, num_blocks, columnBlocksPerChunk(height), [&](const int first_block, const int last_block) {
+            uint32_t b[COLUMN_BLOCK_SIZE];
+            for (int block = first_block; block < last_block; ++block) {
+                const int x0 = block * COLUMN_BLOCK_SIZE;
+                const int num_cols = std::min(COLUMN_BLOCK_SIZE, width - x0);
+
+                std::fill(b, b + num_cols, 1);
+                uint32_t* p_sqd = data + x0;
+                uint32_t* p_label = labels + x0;
+                for (int todo = height - 1; todo > 0; --todo, p_sqd += width, p_label += width) {
+                    propagateLine(p_sqd, p_sqd + width, p_label, p_label + width, b, num_cols);
+                }
+
+                std::fill(b, b + num_cols, 1);
+                for (int todo = height - 1; todo > 0; --todo, p_sqd -= width, p_label -= width) {
+                    propagateLine(p_sqd, p_sqd - width, p_label, p_label - width, b, num_cols);
                 }
             }
-        }
+        });
     }  // SEDM::processColumns
 
     void SEDM::processRows() {
         const int width = m_size.width() + 2;
         const int height = m_size.height() + 2;
+        uint32_t* const data = &m_data[0];
 
-        std::vector<int> s(width, 0);
-        std::vector<int> t(width, 0);
-        std::vector<uint32_t> row_copy(width, 0);
-
-        uint32_t* line = &m_data[0];
-        for (int y = 0; y < height; ++y, line += width) {
-            int q = 0;
-            s[0] = 0;
-            t[0] = 0;
-            for (int x = 1; x < width; ++x) {
-                while (q >= 0 && distSq(t[q], s[q], line[s[q]])
-                                 > distSq(t[q], x, line[x])) {
-                    --q;
-                }
+        parallelFor(0, height, rowsPerChunk(width), [&](const int first_row, const int last_row) {
+            std::vector<int> s(width, 0);
+            std::vector<int> t(width, 0);
+            std::vector<uint32_t> row_copy(width, 0);
 
-                if (q < 0) {
-                    q = 0;
-                    s[0] = x;
-                } else {
-                    const int x2 = s[q];
-                    if ((line[x] != INF_DIST) && (line[x2] != INF_DIST)) {
-                        int w = (x * x + line[x]) - (x2 * x2 + line[x2]);
-                        w /= (x - x2) << 1;
-                        ++w;
-                        if ((unsigned) w < (unsigned) width) {
-                            ++q;
-                            s[q] = x;
-                            t[q] = w;
-                        }
-                    }
-                }
-            }
+            uint32_t* line = data + first_row * width;
+            for (int y = first_row; y < last_row; ++y, line += width) {
+                const int q = buildLowerEnvelope(line, width, &s[0], &t[0]);
 
-            memcpy(&row_copy[0], line, width * sizeof(*line));
+                memcpy(&row_copy[0], line, width * sizeof(*line));
 
-            for (int x = width - 1; x >= 0; --x) {
-                const int x2 = s[q];
-                line[x] = distSq(x, x2, row_copy[x2]);
-                if (x == t[q]) {
-                    --q;
+                for (int x = width - 1, qq = q; x >= 0; --x) {
+                    const int x2 = s[qq];
+                    line[x] = distSq(x, x2, row_copy[x2]);
+                    if (x == t[qq]) {
+                        --qq;
+                    }
                 }
             }
-        }
+        });
     }  // SEDM::processRows
 
     void SEDM::processRows(ConnectivityMap& cmap) {
         const int width = m_size.width() + 2;
         const int height = m_size.height() + 2;
-
-        std::vector<int> s(width, 0);
-        std::vector<int> t(width, 0);
-        std::vector<uint32_t> row_copy(width, 0);
-        std::vector<uint32_t> cmap_row_copy(width, 0);
-
-        uint32_t* line = &m_data[0];
-        uint32_t* cmap_line = cmap.paddedData();
-        for (int y = 0; y < height; ++y, line += width, cmap_line += width) {
-            int q = 0;
-            s[0] = 0;
-            t[0] = 0;
-            for (int x = 1; x < width; ++x) {
-                while (q >= 0 && distSq(t[q], s[q], line[s[q]])
-                                 > distSq(t[q], x, line[x])) {
-                    --q;
-                }
-
-                if (q < 0) {
-                    q = 0;
-                    s[0] = x;
-                } else {
-                    const int x2 = s[q];
-                    if ((line[x] != INF_DIST) && (line[x2] != INF_DIST)) {
-                        int w = (x * x + line[x]) - (x2 * x2 + line[x2]);
-                        w /= (x - x2) << 1;
-                        ++w;
-                        if ((unsigned) w < (unsigned) width) {
-                            ++q;
-                            s[q] = x;
-                            t[q] = w;
-                        }
+        uint32_t* const data = &m_data[0];
+        uint32_t* const labels = cmap.paddedData();
+
+        parallelFor(0, height, rowsPerChunk(width), [&](const int first_row, const int last_row) {
+            std::vector<int> s(width, 0);
+            std::vector<int> t(width, 0);
+            std::vector<uint32_t> row_copy(width, 0);
+            std::vector<uint32_t> cmap_row_copy(width, 0);
+
+            uint32_t* line = data + first_row * width;
+            uint32_t* cmap_line = labels + first_row * width;
+            for (int y = first_row; y < last_row; ++y, line += width, cmap_line += width) {
+                const int q = buildLowerEnvelope(line, width, &s[0], &t[0]);
+
+                memcpy(&row_copy[0], line, width * sizeof(*line));
+                memcpy(&cmap_row_copy[0], cmap_line, width * sizeof(*cmap_line));
+
+                for (int x = width - 1, qq = q; x >= 0; --x) {
+                    const int x2 = s[qq];
+                    line[x] = distSq(x, x2, row_copy[x2]);
+                    cmap_line[x] = cmap_row_copy[x2];
+                    if (x == t[qq]) {
+                        --qq;
                     }
                 }
             }
+        });
+    }  // SEDM::processRows
 
-            memcpy(&row_copy[0], line, width * sizeof(*line));
-            memcpy(&cmap_row_copy[0], cmap_line, width * sizeof(*cmap_line));
+    int SEDM::buildLowerEnvelope(const uint32_t* line, const int width, int* s, int* t) {
+        int q = 0;
+        s[0] = 0;
+        t[0] = 0;
+        for (int x = 1; x < width; ++x) {
+            while (q >= 0 && distSq(t[q], s[q], line[s[q]])
+                             > distSq(t[q], x, line[x])) {
+                --q;
+            }
 
-            for (int x = width - 1; x >= 0; --x) {
+            if (q < 0) {
+                q = 0;
+                s[0] = x;
+            } else {
                 const int x2 = s[q];
-                line[x] = distSq(x, x2, row_copy[x2]);
-                cmap_line[x] = cmap_row_copy[x2];
-                if (x == t[q]) {
-                    --q;
+                if ((line[x] != INF_DIST) && (line[x2] != INF_DIST)) {
+                    int w = (x * x + line[x]) - (x2 * x2 + line[x2]);
+                    w /= (x - x2) << 1;
+                    ++w;
+                    if ((unsigned) w < (unsigned) width) {
+                        ++q;
+                        s[q] = x;
+                        t[q] = w;
+                    }
                 }
             }
         }
-    }  // SEDM::processRows
+
+        return q;
+    }
 
 /*====================== Peak finding stuff goes below ====================*/
 
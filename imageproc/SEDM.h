@@ -187,6 +187,15 @@ namespace imageproc {
 
         void processRows(ConnectivityMap& cmap);
 
+        /**
+         * Builds the lower envelope of parabolas for a row of squared distances.
+         * \p s receives the parabola vertices and \p t the points where they
+         * start to dominate.
+         *
+         * \return The index of the last parabola in the envelope.
+         */
+        static int buildLowerEnvelope(const uint32_t* line, int width, int* s, int* t);
+
         BinaryImage findPeakCandidatesNonPadded() const;
 
         BinaryImage buildEqualMapNonPadded(const uint32_t* src1, const uint32_t* src2) const;
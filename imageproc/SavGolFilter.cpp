@@ -19,6 +19,9 @@
 #include "SavGolFilter.h"
 #include "SavGolKernel.h"
 #include "Grayscale.h"
+#include "Tracer.h"
+#include "ParallelFor.h"
+#include <algorithm>
 
 namespace imageproc {
     namespace {
@@ -54,6 +57,49 @@ namespace imageproc {
             *dst = static_cast<uint8_t>(qBound(0, val, 255));
         }
 
+        /**
+         * The minimum number of rows in a band of the central area.
+         */
+        const int MIN_BAND_HEIGHT = 64;
+
+        /**
+         * dst[i] = sum(src[i + j] * kernel[j]), for i in [0, width).
+         *
+         * The loops are arranged so that the inner one walks contiguous
+         * memory and may be vectorized, while every dst[i] is still summed
+         * in the order of increasing j.
+         */
+        void convolveRow(float* const dst, const uint8_t* const src, const int width,
+                         const float* const kernel, const int kernel_size) {
+            for (int i = 0; i < width; ++i) {
+                dst[i] = 0.0f;
+            }
+            for (int j = 0; j < kernel_size; ++j) {
+                const float k = kernel[j];
+                const uint8_t* const s = src + j;
+                for (int i = 0; i < width; ++i) {
+                    dst[i] += s[i] * k;
+                }
+            }
+        }
+
+        /**
+         * dst[i] = sum(src[i + j * src_stride] * kernel[j]), for i in [0, width).
+         */
+        void convolveColumns(float* const dst, const float* const src, const int src_stride, const int width,
+                             const float* const kernel, const int kernel_size) {
+            for (int i = 0; i < width; ++i) {
+                dst[i] = 0.0f;
+            }
+            const float* s = src;
+            for (int j = 0; j < kernel_size; ++j, s += src_stride) {
+                const float k = kernel[j];
+                for (int i = 0; i < width; ++i) {
+                    dst[i] += s[i] * k;
+                }
+            }
+        }
+
         QImage savGolFilterGrayToGray(const QImage& src, const QSize& window_size, const int hor_degree,
                                       const int vert_degree) {
             const int width = src.width();
@@ -145,19 +191,6 @@ namespace imageproc {
                 k_origin.ry() += 1;
             }
             // Central area.
-#if 0
-            // Simple but slow implementation.
-                    kernel.recalcForOrigin(k_center);
-                    src_line = src_data - k_left;
-                    dst_line = dst_data + dst_bpl * k_top;
-                    for (int y = k_top; y < height - k_bottom; ++y) {
-                        for (int x = k_left; x < width - k_right; ++x) {
-                            kernel.convolve(dst_line + x, src_line + x, src_bpl);
-                        }
-                        src_line += src_bpl;
-                        dst_line += dst_bpl;
-                    }
-#else
             // Take advantage of Savitzky-Golay filter being separable.
             const SavGolKernel hor_kernel(
                     QSize(window_size.width(), 1),
@@ -168,47 +201,42 @@ namespace imageproc {
                     QPoint(0, k_center.y()), 0, vert_degree
             );
 
-            const int shift = kw - 1;
-
-            // Allocate a 16-byte aligned temporary storage.
-            // That may help the compiler to emit efficient SSE code.
-            const int temp_stride = (width - shift + 3) & ~3;
-            AlignedArray<float, 4> temp_array(temp_stride * height);
-            // Horizontal pass.
-            src_line = src_data - shift;
-            float* temp_line = temp_array.data() - shift;
-            for (int y = 0; y < height; ++y) {
-                for (int i = shift; i < width; ++i) {
-                    float sum = 0.0f;
-
-                    const uint8_t* src = src_line + i;
-                    for (int j = 0; j < kw; ++j) {
-                        sum += src[j] * hor_kernel[j];
-                    }
-                    temp_line[i] = sum;
+            // The image is split into bands of rows processed in parallel.
+            // Every band runs the horizontal pass on its own rows plus a
+            // kernel-sized halo, so it doesn't depend on other bands.
+            const int central_width = width - kw + 1;
+            const int temp_stride = (central_width + 3) & ~3;
+            const int band_height = std::max(MIN_BAND_HEIGHT, (kh - 1) * 8);
+            parallelFor(k_top, height - k_bottom, band_height, [&](const int band_top, const int band_bottom) {
+                const int num_temp_rows = band_bottom - band_top + kh - 1;
+
+                // Allocate a 16-byte aligned temporary storage plus an accumulator row.
+                // That may help the compiler to emit efficient SSE code.
+                AlignedArray<float, 4> temp_array(temp_stride * (num_temp_rows + 1));
+                float* const acc_row = temp_array.data() + temp_stride * num_temp_rows;
+
+                // Horizontal pass.
+                const uint8_t* src_row = src_data + src_bpl * (band_top - k_top);
+                float* temp_row = temp_array.data();
+                for (int y = 0; y < num_temp_rows; ++y) {
+                    convolveRow(temp_row, src_row, central_width, hor_kernel.data(), kw);
+                    temp_row += temp_stride;
+                    src_row += src_bpl;
                 }
-                temp_line += temp_stride;
-                src_line += src_bpl;
-            }
-            // Vertical pass.
-            dst_line = dst_data + k_top * dst_bpl + k_left - shift;
-            temp_line = temp_array.data() - shift;
-            for (int y = k_top; y < height - k_bottom; ++y) {
-                for (int i = shift; i < width; ++i) {
-                    float sum = 0.0f;
-
-                    float* tmp = temp_line + i;
-                    for (int j = 0; j < kh; ++j, tmp += temp_stride) {
-                        sum += *tmp * vert_kernel[j];
+
+                // Vertical pass.
+                uint8_t* dst_row = dst_data + dst_bpl * band_top + k_left;
+                temp_row = temp_array.data();
+                for (int y = band_top; y < band_bottom; ++y) {
+                    convolveColumns(acc_row, temp_row, temp_stride, central_width, vert_kernel.data(), kh);
+                    for (int i = 0; i < central_width; ++i) {
+                        const auto val = static_cast<int>(acc_row[i]);
+                        dst_row[i] = static_cast<uint8_t>(qBound(0, val, 255));
                     }
-                    const auto val = static_cast<int>(sum);
-                    dst_line[i] = static_cast<uint8_t>(qBound(0, val, 255));
+                    temp_row += temp_stride;
+                    dst_row += dst_bpl;
                 }
-
-                temp_line += temp_stride;
-                dst_line += dst_bpl;
-            }
-#endif // if 0
+            });
 
             // Left area between two corners.
             k_origin.setX(0);
@@ -285,6 +313,8 @@ namespace imageproc {
     }      // namespace
 
     QImage savGolFilter(const QImage& src, const QSize& window_size, const int hor_degree, const int vert_degree) {
+        const TraceSpan span("imageproc", "savGolFilter");
+
         if ((hor_degree < 0) || (vert_degree < 0)) {
             throw std::invalid_argument("savGolFilter: invalid polynomial degree");
         }
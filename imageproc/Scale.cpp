@@ -18,6 +18,7 @@
 
 #include "Scale.h"
 #include "GrayImage.h"
+#include "Tracer.h"
 #include <cassert>
 
 namespace imageproc {
@@ -361,6 +362,8 @@ namespace imageproc {
     }  // scaleGrayToGray
 
     GrayImage scaleToGray(const GrayImage& src, const QSize& dst_size) {
+        const TraceSpan span("imageproc", "scaleToGray");
+
         if (src.isNull()) {
             return src;
         }
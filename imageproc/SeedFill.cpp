@@ -19,6 +19,7 @@
 #include "SeedFill.h"
 #include "SeedFillGeneric.h"
 #include "GrayImage.h"
+#include "Tracer.h"
 #include <QDebug>
 
 namespace imageproc {
@@ -463,6 +464,8 @@ namespace imageproc {
     }      // namespace
 
     BinaryImage seedFill(const BinaryImage& seed, const BinaryImage& mask, const Connectivity connectivity) {
+        const TraceSpan span("imageproc", "seedFill");
+
         if (seed.size() != mask.size()) {
             throw std::invalid_argument("seedFill: seed and mask have different sizes");
         }
@@ -490,6 +493,8 @@ namespace imageproc {
     }
 
     void seedFillGrayInPlace(GrayImage& seed, const GrayImage& mask, const Connectivity connectivity) {
+        const TraceSpan span("imageproc", "seedFillGrayInPlace");
+
         if (seed.size() != mask.size()) {
             throw std::invalid_argument("seedFillGrayInPlace: seed and mask have different sizes");
         }
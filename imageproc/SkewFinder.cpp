@@ -22,6 +22,7 @@
 #include "Shear.h"
 #include "ReduceThreshold.h"
 #include "Constants.h"
+#include "Tracer.h"
 #include <cmath>
 #include <QDebug>
 
@@ -79,6 +80,8 @@ namespace imageproc {
     }
 
     Skew SkewFinder::findSkew(const BinaryImage& image) const {
+        const TraceSpan span("imageproc", "SkewFinder::findSkew");
+
         if (image.isNull()) {
             throw std::invalid_argument("SkewFinder: null image was provided");
         }
@@ -20,6 +20,7 @@
 #include "ColorMixer.h"
 #include "Transform.h"
 #include "Grayscale.h"
+#include "Tracer.h"
 #include <QDebug>
 #include <cassert>
 
@@ -325,6 +326,8 @@ namespace imageproc {
                      const QRect& dst_rect,
                      const OutsidePixels outside_pixels,
                      const QSizeF& min_mapping_area) {
+        const TraceSpan span("imageproc", "transform");
+
         if (src.isNull() || dst_rect.isEmpty()) {
             return QImage();
         }
@@ -407,6 +410,8 @@ namespace imageproc {
                               const QRect& dst_rect,
                               const OutsidePixels outside_pixels,
                               const QSizeF& min_mapping_area) {
+        const TraceSpan span("imageproc", "transformToGray");
+
         if (src.isNull() || dst_rect.isEmpty()) {
             return GrayImage();
         }
@@ -0,0 +1,209 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "GaussBlur.h"
+#include <boost/test/auto_unit_test.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+namespace imageproc {
+    namespace tests {
+        BOOST_AUTO_TEST_SUITE(GaussBlurTestSuite);
+
+            static void blur(const QSize size,
+                             const float h_sigma,
+                             const float v_sigma,
+                             const std::vector<float>& input,
+                             std::vector<float>& output) {
+                output.resize(input.size());
+                gaussBlurGeneric(
+                        size, h_sigma, v_sigma,
+                        input.data(), size.width(), [](float val) { return val; },
+                        output.data(), size.width(), [](float& dst, float val) { dst = val; }
+                );
+            }
+
+            /**
+             * The serial implementation gaussBlurGeneric() had before
+             * it was split into column blocks and parallel rows.
+             */
+            static void referenceBlur(const QSize size,
+                                      const float h_sigma,
+                                      const float v_sigma,
+                                      const std::vector<float>& input,
+                                      std::vector<float>& output) {
+                using namespace gauss_blur_impl;
+
+                const int width = size.width();
+                const int height = size.height();
+                std::vector<float> val_p(static_cast<size_t>(std::max(width, height)));
+                std::vector<float> val_m(val_p.size());
+                std::vector<float> intermediate(input.size());
+                output.resize(input.size());
+
+                float n_p[5], n_m[5], d_p[5], d_m[5], bd_p[5], bd_m[5];
+                find_iir_constants(n_p, n_m, d_p, d_m, bd_p, bd_m, v_sigma);
+                for (int x = 0; x < width; ++x) {
+                    std::fill(val_p.begin(), val_p.end(), 0.0f);
+                    std::fill(val_m.begin(), val_m.end(), 0.0f);
+
+                    const float* sp_p = input.data() + x;
+                    const float* sp_m = sp_p + (height - 1) * width;
+                    float* vp = val_p.data();
+                    float* vm = val_m.data() + height - 1;
+                    const float initial_p = sp_p[0];
+                    const float initial_m = sp_m[0];
+
+                    for (int y = 0; y < height; ++y) {
+                        const int terms = y < 4 ? y : 4;
+                        int i = 0;
+                        for (; i <= terms; ++i) {
+                            *vp += n_p[i] * sp_p[-i * width] - d_p[i] * vp[-i];
+                            *vm += n_m[i] * sp_m[i * width] - d_m[i] * vm[i];
+                        }
+                        for (; i <= 4; ++i) {
+                            *vp += (n_p[i] - bd_p[i]) * initial_p;
+                            *vm += (n_m[i] - bd_m[i]) * initial_m;
+                        }
+                        sp_p += width;
+                        sp_m -= width;
+                        ++vp;
+                        --vm;
+                    }
+
+                    for (int y = 0; y < height; ++y) {
+                        intermediate[y * width + x] = val_p[y] + val_m[y];
+                    }
+                }
+
+                find_iir_constants(n_p, n_m, d_p, d_m, bd_p, bd_m, h_sigma);
+                for (int y = 0; y < height; ++y) {
+                    std::fill(val_p.begin(), val_p.end(), 0.0f);
+                    std::fill(val_m.begin(), val_m.end(), 0.0f);
+
+                    const float* sp_p = intermediate.data() + y * width;
+                    const float* sp_m = sp_p + width - 1;
+                    float* vp = val_p.data();
+                    float* vm = val_m.data() + width - 1;
+                    const float initial_p = sp_p[0];
+                    const float initial_m = sp_m[0];
+
+                    for (int x = 0; x < width; ++x) {
+                        const int terms = x < 4 ? x : 4;
+                        int i = 0;
+                        for (; i <= terms; ++i) {
+                            *vp += n_p[i] * sp_p[-i] - d_p[i] * vp[-i];
+                            *vm += n_m[i] * sp_m[i] - d_m[i] * vm[i];
+                        }
+                        for (; i <= 4; ++i) {
+                            *vp += (n_p[i] - bd_p[i]) * initial_p;
+                            *vm += (n_m[i] - bd_m[i]) * initial_m;
+                        }
+                        ++sp_p;
+                        --sp_m;
+                        ++vp;
+                        --vm;
+                    }
+
+                    for (int x = 0; x < width; ++x) {
+                        output[y * width + x] = val_p[x] + val_m[x];
+                    }
+                }
+            }
+
+            static std::vector<float> randomGrid(const int width, const int height) {
+                std::vector<float> grid(static_cast<size_t>(width * height));
+                for (float& val : grid) {
+                    val = static_cast<float>(rand() % 256);
+                }
+
+                return grid;
+            }
+
+            BOOST_AUTO_TEST_CASE(test_constant_grid_stays_constant) {
+                // A width that is not a multiple of the column block size.
+                const QSize size(37, 29);
+                const std::vector<float> input(static_cast<size_t>(size.width() * size.height()), 100.0f);
+                std::vector<float> output;
+                blur(size, 3.0f, 5.0f, input, output);
+
+                for (const float val : output) {
+                    BOOST_REQUIRE(std::fabs(val - 100.0f) < 0.1f);
+                }
+            }
+
+            BOOST_AUTO_TEST_CASE(test_matches_serial_reference) {
+                // Sizes below, at, and above a column block, as well as
+                // ones large enough to be split across threads.
+                const QSize sizes[] = {QSize(1, 1), QSize(5, 3), QSize(16, 40), QSize(37, 29), QSize(611, 403)};
+                for (const QSize& size : sizes) {
+                    const std::vector<float> input(randomGrid(size.width(), size.height()));
+                    std::vector<float> output;
+                    std::vector<float> expected;
+                    blur(size, 3.5f, 1.5f, input, output);
+                    referenceBlur(size, 3.5f, 1.5f, input, expected);
+
+                    for (size_t i = 0; i < output.size(); ++i) {
+                        BOOST_REQUIRE(std::fabs(output[i] - expected[i]) < 0.001f);
+                    }
+                }
+            }
+
+            BOOST_AUTO_TEST_CASE(test_in_place_matches_out_of_place) {
+                const QSize size(203, 117);
+                std::vector<float> grid(randomGrid(size.width(), size.height()));
+                std::vector<float> output;
+                blur(size, 4.0f, 2.0f, grid, output);
+
+                gaussBlurGeneric(
+                        size, 4.0f, 2.0f,
+                        grid.data(), size.width(), [](float val) { return val; },
+                        grid.data(), size.width(), [](float& dst, float val) { dst = val; }
+                );
+
+                BOOST_CHECK(grid == output);
+            }
+
+            BOOST_AUTO_TEST_CASE(test_transposition_symmetry) {
+                const int width = 71;
+                const int height = 45;
+                const std::vector<float> input(randomGrid(width, height));
+                std::vector<float> transposed_input(input.size());
+                for (int y = 0; y < height; ++y) {
+                    for (int x = 0; x < width; ++x) {
+                        transposed_input[x * height + y] = input[y * width + x];
+                    }
+                }
+
+                std::vector<float> output;
+                std::vector<float> transposed_output;
+                blur(QSize(width, height), 2.0f, 6.0f, input, output);
+                blur(QSize(height, width), 6.0f, 2.0f, transposed_input, transposed_output);
+
+                for (int y = 0; y < height; ++y) {
+                    for (int x = 0; x < width; ++x) {
+                        BOOST_REQUIRE(std::fabs(output[y * width + x] - transposed_output[x * height + y]) < 0.01f);
+                    }
+                }
+            }
+
+        BOOST_AUTO_TEST_SUITE_END();
+    }  // namespace tests
+}  // namespace imageproc
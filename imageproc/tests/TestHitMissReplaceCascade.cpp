@@ -0,0 +1,183 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HitMissReplaceCascade.h"
+#include "Morphology.h"
+#include "BinaryImage.h"
+#include "BWColor.h"
+#include "Utils.h"
+#include <QRect>
+#include <boost/test/auto_unit_test.hpp>
+#include <stdexcept>
+#include <vector>
+#include <cstdlib>
+
+namespace imageproc {
+    namespace tests {
+        using namespace utils;
+
+        BOOST_AUTO_TEST_SUITE(HitMissReplaceCascadeTestSuite);
+
+            struct Pattern {
+                const char* data;
+                int width;
+                int height;
+            };
+
+            // The edge smoothing rules of output::OutputGenerator.
+            const Pattern smoothing_patterns[] = {
+                    {"XXX"
+                     " - "
+                     "   ", 3, 3},
+                    {"X ?"
+                     "X  "
+                     "X- "
+                     "X- "
+                     "X  "
+                     "X ?", 3, 6},
+                    {"X ?"
+                     "X ?"
+                     "X  "
+                     "X- "
+                     "X- "
+                     "X- "
+                     "X  "
+                     "X ?"
+                     "X ?", 3, 9},
+                    {"XX?"
+                     "XX?"
+                     "XX "
+                     "X+ "
+                     "X+ "
+                     "X+ "
+                     "XX "
+                     "XX?"
+                     "XX?", 3, 9},
+                    {"XX?"
+                     "XX "
+                     "X+ "
+                     "X+ "
+                     "XX "
+                     "XX?", 3, 6},
+                    {"   "
+                     "X+X"
+                     "XXX", 3, 3}
+            };
+
+            void hitMissReplaceAllDirections(BinaryImage& img, const Pattern& pattern) {
+                const int w = pattern.width;
+                const int h = pattern.height;
+                std::vector<char> rotated(static_cast<size_t>(w * h));
+
+                hitMissReplaceInPlace(img, WHITE, pattern.data, w, h);
+
+                for (int y = 0; y < h; ++y) {
+                    for (int x = 0; x < w; ++x) {
+                        rotated[x * h + (h - 1 - y)] = pattern.data[y * w + x];
+                    }
+                }
+                hitMissReplaceInPlace(img, WHITE, &rotated[0], h, w);
+
+                for (int y = 0; y < h; ++y) {
+                    for (int x = 0; x < w; ++x) {
+                        rotated[(h - 1 - y) * w + (w - 1 - x)] = pattern.data[y * w + x];
+                    }
+                }
+                hitMissReplaceInPlace(img, WHITE, &rotated[0], w, h);
+
+                for (int y = 0; y < h; ++y) {
+                    for (int x = 0; x < w; ++x) {
+                        rotated[(w - 1 - x) * h + y] = pattern.data[y * w + x];
+                    }
+                }
+                hitMissReplaceInPlace(img, WHITE, &rotated[0], h, w);
+            }
+
+            /**
+             * Scattered black rectangles, which trigger the smoothing rules
+             * more often than uniform noise.
+             */
+            BinaryImage randomBlobs(const int width, const int height) {
+                BinaryImage img(width, height, WHITE);
+                const int num_blobs = width * height / 30 + 1;
+                for (int i = 0; i < num_blobs; ++i) {
+                    const QRect blob(rand() % width, rand() % height, 1 + rand() % 6, 1 + rand() % 6);
+                    img.fill(blob.intersected(img.rect()), BLACK);
+                    img.fill(QRect(rand() % width, rand() % height, 1, 1), WHITE);
+                }
+
+                return img;
+            }
+
+            void checkSmoothingMatches(const BinaryImage& input, const int passes) {
+                BinaryImage expected(input);
+                HitMissReplaceCascade cascade;
+                for (int i = 0; i < passes; ++i) {
+                    for (const Pattern& pattern : smoothing_patterns) {
+                        hitMissReplaceAllDirections(expected, pattern);
+                        cascade.addRuleAllDirections(pattern.data, pattern.width, pattern.height);
+                    }
+                }
+
+                BinaryImage actual(input);
+                cascade.applyInPlace(actual);
+
+                BOOST_CHECK(actual == expected);
+            }
+
+            BOOST_AUTO_TEST_CASE(test_smoothing_small_images) {
+                const int sizes[][2] = {{1, 1}, {2, 3}, {5, 7}, {31, 40}, {32, 32}, {33, 100}};
+                for (const auto& size : sizes) {
+                    checkSmoothingMatches(randomBinaryImage(size[0], size[1]), 1);
+                    checkSmoothingMatches(randomBlobs(size[0], size[1]), 1);
+                }
+            }
+
+            BOOST_AUTO_TEST_CASE(test_smoothing_multiple_bands) {
+                checkSmoothingMatches(randomBinaryImage(100, 1100), 1);
+                checkSmoothingMatches(randomBlobs(257, 1600), 1);
+                checkSmoothingMatches(randomBlobs(40, 2000), 2);
+            }
+
+            BOOST_AUTO_TEST_CASE(test_wide_pattern) {
+                const char pattern[]
+                        = "X          X"
+                          "X+++++++++ X"
+                          "X          X";
+
+                const BinaryImage input(randomBlobs(300, 700));
+                BinaryImage expected(input);
+                hitMissReplaceInPlace(expected, WHITE, pattern, 12, 3);
+
+                HitMissReplaceCascade cascade;
+                cascade.addRule(pattern, 12, 3);
+                BinaryImage actual(input);
+                cascade.applyInPlace(actual);
+
+                BOOST_CHECK(actual == expected);
+            }
+
+            BOOST_AUTO_TEST_CASE(test_invalid_pattern) {
+                HitMissReplaceCascade cascade;
+                BOOST_CHECK_THROW(cascade.addRule("X-Y", 3, 1), std::invalid_argument);
+                BOOST_CHECK(cascade.isEmpty());
+            }
+
+        BOOST_AUTO_TEST_SUITE_END();
+    }  // namespace tests
+}  // namespace imageproc
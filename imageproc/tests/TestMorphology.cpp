@@ -217,6 +217,35 @@ namespace imageproc {
                 BOOST_CHECK(dilateGray(img, QSize(1, 20), img.rect()) == control);
             }
 
+            static GrayImage transposed(const GrayImage& src) {
+                GrayImage dst(QSize(src.height(), src.width()));
+                for (int y = 0; y < src.height(); ++y) {
+                    for (int x = 0; x < src.width(); ++x) {
+                        dst.data()[x * dst.stride() + y] = src.data()[y * src.stride() + x];
+                    }
+                }
+
+                return dst;
+            }
+
+            BOOST_AUTO_TEST_CASE(test_vertical_gray_matches_horizontal) {
+                // The vertical pass is checked against the horizontal one on a transposed image.
+                const int sizes[][2] = {{1, 1}, {7, 3}, {40, 257}, {131, 1000}};
+                const int brick_heights[] = {1, 2, 5, 20, 63};
+                for (const auto& size : sizes) {
+                    const GrayImage img(randomGrayImage(size[0], size[1]));
+                    const GrayImage img_t(transposed(img));
+                    for (const int h : brick_heights) {
+                        BOOST_CHECK(transposed(dilateGray(img, QSize(1, h), img.rect()))
+                                    == dilateGray(img_t, QSize(h, 1), img_t.rect()));
+                        BOOST_CHECK(transposed(erodeGray(img, QSize(1, h), img.rect()))
+                                    == erodeGray(img_t, QSize(h, 1), img_t.rect()));
+                        BOOST_CHECK(transposed(closeGray(img, QSize(3, h), img.rect(), 0x00))
+                                    == closeGray(img_t, QSize(h, 3), img_t.rect(), 0x00));
+                    }
+                }
+            }
+
             BOOST_AUTO_TEST_CASE(test_dilate_3x3_white) {
                 static const int inp[] = {
                         0, 0, 0, 0, 0, 0, 0, 0, 1,
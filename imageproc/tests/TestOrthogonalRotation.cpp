@@ -168,6 +168,35 @@ namespace imageproc {
                 BOOST_REQUIRE(orthogonalRotation(img, rect, -90) == out4_img);
             }
 
+            BOOST_AUTO_TEST_CASE(test_random_images) {
+                const int sizes[][2] = {{1, 1}, {31, 33}, {32, 64}, {95, 70}, {200, 37}};
+                for (const auto& size : sizes) {
+                    BinaryImage img(randomBinaryImage(size[0], size[1]));
+                    const QRect rect(img.rect().adjusted(size[0] / 3, size[1] / 4, 0, 0));
+
+                    // Checked against pixel by pixel rotation.  Note that getPixel() isn't const.
+                    BinaryImage rotated90(orthogonalRotation(img, rect, 90));
+                    BinaryImage rotated180(orthogonalRotation(img, rect, 180));
+                    BinaryImage rotated270(orthogonalRotation(img, rect, 270));
+                    BOOST_REQUIRE(rotated90.size() == rect.size().transposed());
+                    BOOST_REQUIRE(rotated180.size() == rect.size());
+                    BOOST_REQUIRE(rotated270.size() == rect.size().transposed());
+                    for (int y = 0; y < rect.height(); ++y) {
+                        for (int x = 0; x < rect.width(); ++x) {
+                            const BWColor color = img.getPixel(rect.left() + x, rect.top() + y);
+                            BOOST_REQUIRE(rotated90.getPixel(rect.height() - 1 - y, x) == color);
+                            BOOST_REQUIRE(rotated180.getPixel(rect.width() - 1 - x, rect.height() - 1 - y) == color);
+                            BOOST_REQUIRE(rotated270.getPixel(y, rect.width() - 1 - x) == color);
+                        }
+                    }
+
+                    // Compositions.
+                    BOOST_CHECK(orthogonalRotation(rotated90, 90) == rotated180);
+                    BOOST_CHECK(orthogonalRotation(rotated270, 270) == rotated180);
+                    BOOST_CHECK(orthogonalRotation(rotated180, 180) == orthogonalRotation(img, rect, 0));
+                }
+            }
+
         BOOST_AUTO_TEST_SUITE_END();
     }      // namespace tests
 }  // namespace imageproc
\ No newline at end of file
@@ -0,0 +1,213 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PolynomialSurface.h"
+#include "GrayImage.h"
+#include "GrayRasterOp.h"
+#include <QSize>
+#include <boost/test/auto_unit_test.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace imageproc {
+    namespace tests {
+        BOOST_AUTO_TEST_SUITE(PolynomialSurfaceTestSuite);
+
+            namespace {
+                /**
+                 * A polynomial in x and y, both ranging over [0, 1] across the image,
+                 * with values in [0, 1] standing for gray levels in [0, 255].
+                 */
+                class TestPolynomial {
+                public:
+                    TestPolynomial(const int hor_degree, const int vert_degree)
+                            : m_horDegree(hor_degree),
+                              m_vertDegree(vert_degree) {
+                        // Alternating signs keep the values well inside [0, 1].
+                        for (int i = 0; i <= vert_degree; ++i) {
+                            for (int j = 0; j <= hor_degree; ++j) {
+                                const double sign = ((i + j) % 2 == 0) ? 1.0 : -1.0;
+                                m_coeffs.push_back((i + j == 0) ? 0.4 : 0.3 * sign / ((i + 1) * (j + 1)));
+                            }
+                        }
+                    }
+
+                    int horDegree() const {
+                        return m_horDegree;
+                    }
+
+                    int vertDegree() const {
+                        return m_vertDegree;
+                    }
+
+                    double operator()(const double x, const double y) const {
+                        double sum = 0.0;
+                        int pos = 0;
+                        for (int i = 0; i <= m_vertDegree; ++i) {
+                            for (int j = 0; j <= m_horDegree; ++j, ++pos) {
+                                sum += m_coeffs[pos] * std::pow(x, j) * std::pow(y, i);
+                            }
+                        }
+
+                        return sum;
+                    }
+
+                private:
+                    int m_horDegree;
+                    int m_vertDegree;
+                    std::vector<double> m_coeffs;
+                };
+            }  // namespace
+
+            static double calcScale(const int dimension) {
+                return dimension <= 1 ? 0.0 : 1.0 / (dimension - 1);
+            }
+
+            /**
+             * Evaluates the polynomial at every pixel, the way the renderer
+             * did before it was made to work a row at a time.
+             */
+            static GrayImage referenceRender(const TestPolynomial& polynomial, const QSize& size) {
+                GrayImage image(size);
+                const double xscale = calcScale(size.width());
+                const double yscale = calcScale(size.height());
+                for (int y = 0; y < size.height(); ++y) {
+                    uint8_t* line = image.data() + y * image.stride();
+                    for (int x = 0; x < size.width(); ++x) {
+                        const auto value = static_cast<int>(std::floor(polynomial(x * xscale, y * yscale) * 255.0 + 0.5));
+                        line[x] = static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+                    }
+                }
+
+                return image;
+            }
+
+            static int maxDifference(const GrayImage& img1, const GrayImage& img2) {
+                int max_diff = 0;
+                for (int y = 0; y < img1.height(); ++y) {
+                    const uint8_t* line1 = img1.data() + y * img1.stride();
+                    const uint8_t* line2 = img2.data() + y * img2.stride();
+                    for (int x = 0; x < img1.width(); ++x) {
+                        max_diff = std::max(max_diff, std::abs(int(line1[x]) - int(line2[x])));
+                    }
+                }
+
+                return max_diff;
+            }
+
+            static std::vector<TestPolynomial> testPolynomials() {
+                std::vector<TestPolynomial> polynomials;
+                polynomials.emplace_back(0, 0);
+                polynomials.emplace_back(1, 1);
+                polynomials.emplace_back(2, 3);
+                polynomials.emplace_back(4, 1);
+                polynomials.emplace_back(3, 3);
+                polynomials.emplace_back(5, 5);
+
+                return polynomials;
+            }
+
+            /**
+             * Single rows and columns, widths that aren't a multiple of
+             * the vector size and heights spanning several row chunks.
+             */
+            static std::vector<QSize> testSizes() {
+                std::vector<QSize> sizes;
+                sizes.emplace_back(1, 1);
+                sizes.emplace_back(1, 70);
+                sizes.emplace_back(77, 1);
+                sizes.emplace_back(101, 67);
+                sizes.emplace_back(1237, 61);
+
+                return sizes;
+            }
+
+            static PolynomialSurface fitSurface(const TestPolynomial& polynomial) {
+                const GrayImage source(referenceRender(polynomial, QSize(151, 101)));
+
+                return PolynomialSurface(polynomial.horDegree(), polynomial.vertDegree(), source);
+            }
+
+            BOOST_AUTO_TEST_CASE(test_render_matches_reference) {
+                for (const TestPolynomial& polynomial : testPolynomials()) {
+                    const PolynomialSurface surface(fitSurface(polynomial));
+                    for (const QSize& size : testSizes()) {
+                        const GrayImage rendered(surface.render(size));
+                        BOOST_REQUIRE(rendered.size() == size);
+
+                        // The fitted surface is a close enough match for the polynomial
+                        // that rounding is the only source of differences.
+                        BOOST_CHECK_MESSAGE(
+                                maxDifference(rendered, referenceRender(polynomial, size)) <= 1,
+                                "degrees " << polynomial.horDegree() << "x" << polynomial.vertDegree()
+                                           << ", size " << size.width() << "x" << size.height()
+                        );
+                    }
+                }
+
+                BOOST_CHECK(fitSurface(TestPolynomial(1, 1)).render(QSize()).isNull());
+            }
+
+            BOOST_AUTO_TEST_CASE(test_render_rows_matches_render) {
+                for (const TestPolynomial& polynomial : testPolynomials()) {
+                    const PolynomialSurface surface(fitSurface(polynomial));
+                    for (const QSize& size : testSizes()) {
+                        GrayImage rows(size);
+                        std::vector<int> times_rendered(static_cast<size_t>(size.height()), 0);
+                        uint8_t* const data = rows.data();
+                        const int stride = rows.stride();
+                        surface.renderRows(size, [&](const int y, const uint8_t* row) {
+                            // Each row is rendered once, so the rows don't race.
+                            ++times_rendered[y];
+                            memcpy(data + y * stride, row, static_cast<size_t>(size.width()));
+                        });
+
+                        BOOST_CHECK(std::all_of(times_rendered.begin(), times_rendered.end(),
+                                                [](const int times) { return times == 1; }));
+                        BOOST_CHECK(rows == surface.render(size));
+                    }
+                }
+            }
+
+            BOOST_AUTO_TEST_CASE(test_apply_gray_raster_op) {
+                typedef GRopClippedSubtract<GRopDst, GRopSrc> Op;
+
+                const PolynomialSurface surface(fitSurface(TestPolynomial(3, 3)));
+                for (const QSize& size : testSizes()) {
+                    GrayImage image(size);
+                    for (int y = 0; y < size.height(); ++y) {
+                        uint8_t* line = image.data() + y * image.stride();
+                        for (int x = 0; x < size.width(); ++x) {
+                            line[x] = static_cast<uint8_t>((x * 7 + y * 13) & 0xff);
+                        }
+                    }
+
+                    GrayImage expected(surface.render(size));
+                    grayRasterOp<Op>(expected, image);
+
+                    surface.applyGrayRasterOp<Op>(image);
+                    BOOST_CHECK(image == expected);
+                }
+            }
+
+        BOOST_AUTO_TEST_SUITE_END();
+    }  // namespace tests
+}  // namespace imageproc
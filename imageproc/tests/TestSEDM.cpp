@@ -22,8 +22,12 @@
 #include "Utils.h"
 #include <iostream>
 #include <QImage>
+#include <QPoint>
 #include <boost/test/auto_unit_test.hpp>
 #include <cmath>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
 
 namespace imageproc {
     namespace tests {
@@ -87,6 +91,33 @@ namespace imageproc {
                 BOOST_CHECK(verifySEDM(sedm, out));
             }
 
+            BOOST_AUTO_TEST_CASE(test_matches_brute_force) {
+                // Wide and tall enough to span several column blocks and row chunks.
+                const int width = 83;
+                const int height = 900;
+                BinaryImage img(width, height, WHITE);
+                std::vector<QPoint> black_pixels;
+                for (int i = 0; i < 60; ++i) {
+                    const QPoint pt(rand() % width, rand() % height);
+                    img.setPixel(pt.x(), pt.y(), BLACK);
+                    black_pixels.push_back(pt);
+                }
+
+                const SEDM sedm(img, SEDM::DIST_TO_BLACK, SEDM::DIST_TO_NO_BORDERS);
+                const uint32_t* line = sedm.data();
+                for (int y = 0; y < height; ++y, line += sedm.stride()) {
+                    for (int x = 0; x < width; ++x) {
+                        uint32_t expected = SEDM::INF_DIST;
+                        for (const QPoint& pt : black_pixels) {
+                            const int dx = x - pt.x();
+                            const int dy = y - pt.y();
+                            expected = std::min(expected, uint32_t(dx * dx + dy * dy));
+                        }
+                        BOOST_REQUIRE_EQUAL(line[x], expected);
+                    }
+                }
+            }
+
         BOOST_AUTO_TEST_SUITE_END();
     }      // namespace tests
 }  // namespace imageproc
\ No newline at end of file
@@ -0,0 +1,109 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SavGolFilter.h"
+#include "SavGolKernel.h"
+#include "Grayscale.h"
+#include <QImage>
+#include <QPoint>
+#include <QSize>
+#include <boost/test/auto_unit_test.hpp>
+#include <cstdlib>
+#include <vector>
+
+namespace imageproc {
+    namespace tests {
+        BOOST_AUTO_TEST_SUITE(SavGolFilterTestSuite);
+
+            static QImage randomGray(const int width, const int height) {
+                QImage img(width, height, QImage::Format_Indexed8);
+                img.setColorTable(createGrayscalePalette());
+                for (int y = 0; y < height; ++y) {
+                    uint8_t* line = img.scanLine(y);
+                    for (int x = 0; x < width; ++x) {
+                        line[x] = static_cast<uint8_t>(rand() % 256);
+                    }
+                }
+
+                return img;
+            }
+
+            /**
+             * A straightforward per-pixel evaluation of the separable filter
+             * for pixels whose window fits the image.
+             */
+            static void checkCentralArea(const QImage& src, const QSize& window_size, const int hor_degree,
+                                         const int vert_degree) {
+                const QImage dst(savGolFilter(src, window_size, hor_degree, vert_degree));
+
+                const int kw = window_size.width();
+                const int kh = window_size.height();
+                const SavGolKernel hor_kernel(QSize(kw, 1), QPoint(kw / 2, 0), hor_degree, 0);
+                const SavGolKernel vert_kernel(QSize(1, kh), QPoint(0, kh / 2), 0, vert_degree);
+
+                std::vector<float> column(static_cast<size_t>(kh));
+                for (int y = kh / 2; y < src.height() - (kh - kh / 2 - 1); ++y) {
+                    for (int x = kw / 2; x < src.width() - (kw - kw / 2 - 1); ++x) {
+                        for (int j = 0; j < kh; ++j) {
+                            const uint8_t* line = src.scanLine(y - kh / 2 + j) + x - kw / 2;
+                            float sum = 0.0f;
+                            for (int i = 0; i < kw; ++i) {
+                                sum += line[i] * hor_kernel[i];
+                            }
+                            column[j] = sum;
+                        }
+
+                        float sum = 0.0f;
+                        for (int j = 0; j < kh; ++j) {
+                            sum += column[j] * vert_kernel[j];
+                        }
+                        const auto expected = static_cast<uint8_t>(qBound(0, static_cast<int>(sum), 255));
+
+                        BOOST_REQUIRE_EQUAL(int(dst.scanLine(y)[x]), int(expected));
+                    }
+                }
+            }
+
+            BOOST_AUTO_TEST_CASE(test_central_area_matches_reference) {
+                checkCentralArea(randomGray(57, 31), QSize(5, 5), 2, 2);
+                checkCentralArea(randomGray(40, 300), QSize(11, 11), 4, 4);
+                checkCentralArea(randomGray(123, 211), QSize(7, 3), 3, 1);
+                checkCentralArea(randomGray(11, 11), QSize(11, 11), 2, 2);
+            }
+
+            BOOST_AUTO_TEST_CASE(test_linear_ramp_is_preserved) {
+                QImage src(80, 150, QImage::Format_Indexed8);
+                src.setColorTable(createGrayscalePalette());
+                for (int y = 0; y < src.height(); ++y) {
+                    uint8_t* line = src.scanLine(y);
+                    for (int x = 0; x < src.width(); ++x) {
+                        line[x] = static_cast<uint8_t>(x + y);
+                    }
+                }
+
+                const QImage dst(savGolFilter(src, QSize(9, 7), 2, 2));
+                for (int y = 0; y < src.height(); ++y) {
+                    for (int x = 0; x < src.width(); ++x) {
+                        BOOST_REQUIRE(std::abs(int(dst.scanLine(y)[x]) - int(src.scanLine(y)[x])) <= 1);
+                    }
+                }
+            }
+
+        BOOST_AUTO_TEST_SUITE_END();
+    }  // namespace tests
+}  // namespace imageproc
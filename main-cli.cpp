@@ -20,8 +20,22 @@
 #include <QCoreApplication>
 #include <iostream>
 
+#include "CliClient.h"
+#include "CliDaemon.h"
 #include "CommandLine.h"
 #include "ConsoleBatch.h"
+#include "Tracer.h"
+
+static void writeTrace(const CommandLine& cli) {
+    if (!cli.hasTrace()) {
+        return;
+    }
+
+    if (!Tracer::writeChromeTrace(cli.getTraceFile())) {
+        std::cerr << "Error writing trace file " << cli.getTraceFile().toStdString() << std::endl;
+    }
+    std::cout << Tracer::summary().toStdString();
+}
 
 
 int main(int argc, char** argv) {
@@ -37,11 +51,29 @@ int main(int argc, char** argv) {
     CommandLine::set(cli);
 
     if (cli.isError()) {
+        for (const QString& error : cli.errors()) {
+            std::cout << error.toStdString() << std::endl;
+        }
         cli.printHelp();
 
         return 1;
     }
 
+    if (cli.hasDaemon()) {
+        CliDaemon daemon(cli.getDaemonSocket(), cli.hasDaemonJobs() ? cli.getDaemonJobs() : 1);
+        if (!daemon.listen()) {
+            std::cerr << daemon.errorString().toStdString() << std::endl;
+
+            return 1;
+        }
+
+        return app.exec();
+    }
+
+    if (cli.hasConnect() && cli.hasCancelJob()) {
+        return CliClient(cli.getConnectSocket()).cancel(cli.getCancelJob());
+    }
+
     if (cli.hasHelp() || cli.outputDirectory().isEmpty()
         || ((cli.images().size() == 0) && cli.projectFile().isEmpty())) {
         cli.printHelp();
@@ -49,6 +81,14 @@ int main(int argc, char** argv) {
         return 0;
     }
 
+    if (cli.hasConnect()) {
+        return CliClient(cli.getConnectSocket()).submit(cli, app.arguments());
+    }
+
+    if (cli.hasTrace()) {
+        Tracer::setEnabled(true);
+    }
+
     std::unique_ptr<ConsoleBatch> cbatch;
 
     try {
@@ -60,11 +100,15 @@ int main(int argc, char** argv) {
         cbatch->process();
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
+        // The trace of a failed run is the most interesting one.
+        writeTrace(cli);
         exit(1);
     }
 
     if (cli.hasOutputProject()) {
         cbatch->saveProject(cli.outputProjectFile());
     }
+
+    writeTrace(cli);
 } // main
 
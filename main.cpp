@@ -27,6 +27,8 @@
 #include "CommandLine.h"
 #include "ColorSchemeManager.h"
 #include "LightScheme.h"
+#include "Tracer.h"
+#include <iostream>
 
 int main(int argc, char** argv) {
     // rescaling for high DPI displays
@@ -42,6 +44,13 @@ int main(int argc, char** argv) {
     // Initialize command line in gui mode.
     CommandLine cli(app.arguments());
     CommandLine::set(cli);
+    for (const QString& error : cli.errors()) {
+        std::cout << error.toStdString() << std::endl;
+    }
+
+    if (cli.hasTrace()) {
+        Tracer::setEnabled(true);
+    }
 
     // This information is used by QSettings.
     app.setApplicationName("scantailor");
@@ -83,6 +92,12 @@ int main(int argc, char** argv) {
         main_wnd->openProject(cli.projectFile());
     }
 
-    return app.exec();
+    const int exit_code = app.exec();
+
+    if (cli.hasTrace() && !Tracer::writeChromeTrace(cli.getTraceFile())) {
+        std::cerr << "Error writing trace file " << cli.getTraceFile().toStdString() << std::endl;
+    }
+
+    return exit_code;
 } // main
 
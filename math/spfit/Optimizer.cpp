@@ -17,7 +17,7 @@
  */
 
 #include "Optimizer.h"
-#include "MatrixCalc.h"
+#include "LinearSolver.h"
 #include <boost/foreach.hpp>
 
 namespace spfit {
@@ -60,6 +60,10 @@ namespace spfit {
         VecT<double>(num_dimensions).swap(m_x);
         m_A.swap(A);
         m_b.swap(b);
+
+        // See LinearSolver::solve() for the buffer sizes.
+        m_solverTBuffer.resize(num_dimensions * (num_dimensions + 1));
+        m_solverPBuffer.resize(num_dimensions);
     } // Optimizer::setConstraints
 
     void Optimizer::addExternalForce(const QuadraticFunction& force) {
@@ -103,19 +107,27 @@ namespace spfit {
         m_internalForce += m_externalForce;
 
         // For the layout of m_A and m_b, see setConstraints()
-        const QuadraticFunction::Gradient grad(m_internalForce.gradient());
+        // The gradient is written there directly, rather than
+        // through QuadraticFunction::gradient(), to avoid allocations.
         for (size_t i = 0; i < m_numVars; ++i) {
-            m_b[i] = -grad.b[i];
+            m_b[i] = -m_internalForce.b[i];
             for (size_t j = 0; j < m_numVars; ++j) {
-                m_A(i, j) = grad.A(i, j);
+                m_A(i, j) = m_internalForce.A(i, j) + m_internalForce.A(j, i);
             }
         }
 
         const double total_force_before = m_internalForce.c;
-        DynamicMatrixCalc<double> mc;
+        const size_t num_dimensions = m_b.size();
+        if (m_solverPBuffer.size() != num_dimensions) {
+            // setConstraints() was never called.
+            m_solverTBuffer.resize(num_dimensions * (num_dimensions + 1));
+            m_solverPBuffer.resize(num_dimensions);
+        }
 
         try {
-            mc(m_A).solve(mc(m_b)).write(m_x.data());
+            LinearSolver(num_dimensions, num_dimensions, 1).solve(
+                    m_A.data(), m_x.data(), m_b.data(), m_solverTBuffer.data(), m_solverPBuffer.data()
+            );
         } catch (const std::runtime_error&) {
             m_externalForce.reset();
             m_internalForce.reset();
@@ -162,6 +174,8 @@ namespace spfit {
         m_x.swap(other.m_x);
         m_externalForce.swap(other.m_externalForce);
         m_internalForce.swap(other.m_internalForce);
+        m_solverTBuffer.swap(other.m_solverTBuffer);
+        m_solverPBuffer.swap(other.m_solverPBuffer);
         std::swap(m_numVars, other.m_numVars);
     }
 }  // namespace spfit
\ No newline at end of file
@@ -98,6 +98,13 @@ namespace spfit {
         VecT<double> m_x;
         QuadraticFunction m_externalForce;
         QuadraticFunction m_internalForce;
+
+        /**
+         * Workspaces for LinearSolver, preallocated so that
+         * optimize() doesn't allocate on every iteration.
+         */
+        std::vector<double> m_solverTBuffer;
+        std::vector<size_t> m_solverPBuffer;
     };
 
 
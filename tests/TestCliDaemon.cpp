@@ -0,0 +1,234 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CliDaemon.h"
+#include "CommandLine.h"
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalSocket>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <boost/test/auto_unit_test.hpp>
+#include <map>
+
+namespace Tests {
+    namespace {
+        /**
+         * The daemon needs an event loop, and the filters need
+         * a global command line that doesn't ask for a GUI.
+         */
+        class ApplicationFixture {
+        public:
+            ApplicationFixture()
+                    : m_app(boost::unit_test::framework::master_test_suite().argc,
+                            boost::unit_test::framework::master_test_suite().argv) {
+                CommandLine::set(CommandLine(QStringList(QCoreApplication::applicationFilePath()), false));
+            }
+
+        private:
+            QCoreApplication m_app;
+        };
+
+        /**
+         * The client side of the daemon's protocol.
+         *
+         * The daemon lives in the same thread, so waiting for it
+         * has to spin the event loop rather than block.
+         */
+        class DaemonConnection {
+        public:
+            explicit DaemonConnection(const QString& socket_name) {
+                m_socket.connectToServer(socket_name);
+                m_socket.waitForConnected(TIMEOUT_MS);
+            }
+
+            bool isConnected() const {
+                return m_socket.state() == QLocalSocket::ConnectedState;
+            }
+
+            void send(const QJsonObject& request) {
+                m_socket.write(QJsonDocument(request).toJson(QJsonDocument::Compact));
+                m_socket.write("\n");
+                m_socket.flush();
+            }
+
+            /**
+             * \brief Waits for the next message from the daemon.
+             *
+             * \return The message, or an empty object on timeout.
+             */
+            QJsonObject receive() {
+                QEventLoop loop;
+                QTimer timer;
+                timer.setSingleShot(true);
+                QObject::connect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
+                QObject::connect(&m_socket, SIGNAL(readyRead()), &loop, SLOT(quit()));
+                timer.start(TIMEOUT_MS);
+
+                while (!m_socket.canReadLine() && timer.isActive()) {
+                    loop.exec();
+                }
+                if (!m_socket.canReadLine()) {
+                    return QJsonObject();
+                }
+
+                return QJsonDocument::fromJson(m_socket.readLine()).object();
+            }
+
+        private:
+            // Generous, as a job runs a page through all the filters.
+            static const int TIMEOUT_MS = 60000;
+
+            QLocalSocket m_socket;
+        };
+    }  // namespace
+
+    BOOST_GLOBAL_FIXTURE(ApplicationFixture);
+
+    BOOST_AUTO_TEST_SUITE(CliDaemonTestSuite);
+
+        static QString socketName() {
+            return QString("scantailor-cli-tests-%1").arg(QCoreApplication::applicationPid());
+        }
+
+        /**
+         * Writes a page with a few lines of "text" to \p dir.
+         */
+        static QString createPage(const QString& dir) {
+            QImage image(400, 300, QImage::Format_RGB32);
+            image.fill(Qt::white);
+            for (int y = 60; y < 240; y += 20) {
+                for (int dy = 0; dy < 6; ++dy) {
+                    for (int x = 60; x < 340; ++x) {
+                        image.setPixel(x, y + dy, qRgb(0, 0, 0));
+                    }
+                }
+            }
+
+            const QString path(dir + "/page.png");
+
+            return image.save(path) ? path : QString();
+        }
+
+        static QJsonObject submitRequest(const QStringList& args) {
+            QJsonObject request;
+            request["command"] = QStringLiteral("submit");
+            request["args"] = QJsonArray::fromStringList(args);
+
+            return request;
+        }
+
+        static QJsonObject jobRequest(const QString& command, const int job_id) {
+            QJsonObject request;
+            request["command"] = command;
+            request["job"] = job_id;
+
+            return request;
+        }
+
+        BOOST_AUTO_TEST_CASE(test_invalid_options_dont_stop_daemon) {
+            const QTemporaryDir dir;
+            BOOST_REQUIRE(dir.isValid());
+            const QString page(createPage(dir.path()));
+            BOOST_REQUIRE(!page.isEmpty());
+
+            CliDaemon daemon(socketName(), 1);
+            BOOST_REQUIRE(daemon.listen());
+            DaemonConnection connection(socketName());
+            BOOST_REQUIRE(connection.isConnected());
+
+            // The first three used to terminate the process parsing them.
+            // The rest are options that nothing honours any more.
+            const char* const invalid_options[] = {
+                    "--orientation=sideways", "--content-box=1x2", "--page-detection-box=wide",
+                    "--skew-deviation=2", "--content-deviation=2", "--page-borders=1"
+            };
+            for (const char* option : invalid_options) {
+                connection.send(submitRequest(QStringList() << option << page << dir.path()));
+                const QJsonObject reply(connection.receive());
+                BOOST_CHECK(reply.value("event").toString() == "error");
+
+                // The client is told what was wrong.
+                const QString name(QString(option).section('=', 0, 0).mid(2));
+                BOOST_CHECK(reply.value("error").toString().contains(name));
+            }
+
+            // Still there, and no job ids were used up.
+            connection.send(submitRequest(QStringList() << page << dir.path()));
+            const QJsonObject reply(connection.receive());
+            BOOST_CHECK(reply.value("event").toString() == "queued");
+            BOOST_CHECK_EQUAL(reply.value("job").toInt(), 1);
+        }
+
+        BOOST_AUTO_TEST_CASE(test_submit_and_cancel) {
+            const QTemporaryDir dir;
+            BOOST_REQUIRE(dir.isValid());
+            const QString page(createPage(dir.path()));
+            BOOST_REQUIRE(!page.isEmpty());
+
+            CliDaemon daemon(socketName(), 1);
+            BOOST_REQUIRE(daemon.listen());
+            DaemonConnection connection(socketName());
+            BOOST_REQUIRE(connection.isConnected());
+
+            // With one job at a time, the second job waits for the first
+            // one and gets cancelled before it starts.
+            connection.send(submitRequest(QStringList() << page << dir.path()));
+            connection.send(submitRequest(QStringList() << page << dir.path()));
+            connection.send(jobRequest("cancel", 2));
+
+            QJsonObject reply(connection.receive());
+            BOOST_CHECK(reply.value("event").toString() == "queued");
+            BOOST_CHECK_EQUAL(reply.value("job").toInt(), 1);
+
+            reply = connection.receive();
+            BOOST_CHECK(reply.value("event").toString() == "queued");
+            BOOST_CHECK_EQUAL(reply.value("job").toInt(), 2);
+
+            reply = connection.receive();
+            BOOST_CHECK(reply.value("event").toString() == "status");
+            BOOST_CHECK_EQUAL(reply.value("job").toInt(), 2);
+            BOOST_CHECK(reply.value("state").toString() == "queued");
+
+            std::map<int, QString> finished;
+            while (finished.size() < 2) {
+                reply = connection.receive();
+                BOOST_REQUIRE(!reply.isEmpty());
+
+                const QString event(reply.value("event").toString());
+                if (event == "finished") {
+                    finished[reply.value("job").toInt()] = reply.value("state").toString();
+                } else {
+                    BOOST_CHECK(event == "progress");
+                    BOOST_CHECK_EQUAL(reply.value("job").toInt(), 1);
+                }
+            }
+            BOOST_CHECK(finished[1] == "done");
+            BOOST_CHECK(finished[2] == "cancelled");
+
+            connection.send(jobRequest("status", 2));
+            reply = connection.receive();
+            BOOST_CHECK(reply.value("state").toString() == "cancelled");
+        }
+
+    BOOST_AUTO_TEST_SUITE_END();
+}  // namespace Tests
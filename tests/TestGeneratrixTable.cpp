@@ -0,0 +1,102 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dewarping/GeneratrixTable.h"
+#include <QPointF>
+#include <QRectF>
+#include <boost/test/auto_unit_test.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace Tests {
+    using namespace dewarping;
+
+    BOOST_AUTO_TEST_SUITE(GeneratrixTableTestSuite);
+
+        /**
+         * The top and bottom edges of a page of a book, bulging towards the spine.
+         */
+        static std::vector<QPointF> directrix(const double y, const double bulge) {
+            std::vector<QPointF> polyline;
+            for (int x = 100; x <= 1100; x += 10) {
+                const double t = (x - 100) / 1000.0;
+                polyline.emplace_back(x, y + bulge * std::sin(t * 3.14159265358979));
+            }
+
+            return polyline;
+        }
+
+        static double distance(const QPointF& p1, const QPointF& p2) {
+            return std::sqrt((p1.x() - p2.x()) * (p1.x() - p2.x()) + (p1.y() - p2.y()) * (p1.y() - p2.y()));
+        }
+
+        BOOST_AUTO_TEST_CASE(test_interpolation_matches_dewarper) {
+            const CylindricalSurfaceDewarper dewarper(directrix(200, -60), directrix(1600, 40), 2.0);
+            const int num_columns = 1000;
+            const GeneratrixTable table(dewarper, QRectF(0, 0, num_columns, 1400), num_columns);
+            BOOST_REQUIRE_EQUAL(table.numColumns(), num_columns);
+
+            double max_on_column_error = 0.0;
+            double max_off_column_error = 0.0;
+            for (int column = 0; column < num_columns; column += 7) {
+                for (int i = 0; i <= 8; ++i) {
+                    const double crv_y = i / 8.0;
+
+                    const QPointF on_column(double(column) / num_columns, crv_y);
+                    max_on_column_error = std::max(
+                            max_on_column_error,
+                            distance(table.mapToWarpedSpace(on_column), dewarper.mapToWarpedSpace(on_column))
+                    );
+
+                    // Halfway between columns is where linear interpolation is least accurate.
+                    const QPointF off_column((column + 0.5) / num_columns, crv_y);
+                    max_off_column_error = std::max(
+                            max_off_column_error,
+                            distance(table.mapToWarpedSpace(off_column), dewarper.mapToWarpedSpace(off_column))
+                    );
+                }
+            }
+
+            BOOST_CHECK_SMALL(max_on_column_error, 1e-6);
+            // Way below the precision of rasterization and of zone editing.
+            BOOST_CHECK_SMALL(max_off_column_error, 0.01);
+        }
+
+        BOOST_AUTO_TEST_CASE(test_points_outside_of_table_are_exact) {
+            const CylindricalSurfaceDewarper dewarper(directrix(200, -60), directrix(1600, 40), 2.0);
+            const GeneratrixTable table(dewarper, QRectF(0, 0, 100, 1400), 100);
+
+            const QPointF points[] = {QPointF(-0.25, 0.5), QPointF(1.5, 0.3)};
+            for (const QPointF& pt : points) {
+                BOOST_CHECK_SMALL(distance(table.mapToWarpedSpace(pt), dewarper.mapToWarpedSpace(pt)), 1e-9);
+            }
+        }
+
+        BOOST_AUTO_TEST_CASE(test_empty_table_is_exact) {
+            const CylindricalSurfaceDewarper dewarper(directrix(200, -60), directrix(1600, 40), 2.0);
+            const GeneratrixTable table(dewarper);
+
+            for (int i = 0; i <= 10; ++i) {
+                const QPointF pt(i / 10.0 + 0.033, 0.1 * i);
+                BOOST_CHECK_SMALL(distance(table.mapToWarpedSpace(pt), dewarper.mapToWarpedSpace(pt)), 1e-9);
+            }
+        }
+
+    BOOST_AUTO_TEST_SUITE_END();
+}  // namespace Tests
@@ -0,0 +1,280 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "JpegReader.h"
+#include "TiffReader.h"
+#include "ImageMetadata.h"
+#include "Dpm.h"
+#include "VirtualFunction.h"
+#include <QBuffer>
+#include <QByteArray>
+#include <QFile>
+#include <QImage>
+#include <QTemporaryDir>
+#include <boost/test/auto_unit_test.hpp>
+#include <vector>
+#include <tiffio.h>
+
+extern "C" {
+#include <jpeglib.h>
+}
+
+namespace Tests {
+    BOOST_AUTO_TEST_SUITE(ImageReadersTestSuite);
+
+        namespace {
+            class JpegBufferDestination : public jpeg_destination_mgr {
+            public:
+                explicit JpegBufferDestination(QByteArray& data)
+                        : jpeg_destination_mgr(), m_rData(data) {
+                    init_destination = &JpegBufferDestination::initDestination;
+                    empty_output_buffer = &JpegBufferDestination::emptyOutputBuffer;
+                    term_destination = &JpegBufferDestination::termDestination;
+                }
+
+            private:
+                static JpegBufferDestination* object(j_compress_ptr cinfo) {
+                    return static_cast<JpegBufferDestination*>(cinfo->dest);
+                }
+
+                static void initDestination(j_compress_ptr cinfo) {
+                    JpegBufferDestination* self = object(cinfo);
+                    self->next_output_byte = self->m_buf;
+                    self->free_in_buffer = sizeof(self->m_buf);
+                }
+
+                static boolean emptyOutputBuffer(j_compress_ptr cinfo) {
+                    JpegBufferDestination* self = object(cinfo);
+                    self->m_rData.append((const char*) self->m_buf, sizeof(self->m_buf));
+                    initDestination(cinfo);
+
+                    return 1;
+                }
+
+                static void termDestination(j_compress_ptr cinfo) {
+                    JpegBufferDestination* self = object(cinfo);
+                    self->m_rData.append((const char*) self->m_buf, int(sizeof(self->m_buf) - self->free_in_buffer));
+                }
+
+                QByteArray& m_rData;
+                JOCTET m_buf[4096];
+            };
+        }  // namespace
+
+        /**
+         * Encodes a gradient, either grayscale or RGB, at 300 DPI.
+         */
+        static QByteArray encodeJpeg(const int width, const int height, const bool grayscale) {
+            QByteArray data;
+            jpeg_error_mgr err_mgr;
+            jpeg_compress_struct cinfo;
+            cinfo.err = jpeg_std_error(&err_mgr);
+            jpeg_create_compress(&cinfo);
+            JpegBufferDestination dest(data);
+            cinfo.dest = &dest;
+
+            cinfo.image_width = width;
+            cinfo.image_height = height;
+            cinfo.input_components = grayscale ? 1 : 3;
+            cinfo.in_color_space = grayscale ? JCS_GRAYSCALE : JCS_RGB;
+            jpeg_set_defaults(&cinfo);
+            cinfo.density_unit = 1;
+            cinfo.X_density = 300;
+            cinfo.Y_density = 300;
+
+            jpeg_start_compress(&cinfo, 1);
+            std::vector<JSAMPLE> line(width * cinfo.input_components);
+            while (cinfo.next_scanline < cinfo.image_height) {
+                for (size_t i = 0; i < line.size(); ++i) {
+                    line[i] = static_cast<JSAMPLE>((i + cinfo.next_scanline) & 0xff);
+                }
+                JSAMPROW row = line.data();
+                jpeg_write_scanlines(&cinfo, &row, 1);
+            }
+            jpeg_finish_compress(&cinfo);
+            jpeg_destroy_compress(&cinfo);
+
+            return data;
+        }
+
+        static QImage readJpeg(QByteArray data, const QSize& max_size) {
+            QBuffer buffer(&data);
+            buffer.open(QIODevice::ReadOnly);
+
+            return JpegReader::readImage(buffer, max_size);
+        }
+
+        static bool readJpegMetadata(QByteArray data) {
+            QBuffer buffer(&data);
+            buffer.open(QIODevice::ReadOnly);
+            auto discard = [](const ImageMetadata&) {
+            };
+            ProxyFunction1<decltype(discard), void, const ImageMetadata&> out(discard);
+
+            return JpegReader::readMetadata(buffer, out) == ImageMetadataLoader::LOADED;
+        }
+
+        BOOST_AUTO_TEST_CASE(test_jpeg_reduced_resolution) {
+            const Dpm full_dpm(Dpi(300, 300));
+            for (const bool grayscale : {true, false}) {
+                const QByteArray data(encodeJpeg(400, 300, grayscale));
+
+                const QImage full(readJpeg(data, QSize()));
+                BOOST_REQUIRE(!full.isNull());
+                BOOST_CHECK(full.size() == QSize(400, 300));
+                BOOST_CHECK_EQUAL(full.dotsPerMeterX(), full_dpm.horizontal());
+                BOOST_CHECK(full.format() == (grayscale ? QImage::Format_Indexed8 : QImage::Format_RGB32));
+
+                // 1/4 is the largest reduction that still covers 60x45.
+                const QImage reduced(readJpeg(data, QSize(60, 60)));
+                BOOST_REQUIRE(!reduced.isNull());
+                BOOST_CHECK(reduced.size() == QSize(100, 75));
+                BOOST_CHECK_EQUAL(reduced.dotsPerMeterX(), qRound(full_dpm.horizontal() / 4.0));
+                BOOST_CHECK_EQUAL(reduced.dotsPerMeterY(), qRound(full_dpm.vertical() / 4.0));
+
+                // Never smaller than requested.
+                const QImage exact(readJpeg(data, QSize(200, 150)));
+                BOOST_CHECK(exact.size() == QSize(200, 150));
+                const QImage larger(readJpeg(data, QSize(201, 151)));
+                BOOST_CHECK(larger.size() == QSize(400, 300));
+            }
+        }
+
+        BOOST_AUTO_TEST_CASE(test_corrupt_jpeg) {
+            const QByteArray valid(encodeJpeg(64, 48, false));
+            BOOST_REQUIRE(readJpegMetadata(valid));
+
+            // A JPEG signature followed by garbage fails in jpeg_read_header().
+            QByteArray garbage("\xff\xd8\xff");
+            garbage.append(QByteArray(256, '\x5a'));
+            BOOST_CHECK(readJpeg(garbage, QSize()).isNull());
+            BOOST_CHECK(!readJpegMetadata(garbage));
+
+            // Truncated before the image data: no image to start decompressing.
+            const QByteArray truncated(valid.left(valid.indexOf("\xff\xda")));
+            BOOST_CHECK(readJpeg(truncated, QSize()).isNull());
+            BOOST_CHECK(!readJpegMetadata(truncated));
+
+            // Every error unwinds through the same path, so repeating it
+            // shouldn't leave anything behind.
+            for (int i = 0; i < 100; ++i) {
+                BOOST_CHECK(readJpeg(garbage, QSize(10, 10)).isNull());
+            }
+
+            // The decoder is still usable afterwards.
+            BOOST_CHECK(readJpeg(valid, QSize()).size() == QSize(64, 48));
+        }
+
+        /**
+         * Writes a grayscale TIFF filled with 10, with a half and
+         * a quarter resolution subimage filled with 100 and 200.
+         */
+        static bool writeTiffWithSubImages(const QString& path) {
+            TIFF* tif = TIFFOpen(QFile::encodeName(path).constData(), "w");
+            if (!tif) {
+                return false;
+            }
+
+            const int levels[] = {1, 2, 4};
+            const int fills[] = {10, 100, 200};
+            for (int i = 0; i < 3; ++i) {
+                const int width = 400 / levels[i];
+                const int height = 300 / levels[i];
+                if (i == 0) {
+                    // The next two directories become SubIFDs of this one.
+                    toff_t subifds[2] = {0, 0};
+                    TIFFSetField(tif, TIFFTAG_SUBIFD, 2, subifds);
+                } else {
+                    TIFFSetField(tif, TIFFTAG_SUBFILETYPE, FILETYPE_REDUCEDIMAGE);
+                }
+                TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, width);
+                TIFFSetField(tif, TIFFTAG_IMAGELENGTH, height);
+                TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, 8);
+                TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, 1);
+                TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+                TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+                TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, height);
+                TIFFSetField(tif, TIFFTAG_RESOLUTIONUNIT, RESUNIT_INCH);
+                TIFFSetField(tif, TIFFTAG_XRESOLUTION, 300.0f / levels[i]);
+                TIFFSetField(tif, TIFFTAG_YRESOLUTION, 300.0f / levels[i]);
+
+                std::vector<unsigned char> line(width, static_cast<unsigned char>(fills[i]));
+                for (int y = 0; y < height; ++y) {
+                    if (TIFFWriteScanline(tif, line.data(), y, 0) < 0) {
+                        TIFFClose(tif);
+                        return false;
+                    }
+                }
+                if (!TIFFWriteDirectory(tif)) {
+                    TIFFClose(tif);
+                    return false;
+                }
+            }
+
+            TIFFClose(tif);
+
+            return true;
+        }
+
+        static QImage readTiff(const QString& path, const QSize& max_size) {
+            QFile file(path);
+            if (!file.open(QIODevice::ReadOnly)) {
+                return QImage();
+            }
+
+            return TiffReader::readImage(file, 0, max_size);
+        }
+
+        BOOST_AUTO_TEST_CASE(test_tiff_reduced_resolution) {
+            const QTemporaryDir dir;
+            BOOST_REQUIRE(dir.isValid());
+            const QString path(dir.path() + "/subimages.tif");
+            BOOST_REQUIRE(writeTiffWithSubImages(path));
+
+            const QImage full(readTiff(path, QSize()));
+            BOOST_REQUIRE(!full.isNull());
+            BOOST_CHECK(full.size() == QSize(400, 300));
+            BOOST_CHECK_EQUAL(qGray(full.pixel(0, 0)), 10);
+
+            // The smallest subimage that covers the requested size wins.
+            const QImage quarter(readTiff(path, QSize(60, 60)));
+            BOOST_REQUIRE(!quarter.isNull());
+            BOOST_CHECK(quarter.size() == QSize(100, 75));
+            BOOST_CHECK_EQUAL(qGray(quarter.pixel(0, 0)), 200);
+
+            const QImage half(readTiff(path, QSize(150, 150)));
+            BOOST_REQUIRE(!half.isNull());
+            BOOST_CHECK(half.size() == QSize(200, 150));
+            BOOST_CHECK_EQUAL(qGray(half.pixel(0, 0)), 100);
+            // The resolution is that of the full image, scaled down.
+            BOOST_CHECK_EQUAL(half.dotsPerMeterX(), qRound(Dpm(Dpi(300, 300)).horizontal() / 2.0));
+
+            const QImage too_large(readTiff(path, QSize(401, 301)));
+            BOOST_CHECK(too_large.size() == QSize(400, 300));
+        }
+
+        BOOST_AUTO_TEST_CASE(test_corrupt_tiff) {
+            QByteArray data("II*\0", 4);
+            data.append(QByteArray(256, '\xee'));
+            QBuffer buffer(&data);
+            buffer.open(QIODevice::ReadOnly);
+            BOOST_CHECK(TiffReader::readImage(buffer, 0, QSize(10, 10)).isNull());
+        }
+
+    BOOST_AUTO_TEST_SUITE_END();
+}  // namespace Tests
@@ -0,0 +1,189 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "filters/page_split/Settings.h"
+#include <QLineF>
+#include <QRectF>
+#include <boost/test/auto_unit_test.hpp>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace Tests {
+    using namespace page_split;
+
+    BOOST_AUTO_TEST_SUITE(PageSplitSettingsTestSuite);
+
+        static Params twoPagesParams() {
+            const PageLayout layout(QRectF(0, 0, 100, 100), QLineF(50, 0, 50, 100));
+
+            return Params(layout, Dependencies(), MODE_AUTO);
+        }
+
+        static Settings::UpdateAction setParams(const Params& params) {
+            Settings::UpdateAction action;
+            action.setParams(params);
+
+            return action;
+        }
+
+        static Settings::UpdateAction setLayoutType(const LayoutType layout_type) {
+            Settings::UpdateAction action;
+            action.setLayoutType(layout_type);
+
+            return action;
+        }
+
+        BOOST_AUTO_TEST_CASE(test_update_clears_conflicting_params) {
+            Settings settings;
+            const ImageId image_id("page.png");
+
+            settings.updatePage(image_id, setParams(twoPagesParams()));
+            BOOST_REQUIRE(settings.getPageRecord(image_id).params());
+
+            // Compatible with the params, so they stay.
+            settings.updatePage(image_id, setLayoutType(TWO_PAGES));
+            Settings::Record record(settings.getPageRecord(image_id));
+            BOOST_CHECK(record.params());
+            BOOST_REQUIRE(record.layoutType());
+            BOOST_CHECK_EQUAL(*record.layoutType(), TWO_PAGES);
+
+            // Conflicts with the params, so they go.
+            settings.updatePage(image_id, setLayoutType(SINGLE_PAGE_UNCUT));
+            record = settings.getPageRecord(image_id);
+            BOOST_CHECK(!record.params());
+            BOOST_REQUIRE(record.layoutType());
+            BOOST_CHECK_EQUAL(*record.layoutType(), SINGLE_PAGE_UNCUT);
+        }
+
+        BOOST_AUTO_TEST_CASE(test_conditional_update_leaves_conflicts_alone) {
+            Settings settings;
+            const ImageId image_id("page.png");
+            settings.updatePage(image_id, setParams(twoPagesParams()));
+
+            bool conflict = false;
+            Settings::Record record(
+                    settings.conditionalUpdate(image_id, setLayoutType(SINGLE_PAGE_UNCUT), &conflict)
+            );
+            BOOST_CHECK(conflict);
+            BOOST_CHECK(record.params());
+            BOOST_CHECK(!record.layoutType());
+
+            record = settings.getPageRecord(image_id);
+            BOOST_CHECK(record.params());
+            BOOST_CHECK(!record.layoutType());
+
+            record = settings.conditionalUpdate(image_id, setLayoutType(TWO_PAGES), &conflict);
+            BOOST_CHECK(!conflict);
+            BOOST_CHECK(record.params());
+            BOOST_REQUIRE(record.layoutType());
+            BOOST_CHECK_EQUAL(*record.layoutType(), TWO_PAGES);
+
+            // A page without a record gets no record from a conflicting update.
+            const ImageId other_image_id("other.png");
+            Settings::UpdateAction action(setParams(twoPagesParams()));
+            action.setLayoutType(SINGLE_PAGE_UNCUT);
+            record = settings.conditionalUpdate(other_image_id, action, &conflict);
+            BOOST_CHECK(conflict);
+            BOOST_CHECK(record.isNull());
+            BOOST_CHECK(settings.getPageRecord(other_image_id).isNull());
+        }
+
+        BOOST_AUTO_TEST_CASE(test_null_records) {
+            Settings settings;
+            const ImageId image_id("page.png");
+
+            settings.updatePage(image_id, setLayoutType(TWO_PAGES));
+            BOOST_CHECK(!settings.getPageRecord(image_id).isNull());
+
+            Settings::UpdateAction clear;
+            clear.clearLayoutType();
+            settings.updatePage(image_id, clear);
+            BOOST_CHECK(settings.getPageRecord(image_id).isNull());
+
+            settings.updatePage(image_id, setParams(twoPagesParams()));
+            clear.clearParams();
+            bool conflict = true;
+            const Settings::Record record(settings.conditionalUpdate(image_id, clear, &conflict));
+            BOOST_CHECK(!conflict);
+            BOOST_CHECK(record.isNull());
+            BOOST_CHECK(settings.getPageRecord(image_id).isNull());
+        }
+
+        BOOST_AUTO_TEST_CASE(test_default_layout_type) {
+            Settings settings;
+            const ImageId with_params("with-params.png");
+            const ImageId with_layout_type("with-layout-type.png");
+            const ImageId unknown("unknown.png");
+
+            settings.updatePage(with_params, setParams(twoPagesParams()));
+            settings.updatePage(with_layout_type, setLayoutType(PAGE_PLUS_OFFCUT));
+            BOOST_CHECK_EQUAL(settings.getPageRecord(unknown).combinedLayoutType(), AUTO_LAYOUT_TYPE);
+
+            // Explicit layout types give way to the new default,
+            // and so do params that conflict with it.
+            settings.setLayoutTypeForAllPages(SINGLE_PAGE_UNCUT);
+            BOOST_CHECK_EQUAL(settings.defaultLayoutType(), SINGLE_PAGE_UNCUT);
+            BOOST_CHECK(settings.getPageRecord(with_params).isNull());
+            BOOST_CHECK(settings.getPageRecord(with_layout_type).isNull());
+            BOOST_CHECK_EQUAL(settings.getPageRecord(with_layout_type).combinedLayoutType(), SINGLE_PAGE_UNCUT);
+            BOOST_CHECK_EQUAL(settings.getPageRecord(unknown).combinedLayoutType(), SINGLE_PAGE_UNCUT);
+
+            // Params that don't conflict are kept.
+            settings.setLayoutTypeForAllPages(AUTO_LAYOUT_TYPE);
+            settings.updatePage(with_params, setParams(twoPagesParams()));
+            settings.setLayoutTypeForAllPages(TWO_PAGES);
+            BOOST_CHECK(settings.getPageRecord(with_params).params());
+        }
+
+        BOOST_AUTO_TEST_CASE(test_update_many_pages) {
+            Settings settings;
+            const ImageId first("first.png");
+            const ImageId second("second.png");
+
+            // Later updates see the results of earlier ones,
+            // even for the same page.
+            std::vector<std::pair<ImageId, Settings::UpdateAction>> updates;
+            updates.emplace_back(first, setParams(twoPagesParams()));
+            updates.emplace_back(second, setParams(twoPagesParams()));
+            updates.emplace_back(first, setLayoutType(SINGLE_PAGE_UNCUT));
+            settings.updatePages(updates);
+
+            Settings::Record record(settings.getPageRecord(first));
+            BOOST_CHECK(!record.params());
+            BOOST_REQUIRE(record.layoutType());
+            BOOST_CHECK_EQUAL(*record.layoutType(), SINGLE_PAGE_UNCUT);
+            BOOST_CHECK(settings.getPageRecord(second).params());
+
+            std::set<PageId> pages;
+            pages.insert(PageId(first, PageId::LEFT_PAGE));
+            pages.insert(PageId(first, PageId::RIGHT_PAGE));
+            pages.insert(PageId(second));
+            settings.setLayoutTypeFor(TWO_PAGES, pages);
+
+            record = settings.getPageRecord(first);
+            BOOST_REQUIRE(record.layoutType());
+            BOOST_CHECK_EQUAL(*record.layoutType(), TWO_PAGES);
+            record = settings.getPageRecord(second);
+            BOOST_CHECK(record.params());
+            BOOST_REQUIRE(record.layoutType());
+            BOOST_CHECK_EQUAL(*record.layoutType(), TWO_PAGES);
+        }
+
+    BOOST_AUTO_TEST_SUITE_END();
+}  // namespace Tests
@@ -19,6 +19,9 @@
 #include "SmartFilenameOrdering.h"
 #include <QFileInfo>
 #include <QString>
+#include <algorithm>
+#include <utility>
+#include <vector>
 #include <boost/test/auto_unit_test.hpp>
 
 namespace Tests {
@@ -70,5 +73,126 @@ namespace Tests {
             BOOST_CHECK(less(rhs, lhs));
         }
 
+        /**
+         * The character-by-character comparison SmartFilenameOrdering
+         * used before comparison keys were introduced.
+         */
+        static bool referenceLess(const QFileInfo& lhs, const QFileInfo& rhs) {
+            if (int comp = lhs.absolutePath().compare(rhs.absolutePath())) {
+                return comp < 0;
+            }
+
+            const QString lhs_fname(lhs.fileName());
+            const QString rhs_fname(rhs.fileName());
+            const QChar* lhs_ptr = lhs_fname.constData();
+            const QChar* rhs_ptr = rhs_fname.constData();
+            while (!lhs_ptr->isNull() && !rhs_ptr->isNull()) {
+                const bool lhs_is_digit = lhs_ptr->isDigit();
+                const bool rhs_is_digit = rhs_ptr->isDigit();
+                if (lhs_is_digit != rhs_is_digit) {
+                    return lhs_is_digit;
+                }
+
+                if (lhs_is_digit && rhs_is_digit) {
+                    unsigned long lhs_number = 0;
+                    do {
+                        lhs_number = lhs_number * 10 + lhs_ptr->digitValue();
+                        ++lhs_ptr;
+                    } while (lhs_ptr->isDigit());
+
+                    unsigned long rhs_number = 0;
+                    do {
+                        rhs_number = rhs_number * 10 + rhs_ptr->digitValue();
+                        ++rhs_ptr;
+                    } while (rhs_ptr->isDigit());
+
+                    if (lhs_number != rhs_number) {
+                        return lhs_number < rhs_number;
+                    } else {
+                        continue;
+                    }
+                }
+
+                ++lhs_ptr;
+                ++rhs_ptr;
+            }
+
+            if (!lhs_ptr->isNull() || !rhs_ptr->isNull()) {
+                return lhs_ptr->isNull();
+            }
+
+            return lhs_fname < rhs_fname;
+        }
+
+        /**
+         * Numeric runs, leading zeros, and names that only differ
+         * in case or extension, in their expected order.
+         */
+        static const char* const sorted_paths[] = {
+                "/a/page99.tif",
+                "/scans/9",
+                "/scans/10",
+                "/scans/A",
+                "/scans/a",
+                "/scans/page01_9.tif",
+                "/scans/page1_9.tif",
+                "/scans/page1_10.tif",
+                "/scans/page9",
+                "/scans/Page9.tif",
+                "/scans/page9.TIF",
+                "/scans/page9.png",
+                "/scans/page9.tif",
+                "/scans/page09b.tif",
+                "/scans/page9a.tif",
+                "/scans/page0010.tif",
+                "/scans/page010.tif",
+                "/scans/page10.tif",
+                "/scans/page.tif"
+        };
+
+        BOOST_AUTO_TEST_CASE(test_matches_reference) {
+            const SmartFilenameOrdering less;
+            for (const char* lhs_path : sorted_paths) {
+                const QFileInfo lhs(lhs_path);
+                for (const char* rhs_path : sorted_paths) {
+                    const QFileInfo rhs(rhs_path);
+                    BOOST_CHECK_MESSAGE(
+                            less(lhs, rhs) == referenceLess(lhs, rhs),
+                            lhs_path << " vs " << rhs_path
+                    );
+                }
+            }
+        }
+
+        BOOST_AUTO_TEST_CASE(test_expected_order) {
+            // Start from the reverse order, so that the sort has to move everything.
+            std::vector<QFileInfo> files;
+            for (const char* path : sorted_paths) {
+                files.insert(files.begin(), QFileInfo(path));
+            }
+            std::sort(files.begin(), files.end(), SmartFilenameOrdering());
+
+            std::vector<std::pair<SmartFilenameOrdering::Key, QString>> keyed;
+            for (const char* path : sorted_paths) {
+                const QFileInfo file(path);
+                keyed.insert(keyed.begin(), std::make_pair(SmartFilenameOrdering::key(file), file.filePath()));
+            }
+            std::sort(
+                    keyed.begin(), keyed.end(),
+                    [](const std::pair<SmartFilenameOrdering::Key, QString>& lhs,
+                       const std::pair<SmartFilenameOrdering::Key, QString>& rhs) {
+                        return lhs.first < rhs.first;
+                    }
+            );
+
+            const size_t num_paths = sizeof(sorted_paths) / sizeof(sorted_paths[0]);
+            BOOST_REQUIRE_EQUAL(files.size(), num_paths);
+            BOOST_REQUIRE_EQUAL(keyed.size(), num_paths);
+            for (size_t i = 0; i < num_paths; ++i) {
+                BOOST_CHECK_MESSAGE(files[i].filePath() == sorted_paths[i], "predicate, position " << i);
+                BOOST_CHECK_MESSAGE(keyed[i].second == sorted_paths[i], "keys, position " << i);
+            }
+        }
+
     BOOST_AUTO_TEST_SUITE_END();
 }  // namespace Tests
\ No newline at end of file
@@ -0,0 +1,181 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SnapshotMap.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/test/auto_unit_test.hpp>
+
+namespace Tests {
+    BOOST_AUTO_TEST_SUITE(SnapshotMapTestSuite);
+
+        BOOST_AUTO_TEST_CASE(test_set_find_erase) {
+            SnapshotMap<int, std::string> map;
+            BOOST_CHECK(!map.find(1));
+            BOOST_CHECK(!map.contains(1));
+
+            map.set(1, "one");
+            map.set(2, "two");
+            map.set(1, "uno");
+            BOOST_REQUIRE(map.find(1));
+            BOOST_CHECK_EQUAL(*map.find(1), "uno");
+            BOOST_CHECK_EQUAL(*map.find(2), "two");
+
+            map.erase(1);
+            map.erase(3);
+            BOOST_CHECK(!map.contains(1));
+            BOOST_CHECK(map.contains(2));
+
+            map.clear();
+            BOOST_CHECK(!map.contains(2));
+        }
+
+        BOOST_AUTO_TEST_CASE(test_values_outlive_writes) {
+            SnapshotMap<int, std::string> map;
+            map.set(7, "before");
+
+            const std::shared_ptr<const std::string> value(map.find(7));
+            map.set(7, "after");
+            map.erase(7);
+            map.clear();
+
+            BOOST_CHECK_EQUAL(*value, "before");
+        }
+
+        BOOST_AUTO_TEST_CASE(test_assign_and_for_each) {
+            SnapshotMap<int, int>::Map source;
+            for (int i = 0; i < 1000; ++i) {
+                source.emplace(i, i * i);
+            }
+
+            SnapshotMap<int, int> map;
+            map.set(-1, 0);
+            map.assign(source);
+            BOOST_CHECK(!map.contains(-1));
+
+            std::map<int, int> visited;
+            map.forEach([&visited](int key, int value) {
+                visited[key] = value;
+            });
+            BOOST_REQUIRE_EQUAL(visited.size(), source.size());
+            for (const auto& kv : visited) {
+                BOOST_CHECK_EQUAL(kv.second, kv.first * kv.first);
+            }
+        }
+
+        BOOST_AUTO_TEST_CASE(test_batch) {
+            SnapshotMap<int, std::string> map;
+            map.set(1, "one");
+            map.set(2, "two");
+            const std::shared_ptr<const std::string> old_two(map.find(2));
+
+            SnapshotMap<int, std::string>::Batch batch(map);
+            for (int i = 10; i < 200; ++i) {
+                batch.set(i, std::to_string(i));
+            }
+            batch.set(2, "dos");
+            batch.erase(1);
+            batch.erase(3);
+            batch.erase(150);
+
+            // The batch sees its own writes, but nothing is visible
+            // through the map before commit().
+            BOOST_CHECK(!batch.find(1));
+            BOOST_REQUIRE(batch.find(2));
+            BOOST_CHECK_EQUAL(*batch.find(2), "dos");
+            BOOST_REQUIRE(batch.find(10));
+            BOOST_CHECK_EQUAL(*batch.find(10), "10");
+            BOOST_CHECK(map.contains(1));
+            BOOST_CHECK(!map.contains(10));
+            BOOST_CHECK_EQUAL(*map.find(2), "two");
+
+            batch.commit();
+            BOOST_CHECK(!map.contains(1));
+            BOOST_CHECK(!map.contains(3));
+            BOOST_CHECK(!map.contains(150));
+            BOOST_CHECK_EQUAL(*map.find(2), "dos");
+            for (int i = 10; i < 200; ++i) {
+                if (i != 150) {
+                    BOOST_REQUIRE(map.find(i));
+                    BOOST_CHECK_EQUAL(*map.find(i), std::to_string(i));
+                }
+            }
+            BOOST_CHECK_EQUAL(*old_two, "two");
+
+            // A committed batch can be reused, and starts from the new contents.
+            batch.set(1, "uno");
+            batch.commit();
+            BOOST_CHECK_EQUAL(*map.find(1), "uno");
+            BOOST_CHECK_EQUAL(*map.find(2), "dos");
+
+            int size = 0;
+            map.forEach([&size](int, const std::string&) {
+                ++size;
+            });
+            BOOST_CHECK_EQUAL(size, 191);
+        }
+
+        BOOST_AUTO_TEST_CASE(test_concurrent_readers) {
+            const int num_keys = 256;
+            SnapshotMap<int, std::vector<int>> map;
+            for (int key = 0; key < num_keys; ++key) {
+                map.set(key, std::vector<int>(16, 0));
+            }
+
+            // Every published value is uniform, so a reader seeing a mix
+            // of old and new elements would detect a torn write.
+            bool torn = false;
+            std::vector<std::thread> readers;
+            std::vector<char> reader_torn(4, 0);
+            for (size_t i = 0; i < reader_torn.size(); ++i) {
+                readers.emplace_back([&map, &reader_torn, i]() {
+                    for (int iter = 0; iter < 20000; ++iter) {
+                        const std::shared_ptr<const std::vector<int>> value(map.find(iter % num_keys));
+                        if (!value) {
+                            reader_torn[i] = 1;
+                            continue;
+                        }
+                        for (const int v : *value) {
+                            if (v != value->front()) {
+                                reader_torn[i] = 1;
+                            }
+                        }
+                    }
+                });
+            }
+
+            for (int version = 1; version <= 100; ++version) {
+                for (int key = 0; key < num_keys; ++key) {
+                    map.set(key, std::vector<int>(16, version));
+                }
+            }
+
+            for (std::thread& reader : readers) {
+                reader.join();
+            }
+            for (const char t : reader_torn) {
+                torn = torn || t;
+            }
+            BOOST_CHECK(!torn);
+        }
+
+    BOOST_AUTO_TEST_SUITE_END();
+}  // namespace Tests
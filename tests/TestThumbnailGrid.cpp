@@ -0,0 +1,88 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ThumbnailGrid.h"
+#include <QPointF>
+#include <QRectF>
+#include <QSizeF>
+#include <boost/test/auto_unit_test.hpp>
+#include <utility>
+
+namespace Tests {
+    BOOST_AUTO_TEST_SUITE(ThumbnailGridTestSuite);
+
+        /**
+         * 20 thumbnails in 3 columns make 7 rows, the last one holding 2 thumbnails.
+         * Row r spans [200 * r - 5, 200 * r + 195) vertically.
+         */
+        static const int NUM_ITEMS = 20;
+        static const qreal TOP_MARGIN = 5;
+
+        static ThumbnailGrid makeGrid() {
+            return ThumbnailGrid(QPointF(0, 0), QSizeF(300, 200), 3);
+        }
+
+        static std::pair<int, int> range(const qreal top, const qreal bottom, const int margin_rows) {
+            return makeGrid().itemRange(QRectF(0, top, 300, bottom - top), TOP_MARGIN, margin_rows, NUM_ITEMS);
+        }
+
+        BOOST_AUTO_TEST_CASE(test_positions) {
+            const ThumbnailGrid grid(QPointF(10, 20), QSizeF(300, 200), 3);
+            BOOST_CHECK(grid.position(0) == QPointF(10, 20));
+            BOOST_CHECK(grid.position(2) == QPointF(610, 20));
+            BOOST_CHECK(grid.position(4) == QPointF(310, 220));
+
+            BOOST_CHECK_EQUAL(grid.numRows(0), 0);
+            BOOST_CHECK_EQUAL(grid.numRows(3), 1);
+            BOOST_CHECK_EQUAL(grid.numRows(NUM_ITEMS), 7);
+            BOOST_CHECK_EQUAL(grid.numRows(21), 7);
+        }
+
+        BOOST_AUTO_TEST_CASE(test_visible_rows) {
+            // The first two rows.
+            BOOST_CHECK(range(0, 390, 0) == std::make_pair(0, 6));
+            // Exactly the second row.
+            BOOST_CHECK(range(195, 394.5, 0) == std::make_pair(3, 6));
+            // Touching the top of the second row.
+            BOOST_CHECK(range(100, 195, 0) == std::make_pair(0, 6));
+            // The last row is partial.
+            BOOST_CHECK(range(1195, 1300, 0) == std::make_pair(18, NUM_ITEMS));
+        }
+
+        BOOST_AUTO_TEST_CASE(test_margin_rows) {
+            BOOST_CHECK(range(0, 390, 1) == std::make_pair(0, 9));
+            BOOST_CHECK(range(595, 794.5, 2) == std::make_pair(3, 18));
+            BOOST_CHECK(range(995, 1194.5, 3) == std::make_pair(6, NUM_ITEMS));
+        }
+
+        BOOST_AUTO_TEST_CASE(test_out_of_range) {
+            // Above the first row, but with the margin reaching into it.
+            BOOST_CHECK(range(-1000, -500, 0) == std::make_pair(0, 0));
+            BOOST_CHECK(range(-1000, -500, 3) == std::make_pair(0, 3));
+            // Below the last row.
+            BOOST_CHECK(range(5000, 5500, 1) == std::make_pair(NUM_ITEMS, NUM_ITEMS));
+            // Huge rects don't overflow.
+            BOOST_CHECK(range(-1e12, 1e12, 3) == std::make_pair(0, NUM_ITEMS));
+            // No thumbnails at all.
+            BOOST_CHECK(
+                    makeGrid().itemRange(QRectF(0, 0, 300, 400), TOP_MARGIN, 3, 0) == std::make_pair(0, 0)
+            );
+        }
+
+    BOOST_AUTO_TEST_SUITE_END();
+}  // namespace Tests
@@ -0,0 +1,225 @@
+/*
+    Scan Tailor - Interactive post-processing tool for scanned pages.
+    Copyright (C)  Joseph Artsimovich <joseph.artsimovich@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TiffWriter.h"
+#include "TiffReader.h"
+#include <QBuffer>
+#include <QByteArray>
+#include <QImage>
+#include <QSettings>
+#include <QTemporaryDir>
+#include <QVector>
+#include <boost/test/auto_unit_test.hpp>
+#include <tiffio.h>
+
+namespace Tests {
+    BOOST_AUTO_TEST_SUITE(TiffWriterTestSuite);
+
+        namespace {
+            /**
+             * Points QSettings at a temporary directory, so that the compression
+             * settings the tests choose don't end up in the user's configuration.
+             */
+            class CompressionSettings {
+            public:
+                CompressionSettings() {
+                    QSettings::setDefaultFormat(QSettings::IniFormat);
+                    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, m_dir.path());
+                }
+
+                ~CompressionSettings() {
+                    QSettings settings;
+                    settings.remove("settings/bw_compression");
+                    settings.remove("settings/color_compression");
+                    settings.sync();
+                    TiffWriter::reloadSettings();
+                }
+
+                bool isValid() const {
+                    return m_dir.isValid();
+                }
+
+                void set(const int bw_compression, const int color_compression) {
+                    QSettings settings;
+                    settings.setValue("settings/bw_compression", bw_compression);
+                    settings.setValue("settings/color_compression", color_compression);
+                    settings.sync();
+                    TiffWriter::reloadSettings();
+                }
+
+            private:
+                QTemporaryDir m_dir;
+            };
+        }  // namespace
+
+        /**
+         * The image sizes below are chosen so that an image is split into
+         * several strips, the last one shorter than the rest.  Strips hold
+         * about 256K of uncompressed data, in multiples of 16 rows.
+         */
+
+        static QImage createBinaryImage(const QImage::Format format, const QRgb color0, const QRgb color1) {
+            // 250 bytes per line make 1056 rows per strip.
+            QImage image(2000, 2500, format);
+            image.setColorTable(QVector<QRgb>() << color0 << color1);
+            for (int y = 0; y < image.height(); ++y) {
+                for (int x = 0; x < image.width(); ++x) {
+                    const bool stripe = ((x / 13 + y / 17) % 3) == 0;
+                    const bool dot = ((x * y) % 11) == 0;
+                    image.setPixel(x, y, (stripe != dot) ? 1 : 0);
+                }
+            }
+
+            return image;
+        }
+
+        static QImage createGrayImage() {
+            // 1000 bytes per line make 272 rows per strip.
+            QImage image(1000, 700, QImage::Format_Indexed8);
+            QVector<QRgb> palette(256);
+            for (int i = 0; i < 256; ++i) {
+                palette[i] = qRgb(i, i, i);
+            }
+            image.setColorTable(palette);
+            for (int y = 0; y < image.height(); ++y) {
+                uchar* line = image.scanLine(y);
+                for (int x = 0; x < image.width(); ++x) {
+                    line[x] = static_cast<uchar>((x + 3 * y) & 0xff);
+                }
+            }
+
+            return image;
+        }
+
+        static QImage createColorImage(const QImage::Format format) {
+            // 3000 (RGB) or 4000 (RGBA) bytes per line make 96 or 80 rows per strip.
+            QImage image(1000, 250, format);
+            for (int y = 0; y < image.height(); ++y) {
+                for (int x = 0; x < image.width(); ++x) {
+                    // libtiff premultiplies colors when reading images with alpha,
+                    // so only fully opaque and fully transparent pixels survive exactly.
+                    const int alpha = ((x / 7 + y / 5) % 4 == 0) ? 0 : 255;
+                    image.setPixel(x, y, qRgba(x & 0xff, y & 0xff, (x + y) & 0xff, alpha));
+                }
+            }
+
+            return image;
+        }
+
+        static QImage writeAndRead(const QImage& image) {
+            QByteArray data;
+            QBuffer buffer(&data);
+            buffer.open(QIODevice::WriteOnly);
+            if (!TiffWriter::writeImage(buffer, image)) {
+                return QImage();
+            }
+            buffer.close();
+
+            buffer.open(QIODevice::ReadOnly);
+
+            return TiffReader::readImage(buffer);
+        }
+
+        /**
+         * Compares the colors of the two images, pixel by pixel.
+         * The colors of transparent pixels don't matter.
+         */
+        static bool samePixels(const QImage& expected, const QImage& actual) {
+            if (expected.size() != actual.size()) {
+                return false;
+            }
+
+            const QImage expected_argb(expected.convertToFormat(QImage::Format_ARGB32));
+            const QImage actual_argb(actual.convertToFormat(QImage::Format_ARGB32));
+            for (int y = 0; y < expected.height(); ++y) {
+                const auto* expected_line = reinterpret_cast<const QRgb*>(expected_argb.constScanLine(y));
+                const auto* actual_line = reinterpret_cast<const QRgb*>(actual_argb.constScanLine(y));
+                for (int x = 0; x < expected.width(); ++x) {
+                    const QRgb expected_pixel = expected_line[x];
+                    const QRgb actual_pixel = actual_line[x];
+                    if (qAlpha(expected_pixel) != qAlpha(actual_pixel)) {
+                        return false;
+                    }
+                    if ((qAlpha(expected_pixel) != 0) && (expected_pixel != actual_pixel)) {
+                        return false;
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        BOOST_AUTO_TEST_CASE(test_binary_images) {
+            CompressionSettings settings;
+            BOOST_REQUIRE(settings.isValid());
+
+            const QRgb white = qRgb(0xff, 0xff, 0xff);
+            const QRgb black = qRgb(0x00, 0x00, 0x00);
+            const QImage images[] = {
+                    // Black on white, written as PHOTOMETRIC_MINISWHITE.
+                    createBinaryImage(QImage::Format_Mono, white, black),
+                    // White on black, written as PHOTOMETRIC_MINISBLACK.
+                    createBinaryImage(QImage::Format_Mono, black, white),
+                    // The bit order gets reversed on the way.
+                    createBinaryImage(QImage::Format_MonoLSB, white, black)
+            };
+
+            const int compressions[] = {COMPRESSION_CCITTFAX4, COMPRESSION_LZW, COMPRESSION_NONE};
+            for (const int compression : compressions) {
+                settings.set(compression, COMPRESSION_LZW);
+                for (const QImage& image : images) {
+                    const QImage read(writeAndRead(image));
+                    BOOST_REQUIRE(!read.isNull());
+                    BOOST_CHECK(read.format() == QImage::Format_Mono);
+                    BOOST_CHECK_MESSAGE(samePixels(image, read), "compression " << compression);
+                }
+            }
+        }
+
+        BOOST_AUTO_TEST_CASE(test_gray_and_color_images) {
+            CompressionSettings settings;
+            BOOST_REQUIRE(settings.isValid());
+
+            const QImage gray(createGrayImage());
+            const QImage rgb(createColorImage(QImage::Format_RGB32));
+            const QImage argb(createColorImage(QImage::Format_ARGB32));
+
+            const int compressions[] = {COMPRESSION_LZW, COMPRESSION_NONE};
+            for (const int compression : compressions) {
+                settings.set(COMPRESSION_CCITTFAX4, compression);
+
+                QImage read(writeAndRead(gray));
+                BOOST_REQUIRE(!read.isNull());
+                BOOST_CHECK(read.format() == QImage::Format_Indexed8);
+                BOOST_CHECK(read.isGrayscale());
+                BOOST_CHECK_MESSAGE(samePixels(gray, read), "compression " << compression);
+
+                read = writeAndRead(rgb);
+                BOOST_REQUIRE(!read.isNull());
+                BOOST_CHECK(!read.hasAlphaChannel());
+                BOOST_CHECK_MESSAGE(samePixels(rgb, read), "compression " << compression);
+
+                read = writeAndRead(argb);
+                BOOST_REQUIRE(!read.isNull());
+                BOOST_CHECK(read.hasAlphaChannel());
+                BOOST_CHECK_MESSAGE(samePixels(argb, read), "compression " << compression);
+            }
+        }
+
+    BOOST_AUTO_TEST_SUITE_END();
+}  // namespace Tests